@@ -73,6 +73,10 @@ GENERIC_CXXFLAGS+=-DENABLE_CUDA_PROFILING
 LDFLAGS+=-lnvToolsExt
 endif
 
+ifeq ($(PLAIN_WORK_STEALING),yes)
+GENERIC_CXXFLAGS+=-DNNFORGE_PLAIN_WORK_STEALING
+endif
+
 NVCCFLAGS+=-Xcompiler="$(GENERIC_CXXFLAGS)"
 CXXFLAGS=$(GENERIC_CXXFLAGS)
 
@@ -2,6 +2,8 @@ BUILD_MODE?=release
 ENABLE_CUDA_BACKEND?=yes
 ENABLE_CUDA_PROFILING?=no
 CPP11COMPILER?=no
+# Parallel loops of the plain backend kernels run on the work stealing scheduler instead of OpenMP when set to yes
+PLAIN_WORK_STEALING?=no
 PROTOBUF_PATH?=/usr
 BOOST_PATH?=/usr
 OPENCV_PATH?=/usr
@@ -26,7 +28,9 @@ NETCDF_LIBS?=-lnetcdf
 MATIO_LIBS?=-lmatio
 
 CPP_FLAGS_CPP11?=-std=c++11
-CPP_HW_ARCHITECTURE?=-march=native # set this to -march=corei7 if you see AVX related errors when CPP11COMPILER=yes
+# Hot kernels of the plain backend select SSE2/AVX2/AVX-512 variant at run time, so portable binaries are built by default;
+# set this to -march=native to tune the rest of the code for the build machine
+CPP_HW_ARCHITECTURE?=
 CPP_FLAGS_COMMON?=-ffast-math $(CPP_HW_ARCHITECTURE) -mfpmath=sse -msse2 # -mavx
 CPP_FLAGS_DEBUG_MODE?=-g
 CPP_FLAGS_RELEASE_MODE?=-O3
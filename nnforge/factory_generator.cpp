@@ -55,4 +55,9 @@ namespace nnforge
 	{
 		return std::vector<int_option>();
 	}
+
+	void factory_generator::set_tuning_state(tuning_state::ptr tuning)
+	{
+		this->tuning = tuning;
+	}
 }
@@ -19,6 +19,7 @@
 #include "forward_propagation_factory.h"
 #include "backward_propagation_factory.h"
 #include "config_options.h"
+#include "tuning_state.h"
 #include "nn_types.h"
 
 namespace nnforge
@@ -50,7 +51,13 @@ namespace nnforge
 
 		virtual std::vector<int_option> get_int_options();
 
+		// Should be called before initialize, backends don't auto-tune unless it is called
+		void set_tuning_state(tuning_state::ptr tuning);
+
 	protected:
 		factory_generator();
+
+	protected:
+		tuning_state::ptr tuning;
 	};
 }
@@ -30,7 +30,9 @@ namespace nnforge
 			backward_data = 1,
 			backward_weights = 2,
 			backward_data_and_weights = 3,
-			update_weights = 4
+			update_weights = 4,
+			// Forward prop run again during backward prop to restore the output which was not kept
+			recompute = 5
 		};
 
 		layer_action()
@@ -73,6 +75,10 @@ namespace nnforge
 			{
 				return "update_weights";
 			}
+			else if (at == recompute)
+			{
+				return "recompute";
+			}
 			else
 			{
 				return (boost::format("backward_data_%1%") % backprop_index).str();
@@ -84,10 +90,16 @@ namespace nnforge
 		int backprop_index;
 
 		friend bool operator <(const layer_action& x, const layer_action& y);
+		friend bool operator ==(const layer_action& x, const layer_action& y);
 	};
 
 	inline bool operator <(const layer_action& x, const layer_action& y)
 	{
 		return (((unsigned long long)x.at << 32) | (unsigned int)x.backprop_index) < (((unsigned long long)y.at << 32) | (unsigned int)y.backprop_index);
 	}
+
+	inline bool operator ==(const layer_action& x, const layer_action& y)
+	{
+		return (x.at == y.at) && (x.backprop_index == y.backprop_index);
+	}
 }
@@ -52,6 +52,7 @@ namespace nnforge
 		layer_action action;
 
 		friend bool operator <(const layer_name_with_action& x, const layer_name_with_action& y);
+		friend bool operator ==(const layer_name_with_action& x, const layer_name_with_action& y);
 	};
 
 	inline bool operator <(const layer_name_with_action& x, const layer_name_with_action& y)
@@ -69,4 +70,9 @@ namespace nnforge
 			return x.action < y.action;
 		}
 	}
+
+	inline bool operator ==(const layer_name_with_action& x, const layer_name_with_action& y)
+	{
+		return (x.name == y.name) && (x.action == y.action);
+	}
 }
@@ -127,6 +127,8 @@ namespace nnforge
 		{
 			layer::const_ptr l = actions[*vp.first].l;
 			layer_action action = actions[*vp.first].action;
+			if (action.get_action_type() == layer_action::recompute)
+				continue;
 			std::vector<layer_configuration_specific> input_layer_configs;
 			for(std::vector<std::string>::const_iterator it = l->input_layer_instance_names.begin(); it != l->input_layer_instance_names.end(); ++it)
 				input_layer_configs.push_back(layer_config_map.find(*it)->second);
@@ -349,23 +351,18 @@ namespace nnforge
 		return static_cast<int>(num_colors);
 	}
 
-	std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > network_action_schema::get_buffer_set(
+	void network_action_schema::fill_buffer_incompatibility_graph(
 		const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > >& buffers,
 		const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies_and_overwrites,
-		const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& should_be_placed_into_the_same_buffers) const
+		const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& should_be_placed_into_the_same_buffers,
+		buffer_incompatibility_graph& incompatible_output_actions_with_lifetime,
+		std::set<std::pair<buffer_incompatibility_graph::vertex_descriptor, buffer_incompatibility_graph::vertex_descriptor> > * in_place_pairs) const
 	{
-		typedef boost::adjacency_list<
-			boost::vecS,
-			boost::vecS,
-			boost::undirectedS,
-			vertex_info_list_for_buffer_set> undirected_action_schema_graph2;
-
-		undirected_action_schema_graph2 incompatible_output_actions_with_lifetime;
-		std::map<layer_name_with_action, std::map<buffer_lifetime, undirected_action_schema_graph2::vertex_descriptor> > incompatible_output_action_to_vertex_decriptor_map;
+		std::map<layer_name_with_action, std::map<buffer_lifetime, buffer_incompatibility_graph::vertex_descriptor> > incompatible_output_action_to_vertex_decriptor_map;
 		{
 			for(std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >::const_iterator itt = should_be_placed_into_the_same_buffers.begin(); itt != should_be_placed_into_the_same_buffers.end(); ++itt)
 			{
-				undirected_action_schema_graph2::vertex_descriptor new_action_descriptor = boost::add_vertex(incompatible_output_actions_with_lifetime);
+				buffer_incompatibility_graph::vertex_descriptor new_action_descriptor = boost::add_vertex(incompatible_output_actions_with_lifetime);
 				const std::vector<std::pair<layer_name_with_action, buffer_lifetime> >& buffers = *itt;
 				for(std::vector<std::pair<layer_name_with_action, buffer_lifetime> >::const_iterator it = buffers.begin(); it != buffers.end(); ++it)
 				{
@@ -373,10 +370,10 @@ namespace nnforge
 					layer_action action = it->first.get_action();
 					const buffer_lifetime& lifetime = it->second;
 
-					std::map<buffer_lifetime, undirected_action_schema_graph2::vertex_descriptor>& tt = incompatible_output_action_to_vertex_decriptor_map.insert(
+					std::map<buffer_lifetime, buffer_incompatibility_graph::vertex_descriptor>& tt = incompatible_output_action_to_vertex_decriptor_map.insert(
 						std::make_pair(
 							layer_name_with_action(l->instance_name, action),
-							std::map<buffer_lifetime, undirected_action_schema_graph2::vertex_descriptor>())).first->second;
+							std::map<buffer_lifetime, buffer_incompatibility_graph::vertex_descriptor>())).first->second;
 
 					if (tt.find(lifetime) != tt.end())
 						throw neural_network_exception((boost::format("Buffer %1% for action %2% for layer %3% is specified multiple times for different same buffer sets") % lifetime.str() % l->instance_name % action.str()).str());
@@ -392,16 +389,16 @@ namespace nnforge
 				layer_action action = it->first.get_action();
 				const std::vector<std::pair<buffer_lifetime, float> >& lifetime_list = it->second;
 
-				std::map<buffer_lifetime, undirected_action_schema_graph2::vertex_descriptor>& tt = incompatible_output_action_to_vertex_decriptor_map.insert(
+				std::map<buffer_lifetime, buffer_incompatibility_graph::vertex_descriptor>& tt = incompatible_output_action_to_vertex_decriptor_map.insert(
 					std::make_pair(
 						layer_name_with_action(l->instance_name, action),
-						std::map<buffer_lifetime, undirected_action_schema_graph2::vertex_descriptor>())).first->second;
+						std::map<buffer_lifetime, buffer_incompatibility_graph::vertex_descriptor>())).first->second;
 				for(std::vector<std::pair<buffer_lifetime, float> >::const_iterator it2 = lifetime_list.begin(); it2 != lifetime_list.end(); ++it2)
 				{
 					const buffer_lifetime& lifetime = it2->first;
 					float buffer_size = it2->second;
-					std::map<buffer_lifetime, undirected_action_schema_graph2::vertex_descriptor>::iterator old_it = tt.find(lifetime);
-					undirected_action_schema_graph2::vertex_descriptor new_action_descriptor;
+					std::map<buffer_lifetime, buffer_incompatibility_graph::vertex_descriptor>::iterator old_it = tt.find(lifetime);
+					buffer_incompatibility_graph::vertex_descriptor new_action_descriptor;
 					if (old_it != tt.end())
 					{
 						new_action_descriptor = old_it->second;
@@ -459,8 +456,8 @@ namespace nnforge
 			{
 				for(std::vector<std::pair<buffer_lifetime, float> >::const_iterator it2 = it1 + 1; it2 != current_buffer_lifetimes.end(); ++it2)
 				{
-					undirected_action_schema_graph2::vertex_descriptor v1 = incompatible_output_action_to_vertex_decriptor_map[current_layer_name_with_action][it1->first];
-					undirected_action_schema_graph2::vertex_descriptor v2 = incompatible_output_action_to_vertex_decriptor_map[current_layer_name_with_action][it2->first];
+					buffer_incompatibility_graph::vertex_descriptor v1 = incompatible_output_action_to_vertex_decriptor_map[current_layer_name_with_action][it1->first];
+					buffer_incompatibility_graph::vertex_descriptor v2 = incompatible_output_action_to_vertex_decriptor_map[current_layer_name_with_action][it2->first];
 					if ((v1 != v2) && (!boost::edge(v1, v2, incompatible_output_actions_with_lifetime).second))
 					{
 						boost::add_edge(
@@ -505,8 +502,8 @@ namespace nnforge
 						const std::vector<std::pair<buffer_lifetime, float> >& incompatible_buffer_lifetimes = subsequent_buffer_list_it->second;
 						for(std::vector<std::pair<buffer_lifetime, float> >::const_iterator incompatible_buffer_lifetime_it = incompatible_buffer_lifetimes.begin(); incompatible_buffer_lifetime_it != incompatible_buffer_lifetimes.end(); ++incompatible_buffer_lifetime_it)
 						{
-							undirected_action_schema_graph2::vertex_descriptor v1 = incompatible_output_action_to_vertex_decriptor_map[current_layer_name_with_action][source_buffer_lifetime];
-							undirected_action_schema_graph2::vertex_descriptor v2 = incompatible_output_action_to_vertex_decriptor_map[subsequent_layer_name_with_action][incompatible_buffer_lifetime_it->first];
+							buffer_incompatibility_graph::vertex_descriptor v1 = incompatible_output_action_to_vertex_decriptor_map[current_layer_name_with_action][source_buffer_lifetime];
+							buffer_incompatibility_graph::vertex_descriptor v2 = incompatible_output_action_to_vertex_decriptor_map[subsequent_layer_name_with_action][incompatible_buffer_lifetime_it->first];
 							if ((v1 != v2) && (!boost::edge(v1, v2, incompatible_output_actions_with_lifetime).second))
 							{
 								boost::add_edge(
@@ -561,11 +558,15 @@ namespace nnforge
 						const std::vector<std::pair<buffer_lifetime, float> >& incompatible_buffer_lifetimes = subsequent_buffer_list_it->second;
 						for(std::vector<std::pair<buffer_lifetime, float> >::const_iterator incompatible_buffer_lifetime_it = incompatible_buffer_lifetimes.begin(); incompatible_buffer_lifetime_it != incompatible_buffer_lifetimes.end(); ++incompatible_buffer_lifetime_it)
 						{
+							buffer_incompatibility_graph::vertex_descriptor v1 = incompatible_output_action_to_vertex_decriptor_map[current_layer_name_with_action][source_buffer_lifetime];
+							buffer_incompatibility_graph::vertex_descriptor v2 = incompatible_output_action_to_vertex_decriptor_map[subsequent_layer_name_with_action][incompatible_buffer_lifetime_it->first];
 							if (can_overwrite_input && (incompatible_buffer_lifetime_it->first.get_buffer_lifetime_type() == buffer_lifetime::action_output_buffer))
+							{
+								if ((v1 != v2) && (in_place_pairs != 0))
+									in_place_pairs->insert(std::make_pair(std::min(v1, v2), std::max(v1, v2)));
 								continue;
+							}
 
-							undirected_action_schema_graph2::vertex_descriptor v1 = incompatible_output_action_to_vertex_decriptor_map[current_layer_name_with_action][source_buffer_lifetime];
-							undirected_action_schema_graph2::vertex_descriptor v2 = incompatible_output_action_to_vertex_decriptor_map[subsequent_layer_name_with_action][incompatible_buffer_lifetime_it->first];
 							if ((v1 != v2) && (!boost::edge(v1, v2, incompatible_output_actions_with_lifetime).second))
 							{
 								boost::add_edge(
@@ -578,29 +579,212 @@ namespace nnforge
 				}
 			}
 		}
-		// incompatible_output_layers is filled with edges
+	}
+
+	std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > network_action_schema::get_buffer_set(
+		const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > >& buffers,
+		const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies_and_overwrites,
+		const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& should_be_placed_into_the_same_buffers) const
+	{
+		buffer_incompatibility_graph incompatible_output_actions_with_lifetime;
+		fill_buffer_incompatibility_graph(
+			buffers,
+			dependencies_and_overwrites,
+			should_be_placed_into_the_same_buffers,
+			incompatible_output_actions_with_lifetime);
 
 		std::vector<float> weights_vec(boost::num_vertices(incompatible_output_actions_with_lifetime));
 		if (weights_vec.empty())
 			weights_vec.resize(1); // So that weights_vec.front() would not fail
-		boost::iterator_property_map<float*, typename boost::property_map<undirected_action_schema_graph2, boost::vertex_index_t>::const_type> weights(&weights_vec.front(), boost::get(boost::vertex_index, incompatible_output_actions_with_lifetime));
-		for(std::pair<undirected_action_schema_graph2::vertex_iterator, undirected_action_schema_graph2::vertex_iterator> vp = boost::vertices(incompatible_output_actions_with_lifetime); vp.first != vp.second; ++vp.first)
+		boost::iterator_property_map<float*, typename boost::property_map<buffer_incompatibility_graph, boost::vertex_index_t>::const_type> weights(&weights_vec.front(), boost::get(boost::vertex_index, incompatible_output_actions_with_lifetime));
+		for(std::pair<buffer_incompatibility_graph::vertex_iterator, buffer_incompatibility_graph::vertex_iterator> vp = boost::vertices(incompatible_output_actions_with_lifetime); vp.first != vp.second; ++vp.first)
 			boost::put(weights, *vp.first, incompatible_output_actions_with_lifetime[*vp.first].buffer_size);
 
-		std::vector<typename boost::graph_traits<undirected_action_schema_graph2>::vertices_size_type> colors_vec(boost::num_vertices(incompatible_output_actions_with_lifetime));
+		std::vector<typename boost::graph_traits<buffer_incompatibility_graph>::vertices_size_type> colors_vec(boost::num_vertices(incompatible_output_actions_with_lifetime));
 		if (colors_vec.empty())
 			colors_vec.resize(1); // So that colors_vec.front() would not fail
-		boost::iterator_property_map<typename boost::graph_traits<undirected_action_schema_graph2>::vertices_size_type*, typename boost::property_map<undirected_action_schema_graph2, boost::vertex_index_t>::const_type> colors(&colors_vec.front(), boost::get(boost::vertex_index, incompatible_output_actions_with_lifetime));
+		boost::iterator_property_map<typename boost::graph_traits<buffer_incompatibility_graph>::vertices_size_type*, typename boost::property_map<buffer_incompatibility_graph, boost::vertex_index_t>::const_type> colors(&colors_vec.front(), boost::get(boost::vertex_index, incompatible_output_actions_with_lifetime));
 		int color_count = get_graph_coloring(incompatible_output_actions_with_lifetime, colors, weights);
 
 		std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > res(color_count);
-		for(std::pair<undirected_action_schema_graph2::vertex_iterator, undirected_action_schema_graph2::vertex_iterator> vp = boost::vertices(incompatible_output_actions_with_lifetime); vp.first != vp.second; ++vp.first)
+		for(std::pair<buffer_incompatibility_graph::vertex_iterator, buffer_incompatibility_graph::vertex_iterator> vp = boost::vertices(incompatible_output_actions_with_lifetime); vp.first != vp.second; ++vp.first)
 			for(std::vector<vertex_info_for_buffer_set>::const_iterator it = incompatible_output_actions_with_lifetime[*vp.first].buffers.begin(); it != incompatible_output_actions_with_lifetime[*vp.first].buffers.end(); ++it)
 				res[boost::get(colors, *vp.first)].push_back(std::make_pair(layer_name_with_action(it->l->instance_name, it->action), it->lifetime));
 
 		return res;
 	}
 
+	std::vector<std::pair<size_t, std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > > network_action_schema::get_buffer_offsets(
+		const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, size_t> > >& buffers,
+		const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies_and_overwrites,
+		const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& should_be_placed_into_the_same_buffers,
+		size_t alignment,
+		size_t& arena_size) const
+	{
+		buffer_incompatibility_graph incompatible_output_actions_with_lifetime;
+		std::set<std::pair<buffer_incompatibility_graph::vertex_descriptor, buffer_incompatibility_graph::vertex_descriptor> > in_place_pairs;
+		fill_buffer_incompatibility_graph(
+			get_buffer_weights(buffers),
+			dependencies_and_overwrites,
+			should_be_placed_into_the_same_buffers,
+			incompatible_output_actions_with_lifetime,
+			&in_place_pairs);
+
+		const unsigned int vertex_count = static_cast<unsigned int>(boost::num_vertices(incompatible_output_actions_with_lifetime));
+
+		// Float weights of the graph might be rounded, sizes are taken from the original map
+		std::vector<size_t> sizes(vertex_count, 0);
+		for(unsigned int v = 0; v < vertex_count; ++v)
+		{
+			const std::vector<vertex_info_for_buffer_set>& vertex_buffers = incompatible_output_actions_with_lifetime[v].buffers;
+			for(std::vector<vertex_info_for_buffer_set>::const_iterator it = vertex_buffers.begin(); it != vertex_buffers.end(); ++it)
+			{
+				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, size_t> > >::const_iterator buffer_it = buffers.find(layer_name_with_action(it->l->instance_name, it->action));
+				if (buffer_it == buffers.end())
+					continue;
+				for(std::vector<std::pair<buffer_lifetime, size_t> >::const_iterator it2 = buffer_it->second.begin(); it2 != buffer_it->second.end(); ++it2)
+					if (it2->first.get_buffer_lifetime_type() == it->lifetime.get_buffer_lifetime_type())
+						sizes[v] = std::max(sizes[v], it2->second);
+			}
+			sizes[v] = (sizes[v] + alignment - 1) / alignment * alignment;
+		}
+
+		std::vector<std::vector<unsigned int> > conflicting_vertices(vertex_count);
+		for(std::pair<buffer_incompatibility_graph::edge_iterator, buffer_incompatibility_graph::edge_iterator> ep = boost::edges(incompatible_output_actions_with_lifetime); ep.first != ep.second; ++ep.first)
+		{
+			unsigned int v1 = static_cast<unsigned int>(boost::source(*ep.first, incompatible_output_actions_with_lifetime));
+			unsigned int v2 = static_cast<unsigned int>(boost::target(*ep.first, incompatible_output_actions_with_lifetime));
+			conflicting_vertices[v1].push_back(v2);
+			conflicting_vertices[v2].push_back(v1);
+		}
+
+		// Partial overlap of the input and the output written in place of it would corrupt the input before it is read
+		std::vector<std::vector<unsigned int> > in_place_vertices(vertex_count);
+		for(std::set<std::pair<buffer_incompatibility_graph::vertex_descriptor, buffer_incompatibility_graph::vertex_descriptor> >::const_iterator it = in_place_pairs.begin(); it != in_place_pairs.end(); ++it)
+		{
+			if (boost::edge(it->first, it->second, incompatible_output_actions_with_lifetime).second)
+				continue;
+			in_place_vertices[it->first].push_back(static_cast<unsigned int>(it->second));
+			in_place_vertices[it->second].push_back(static_cast<unsigned int>(it->first));
+		}
+
+		std::vector<std::pair<size_t, unsigned int> > size_and_vertex_list;
+		for(unsigned int v = 0; v < vertex_count; ++v)
+			size_and_vertex_list.push_back(std::make_pair(sizes[v], v));
+		std::stable_sort(size_and_vertex_list.begin(), size_and_vertex_list.end(), compare_sizes);
+
+		std::vector<size_t> offsets(vertex_count, 0);
+		std::vector<bool> placed(vertex_count, false);
+		arena_size = 0;
+		for(std::vector<std::pair<size_t, unsigned int> >::const_iterator it = size_and_vertex_list.begin(); it != size_and_vertex_list.end(); ++it)
+		{
+			const unsigned int v = it->second;
+			const size_t size = it->first;
+
+			// The buffer starts either at the beginning of the arena, right after one of its neighbors, or at the start of the input it overwrites
+			std::vector<size_t> candidate_offsets(1, 0);
+			for(std::vector<unsigned int>::const_iterator it2 = conflicting_vertices[v].begin(); it2 != conflicting_vertices[v].end(); ++it2)
+				if (placed[*it2])
+					candidate_offsets.push_back(offsets[*it2] + sizes[*it2]);
+			for(std::vector<unsigned int>::const_iterator it2 = in_place_vertices[v].begin(); it2 != in_place_vertices[v].end(); ++it2)
+			{
+				if (placed[*it2])
+				{
+					candidate_offsets.push_back(offsets[*it2]);
+					candidate_offsets.push_back(offsets[*it2] + sizes[*it2]);
+				}
+			}
+
+			size_t best_offset = 0;
+			size_t best_gap = std::numeric_limits<size_t>::max();
+			bool found = false;
+			for(std::vector<size_t>::const_iterator offset_it = candidate_offsets.begin(); offset_it != candidate_offsets.end(); ++offset_it)
+			{
+				const size_t offset = *offset_it;
+				bool fits = true;
+				bool in_place = false;
+				size_t gap_end = std::numeric_limits<size_t>::max();
+				for(std::vector<unsigned int>::const_iterator it2 = conflicting_vertices[v].begin(); (it2 != conflicting_vertices[v].end()) && fits; ++it2)
+				{
+					if (!placed[*it2])
+						continue;
+					if ((offset < offsets[*it2] + sizes[*it2]) && (offsets[*it2] < offset + size))
+						fits = false;
+					else if (offsets[*it2] >= offset + size)
+						gap_end = std::min(gap_end, offsets[*it2]);
+				}
+				for(std::vector<unsigned int>::const_iterator it2 = in_place_vertices[v].begin(); (it2 != in_place_vertices[v].end()) && fits; ++it2)
+				{
+					if (!placed[*it2])
+						continue;
+					if (offsets[*it2] == offset)
+						in_place = true;
+					else if ((offset < offsets[*it2] + sizes[*it2]) && (offsets[*it2] < offset + size))
+						fits = false;
+					else if (offsets[*it2] >= offset + size)
+						gap_end = std::min(gap_end, offsets[*it2]);
+				}
+				if (!fits)
+					continue;
+
+				// Sharing the storage with the input costs nothing, otherwise the smallest gap wins, the lowest offset breaks ties
+				size_t gap = in_place ? 0 : ((gap_end == std::numeric_limits<size_t>::max()) ? gap_end : gap_end - offset);
+				if ((!found) || (gap < best_gap) || ((gap == best_gap) && (offset < best_offset)))
+				{
+					best_offset = offset;
+					best_gap = gap;
+					found = true;
+				}
+			}
+
+			offsets[v] = best_offset;
+			placed[v] = true;
+			arena_size = std::max(arena_size, best_offset + size);
+		}
+
+		std::vector<std::pair<size_t, std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > > res(vertex_count);
+		for(unsigned int v = 0; v < vertex_count; ++v)
+		{
+			res[v].first = offsets[v];
+			const std::vector<vertex_info_for_buffer_set>& vertex_buffers = incompatible_output_actions_with_lifetime[v].buffers;
+			for(std::vector<vertex_info_for_buffer_set>::const_iterator it = vertex_buffers.begin(); it != vertex_buffers.end(); ++it)
+				res[v].second.push_back(std::make_pair(layer_name_with_action(it->l->instance_name, it->action), it->lifetime));
+		}
+
+		return res;
+	}
+
+	std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > network_action_schema::get_buffer_set(
+		const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, size_t> > >& buffers,
+		const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies_and_overwrites,
+		const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& should_be_placed_into_the_same_buffers) const
+	{
+		return get_buffer_set(
+			get_buffer_weights(buffers),
+			dependencies_and_overwrites,
+			should_be_placed_into_the_same_buffers);
+	}
+
+	std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > > network_action_schema::get_buffer_weights(const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, size_t> > >& buffers)
+	{
+		std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > > res;
+		for(std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, size_t> > >::const_iterator it = buffers.begin(); it != buffers.end(); ++it)
+		{
+			std::vector<std::pair<buffer_lifetime, float> >& dst = res.insert(std::make_pair(it->first, std::vector<std::pair<buffer_lifetime, float> >())).first->second;
+			for(std::vector<std::pair<buffer_lifetime, size_t> >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+				dst.push_back(std::make_pair(it2->first, static_cast<float>(it2->second)));
+		}
+
+		return res;
+	}
+
+	bool network_action_schema::compare_sizes(
+		const std::pair<size_t, unsigned int>& t1,
+		const std::pair<size_t, unsigned int>& t2)
+	{
+		return t1.first > t2.first;
+	}
+
 	layer::const_ptr network_action_schema::find_layer(const std::string& instance_name) const
 	{
 		std::map<std::string, layer::const_ptr>::const_iterator it = name_to_layer_map.find(instance_name);
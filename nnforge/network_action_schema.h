@@ -25,6 +25,7 @@
 
 #include <vector>
 #include <map>
+#include <set>
 #include <limits>
 
 #include <boost/graph/adjacency_list.hpp>
@@ -78,6 +79,7 @@ namespace nnforge
 			const std::map<std::string, layer_configuration_specific>& layer_config_map,
 			const std::map<std::string, unsigned int>& tiling_factor_map) const;
 
+		// Recompute actions are skipped, they repeat the work of forward actions and add no useful flops
 		std::map<layer_name_with_action, float> get_flops_per_action(
 			const std::map<std::string, layer_configuration_specific>& layer_config_map,
 			const std::map<std::string, unsigned int>& tiling_factor_map) const;
@@ -102,6 +104,23 @@ namespace nnforge
 			const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies_and_overwrites,
 			const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& should_be_placed_into_the_same_buffers) const;
 
+		// Same as above for buffer sizes in bytes
+		std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > get_buffer_set(
+			const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, size_t> > >& buffers,
+			const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies_and_overwrites,
+			const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& should_be_placed_into_the_same_buffers) const;
+
+		// The function assigns offsets within a single arena to groups of buffers, buffers which might be alive at the same time don't overlap
+		// Takes the same input as get_buffer_set with exact buffer sizes, offsets are multiples of alignment
+		// An output written in place of the input either gets the offset of that input or doesn't overlap it
+		// Groups are placed greedily by size, each one into the smallest gap it fits; arena_size is set to the size of the arena required
+		std::vector<std::pair<size_t, std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > > get_buffer_offsets(
+			const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, size_t> > >& buffers,
+			const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies_and_overwrites,
+			const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& should_be_placed_into_the_same_buffers,
+			size_t alignment,
+			size_t& arena_size) const;
+
 		void drop_actions_not_required_to_do(const std::set<layer_name_with_action>& target_action_set);
 
 	private:
@@ -143,6 +162,13 @@ namespace nnforge
 			const std::pair<action_schema_graph::vertex_descriptor, std::pair<double, float> >& t1,
 			const std::pair<action_schema_graph::vertex_descriptor, std::pair<double, float> >& t2);
 
+		static std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > > get_buffer_weights(const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, size_t> > >& buffers);
+
+		// Larger sizes first
+		static bool compare_sizes(
+			const std::pair<size_t, unsigned int>& t1,
+			const std::pair<size_t, unsigned int>& t2);
+
 		template<class vertex>
 		struct record_all_edges : public boost::default_dfs_visitor
 		{
@@ -229,6 +255,21 @@ namespace nnforge
 			float buffer_size;
 		};
 
+		typedef boost::adjacency_list<
+			boost::vecS,
+			boost::vecS,
+			boost::undirectedS,
+			vertex_info_list_for_buffer_set> buffer_incompatibility_graph;
+
+		// Adds a vertex for each group of buffers sharing the storage and edges between the buffers which might be alive at the same time
+		// Pairs of an input and the output written in place of it have no edge, they are added to in_place_pairs when it is not null
+		void fill_buffer_incompatibility_graph(
+			const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > >& buffers,
+			const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies_and_overwrites,
+			const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& should_be_placed_into_the_same_buffers,
+			buffer_incompatibility_graph& incompatible_output_actions_with_lifetime,
+			std::set<std::pair<buffer_incompatibility_graph::vertex_descriptor, buffer_incompatibility_graph::vertex_descriptor> > * in_place_pairs = 0) const;
+
 	private:
 		static const unsigned int border_penwidth;
 		static const unsigned int arrow_penwidth;
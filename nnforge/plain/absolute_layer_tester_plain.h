@@ -49,6 +49,12 @@ namespace nnforge
 				layer::const_ptr layer_schema,
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
+
+			virtual bool is_channel_blocked_layout_supported(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
 		};
 	}
 }
@@ -0,0 +1,414 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "auto_tuner_plain.h"
+
+#include "channel_blocked_layout_plain.h"
+#include "cpu_dispatch_plain.h"
+
+#include <boost/chrono.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const unsigned int auto_tuner_plain::run_count = 3;
+
+		unsigned int auto_tuner_plain::get_tuning_entry_count(unsigned int entry_count)
+		{
+			if (entry_count == 0)
+				return 0;
+
+			unsigned int res = 1;
+			while (res <= entry_count / 2)
+				res *= 2;
+			return res;
+		}
+
+		std::string auto_tuner_plain::get_tester_algorithm(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int tuning_entry_count)
+		{
+			std::string res = plain_config->algorithm;
+			if (res.empty() && plain_config->tuning && (tuning_entry_count > 0))
+				plain_config->tuning->get_decision(get_key("forward", plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific, tuning_entry_count), res);
+			return res;
+		}
+
+		std::string auto_tuner_plain::get_updater_algorithm(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int tuning_entry_count)
+		{
+			std::string res = plain_config->algorithm;
+			if (res.empty() && plain_config->tuning && (tuning_entry_count > 0))
+				plain_config->tuning->get_decision(get_key(get_updater_pass_name(actions), plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific, tuning_entry_count), res);
+			return res;
+		}
+
+		bool auto_tuner_plain::tune_tester(
+			plain_running_configuration::const_ptr plain_config,
+			layer_tester_plain::const_ptr tester,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int tuning_entry_count,
+			debug_state::ptr debug)
+		{
+			if (!plain_config->tuning || !plain_config->tuning->is_tuning() || (tuning_entry_count == 0))
+				return false;
+
+			std::vector<std::string> candidates = tester->get_algorithm_candidates(plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific);
+			if (candidates.size() < 2)
+				return false;
+
+			std::string key = get_key("forward", plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific, tuning_entry_count);
+			if (is_tuned(plain_config, key, candidates))
+				return false;
+
+			// Candidates are timed with algorithm configurations, the decision is set for the winner only
+			std::vector<float> times;
+			for(std::vector<std::string>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+				times.push_back(time_tester(plain_config->get_algorithm_configuration(*it), tester, layer_schema, input_configuration_specific_list, output_configuration_specific, tuning_entry_count));
+
+			set_decision(plain_config, layer_schema, key, candidates, times, debug);
+			return true;
+		}
+
+		bool auto_tuner_plain::tune_updater(
+			plain_running_configuration::const_ptr plain_config,
+			layer_updater_plain::const_ptr updater,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const std::set<layer_action>& actions,
+			unsigned int tuning_entry_count,
+			debug_state::ptr debug)
+		{
+			if (!plain_config->tuning || !plain_config->tuning->is_tuning() || (tuning_entry_count == 0))
+				return false;
+
+			std::vector<std::string> candidates = updater->get_algorithm_candidates(actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific);
+			if (candidates.size() < 2)
+				return false;
+
+			std::string key = get_key(get_updater_pass_name(actions), plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific, tuning_entry_count);
+			if (is_tuned(plain_config, key, candidates))
+				return false;
+
+			// Candidates are timed with algorithm configurations, the decision is set for the winner only
+			std::vector<float> times;
+			for(std::vector<std::string>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+				times.push_back(time_updater(plain_config->get_algorithm_configuration(*it), updater, layer_schema, input_configuration_specific_list, output_configuration_specific, actions, tuning_entry_count));
+
+			set_decision(plain_config, layer_schema, key, candidates, times, debug);
+			return true;
+		}
+
+		std::string auto_tuner_plain::get_key(
+			const std::string& pass_name,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int tuning_entry_count)
+		{
+			std::stringstream res;
+			res << "plain " << pass_name << " " << layer_schema->get_type_name();
+
+			std::vector<std::string> parameter_strings = layer_schema->get_parameter_strings();
+			for(std::vector<std::string>::const_iterator it = parameter_strings.begin(); it != parameter_strings.end(); ++it)
+				res << ", " << *it;
+
+			std::vector<layer_configuration_specific> configs = input_configuration_specific_list;
+			configs.push_back(output_configuration_specific);
+			for(std::vector<layer_configuration_specific>::const_iterator it = configs.begin(); it != configs.end(); ++it)
+			{
+				res << ((it == configs.end() - 1) ? " -> " : " ") << it->feature_map_count;
+				for(std::vector<unsigned int>::const_iterator it2 = it->dimension_sizes.begin(); it2 != it->dimension_sizes.end(); ++it2)
+					res << "x" << *it2;
+			}
+
+			res << ", entries " << tuning_entry_count;
+			res << ", " << cpu_dispatch_plain::get_isa_name(plain_config->cpu_isa);
+			res << ", threads " << plain_config->total_openmp_thread_count;
+			if (plain_config->channel_block_size > 0)
+				res << ", block " << plain_config->channel_block_size;
+
+			return res.str();
+		}
+
+		std::string auto_tuner_plain::get_updater_pass_name(const std::set<layer_action>& actions)
+		{
+			std::string res = "training";
+			for(std::set<layer_action>::const_iterator it = actions.begin(); it != actions.end(); ++it)
+				res += ((it == actions.begin()) ? " " : "+") + it->str();
+
+			return res;
+		}
+
+		bool auto_tuner_plain::is_tuned(
+			plain_running_configuration::const_ptr plain_config,
+			const std::string& key,
+			const std::vector<std::string>& candidates)
+		{
+			std::string value;
+			if (!plain_config->tuning->get_decision(key, value))
+				return false;
+
+			return (std::find(candidates.begin(), candidates.end(), value) != candidates.end());
+		}
+
+		void auto_tuner_plain::set_decision(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::string& key,
+			const std::vector<std::string>& candidates,
+			const std::vector<float>& times,
+			debug_state::ptr debug)
+		{
+			unsigned int best_index = static_cast<unsigned int>(std::min_element(times.begin(), times.end()) - times.begin());
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "plain auto tuning " << layer_schema->instance_name << ":";
+				for(unsigned int i = 0; i < static_cast<unsigned int>(candidates.size()); ++i)
+					debug_str << ((i == 0) ? " " : ", ") << candidates[i] << " " << (boost::format("%|1$.3f|") % (times[i] * 1000.0F)).str() << " ms";
+				debug_str << ", " << candidates[best_index] << " chosen";
+				debug->output_message(debug_str.str().c_str());
+			}
+
+			plain_config->tuning->set_decision(key, candidates[best_index]);
+		}
+
+		float auto_tuner_plain::time_tester(
+			plain_running_configuration::const_ptr plain_config,
+			layer_tester_plain::const_ptr tester,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int tuning_entry_count)
+		{
+			layer_data::const_ptr data = tester->get_data(layer_schema->create_layer_data(), plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific);
+			layer_data_custom::const_ptr data_custom = layer_schema->create_layer_data_custom();
+
+			std::vector<plain_buffer::const_ptr> input_buffers;
+			for(std::vector<layer_configuration_specific>::const_iterator it = input_configuration_specific_list.begin(); it != input_configuration_specific_list.end(); ++it)
+				input_buffers.push_back(create_buffer(it->get_neuron_count() * tuning_entry_count * sizeof(float)));
+			plain_buffer::ptr output_buffer = create_buffer(output_configuration_specific.get_neuron_count() * tuning_entry_count * sizeof(float));
+			plain_buffer::ptr temporary_working_fixed_buffer = create_buffer(tester->get_temporary_working_fixed_buffer_size(
+				plain_config,
+				layer_schema,
+				input_configuration_specific_list,
+				output_configuration_specific));
+			plain_buffer::ptr temporary_working_per_entry_buffer = create_buffer(tester->get_temporary_working_per_entry_buffer_size(
+				plain_config,
+				layer_schema,
+				input_configuration_specific_list,
+				output_configuration_specific) * tuning_entry_count);
+
+			// Timed the same way forward_propagation_plain runs it, the contents of synthetic buffers don't matter
+			const unsigned int block_size = plain_config->channel_block_size;
+			bool channel_blocked = (block_size > 0) && tester->is_channel_blocked_layout_preferred() && channel_blocked_layout_plain::is_compatible(output_configuration_specific, block_size);
+			for(std::vector<layer_configuration_specific>::const_iterator it = input_configuration_specific_list.begin(); it != input_configuration_specific_list.end(); ++it)
+				channel_blocked = channel_blocked && channel_blocked_layout_plain::is_compatible(*it, block_size);
+			channel_blocked = channel_blocked && tester->is_channel_blocked_layout_supported(plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific);
+
+			float best_time = std::numeric_limits<float>::max();
+			for(unsigned int run_id = 0; run_id <= run_count; ++run_id)
+			{
+				boost::chrono::steady_clock::time_point start = boost::chrono::high_resolution_clock::now();
+				if (channel_blocked)
+					tester->run_forward_propagation_channel_blocked(
+						output_buffer,
+						input_buffers,
+						temporary_working_fixed_buffer,
+						temporary_working_per_entry_buffer,
+						plain_config,
+						layer_schema,
+						data,
+						data_custom,
+						input_configuration_specific_list,
+						output_configuration_specific,
+						tuning_entry_count);
+				else
+					tester->run_forward_propagation(
+						output_buffer,
+						input_buffers,
+						temporary_working_fixed_buffer,
+						temporary_working_per_entry_buffer,
+						plain_config,
+						layer_schema,
+						data,
+						data_custom,
+						input_configuration_specific_list,
+						output_configuration_specific,
+						tuning_entry_count);
+				boost::chrono::duration<float> sec = boost::chrono::high_resolution_clock::now() - start;
+				if (run_id > 0)
+					best_time = std::min(best_time, sec.count());
+			}
+
+			return best_time;
+		}
+
+		float auto_tuner_plain::time_updater(
+			plain_running_configuration::const_ptr plain_config,
+			layer_updater_plain::const_ptr updater,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const std::set<layer_action>& actions,
+			unsigned int tuning_entry_count)
+		{
+			layer_data::const_ptr data = layer_schema->create_layer_data();
+			layer_data::ptr gradient = layer_schema->create_layer_data();
+			layer_data_custom::const_ptr data_custom = layer_schema->create_layer_data_custom();
+
+			std::vector<plain_buffer::const_ptr> input_buffers;
+			std::vector<plain_buffer::ptr> input_errors_buffers;
+			for(std::vector<layer_configuration_specific>::const_iterator it = input_configuration_specific_list.begin(); it != input_configuration_specific_list.end(); ++it)
+			{
+				input_buffers.push_back(create_buffer(it->get_neuron_count() * tuning_entry_count * sizeof(float)));
+				input_errors_buffers.push_back(create_buffer(it->get_neuron_count() * tuning_entry_count * sizeof(float)));
+			}
+			plain_buffer::ptr output_buffer = create_buffer(output_configuration_specific.get_neuron_count() * tuning_entry_count * sizeof(float));
+			plain_buffer::ptr output_errors_buffer = create_buffer(output_configuration_specific.get_neuron_count() * tuning_entry_count * sizeof(float));
+			plain_buffer::ptr temporary_per_entry_buffer = create_buffer(updater->get_temporary_per_entry_buffer_size(
+				actions,
+				plain_config,
+				layer_schema,
+				input_configuration_specific_list,
+				output_configuration_specific) * tuning_entry_count);
+
+			// Working buffers are shared by all the actions
+			size_t temporary_working_fixed_size = 0;
+			size_t temporary_working_per_entry_size = 0;
+			for(std::set<layer_action>::const_iterator it = actions.begin(); it != actions.end(); ++it)
+			{
+				temporary_working_fixed_size = std::max(temporary_working_fixed_size, updater->get_temporary_working_fixed_buffer_size(
+					*it,
+					actions,
+					plain_config,
+					layer_schema,
+					input_configuration_specific_list,
+					output_configuration_specific));
+				temporary_working_per_entry_size = std::max(temporary_working_per_entry_size, updater->get_temporary_working_per_entry_buffer_size(
+					*it,
+					actions,
+					plain_config,
+					layer_schema,
+					input_configuration_specific_list,
+					output_configuration_specific));
+			}
+			plain_buffer::ptr temporary_working_fixed_buffer = create_buffer(temporary_working_fixed_size);
+			plain_buffer::ptr temporary_working_per_entry_buffer = create_buffer(temporary_working_per_entry_size * tuning_entry_count);
+
+			float best_time = std::numeric_limits<float>::max();
+			for(unsigned int run_id = 0; run_id <= run_count; ++run_id)
+			{
+				boost::chrono::steady_clock::time_point start = boost::chrono::high_resolution_clock::now();
+				for(std::set<layer_action>::const_iterator it = actions.begin(); it != actions.end(); ++it)
+				{
+					switch (it->get_action_type())
+					{
+					case layer_action::forward:
+						updater->run_forward_propagation(
+							output_buffer,
+							input_buffers,
+							temporary_working_fixed_buffer,
+							temporary_working_per_entry_buffer,
+							temporary_per_entry_buffer,
+							plain_config,
+							layer_schema,
+							data,
+							data_custom,
+							input_configuration_specific_list,
+							output_configuration_specific,
+							actions,
+							tuning_entry_count);
+						break;
+					case layer_action::backward_data:
+						updater->run_backward_data_propagation(
+							it->get_backprop_index(),
+							input_errors_buffers[it->get_backprop_index()],
+							output_errors_buffer,
+							input_buffers,
+							output_buffer,
+							temporary_working_fixed_buffer,
+							temporary_working_per_entry_buffer,
+							temporary_per_entry_buffer,
+							plain_config,
+							layer_schema,
+							data,
+							data_custom,
+							input_configuration_specific_list,
+							output_configuration_specific,
+							false,
+							actions,
+							tuning_entry_count);
+						break;
+					case layer_action::backward_weights:
+						updater->run_backward_weights_propagation(
+							input_buffers,
+							output_errors_buffer,
+							temporary_working_fixed_buffer,
+							temporary_working_per_entry_buffer,
+							temporary_per_entry_buffer,
+							plain_config,
+							layer_schema,
+							gradient,
+							data_custom,
+							input_configuration_specific_list,
+							output_configuration_specific,
+							actions,
+							tuning_entry_count);
+						break;
+					default:
+						break;
+					}
+				}
+				boost::chrono::duration<float> sec = boost::chrono::high_resolution_clock::now() - start;
+				if (run_id > 0)
+					best_time = std::min(best_time, sec.count());
+			}
+
+			return best_time;
+		}
+
+		plain_buffer::ptr auto_tuner_plain::create_buffer(size_t size)
+		{
+			if (size == 0)
+				return plain_buffer::ptr();
+
+			plain_buffer::ptr res(new plain_buffer(size));
+			memset(static_cast<void *>(*res), 0, size);
+			return res;
+		}
+	}
+}
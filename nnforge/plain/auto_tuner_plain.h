@@ -0,0 +1,143 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "layer_tester_plain.h"
+#include "layer_updater_plain.h"
+#include "plain_running_configuration.h"
+#include "../debug_state.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Chooses the fastest of the algorithms a tester or an updater reports as candidates by running each of them
+		// on synthetic data of the tuning entry count the propagation runs chunks with. Decisions are keyed with layer type, parameters,
+		// configurations, actions of the updater, tuning entry count, instruction set and thread count, they are stored in plain_config->tuning
+		// and reused by later runs
+		class auto_tuner_plain
+		{
+		public:
+			// Entry counts are bucketed by powers of two, the largest one not exceeding entry_count is returned;
+			// chunks of the same bucket share decisions. Returns 0 for 0, which stands for the entry count not known yet
+			static unsigned int get_tuning_entry_count(unsigned int entry_count);
+
+			// Returns the algorithm of the configuration when set, the decision otherwise, empty string when there is no decision
+			// or tuning_entry_count is 0. The key is built and the decisions are locked on each call, so it is resolved once when the layer is set up
+			static std::string get_tester_algorithm(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int tuning_entry_count);
+
+			// Returns the algorithm of the configuration when set, the decision for the set of actions otherwise, empty string when there is no decision
+			// or tuning_entry_count is 0. The key is built and the decisions are locked on each call, so it is resolved once when the layer is set up
+			static std::string get_updater_algorithm(
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int tuning_entry_count);
+
+			// Does nothing when tuning is off, tuning_entry_count is 0 or the decision is already made.
+			// Returns true when a new decision is made, the caller should save the tuning state once all the layers are tuned
+			static bool tune_tester(
+				plain_running_configuration::const_ptr plain_config,
+				layer_tester_plain::const_ptr tester,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int tuning_entry_count,
+				debug_state::ptr debug);
+
+			// Does nothing when tuning is off, tuning_entry_count is 0 or the decision is already made.
+			// Returns true when a new decision is made, the caller should save the tuning state once all the layers are tuned
+			static bool tune_updater(
+				plain_running_configuration::const_ptr plain_config,
+				layer_updater_plain::const_ptr updater,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				const std::set<layer_action>& actions,
+				unsigned int tuning_entry_count,
+				debug_state::ptr debug);
+
+		private:
+			static std::string get_key(
+				const std::string& pass_name,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int tuning_entry_count);
+
+			// Updaters doing different actions for the same layer are tuned separately
+			static std::string get_updater_pass_name(const std::set<layer_action>& actions);
+
+			// Returns true when the decision cached is one of the candidates
+			static bool is_tuned(
+				plain_running_configuration::const_ptr plain_config,
+				const std::string& key,
+				const std::vector<std::string>& candidates);
+
+			// Timings of the candidates are reported to debug
+			static void set_decision(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::string& key,
+				const std::vector<std::string>& candidates,
+				const std::vector<float>& times,
+				debug_state::ptr debug);
+
+			// Returns the best time of run_count runs, in seconds
+			static float time_tester(
+				plain_running_configuration::const_ptr plain_config,
+				layer_tester_plain::const_ptr tester,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int tuning_entry_count);
+
+			// Returns the best time of run_count runs, in seconds
+			static float time_updater(
+				plain_running_configuration::const_ptr plain_config,
+				layer_updater_plain::const_ptr updater,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				const std::set<layer_action>& actions,
+				unsigned int tuning_entry_count);
+
+			// Returns zero initialized buffer or null pointer when size is 0
+			static plain_buffer::ptr create_buffer(size_t size);
+
+		private:
+			// Measured runs, each candidate is run once more before them to warm up caches
+			static const unsigned int run_count;
+
+		private:
+			auto_tuner_plain();
+			~auto_tuner_plain();
+		};
+	}
+}
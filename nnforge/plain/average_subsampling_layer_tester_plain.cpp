@@ -16,6 +16,7 @@
 
 #include "average_subsampling_layer_tester_plain.h"
 
+#include "spatial_split_plain.h"
 #include "../average_subsampling_layer.h"
 #include "../nn_types.h"
 
@@ -109,7 +110,12 @@ namespace nnforge
 				}
 			}
 
-			const int total_workload = entry_count * output_configuration_specific.feature_map_count;
+			const unsigned int spatial_split_count = spatial_split_plain::get_split_count(
+				*plain_config,
+				entry_count * output_feature_map_count,
+				output_neuron_count_per_feature_map,
+				const_subsampling_elem_count);
+			const int total_workload = entry_count * output_configuration_specific.feature_map_count * spatial_split_count;
 			const std::vector<unsigned int>::const_iterator dimension_sizes_it = output_dimension_sizes.begin();
 			const std::vector<unsigned int>::const_iterator subsampling_sizes_it = subsampling_sizes.begin();
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
@@ -122,14 +128,24 @@ namespace nnforge
 				#pragma omp for schedule(guided)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
-					int output_entry_id = workload_id / output_feature_map_count;
-					int output_feature_map_id = workload_id - (output_entry_id * output_feature_map_count);
+					int feature_map_workload_id = workload_id / spatial_split_count;
+					int spatial_split_id = workload_id - (feature_map_workload_id * spatial_split_count);
+					int output_entry_id = feature_map_workload_id / output_feature_map_count;
+					int output_feature_map_id = feature_map_workload_id - (output_entry_id * output_feature_map_count);
+					unsigned int output_neuron_start;
+					unsigned int output_neuron_end;
+					spatial_split_plain::get_range(output_neuron_count_per_feature_map, spatial_split_count, spatial_split_id, output_neuron_start, output_neuron_end);
 
 					const float * in_it_base = in_it_global + (output_entry_id * entry_subsampling_size * input_neuron_count) + (output_feature_map_id * feature_map_subsampling_size * input_neuron_count_per_feature_map);
 					float * out_it_base = out_it_global + (output_entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
 
-					std::fill_n(current_output_position.begin(), spatial_dimension_count, 0);
-					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; ++out_it)
+					unsigned int remaining_output_neuron_id = output_neuron_start;
+					for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+					{
+						current_output_position[i] = remaining_output_neuron_id % *(dimension_sizes_it + i);
+						remaining_output_neuron_id /= *(dimension_sizes_it + i);
+					}
+					for(float * out_it = out_it_base + output_neuron_start; out_it != out_it_base + output_neuron_end; ++out_it)
 					{
 						// Define the starting position of the first input elem
 						int in_it_offset = 0;
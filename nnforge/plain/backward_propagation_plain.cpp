@@ -17,12 +17,22 @@
 #include "backward_propagation_plain.h"
 
 #include "layer_updater_plain_factory.h"
+#include "auto_tuner_plain.h"
+#include "weights_update_plain.h"
+#include "chunk_pipeline_plain.h"
+#include "numa_plain.h"
+#include "softmax_negative_log_likelihood_layer_updater_plain.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/chrono.hpp>
+#include <cmath>
+#include <algorithm>
 
 #include "../neural_network_exception.h"
+#include "../softmax_layer.h"
+#include "../negative_log_likelihood_layer.h"
 
 namespace nnforge
 {
@@ -38,52 +48,43 @@ namespace nnforge
 			plain_running_configuration::const_ptr plain_config)
 			: backward_propagation(schema, output_layer_names, error_source_layer_names, exclude_data_update_layer_names, debug, profile)
 			, plain_config(plain_config)
+			, tuning_entry_count(0)
 			, temporary_working_fixed_size(0)
+			, arena(plain_config->huge_pages)
 		{
 			actions_in_execution_order = action_schema->get_actions_in_execution_order();
-
 			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
-			{
-				if (it->get_action().get_action_type() != layer_action::backward_data)
-					continue;
-				layer::const_ptr l = this->schema->get_layer(it->get_name());
-				const std::string& previous_layer_name = l->input_layer_instance_names[it->get_action().get_backprop_index()];
-				input_to_all_output_map.insert(std::make_pair(previous_layer_name, std::vector<layer_name_with_action>())).first->second.push_back(*it);
-			}
+				action_to_dependencies_map.insert(std::make_pair(*it, action_schema->get_dependencies(*it)));
 
-			// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
-			network_action_schema::ptr sequential_action_schema(new network_action_schema());
+			setup_fused_softmax_loss_layers();
+
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
 			{
-				std::vector<layer_name_with_action> dependencies;
-				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				if (it->get_action().get_action_type() == layer_action::backward_data)
 				{
-					sequential_action_schema->add_action(
-						this->schema->get_layer(it->get_name()),
-						it->get_action(),
-						dependencies);
-					dependencies.clear();
-					dependencies.push_back(*it);
+					layer::const_ptr l = this->schema->get_layer(it->get_name());
+					std::string previous_layer_name = l->input_layer_instance_names[it->get_action().get_backprop_index()];
+					// Fused loss layer writes errors for the input of the softmax layer
+					if (fused_softmax_loss_layer_names.find(l->instance_name) != fused_softmax_loss_layer_names.end())
+						previous_layer_name = this->schema->get_layer(previous_layer_name)->input_layer_instance_names[0];
+					input_to_all_output_map.insert(std::make_pair(previous_layer_name, std::vector<layer_name_with_action>())).first->second.push_back(*it);
+				}
+				else if (it->get_action().get_action_type() == layer_action::backward_data_and_weights)
+				{
+					layer::const_ptr l = this->schema->get_layer(it->get_name());
+					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					{
+						const std::string& previous_layer_name = *it2;
+						input_to_all_output_map.insert(std::make_pair(previous_layer_name, std::vector<layer_name_with_action>())).first->second.push_back(*it);
+					}
 				}
 			}
-			action_schema = sequential_action_schema;
 
-			if (debug->is_debug())
-			{
-				boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
-				action_schema->write_gv(out);
-			}
+			actions_with_recompute_in_execution_order = actions_in_execution_order;
+			setup_sequential_action_schema();
 
-			std::set<std::string> action_layer_names;
 			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
-			{
-				action_layer_names.insert(it->get_name());
 				layer_name_to_action_set_map.insert(std::make_pair(it->get_name(), std::set<layer_action>())).first->second.insert(it->get_action());
-			}
-			for(std::set<std::string> ::const_iterator it = action_layer_names.begin(); it != action_layer_names.end(); ++it)
-				updaters.insert(
-					std::make_pair(
-						*it,
-						layer_updater_plain_factory::singleton::get_const_instance().get_updater_plain_layer(this->schema->get_layer(*it)->get_type_name())));
 		}
 
 		backward_propagation_plain::~backward_propagation_plain()
@@ -119,7 +120,30 @@ namespace nnforge
 				layer_list.push_back(schema->get_layer(*it));
 			layer_data_list::ptr gradient(new layer_data_list(layer_list, 0.0F));
 
-			buffer_plain_size_configuration buffer_configuration = buffer_config_without_data_and_momentum;
+			// Weights update metadata is resolved once per run
+			std::map<std::string, weights_update_plain::ptr> weights_updates;
+			for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
+			{
+				const std::string& layer_name = *it;
+				layer_data::ptr previous_upd;
+				if (momentum.is_momentum_data())
+					previous_upd = momentum_data->data_list.find(layer_name);
+				layer_data::ptr previous_upd2;
+				if (momentum.is_momentum_data2())
+					previous_upd2 = momentum_data2->data_list.find(layer_name);
+				weights_updates.insert(std::make_pair(layer_name, weights_update_plain::ptr(new weights_update_plain(
+					data.data_list.find(layer_name),
+					gradient->find(layer_name),
+					previous_upd,
+					previous_upd2,
+					learning_rates.find(layer_name)->second,
+					schema->get_layer(layer_name)->get_weight_decay_part_id_set(),
+					weight_decay,
+					momentum))));
+			}
+
+			// Data, gradient and momentum buffers, the rest are sized by the setup
+			buffer_plain_size_configuration data_buffer_configuration;
 			{
 				for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
 				{
@@ -127,12 +151,12 @@ namespace nnforge
 					layer_data::ptr d = data.data_list.get(layer_name);
 					for(layer_data::const_iterator it2 = d->begin(); it2 != d->end(); ++it2)
 					{
-						buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // data
-						buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // gradient
+						data_buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // data
+						data_buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // gradient
 						if (momentum.is_momentum_data())
-							buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // momentum
+							data_buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // momentum
 						if (momentum.is_momentum_data2())
-							buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // 2nd momentum
+							data_buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // 2nd momentum
 					}
 				}
 				std::vector<std::string> data_custom_layer_list = data.data_custom_list.get_data_custom_layer_name_list();
@@ -141,62 +165,92 @@ namespace nnforge
 					const std::string& layer_name = *it;
 					layer_data_custom::ptr d = data.data_custom_list.get(layer_name);
 					for(layer_data_custom::const_iterator it2 = d->begin(); it2 != d->end(); ++it2)
-						buffer_configuration.add_constant_buffer(it2->size() * sizeof(int));
+						data_buffer_configuration.add_constant_buffer(it2->size() * sizeof(int));
 				}
 				for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
-					buffer_configuration.add_constant_buffer(it->second.size() * sizeof(double));
+					data_buffer_configuration.add_constant_buffer(it->second.size() * sizeof(double));
 			}
 
-			unsigned int max_entry_count = plain_config->get_max_entry_count(buffer_configuration);
+			std::vector<unsigned int> entry_read_count_list = get_entry_read_count_list(batch_size, data_buffer_configuration);
 
-			if (debug->is_debug())
+			// Algorithms are tuned for the largest chunk, the setup is redone when it falls into another bucket
+			if (plain_config->tuning && plain_config->tuning->is_tuning())
 			{
-				std::stringstream debug_str;
-				debug_str << "backward prop plain max packet size: " << max_entry_count;
-				debug->output_message(debug_str.str().c_str());
+				unsigned int new_tuning_entry_count = auto_tuner_plain::get_tuning_entry_count(*std::max_element(entry_read_count_list.begin(), entry_read_count_list.end()));
+				if (new_tuning_entry_count != tuning_entry_count)
+				{
+					tuning_entry_count = new_tuning_entry_count;
+					layer_config_map_modified();
+					entry_read_count_list = get_entry_read_count_list(batch_size, data_buffer_configuration);
+				}
 			}
 
-			if (max_entry_count == 0)
-				throw neural_network_exception("Insufficient memory to do forward-backward prop for even one sample");
+			unsigned int max_chunk_size = *std::max_element(entry_read_count_list.begin(), entry_read_count_list.end());
 
-			std::vector<unsigned int> entry_read_count_list;
-			if (batch_size <= max_entry_count)
-				entry_read_count_list.push_back(batch_size);
-			else
+			bool new_arena_block;
 			{
-				unsigned int chunk_count = (batch_size + max_entry_count - 1) / max_entry_count;
-				unsigned int chunk_min_size = batch_size / chunk_count;
-				unsigned int plus1_chunk_count = batch_size % chunk_count;
-				entry_read_count_list.resize(chunk_count);
-				std::fill_n(entry_read_count_list.begin(), plus1_chunk_count, chunk_min_size + 1);
-				std::fill_n(entry_read_count_list.begin() + plus1_chunk_count, chunk_count - plus1_chunk_count, chunk_min_size);
-
-				if (debug->is_debug())
-				{
-					std::stringstream debug_str;
-					debug_str << "Batch " << batch_size << " is split into multiple chunks: ";
-					for(std::vector<unsigned int>::const_iterator it = entry_read_count_list.begin(); it != entry_read_count_list.end(); ++it)
-					{
-						if (it != entry_read_count_list.begin())
-							debug_str << ", ";
-						debug_str << *it;
-					}
-					debug->output_message(debug_str.str().c_str());
-				}
+				size_t arena_size = chunk_pipeline_plain::get_arena_size(dedicated_per_entry_data_name_to_size_map, max_chunk_size);
+				if (temporary_working_fixed_size > 0)
+					arena_size += buffer_arena_plain::get_aligned_size(temporary_working_fixed_size);
+				arena_size += buffer_arena_plain::get_slots_size(layer_buffer_set_per_entry_size_list, layer_buffer_set_per_entry_offset_list, layer_buffers_per_entry_size, max_chunk_size);
+				new_arena_block = arena.begin_run(arena_size);
 			}
-			unsigned int max_chunk_size = *std::max_element(entry_read_count_list.begin(), entry_read_count_list.end());
 
+			// Dedicated buffers are owned by the pipeline, the map is updated for each chunk
 			std::map<std::string, plain_buffer::ptr> dedicated_buffers;
-			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
-				dedicated_buffers.insert(std::make_pair(it->first, plain_buffer::ptr(new plain_buffer(it->second * max_chunk_size))));
+			chunk_pipeline_plain pipeline(
+				reader,
+				writer,
+				dedicated_per_entry_data_name_to_size_map,
+				data_layer_names,
+				output_layer_names,
+				output_layers_tiling_factor,
+				entry_read_count_list,
+				plain_config->reader_thread_count,
+				arena);
+
+			// Compute threads are bound once the reader and the writer are started, so these keep the CPUs of the caller
+			thread_binding_guard_plain caller_binding_guard;
+			plain_config->bind_openmp_threads();
 
 			plain_buffer::ptr temporary_working_fixed_buffer;
 			if (temporary_working_fixed_size > 0)
-				temporary_working_fixed_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_size));
+				temporary_working_fixed_buffer = arena.allocate(temporary_working_fixed_size);
+
+			// Layer buffers are followed by dedicated ones, the latter are updated for each chunk
+			std::vector<plain_buffer::ptr> buffer_slots = arena.allocate_slots(layer_buffer_set_per_entry_size_list, layer_buffer_set_per_entry_offset_list, layer_buffers_per_entry_size, max_chunk_size);
+			buffer_slots.resize(layer_buffer_set_per_entry_size_list.size() + dedicated_per_entry_data_name_to_size_map.size());
+
+			// Pages are placed on the nodes of the threads which will work on them
+			if (new_arena_block && plain_config->is_first_touch_required())
+				for(unsigned int slot_id = 0; slot_id < static_cast<unsigned int>(layer_buffer_set_per_entry_size_list.size()); ++slot_id)
+					numa_plain::first_touch(*buffer_slots[slot_id], buffer_slots[slot_id]->get_size(), plain_config->openmp_thread_count);
+
+			// Data is resolved once per run
+			std::vector<layer_data::ptr> step_data_list(steps.size());
+			std::vector<layer_data_custom::ptr> step_data_custom_list(steps.size());
+			std::vector<layer_data::ptr> step_gradient_list(steps.size());
+			std::vector<weights_update_plain *> step_weights_update_list(steps.size());
+			std::vector<std::vector<double> *> step_updates_accumulated_list(steps.size());
+			for(unsigned int step_id = 0; step_id < static_cast<unsigned int>(steps.size()); ++step_id)
+			{
+				const std::string& layer_name = steps[step_id].layer_schema->instance_name;
+				step_data_list[step_id] = data.data_list.find(layer_name);
+				step_data_custom_list[step_id] = data.data_custom_list.find(layer_name);
+				step_gradient_list[step_id] = gradient->find(layer_name);
+				if (steps[step_id].action.get_action_type() == layer_action::update_weights)
+				{
+					step_weights_update_list[step_id] = weights_updates[layer_name].get();
+					step_updates_accumulated_list[step_id] = &updates_accumulated[layer_name];
+				}
+			}
 
-			std::vector<plain_buffer::ptr> layer_buffers;
-			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
-				layer_buffers.push_back(plain_buffer::ptr(new plain_buffer(*it * max_chunk_size)));
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain buffer arena: " << ((arena.get_size() + 1024 - 1) / 1024) << " KB, high-water mark " << ((arena.get_high_water_mark() + 1024 - 1) / 1024) << " KB";
+				debug->output_message(debug_str.str().c_str());
+			}
 
 			unsigned int base_iteration_count = 0;
 			if (momentum.type == training_momentum::adam_momentum)
@@ -208,31 +262,18 @@ namespace nnforge
 					throw neural_network_exception("Training data reader doesn't report entry_count, which is required for ADAM momentum");
 			}
 
+			// Accumulated over all the chunks, empty when not profiling
+			std::vector<double> step_seconds;
+			if (profile->is_profile())
+				step_seconds.resize(steps.size(), 0.0);
+
 			unsigned int entry_processed_count = 0;
-			unsigned int chunk_index = 0;
 			unsigned int gradient_accumulated_entry_count = 0;
 			unsigned int gradient_applied_count = 0;
 
-			while(true)
+			unsigned int entry_read_count;
+			while(pipeline.get_next_chunk(dedicated_buffers, entry_read_count))
 			{
-				const int current_max_entry_count_const = entry_read_count_list[chunk_index];
-				int entry_read_count = 0;
-				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count) reduction(+:entry_read_count)
-				{
-					#pragma omp for schedule(dynamic)
-					for(int entry_id = 0; entry_id < current_max_entry_count_const; ++entry_id)
-					{
-						std::map<std::string, float *> data_map;
-						for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
-							data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float))));
-						if (reader.read(entry_processed_count + entry_id, data_map))
-							++entry_read_count;
-					}
-				}
-
-				if (entry_read_count == 0)
-					break;
-
 				gradient_accumulated_entry_count += entry_read_count;
 				bool is_apply_gradient = false;
 				float gradient_normalizer;
@@ -244,236 +285,142 @@ namespace nnforge
 					gradient_applied_count++;
 				}
 
-				for(std::vector<layer_name_with_action>::const_iterator action_it = actions_in_execution_order.begin(); action_it  != actions_in_execution_order.end(); ++action_it)
 				{
-					const layer_name_with_action& current_layer_name_with_action = *action_it;
-					std::string layer_name = current_layer_name_with_action.get_name();;
-					layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
-					layer::const_ptr l = schema->get_layer(layer_name);
-					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
-					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
-						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
-					layer_action action = current_layer_name_with_action.get_action();
-					layer::const_ptr current_layer = schema->find_layer(layer_name);
-					const std::set<layer_action>& actions = layer_name_to_action_set_map[layer_name];
-					unsigned int tiling_factor = cumulative_tiling_factor_map[layer_name];
+					// Both dedicated buffers and slots are ordered by layer name
+					std::vector<plain_buffer::ptr>::iterator slot_it = buffer_slots.begin() + layer_buffer_set_per_entry_size_list.size();
+					for(std::map<std::string, plain_buffer::ptr>::const_iterator it = dedicated_buffers.begin(); it != dedicated_buffers.end(); ++it, ++slot_it)
+						*slot_it = it->second;
+				}
 
+				for(unsigned int step_id = 0; step_id < static_cast<unsigned int>(steps.size()); ++step_id)
+				{
+					const step& current_step = steps[step_id];
+					const unsigned int current_entry_count = entry_read_count * current_step.tiling_factor;
+
+					boost::chrono::steady_clock::time_point start;
+					if (!step_seconds.empty())
+						start = boost::chrono::high_resolution_clock::now();
+
+					std::vector<plain_buffer::const_ptr> input_neurons_buffers(current_step.input_buffer_slots.size());
+					for(unsigned int i = 0; i < static_cast<unsigned int>(input_neurons_buffers.size()); ++i)
+						if (current_step.input_buffer_slots[i] >= 0)
+							input_neurons_buffers[i] = buffer_slots[current_step.input_buffer_slots[i]];
+					plain_buffer::ptr output_buffer;
+					if (current_step.output_buffer_slot >= 0)
+						output_buffer = buffer_slots[current_step.output_buffer_slot];
 					plain_buffer::ptr temporary_working_per_entry_buffer;
-					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_working_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
-						if (it != temporary_working_per_entry_data_action_to_set_map.end())
-							temporary_working_per_entry_buffer = layer_buffers[it->second];
-					}
-
-					switch (action.get_action_type())
+					if (current_step.temporary_working_per_entry_buffer_slot >= 0)
+						temporary_working_per_entry_buffer = buffer_slots[current_step.temporary_working_per_entry_buffer_slot];
+					plain_buffer::ptr temporary_per_entry_buffer;
+					if (current_step.temporary_per_entry_buffer_slot >= 0)
+						temporary_per_entry_buffer = buffer_slots[current_step.temporary_per_entry_buffer_slot];
+					plain_buffer::const_ptr output_neurons_buffer;
+					if (current_step.output_neurons_buffer_slot >= 0)
+						output_neurons_buffer = buffer_slots[current_step.output_neurons_buffer_slot];
+					plain_buffer::const_ptr output_errors_buffer;
+					if (current_step.output_errors_buffer_slot >= 0)
+						output_errors_buffer = buffer_slots[current_step.output_errors_buffer_slot];
+
+					switch (current_step.action.get_action_type())
 					{
 					case layer_action::forward:
-						{
-							plain_buffer::ptr output_buffer;
-							{
-								std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(current_layer_name_with_action);
-								if (it != layer_buffer_action_to_set_map.end())
-									output_buffer = layer_buffers[it->second];
-								else
-									output_buffer = dedicated_buffers.find(layer_name)->second;
-							}
-
-							std::vector<plain_buffer::const_ptr> input_buffers;
-							for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it)
-							{
-								std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
-								if (it != layer_buffer_action_to_set_map.end())
-									input_buffers.push_back(layer_buffers[it->second]);
-								else
-									input_buffers.push_back(dedicated_buffers.find(*input_layer_name_it)->second);
-							}
-
-							plain_buffer::ptr temporary_per_entry_buffer;
-							{
-								std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
-								if (it != temporary_per_entry_data_action_to_set_map.end())
-									temporary_per_entry_buffer = layer_buffers[it->second];
-							}
-
-							updaters.find(layer_name)->second->run_forward_propagation(
-								output_buffer,
-								input_buffers,
-								temporary_working_fixed_buffer,
-								temporary_working_per_entry_buffer,
-								temporary_per_entry_buffer,
-								plain_config,
-								current_layer,
-								data.data_list.find(layer_name),
-								data.data_custom_list.find(layer_name),
-								input_layer_configuration_specific_list,
-								output_layer_configuration_specific,
-								actions,
-								entry_read_count * tiling_factor);
-						}
+					case layer_action::recompute:
+						current_step.updater->run_forward_propagation(
+							output_buffer,
+							input_neurons_buffers,
+							temporary_working_fixed_buffer,
+							temporary_working_per_entry_buffer,
+							temporary_per_entry_buffer,
+							current_step.plain_config,
+							current_step.layer_schema,
+							step_data_list[step_id],
+							step_data_custom_list[step_id],
+							current_step.input_configuration_specific_list,
+							current_step.output_configuration_specific,
+							*current_step.actions,
+							current_entry_count);
 						break;
 					case layer_action::backward_data:
-						{
-							plain_buffer::ptr output_buffer = layer_buffers[layer_buffer_action_to_set_map[current_layer_name_with_action]];
-
-							std::vector<plain_buffer::const_ptr> input_neurons_buffers;
-							unsigned int data_input_index = 0;
-							for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it, ++data_input_index)
-							{
-								if (updaters[layer_name]->is_backward_data_dependent_on_input_buffer(action.get_backprop_index(), data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
-									if (it != layer_buffer_action_to_set_map.end())
-										input_neurons_buffers.push_back(layer_buffers[it->second]);
-									else
-										input_neurons_buffers.push_back(dedicated_buffers[*input_layer_name_it]);
-								}
-								else
-									input_neurons_buffers.push_back(plain_buffer::const_ptr());
-							}
-
-							plain_buffer::ptr temporary_per_entry_buffer;
-							{
-								if (updaters[layer_name]->is_backward_data_dependent_on_temporary_per_entry_buffer(action.get_backprop_index(), actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
-									if (it != temporary_per_entry_data_action_to_set_map.end())
-										temporary_per_entry_buffer = layer_buffers[it->second];
-								}
-							}
-
-							plain_buffer::const_ptr output_neurons_buffer;
-							{
-								if (updaters[layer_name]->is_backward_data_dependent_on_output_buffer(action.get_backprop_index(), actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
-									if (it != layer_buffer_action_to_set_map.end())
-										output_neurons_buffer = layer_buffers[it->second];
-									else
-										output_neurons_buffer = dedicated_buffers[layer_name];
-								}
-							}
-
-							plain_buffer::const_ptr output_errors_buffer;
-							{
-								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator it = input_to_all_output_map.find(layer_name);
-								if (it != input_to_all_output_map.end())
-									output_errors_buffer = layer_buffers[layer_buffer_action_to_set_map[it->second.front()]];
-							}
-
-							updaters.find(layer_name)->second->run_backward_data_propagation(
-								action.get_backprop_index(),
-								output_buffer,
-								output_errors_buffer,
-								input_neurons_buffers,
-								output_neurons_buffer,
-								temporary_working_fixed_buffer,
-								temporary_working_per_entry_buffer,
-								temporary_per_entry_buffer,
-								plain_config,
-								current_layer,
-								data.data_list.find(layer_name),
-								data.data_custom_list.find(layer_name),
-								input_layer_configuration_specific_list,
-								output_layer_configuration_specific,
-								add_output_actions.find(current_layer_name_with_action) != add_output_actions.end(),
-								actions,
-								entry_read_count * tiling_factor);
-						}
+						current_step.updater->run_backward_data_propagation(
+							current_step.action.get_backprop_index(),
+							output_buffer,
+							output_errors_buffer,
+							input_neurons_buffers,
+							output_neurons_buffer,
+							temporary_working_fixed_buffer,
+							temporary_working_per_entry_buffer,
+							temporary_per_entry_buffer,
+							current_step.plain_config,
+							current_step.layer_schema,
+							step_data_list[step_id],
+							step_data_custom_list[step_id],
+							current_step.input_configuration_specific_list,
+							current_step.output_configuration_specific,
+							current_step.add_output,
+							*current_step.actions,
+							current_entry_count);
 						break;
 					case layer_action::backward_weights:
-						{
-							std::vector<plain_buffer::const_ptr> input_neurons_buffers;
-							unsigned int data_input_index = 0;
-							for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it, ++data_input_index)
-							{
-								if (updaters[layer_name]->is_backward_weights_dependent_on_input_buffer(data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
-									if (it != layer_buffer_action_to_set_map.end())
-										input_neurons_buffers.push_back(layer_buffers[it->second]);
-									else
-										input_neurons_buffers.push_back(dedicated_buffers[*input_layer_name_it]);
-								}
-								else
-									input_neurons_buffers.push_back(plain_buffer::const_ptr());
-							}
-
-							plain_buffer::ptr temporary_per_entry_buffer;
-							{
-								if (updaters[layer_name]->is_backward_weights_dependent_on_temporary_per_entry_buffer(actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
-									if (it != temporary_per_entry_data_action_to_set_map.end())
-										temporary_per_entry_buffer = layer_buffers[it->second];
-								}
-							}
-
-							plain_buffer::const_ptr output_errors_buffer;
-							{
-								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator it = input_to_all_output_map.find(layer_name);
-								if (it != input_to_all_output_map.end())
-									output_errors_buffer = layer_buffers[layer_buffer_action_to_set_map[it->second.front()]];
-							}
-
-							updaters.find(layer_name)->second->run_backward_weights_propagation(
-								input_neurons_buffers,
-								output_errors_buffer,
-								temporary_working_fixed_buffer,
-								temporary_working_per_entry_buffer,
-								temporary_per_entry_buffer,
-								plain_config,
-								current_layer,
-								gradient->find(layer_name),
-								data.data_custom_list.find(layer_name),
-								input_layer_configuration_specific_list,
-								output_layer_configuration_specific,
-								actions,
-								entry_read_count * tiling_factor);
-						}
+						current_step.updater->run_backward_weights_propagation(
+							input_neurons_buffers,
+							output_errors_buffer,
+							temporary_working_fixed_buffer,
+							temporary_working_per_entry_buffer,
+							temporary_per_entry_buffer,
+							current_step.plain_config,
+							current_step.layer_schema,
+							step_gradient_list[step_id],
+							step_data_custom_list[step_id],
+							current_step.input_configuration_specific_list,
+							current_step.output_configuration_specific,
+							*current_step.actions,
+							current_entry_count);
+						break;
+					case layer_action::backward_data_and_weights:
+						current_step.updater->run_backward_data_and_weights_propagation(
+							output_buffer,
+							output_errors_buffer,
+							input_neurons_buffers,
+							output_neurons_buffer,
+							temporary_working_fixed_buffer,
+							temporary_working_per_entry_buffer,
+							temporary_per_entry_buffer,
+							current_step.plain_config,
+							current_step.layer_schema,
+							step_data_list[step_id],
+							step_gradient_list[step_id],
+							step_data_custom_list[step_id],
+							current_step.input_configuration_specific_list,
+							current_step.output_configuration_specific,
+							current_step.add_output,
+							*current_step.actions,
+							current_entry_count);
 						break;
 					case layer_action::update_weights:
-						{
-							if (is_apply_gradient)
-							{
-								layer_data::ptr previous_upd;
-								if (momentum.is_momentum_data())
-									previous_upd = momentum_data->data_list.find(layer_name);
-								layer_data::ptr previous_upd2;
-								if (momentum.is_momentum_data2())
-									previous_upd2 = momentum_data2->data_list.find(layer_name);
-								apply_gradient(
-									layer_name,
-									data.data_list.find(layer_name),
-									gradient->find(layer_name),
-									previous_upd,
-									previous_upd2,
-									updates_accumulated[layer_name],
-									learning_rates.find(layer_name)->second,
-									gradient_normalizer,
-									weight_decay,
-									momentum,
-									base_iteration_count + gradient_applied_count);
-							}
-						}
+						if (is_apply_gradient)
+							step_weights_update_list[step_id]->run(
+								*plain_config,
+								gradient_normalizer,
+								base_iteration_count + gradient_applied_count,
+								*step_updates_accumulated_list[step_id]);
 						break;
 					}
-				}
 
-				for(int entry_id = 0; entry_id < entry_read_count * static_cast<int>(output_layers_tiling_factor); ++entry_id)
-				{
-					std::map<std::string, const float *> data_map;
-					for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
-						data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float) / output_layers_tiling_factor)));
-					writer.write(entry_processed_count + entry_id, data_map);
+					if (!step_seconds.empty())
+					{
+						boost::chrono::duration<double> sec = boost::chrono::high_resolution_clock::now() - start;
+						step_seconds[step_id] += sec.count();
+					}
 				}
 
-				entry_processed_count += entry_read_count;
-				chunk_index = (chunk_index + 1) % entry_read_count_list.size();
+				pipeline.write_chunk();
 
-				if (entry_read_count < current_max_entry_count_const)
-					break;
+				entry_processed_count += entry_read_count;
 			}
+			pipeline.finish();
 
+			// Time of updating weights after the last chunk
+			std::map<std::string, double> final_update_seconds;
 			if (gradient_accumulated_entry_count > 0)
 			{
 				float gradient_normalizer = 1.0F / static_cast<float>(batch_size);
@@ -481,24 +428,17 @@ namespace nnforge
 				for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
 				{
 					const std::string& layer_name = it->first;
-					layer_data::ptr previous_upd;
-					if (momentum.is_momentum_data())
-						previous_upd = momentum_data->data_list.find(layer_name);
-					layer_data::ptr previous_upd2;
-					if (momentum.is_momentum_data2())
-						previous_upd2 = momentum_data2->data_list.find(layer_name);
-					apply_gradient(
-						layer_name,
-						data.data_list.find(layer_name),
-						gradient->find(layer_name),
-						previous_upd,
-						previous_upd2,
-						updates_accumulated[layer_name],
-						learning_rates.find(layer_name)->second,
+					boost::chrono::steady_clock::time_point start = boost::chrono::high_resolution_clock::now();
+					weights_updates[layer_name]->run(
+						*plain_config,
 						gradient_normalizer,
-						weight_decay,
-						momentum,
-						base_iteration_count + gradient_applied_count);
+						base_iteration_count + gradient_applied_count,
+						updates_accumulated[layer_name]);
+					if (!step_seconds.empty())
+					{
+						boost::chrono::duration<double> sec = boost::chrono::high_resolution_clock::now() - start;
+						final_update_seconds.insert(std::make_pair(layer_name, sec.count()));
+					}
 				}
 			}
 
@@ -515,19 +455,442 @@ namespace nnforge
 			}
 			entries_processed = entry_processed_count;
 			action_seconds.clear();
+			if (!step_seconds.empty())
+			{
+				for(unsigned int step_id = 0; step_id < static_cast<unsigned int>(steps.size()); ++step_id)
+				{
+					const layer_name_with_action action(steps[step_id].layer_schema->instance_name, steps[step_id].action);
+					double seconds = step_seconds[step_id];
+					if (steps[step_id].action.get_action_type() == layer_action::update_weights)
+					{
+						std::map<std::string, double>::const_iterator it = final_update_seconds.find(action.get_name());
+						if (it != final_update_seconds.end())
+							seconds += it->second;
+					}
+					action_seconds.insert(std::make_pair(action, static_cast<float>(seconds)));
+				}
+				// Reading and writing overlap with compute
+				action_seconds.insert(std::make_pair(layer_name_with_action(chunk_pipeline_plain::reader_pseudo_layer_name, layer_action::forward), static_cast<float>(pipeline.get_read_seconds())));
+				action_seconds.insert(std::make_pair(layer_name_with_action(chunk_pipeline_plain::writer_pseudo_layer_name, layer_action::forward), static_cast<float>(pipeline.get_write_seconds())));
+			}
+		}
+
+		std::vector<unsigned int> backward_propagation_plain::get_entry_read_count_list(
+			unsigned int batch_size,
+			const buffer_plain_size_configuration& data_buffer_configuration) const
+		{
+			buffer_plain_size_configuration buffer_configuration = buffer_config_without_data_and_momentum;
+			buffer_configuration.add_constant_buffer(data_buffer_configuration.constant_buffer_size);
+
+			unsigned int max_entry_count = plain_config->get_max_entry_count(buffer_configuration);
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain max packet size: " << max_entry_count;
+				debug->output_message(debug_str.str().c_str());
+			}
+
+			if (max_entry_count == 0)
+				throw neural_network_exception("Insufficient memory to do forward-backward prop for even one sample");
+
+			std::vector<unsigned int> entry_read_count_list;
+			if (batch_size <= max_entry_count)
+				entry_read_count_list.push_back(batch_size);
+			else
+			{
+				unsigned int chunk_count = (batch_size + max_entry_count - 1) / max_entry_count;
+				unsigned int chunk_min_size = batch_size / chunk_count;
+				unsigned int plus1_chunk_count = batch_size % chunk_count;
+				entry_read_count_list.resize(chunk_count);
+				std::fill_n(entry_read_count_list.begin(), plus1_chunk_count, chunk_min_size + 1);
+				std::fill_n(entry_read_count_list.begin() + plus1_chunk_count, chunk_count - plus1_chunk_count, chunk_min_size);
+
+				if (debug->is_debug())
+				{
+					std::stringstream debug_str;
+					debug_str << "Batch " << batch_size << " is split into multiple chunks: ";
+					for(std::vector<unsigned int>::const_iterator it = entry_read_count_list.begin(); it != entry_read_count_list.end(); ++it)
+					{
+						if (it != entry_read_count_list.begin())
+							debug_str << ", ";
+						debug_str << *it;
+					}
+					debug->output_message(debug_str.str().c_str());
+				}
+			}
+
+			return entry_read_count_list;
+		}
+
+		float backward_propagation_plain::get_max_flops() const
+		{
+			return plain_config->get_flops();
 		}
 
 		void backward_propagation_plain::layer_config_map_modified()
 		{
+			// Buffer plan is about to change
+			arena.release();
+
+			setup_updaters();
+
+			setup_recompute_actions();
+
 			setup_dedicated_buffer_sizes();
 
 			setup_layer_buffer_sizes();
 
 			setup_temporary_working_fixed_buffer_sizes();
 
+			setup_steps();
+
 			update_buffer_config();
 		}
 
+		void backward_propagation_plain::setup_sequential_action_schema()
+		{
+			// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
+			network_action_schema::ptr sequential_action_schema(new network_action_schema());
+			{
+				std::vector<layer_name_with_action> dependencies;
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_with_recompute_in_execution_order.begin(); it != actions_with_recompute_in_execution_order.end(); ++it)
+				{
+					sequential_action_schema->add_action(
+						schema->get_layer(it->get_name()),
+						it->get_action(),
+						dependencies);
+					dependencies.clear();
+					dependencies.push_back(*it);
+				}
+			}
+			action_schema = sequential_action_schema;
+
+			if (debug->is_debug())
+			{
+				boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
+				action_schema->write_gv(out);
+			}
+		}
+
+		void backward_propagation_plain::setup_fused_softmax_loss_layers()
+		{
+			fused_softmax_loss_layer_names.clear();
+
+			std::map<std::string, unsigned int> layer_name_to_consumer_count_map;
+			{
+				std::vector<layer::const_ptr> layer_list = schema->get_layers();
+				for(std::vector<layer::const_ptr>::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it)
+					for(std::vector<std::string>::const_iterator it2 = (*it)->input_layer_instance_names.begin(); it2 != (*it)->input_layer_instance_names.end(); ++it2)
+						++layer_name_to_consumer_count_map[*it2];
+			}
+
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				if ((it->get_action().get_action_type() != layer_action::backward_data) || (it->get_action().get_backprop_index() != 0))
+					continue;
+				layer::const_ptr l = schema->get_layer(it->get_name());
+				if (l->get_type_name() != negative_log_likelihood_layer::layer_type_name)
+					continue;
+				const std::string& softmax_layer_name = l->input_layer_instance_names[0];
+				layer::const_ptr softmax_l = schema->get_layer(softmax_layer_name);
+				if (softmax_l->get_type_name() != softmax_layer::layer_type_name)
+					continue;
+				// Errors of the softmax layer are used by the loss layer only
+				if (layer_name_to_consumer_count_map[softmax_layer_name] != 1)
+					continue;
+				if (std::find(output_layer_names.begin(), output_layer_names.end(), softmax_layer_name) != output_layer_names.end())
+					continue;
+				const layer_name_with_action softmax_action(softmax_layer_name, layer_action(layer_action::backward_data, 0));
+				if (action_to_dependencies_map.find(softmax_action) == action_to_dependencies_map.end())
+					continue;
+
+				fused_softmax_loss_layer_names.insert(l->instance_name);
+
+				// The loss action takes the place of the softmax one
+				actions_in_execution_order.erase(std::find(actions_in_execution_order.begin(), actions_in_execution_order.end(), softmax_action));
+				action_to_dependencies_map.erase(softmax_action);
+				for(std::map<layer_name_with_action, std::vector<layer_name_with_action> >::iterator it2 = action_to_dependencies_map.begin(); it2 != action_to_dependencies_map.end(); ++it2)
+				{
+					std::vector<layer_name_with_action>& dependencies = it2->second;
+					std::vector<layer_name_with_action>::iterator dep_it = std::find(dependencies.begin(), dependencies.end(), softmax_action);
+					if (dep_it == dependencies.end())
+						continue;
+					if ((it2->first == *it) || (std::find(dependencies.begin(), dependencies.end(), *it) != dependencies.end()))
+						dependencies.erase(dep_it);
+					else
+						*dep_it = *it;
+				}
+				for(std::vector<std::vector<layer_name_with_action> >::iterator it2 = same_output_action_sets.begin(); it2 != same_output_action_sets.end(); ++it2)
+					std::replace(it2->begin(), it2->end(), softmax_action, *it);
+				if (add_output_actions.erase(softmax_action) > 0)
+					add_output_actions.insert(*it);
+
+				if (debug->is_debug())
+				{
+					std::stringstream debug_str;
+					debug_str << "backward prop plain fuses backward data of " << softmax_layer_name << " into " << l->instance_name;
+					debug->output_message(debug_str.str().c_str());
+				}
+			}
+		}
+
+		void backward_propagation_plain::setup_updaters()
+		{
+			// Updaters are chosen once layer configurations are known, specialized ones depend on them
+			updaters.clear();
+			updater_plain_config_map.clear();
+			bool decisions_made = false;
+			for(std::map<std::string, std::set<layer_action> >::const_iterator it = layer_name_to_action_set_map.begin(); it != layer_name_to_action_set_map.end(); ++it)
+			{
+				layer::const_ptr l = schema->get_layer(it->first);
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+				if (fused_softmax_loss_layer_names.find(it->first) != fused_softmax_loss_layer_names.end())
+					updaters.insert(std::make_pair(it->first, layer_updater_plain::const_ptr(new softmax_negative_log_likelihood_layer_updater_plain())));
+				else
+					updaters.insert(
+						std::make_pair(
+							it->first,
+							layer_updater_plain_factory::singleton::get_const_instance().get_updater_plain_layer(
+								plain_config,
+								l,
+								input_layer_configuration_specific_list,
+								layer_config_map[it->first])));
+
+				// Algorithm decisions should be made before buffer sizes are set up
+				decisions_made = auto_tuner_plain::tune_updater(
+					plain_config,
+					updaters[it->first],
+					l,
+					input_layer_configuration_specific_list,
+					layer_config_map[it->first],
+					it->second,
+					tuning_entry_count,
+					debug) || decisions_made;
+
+				// The decision is looked up once, the updater reads it from the configuration it is called with
+				std::string algorithm = auto_tuner_plain::get_updater_algorithm(
+					it->second,
+					plain_config,
+					l,
+					input_layer_configuration_specific_list,
+					layer_config_map[it->first],
+					tuning_entry_count);
+				updater_plain_config_map.insert(std::make_pair(it->first, algorithm.empty() ? plain_config : plain_config->get_algorithm_configuration(algorithm)));
+			}
+
+			// The cache file is rewritten once for all the decisions made
+			if (decisions_made)
+				plain_config->tuning->save();
+		}
+
+		void backward_propagation_plain::setup_recompute_actions()
+		{
+			recomputed_layer_names.clear();
+			actions_with_recompute_in_execution_order = actions_in_execution_order;
+
+			std::vector<std::string> forward_layer_names;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				if (it->get_action().get_action_type() == layer_action::forward)
+					forward_layer_names.push_back(it->get_name());
+
+			std::set<std::string> checkpoint_layer_names;
+			if (!plain_config->checkpoint_layer_names.empty())
+				checkpoint_layer_names = plain_config->checkpoint_layer_names;
+			else if ((plain_config->checkpoint_segment_count != 0) && !forward_layer_names.empty())
+			{
+				unsigned int layer_count = static_cast<unsigned int>(forward_layer_names.size());
+				unsigned int segment_count = (plain_config->checkpoint_segment_count > 0)
+					? static_cast<unsigned int>(plain_config->checkpoint_segment_count)
+					: static_cast<unsigned int>(sqrtf(static_cast<float>(layer_count)) + 0.5F);
+				segment_count = std::max(std::min(segment_count, layer_count), 1U);
+				for(unsigned int segment_id = 0; segment_id < segment_count; ++segment_id)
+					checkpoint_layer_names.insert(forward_layer_names[(segment_id + 1) * layer_count / segment_count - 1]);
+			}
+
+			if (checkpoint_layer_names.empty())
+				return;
+
+			// Backward weights actions are moved to run as soon as their dependencies are done,
+			// otherwise the recomputed outputs they read would be kept till the very end of the backward pass
+			std::vector<layer_name_with_action> actions_in_backward_order;
+			{
+				std::set<layer_name_with_action> done_actions;
+				std::vector<layer_name_with_action> pending_actions;
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+					if (it->get_action().get_action_type() == layer_action::backward_weights)
+						pending_actions.push_back(*it);
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				{
+					if (it->get_action().get_action_type() == layer_action::backward_weights)
+						continue;
+					actions_in_backward_order.push_back(*it);
+					done_actions.insert(*it);
+
+					bool added = true;
+					while (added)
+					{
+						added = false;
+						for(std::vector<layer_name_with_action>::iterator it2 = pending_actions.begin(); it2 != pending_actions.end(); ++it2)
+						{
+							const std::vector<layer_name_with_action>& dependencies = action_to_dependencies_map[*it2];
+							bool ready = true;
+							for(std::vector<layer_name_with_action>::const_iterator it3 = dependencies.begin(); it3 != dependencies.end(); ++it3)
+								ready = ready && (done_actions.find(*it3) != done_actions.end());
+							if (ready)
+							{
+								actions_in_backward_order.push_back(*it2);
+								done_actions.insert(*it2);
+								pending_actions.erase(it2);
+								added = true;
+								break;
+							}
+						}
+					}
+				}
+				actions_in_backward_order.insert(actions_in_backward_order.end(), pending_actions.begin(), pending_actions.end());
+			}
+
+			// The segment ends with the checkpoint
+			std::map<std::string, unsigned int> layer_name_to_segment_id_map;
+			{
+				unsigned int segment_id = 0;
+				for(std::vector<std::string>::const_iterator it = forward_layer_names.begin(); it != forward_layer_names.end(); ++it)
+				{
+					layer_name_to_segment_id_map.insert(std::make_pair(*it, segment_id));
+					if (checkpoint_layer_names.find(*it) != checkpoint_layer_names.end())
+						++segment_id;
+				}
+			}
+
+			std::set<std::string> kept_layer_names(checkpoint_layer_names);
+			kept_layer_names.insert(output_layer_names.begin(), output_layer_names.end());
+			for(std::vector<std::string>::const_iterator it = forward_layer_names.begin(); it != forward_layer_names.end(); ++it)
+			{
+				layer::const_ptr l = schema->get_layer(*it);
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+				if (!updaters[*it]->is_forward_recomputable(layer_name_to_action_set_map[*it], updater_plain_config_map[*it], l, input_layer_configuration_specific_list, layer_config_map[*it]))
+					kept_layer_names.insert(*it);
+
+				// Recomputing a segment reads outputs of its own layers and the kept ones only
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+				{
+					std::map<std::string, unsigned int>::const_iterator segment_it = layer_name_to_segment_id_map.find(*it2);
+					if ((segment_it != layer_name_to_segment_id_map.end()) && (segment_it->second != layer_name_to_segment_id_map[*it]))
+						kept_layer_names.insert(*it2);
+				}
+			}
+
+			// Index of the first backward action reading the output or the temporary per entry buffer of the layer
+			std::map<std::string, unsigned int> first_reader_action_id_map;
+			for(unsigned int action_id = 0; action_id < static_cast<unsigned int>(actions_in_backward_order.size()); ++action_id)
+			{
+				const layer_name_with_action& current_action = actions_in_backward_order[action_id];
+				const layer_action::action_type action_type = current_action.get_action().get_action_type();
+				if ((action_type != layer_action::backward_data) && (action_type != layer_action::backward_weights) && (action_type != layer_action::backward_data_and_weights))
+					continue;
+
+				const std::string& layer_name = current_action.get_name();
+				layer::const_ptr l = schema->get_layer(layer_name);
+				layer_updater_plain::const_ptr updater = updaters[layer_name];
+				const std::set<layer_action>& actions = layer_name_to_action_set_map[layer_name];
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+				const layer_configuration_specific& output_layer_configuration_specific = layer_config_map[layer_name];
+
+				unsigned int data_input_index = 0;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
+				{
+					if (data_layer_names.find(*it2) != data_layer_names.end())
+						continue;
+					bool dependent;
+					switch (action_type)
+					{
+					case layer_action::backward_data:
+						dependent = updater->is_backward_data_dependent_on_input_buffer(current_action.get_action().get_backprop_index(), data_input_index, actions, updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+						break;
+					case layer_action::backward_weights:
+						dependent = updater->is_backward_weights_dependent_on_input_buffer(data_input_index, actions, updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+						break;
+					default:
+						dependent = updater->is_backward_data_and_weights_dependent_on_input_buffer(data_input_index, actions, updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+						break;
+					}
+					if (dependent)
+						first_reader_action_id_map.insert(std::make_pair(*it2, action_id));
+				}
+
+				bool own_buffers_dependent;
+				switch (action_type)
+				{
+				case layer_action::backward_data:
+					own_buffers_dependent = updater->is_backward_data_dependent_on_output_buffer(current_action.get_action().get_backprop_index(), actions, updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific)
+						|| updater->is_backward_data_dependent_on_temporary_per_entry_buffer(current_action.get_action().get_backprop_index(), actions, updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+					break;
+				case layer_action::backward_weights:
+					own_buffers_dependent = updater->is_backward_weights_dependent_on_temporary_per_entry_buffer(actions, updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+					break;
+				default:
+					own_buffers_dependent = updater->is_backward_data_and_weights_dependent_on_output_buffer(actions, updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific)
+						|| updater->is_backward_data_and_weights_dependent_on_temporary_per_entry_buffer(actions, updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+					break;
+				}
+				if (own_buffers_dependent)
+					first_reader_action_id_map.insert(std::make_pair(layer_name, action_id));
+			}
+
+			// All the layers of the segment are recomputed right before the first backward action reading any of them
+			std::map<unsigned int, unsigned int> segment_id_to_action_id_map;
+			for(std::map<std::string, unsigned int>::const_iterator it = first_reader_action_id_map.begin(); it != first_reader_action_id_map.end(); ++it)
+			{
+				if (kept_layer_names.find(it->first) != kept_layer_names.end())
+					continue;
+				recomputed_layer_names.insert(it->first);
+				std::map<unsigned int, unsigned int>::iterator segment_it = segment_id_to_action_id_map.insert(std::make_pair(layer_name_to_segment_id_map[it->first], it->second)).first;
+				segment_it->second = std::min(segment_it->second, it->second);
+			}
+
+			// Inputs of recomputed layers are recomputed too unless kept, they belong to the same segment
+			for(std::vector<std::string>::const_reverse_iterator it = forward_layer_names.rbegin(); it != forward_layer_names.rend(); ++it)
+			{
+				if (recomputed_layer_names.find(*it) == recomputed_layer_names.end())
+					continue;
+				layer::const_ptr l = schema->get_layer(*it);
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					if ((data_layer_names.find(*it2) == data_layer_names.end()) && (kept_layer_names.find(*it2) == kept_layer_names.end()))
+						recomputed_layer_names.insert(*it2);
+			}
+
+			std::map<unsigned int, std::vector<layer_name_with_action> > action_id_to_recompute_actions_map;
+			for(std::vector<std::string>::const_iterator it = forward_layer_names.begin(); it != forward_layer_names.end(); ++it)
+				if (recomputed_layer_names.find(*it) != recomputed_layer_names.end())
+					action_id_to_recompute_actions_map[segment_id_to_action_id_map[layer_name_to_segment_id_map[*it]]].push_back(layer_name_with_action(*it, layer_action::recompute));
+
+			actions_with_recompute_in_execution_order.clear();
+			for(unsigned int action_id = 0; action_id < static_cast<unsigned int>(actions_in_backward_order.size()); ++action_id)
+			{
+				std::map<unsigned int, std::vector<layer_name_with_action> >::const_iterator it = action_id_to_recompute_actions_map.find(action_id);
+				if (it != action_id_to_recompute_actions_map.end())
+					actions_with_recompute_in_execution_order.insert(actions_with_recompute_in_execution_order.end(), it->second.begin(), it->second.end());
+				actions_with_recompute_in_execution_order.push_back(actions_in_backward_order[action_id]);
+			}
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain recomputes " << recomputed_layer_names.size() << " layers in " << segment_id_to_action_id_map.size() << " segments";
+				debug_str << ", keeps outputs of " << kept_layer_names.size() << " layers";
+				debug->output_message(debug_str.str().c_str());
+			}
+
+			setup_sequential_action_schema();
+		}
+
 		void backward_propagation_plain::setup_dedicated_buffer_sizes()
 		{
 			dedicated_per_entry_data_name_to_size_map.clear();
@@ -552,7 +915,7 @@ namespace nnforge
 				size_t new_temporary_working_fixed_size = updaters[layer_name]->get_temporary_working_fixed_buffer_size(
 					it->get_action(),
 					layer_name_to_action_set_map[layer_name],
-					plain_config,
+					updater_plain_config_map[layer_name],
 					l,
 					input_layer_configuration_specific_list,
 					output_layer_configuration_specific);
@@ -571,12 +934,13 @@ namespace nnforge
 		{
 			std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > layer_buffer_set_list;
 			{
-				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > > buffers;
+				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, size_t> > > buffers;
 				std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > > dependencies;
 				std::set<std::string> dedicated_output_buffers(output_layer_names.begin(), output_layer_names.end());
-				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_with_recompute_in_execution_order.begin(); it != actions_with_recompute_in_execution_order.end(); ++it)
 				{
 					std::string layer_name = it->get_name();
+					const layer_action updater_action = get_updater_action(it->get_action());
 					layer::const_ptr l = schema->get_layer(layer_name);
 					layer_updater_plain::const_ptr updater = updaters[layer_name];
 					layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
@@ -584,46 +948,56 @@ namespace nnforge
 					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 
-					std::vector<std::pair<buffer_lifetime, float> > current_buffers;
+					std::vector<std::pair<buffer_lifetime, size_t> > current_buffers;
 					{
 						switch (it->get_action().get_action_type())
 						{
 						case layer_action::forward:
+						case layer_action::recompute:
 							{
 								size_t buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
 								if (dedicated_output_buffers.find(it->get_name()) == dedicated_output_buffers.end())
-										current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
+										current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), buffer_size_per_entry));
 							}
 							{
 								size_t temporary_per_entry_buffer_size = updater->get_temporary_per_entry_buffer_size(
 									layer_name_to_action_set_map[layer_name],
-									plain_config,
+									updater_plain_config_map[layer_name],
 									l,
 									input_layer_configuration_specific_list,
 									output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
 								if (temporary_per_entry_buffer_size > 0)
-									current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), static_cast<float>(temporary_per_entry_buffer_size)));
+									current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), temporary_per_entry_buffer_size));
 							}
 							break;
 						case layer_action::backward_data:
 							{
 								const std::string& previous_layer_name = schema->get_layer(layer_name)->input_layer_instance_names[it->get_action().get_backprop_index()];
 								size_t buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
-								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
+								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), buffer_size_per_entry));
+							}
+							break;
+						case layer_action::backward_data_and_weights:
+							{
+								if (schema->get_layer(layer_name)->input_layer_instance_names.size() != 1)
+									throw neural_network_exception((boost::format("setup_layer_buffer_sizes cannot handle multiple output buffers for action %1% for layer %2%") % it->get_action().str() % it->get_name()).str());
+								const std::string& previous_layer_name = schema->get_layer(layer_name)->input_layer_instance_names[0];
+								size_t buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
+								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), buffer_size_per_entry));
 							}
 							break;
 						}
 
 						{
 							size_t temporary_working_per_entry_buffer_size = updater->get_temporary_working_per_entry_buffer_size(
-								it->get_action(),
+								updater_action,
 								layer_name_to_action_set_map[layer_name],
-								plain_config,
+								updater_plain_config_map[layer_name],
 								l,
 								input_layer_configuration_specific_list,
 								output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
 							if (temporary_working_per_entry_buffer_size > 0)
-								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::working_buffer), static_cast<float>(temporary_working_per_entry_buffer_size)));
+								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::working_buffer), temporary_working_per_entry_buffer_size));
 						}
 					}
 
@@ -638,9 +1012,9 @@ namespace nnforge
 						for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 							input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 						input_index_layer_can_write = updaters[layer_name]->get_input_index_layer_can_write(
-							it->get_action(),
+							updater_action,
 							layer_name_to_action_set_map[layer_name],
-							plain_config,
+							updater_plain_config_map[layer_name],
 							l,
 							input_layer_configuration_specific_list,
 							output_layer_configuration_specific);
@@ -652,13 +1026,15 @@ namespace nnforge
 						switch (it->get_action().get_action_type())
 						{
 						case layer_action::forward:
+						case layer_action::recompute:
 							{
+								const bool is_recompute = (it->get_action().get_action_type() == layer_action::recompute);
 								int input_index = 0;
 								for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++input_index)
 								{
 									const std::string& previous_layer_name = *it2;
 									if (data_layer_names.find(previous_layer_name) == data_layer_names.end())
-										current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(
+										current_dependencies.insert(std::make_pair(is_recompute ? get_activation_action(previous_layer_name) : layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(
 											std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == input_index)));
 								}
 							}
@@ -670,17 +1046,17 @@ namespace nnforge
 								{
 									const std::string& previous_layer_name = *it2;
 									if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) &&
-										updater->is_backward_weights_dependent_on_input_buffer(data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+										updater->is_backward_weights_dependent_on_input_buffer(data_input_index, layer_name_to_action_set_map[layer_name], updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific))
 									{
-										current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+										current_dependencies.insert(std::make_pair(get_activation_action(previous_layer_name), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
 									}
 								}
 								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = input_to_all_output_map.find(l->instance_name);
 								if (input_to_all_output_it != input_to_all_output_map.end())
 									for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
 										current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
-								if (updater->is_backward_weights_dependent_on_temporary_per_entry_buffer(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
+								if (updater->is_backward_weights_dependent_on_temporary_per_entry_buffer(layer_name_to_action_set_map[layer_name], updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+									current_dependencies.insert(std::make_pair(get_activation_action(it->get_name()), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
 							}
 							break;
 						case layer_action::backward_data:
@@ -690,17 +1066,36 @@ namespace nnforge
 								for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
 								{
 									const std::string& previous_layer_name = *it2;
-									if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) && updater->is_backward_data_dependent_on_input_buffer(action_input_index, data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-										current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+									if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) && updater->is_backward_data_dependent_on_input_buffer(action_input_index, data_input_index, layer_name_to_action_set_map[layer_name], updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+										current_dependencies.insert(std::make_pair(get_activation_action(previous_layer_name), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
 								}
-								if (updater->is_backward_data_dependent_on_output_buffer(action_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+								if (updater->is_backward_data_dependent_on_output_buffer(action_input_index, layer_name_to_action_set_map[layer_name], updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+									current_dependencies.insert(std::make_pair(get_activation_action(it->get_name()), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
 								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = input_to_all_output_map.find(l->instance_name);
 								if (input_to_all_output_it != input_to_all_output_map.end())
 									for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
 										current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == 0)));
-								if (updater->is_backward_data_dependent_on_temporary_per_entry_buffer(action_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
+								if (updater->is_backward_data_dependent_on_temporary_per_entry_buffer(action_input_index, layer_name_to_action_set_map[layer_name], updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+									current_dependencies.insert(std::make_pair(get_activation_action(it->get_name()), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
+							}
+							break;
+						case layer_action::backward_data_and_weights:
+							{
+								unsigned int data_input_index = 0;
+								for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
+								{
+									const std::string& previous_layer_name = *it2;
+									if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) && updater->is_backward_data_and_weights_dependent_on_input_buffer(data_input_index, layer_name_to_action_set_map[layer_name], updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+										current_dependencies.insert(std::make_pair(get_activation_action(previous_layer_name), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+								}
+								if (updater->is_backward_data_and_weights_dependent_on_output_buffer(layer_name_to_action_set_map[layer_name], updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+									current_dependencies.insert(std::make_pair(get_activation_action(it->get_name()), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = input_to_all_output_map.find(l->instance_name);
+								if (input_to_all_output_it != input_to_all_output_map.end())
+									for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
+										current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == 0)));
+								if (updater->is_backward_data_and_weights_dependent_on_temporary_per_entry_buffer(layer_name_to_action_set_map[layer_name], updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+									current_dependencies.insert(std::make_pair(get_activation_action(it->get_name()), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
 							}
 							break;
 						}
@@ -720,10 +1115,29 @@ namespace nnforge
 						tt.push_back(std::make_pair(*it2, buffer_lifetime(buffer_lifetime::action_output_buffer)));
 				}
 
-				layer_buffer_set_list = action_schema->get_buffer_set(
-					buffers,
-					dependencies,
-					std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >());
+				layer_buffer_set_per_entry_offset_list.clear();
+				layer_buffers_per_entry_size = 0;
+				if (plain_config->buffer_offset_planning)
+				{
+					std::vector<std::pair<size_t, std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > > layer_buffer_offset_list = action_schema->get_buffer_offsets(
+						buffers,
+						dependencies,
+						std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >(),
+						buffer_arena_plain::buffer_alignment,
+						layer_buffers_per_entry_size);
+					for(std::vector<std::pair<size_t, std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > >::const_iterator it = layer_buffer_offset_list.begin(); it != layer_buffer_offset_list.end(); ++it)
+					{
+						layer_buffer_set_per_entry_offset_list.push_back(it->first);
+						layer_buffer_set_list.push_back(it->second);
+					}
+				}
+				else
+				{
+					layer_buffer_set_list = action_schema->get_buffer_set(
+						buffers,
+						dependencies,
+						std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >());
+				}
 			}
 
 			layer_buffer_set_per_entry_size_list.clear();
@@ -752,6 +1166,7 @@ namespace nnforge
 						switch (it->first.get_action().get_action_type())
 						{
 						case layer_action::forward:
+						case layer_action::recompute:
 							buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
 							break;
 						case layer_action::backward_data:
@@ -760,17 +1175,23 @@ namespace nnforge
 								buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
 							}
 							break;
+						case layer_action::backward_data_and_weights:
+							{
+								const std::string& previous_layer_name = schema->get_layer(layer_name)->input_layer_instance_names[0];
+								buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
+							}
+							break;
 						default:
 							throw neural_network_exception((boost::format("Unexpected buffer lifetime %1% encountered for layer %2% action %3%") % it->second.str() % it->first.get_name() % it->first.get_action().str()).str());
 						}
 						break;
 					case buffer_lifetime::working_buffer:
 						temporary_working_per_entry_data_action_to_set_map.insert(std::make_pair(it->first, set_id));
-						buffer_size_per_entry = updaters[layer_name]->get_temporary_working_per_entry_buffer_size(it->first.get_action(), layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
+						buffer_size_per_entry = updaters[layer_name]->get_temporary_working_per_entry_buffer_size(get_updater_action(it->first.get_action()), layer_name_to_action_set_map[layer_name], updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
 						break;
 					case buffer_lifetime::temporary_buffer:
 						temporary_per_entry_data_action_to_set_map.insert(std::make_pair(it->first, set_id));
-						buffer_size_per_entry = updaters[layer_name]->get_temporary_per_entry_buffer_size(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
+						buffer_size_per_entry = updaters[layer_name]->get_temporary_per_entry_buffer_size(layer_name_to_action_set_map[layer_name], updater_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
 						break;
 					default:
 						throw neural_network_exception((boost::format("Unexpected buffer lifetime %1% encountered for layer %2% action %3%") % it->second.str() % it->first.get_name() % it->first.get_action().str()).str());
@@ -787,11 +1208,16 @@ namespace nnforge
 				for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
 						total_buffer_size += *it;
 				debug_str << ", total size " << ((total_buffer_size + 1024 - 1) / 1024) << " KB";
+				if (!layer_buffer_set_per_entry_offset_list.empty())
+					debug_str << ", planned peak " << ((layer_buffers_per_entry_size + 1024 - 1) / 1024) << " KB";
 				debug->output_message(debug_str.str().c_str());
 				for(unsigned int set_id = 0; set_id < static_cast<unsigned int>(layer_buffer_set_per_entry_size_list.size()); ++set_id)
 				{
 					std::stringstream debug_str;
-					debug_str << " - " << ((layer_buffer_set_per_entry_size_list[set_id] + 1024 - 1) / 1024) << " KB: ";
+					debug_str << " - ";
+					if (!layer_buffer_set_per_entry_offset_list.empty())
+						debug_str << "at " << (layer_buffer_set_per_entry_offset_list[set_id] / 1024) << " KB ";
+					debug_str << ((layer_buffer_set_per_entry_size_list[set_id] + 1024 - 1) / 1024) << " KB: ";
 					const std::vector<std::pair<layer_name_with_action, buffer_lifetime> >& action_list = layer_buffer_set_list[set_id];
 					for(std::vector<std::pair<layer_name_with_action, buffer_lifetime> >::const_iterator it = action_list.begin(); it != action_list.end(); ++it)
 					{
@@ -808,171 +1234,166 @@ namespace nnforge
 			}
 		}
 
-		void backward_propagation_plain::update_buffer_config()
+		int backward_propagation_plain::get_buffer_slot(const layer_name_with_action& action) const
 		{
-			buffer_plain_size_configuration buffer_configuration;
+			std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(action);
+			if (it != layer_buffer_action_to_set_map.end())
+				return static_cast<int>(it->second);
 
-			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
-				buffer_configuration.add_per_entry_buffer(*it);
+			int slot = static_cast<int>(layer_buffer_set_per_entry_size_list.size());
+			for(std::map<std::string, size_t>::const_iterator it2 = dedicated_per_entry_data_name_to_size_map.begin(); it2 != dedicated_per_entry_data_name_to_size_map.end(); ++it2, ++slot)
+				if (it2->first == action.get_name())
+					return slot;
 
-			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
-				buffer_configuration.add_per_entry_buffer(it->second);
+			throw neural_network_exception((boost::format("No buffer found for the output of layer %1% action %2%") % action.get_name() % action.get_action().str()).str());
+		}
 
-			buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
+		layer_name_with_action backward_propagation_plain::get_activation_action(const std::string& layer_name) const
+		{
+			if (recomputed_layer_names.find(layer_name) != recomputed_layer_names.end())
+				return layer_name_with_action(layer_name, layer_action::recompute);
 
-			buffer_config_without_data_and_momentum = buffer_configuration;
+			return layer_name_with_action(layer_name, layer_action::forward);
 		}
 
-		void backward_propagation_plain::apply_gradient(
-			const std::string& layer_name,
-			layer_data::ptr data,
-			layer_data::ptr gradient,
-			layer_data::ptr previous_upd,
-			layer_data::ptr previous_upd2,
-			std::vector<double>& updates_accumulated,
-			const std::vector<float>& learning_rates,
-			float normalizer,
-			float weight_decay,
-			training_momentum momentum,
-			unsigned int iteration_id) const
+		layer_action backward_propagation_plain::get_updater_action(const layer_action& action)
 		{
-			switch (momentum.type)
+			if (action.get_action_type() == layer_action::recompute)
+				return layer_action(layer_action::forward);
+
+			return action;
+		}
+
+		int backward_propagation_plain::get_layer_buffer_slot(
+			const std::map<layer_name_with_action, unsigned int>& action_to_set_map,
+			const layer_name_with_action& action)
+		{
+			std::map<layer_name_with_action, unsigned int>::const_iterator it = action_to_set_map.find(action);
+			if (it != action_to_set_map.end())
+				return static_cast<int>(it->second);
+
+			return -1;
+		}
+
+		void backward_propagation_plain::setup_steps()
+		{
+			steps.clear();
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_with_recompute_in_execution_order.begin(); it != actions_with_recompute_in_execution_order.end(); ++it)
 			{
-			case training_momentum::no_momentum:
+				const std::string& layer_name = it->get_name();
+				const layer_action action = it->get_action();
+				step new_step;
+				new_step.action = action;
+				new_step.layer_schema = schema->get_layer(layer_name);
+				new_step.updater = updaters.find(layer_name)->second;
+				new_step.plain_config = updater_plain_config_map[layer_name];
+				new_step.actions = &layer_name_to_action_set_map[layer_name];
+				for(std::vector<std::string>::const_iterator it2 = new_step.layer_schema->input_layer_instance_names.begin(); it2 != new_step.layer_schema->input_layer_instance_names.end(); ++it2)
+					new_step.input_configuration_specific_list.push_back(layer_config_map[*it2]);
+				new_step.output_configuration_specific = layer_config_map[layer_name];
+				new_step.tiling_factor = cumulative_tiling_factor_map[layer_name];
+				new_step.output_buffer_slot = -1;
+				new_step.temporary_working_per_entry_buffer_slot = get_layer_buffer_slot(temporary_working_per_entry_data_action_to_set_map, *it);
+				new_step.temporary_per_entry_buffer_slot = -1;
+				new_step.output_neurons_buffer_slot = -1;
+				new_step.output_errors_buffer_slot = -1;
+				new_step.add_output = (add_output_actions.find(*it) != add_output_actions.end());
+
+				const std::vector<std::string>& input_layer_names = new_step.layer_schema->input_layer_instance_names;
+				switch (action.get_action_type())
 				{
-					layer_data::iterator gradient_it = gradient->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					double accum = 0.0;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
-					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						float learning_rate = *learning_rate_it;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2)
-						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float upd = learning_rate * (gr * normalizer - current_weight * actual_weight_decay);
-							accum += static_cast<double>(fabsf(upd));
-							float new_weight = current_weight + upd;
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-						}
-						*updates_accumulated_it += accum;
-					}
-				}
-				break;
-			case training_momentum::vanilla_momentum:
-				{
-					layer_data::iterator gradient_it = gradient->begin();
-					layer_data::iterator previous_upd_it = previous_upd->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++previous_upd_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
+				case layer_action::forward:
+				case layer_action::recompute:
+					new_step.output_buffer_slot = get_buffer_slot(*it);
+					for(std::vector<std::string>::const_iterator it2 = input_layer_names.begin(); it2 != input_layer_names.end(); ++it2)
+						new_step.input_buffer_slots.push_back(get_buffer_slot((action.get_action_type() == layer_action::recompute) ? get_activation_action(*it2) : layer_name_with_action(*it2, layer_action::forward)));
+					new_step.temporary_per_entry_buffer_slot = get_layer_buffer_slot(temporary_per_entry_data_action_to_set_map, *it);
+					break;
+				case layer_action::backward_data:
+				case layer_action::backward_weights:
+				case layer_action::backward_data_and_weights:
 					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						std::vector<float>::iterator previous_upd_it2 = previous_upd_it->begin();
-						float learning_rate = *learning_rate_it;
-						double accum = 0.0;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2, ++previous_upd_it2)
+						const layer_action::action_type action_type = action.get_action_type();
+						if (action_type != layer_action::backward_weights)
 						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float prev_upd = *previous_upd_it2;
-							float upd = prev_upd * momentum.momentum_val + learning_rate * (gr * normalizer - current_weight * actual_weight_decay);
-							accum += static_cast<double>(fabsf(upd));
-							float new_weight = current_weight + upd;
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-							*previous_upd_it2 = upd;
+							new_step.output_buffer_slot = get_layer_buffer_slot(layer_buffer_action_to_set_map, *it);
+							if (new_step.output_buffer_slot < 0)
+								throw neural_network_exception((boost::format("No output buffer assigned to action %1% for layer %2%") % action.str() % layer_name).str());
 						}
-						*updates_accumulated_it += accum;
-					}
-				}
-				break;
-			case training_momentum::nesterov_momentum:
-				{
-					layer_data::iterator gradient_it = gradient->begin();
-					layer_data::iterator previous_upd_it = previous_upd->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++previous_upd_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
-					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						std::vector<float>::iterator previous_upd_it2 = previous_upd_it->begin();
-						float learning_rate = *learning_rate_it;
-						double accum = 0.0;
-						float mp1 = momentum.momentum_val + 1.0F;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2, ++previous_upd_it2)
+
+						unsigned int data_input_index = 0;
+						for(std::vector<std::string>::const_iterator it2 = input_layer_names.begin(); it2 != input_layer_names.end(); ++it2, ++data_input_index)
 						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float prev_upd = *previous_upd_it2;
-							float new_upd = prev_upd * momentum.momentum_val + learning_rate * (gr * normalizer - current_weight * actual_weight_decay);
-							float upd = mp1 * new_upd - momentum.momentum_val * prev_upd;
-							accum += static_cast<double>(fabsf(upd));
-							float new_weight = current_weight + upd;
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-							*previous_upd_it2 = new_upd;
+							bool dependent;
+							switch (action_type)
+							{
+							case layer_action::backward_data:
+								dependent = new_step.updater->is_backward_data_dependent_on_input_buffer(action.get_backprop_index(), data_input_index, *new_step.actions, new_step.plain_config, new_step.layer_schema, new_step.input_configuration_specific_list, new_step.output_configuration_specific);
+								break;
+							case layer_action::backward_weights:
+								dependent = new_step.updater->is_backward_weights_dependent_on_input_buffer(data_input_index, *new_step.actions, new_step.plain_config, new_step.layer_schema, new_step.input_configuration_specific_list, new_step.output_configuration_specific);
+								break;
+							default:
+								dependent = new_step.updater->is_backward_data_and_weights_dependent_on_input_buffer(data_input_index, *new_step.actions, new_step.plain_config, new_step.layer_schema, new_step.input_configuration_specific_list, new_step.output_configuration_specific);
+								break;
+							}
+							new_step.input_buffer_slots.push_back(dependent ? get_buffer_slot(get_activation_action(*it2)) : -1);
 						}
-						*updates_accumulated_it += accum;
-					}
-				}
-				break;
-			case training_momentum::adam_momentum:
-				{
-					layer_data::iterator gradient_it = gradient->begin();
-					layer_data::iterator previous_upd_it = previous_upd->begin();
-					layer_data::iterator previous_upd2_it = previous_upd2->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					float one_minus_beta1t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val, static_cast<float>(iteration_id)));
-					float one_minus_beta2t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val2, static_cast<float>(iteration_id)));
-					float epsilon = 1.0e-8F;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++previous_upd_it, ++previous_upd2_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
-					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						std::vector<float>::iterator previous_upd_it2 = previous_upd_it->begin();
-						std::vector<float>::iterator previous_upd2_it2 = previous_upd2_it->begin();
-						float learning_rate = *learning_rate_it;
-						double accum = 0.0;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2, ++previous_upd_it2, ++previous_upd2_it2)
+
+						bool temporary_per_entry_dependent;
+						bool output_neurons_dependent;
+						switch (action_type)
 						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float previous_biased_first_momentum = *previous_upd_it2;
-							float previous_biased_second_momentum = *previous_upd2_it2;
-							float total_gradient = gr * normalizer - current_weight * weight_decay;
-							float new_biased_first_momentum = momentum.momentum_val * previous_biased_first_momentum + (1.0F - momentum.momentum_val) * total_gradient;
-							float new_biased_second_momentum = momentum.momentum_val2 * previous_biased_second_momentum + (1.0F - momentum.momentum_val2) * total_gradient * total_gradient;
-							float unbiased_first_momentum = new_biased_first_momentum * one_minus_beta1t_inverted;
-							float unbiased_second_momentum = new_biased_second_momentum * one_minus_beta2t_inverted;
-							float upd = (learning_rate * unbiased_first_momentum) / (sqrtf(unbiased_second_momentum) + epsilon);
-							float new_weight = current_weight + upd;
-							accum += static_cast<double>(fabsf(upd));
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-							*previous_upd_it2 = new_biased_first_momentum;
-							*previous_upd2_it2 = new_biased_second_momentum;
+						case layer_action::backward_data:
+							temporary_per_entry_dependent = new_step.updater->is_backward_data_dependent_on_temporary_per_entry_buffer(action.get_backprop_index(), *new_step.actions, new_step.plain_config, new_step.layer_schema, new_step.input_configuration_specific_list, new_step.output_configuration_specific);
+							output_neurons_dependent = new_step.updater->is_backward_data_dependent_on_output_buffer(action.get_backprop_index(), *new_step.actions, new_step.plain_config, new_step.layer_schema, new_step.input_configuration_specific_list, new_step.output_configuration_specific);
+							break;
+						case layer_action::backward_weights:
+							temporary_per_entry_dependent = new_step.updater->is_backward_weights_dependent_on_temporary_per_entry_buffer(*new_step.actions, new_step.plain_config, new_step.layer_schema, new_step.input_configuration_specific_list, new_step.output_configuration_specific);
+							output_neurons_dependent = false;
+							break;
+						default:
+							temporary_per_entry_dependent = new_step.updater->is_backward_data_and_weights_dependent_on_temporary_per_entry_buffer(*new_step.actions, new_step.plain_config, new_step.layer_schema, new_step.input_configuration_specific_list, new_step.output_configuration_specific);
+							output_neurons_dependent = new_step.updater->is_backward_data_and_weights_dependent_on_output_buffer(*new_step.actions, new_step.plain_config, new_step.layer_schema, new_step.input_configuration_specific_list, new_step.output_configuration_specific);
+							break;
 						}
-						*updates_accumulated_it += accum;
+
+						if (temporary_per_entry_dependent)
+							new_step.temporary_per_entry_buffer_slot = get_layer_buffer_slot(temporary_per_entry_data_action_to_set_map, get_activation_action(layer_name));
+
+						if (output_neurons_dependent)
+							new_step.output_neurons_buffer_slot = get_buffer_slot(get_activation_action(layer_name));
+
+						std::map<std::string, std::vector<layer_name_with_action> >::const_iterator it2 = input_to_all_output_map.find(layer_name);
+						if (it2 != input_to_all_output_map.end())
+							new_step.output_errors_buffer_slot = get_layer_buffer_slot(layer_buffer_action_to_set_map, it2->second.front());
 					}
+					break;
+				default:
+					break;
 				}
-				break;
+
+				steps.push_back(new_step);
 			}
 		}
+
+		void backward_propagation_plain::update_buffer_config()
+		{
+			buffer_plain_size_configuration buffer_configuration;
+
+			if (!layer_buffer_set_per_entry_offset_list.empty())
+				buffer_configuration.add_per_entry_buffer(layer_buffers_per_entry_size);
+			else
+				for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
+					buffer_configuration.add_per_entry_buffer(*it);
+
+			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
+				for(unsigned int buffer_set_id = 0; buffer_set_id < chunk_pipeline_plain::buffer_set_count; ++buffer_set_id)
+					buffer_configuration.add_per_entry_buffer(it->second);
+
+			buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
+
+			buffer_config_without_data_and_momentum = buffer_configuration;
+		}
 	}
 }
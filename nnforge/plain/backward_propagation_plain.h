@@ -20,6 +20,7 @@
 
 #include "plain_running_configuration.h"
 #include "layer_updater_plain.h"
+#include "buffer_arena_plain.h"
 
 #include <map>
 
@@ -63,7 +64,20 @@ namespace nnforge
 			// The layer_config_map is guaranteed to be compatible with schema
 			virtual void layer_config_map_modified();
 
+			virtual float get_max_flops() const;
+
 		private:
+			void setup_sequential_action_schema();
+
+			// Finds negative log likelihood layers fed by softmax layers with no other consumers,
+			// backward data of the softmax layer is dropped and the loss layer propagates errors to its input
+			void setup_fused_softmax_loss_layers();
+
+			void setup_updaters();
+
+			// Chooses the layers whose outputs are recomputed and inserts recompute actions, called after updaters are set up
+			void setup_recompute_actions();
+
 			void setup_dedicated_buffer_sizes();
 
 			void setup_layer_buffer_sizes();
@@ -72,31 +86,80 @@ namespace nnforge
 
 			void update_buffer_config();
 
-			void apply_gradient(
-				const std::string& layer_name,
-				layer_data::ptr data,
-				layer_data::ptr gradient,
-				layer_data::ptr previous_upd,
-				layer_data::ptr previous_upd2,
-				std::vector<double>& updates_accumulated,
-				const std::vector<float>& learning_rates,
-				float normalizer,
-				float weight_decay,
-				training_momentum momentum,
-				unsigned int iteration_id) const;
+			// Splits the batch into chunks fitting the memory along with the data buffers
+			std::vector<unsigned int> get_entry_read_count_list(
+				unsigned int batch_size,
+				const buffer_plain_size_configuration& data_buffer_configuration) const;
+
+			// Compiles actions into steps, called after all the buffers are assigned
+			void setup_steps();
+
+			// Falls back to the dedicated buffer of the layer when the action has no layer buffer
+			int get_buffer_slot(const layer_name_with_action& action) const;
+
+			// Returns the recompute action of the layer when its output is recomputed, the forward one otherwise
+			layer_name_with_action get_activation_action(const std::string& layer_name) const;
+
+			// Updaters run recompute actions as forward ones
+			static layer_action get_updater_action(const layer_action& action);
+
+			// Returns -1 when action has no buffer assigned
+			static int get_layer_buffer_slot(
+				const std::map<layer_name_with_action, unsigned int>& action_to_set_map,
+				const layer_name_with_action& action);
+
+		private:
+			// Action with everything resolved but the buffers and the data, buffers are referenced by their slots:
+			// layer buffers come first, dedicated buffers follow in the order of their names, -1 stands for no buffer
+			class step
+			{
+			public:
+				layer_action action;
+				layer::const_ptr layer_schema;
+				layer_updater_plain::const_ptr updater;
+				// Carries the algorithm resolved for the layer
+				plain_running_configuration::const_ptr plain_config;
+				// Points to the element of layer_name_to_action_set_map
+				const std::set<layer_action> * actions;
+				std::vector<layer_configuration_specific> input_configuration_specific_list;
+				layer_configuration_specific output_configuration_specific;
+				unsigned int tiling_factor;
+				int output_buffer_slot;
+				// Set to -1 for inputs the backward action doesn't depend on
+				std::vector<int> input_buffer_slots;
+				int temporary_working_per_entry_buffer_slot;
+				int temporary_per_entry_buffer_slot;
+				int output_neurons_buffer_slot;
+				int output_errors_buffer_slot;
+				bool add_output;
+			};
 
 		private:
 			plain_running_configuration::const_ptr plain_config;
 
 			std::vector<layer_name_with_action> actions_in_execution_order;
+			// Dependencies in the original action schema, the sequential one replaces it
+			std::map<layer_name_with_action, std::vector<layer_name_with_action> > action_to_dependencies_map;
+			// Recompute actions are inserted before the first backward action reading outputs of their segment,
+			// the same as actions_in_execution_order when nothing is recomputed
+			std::vector<layer_name_with_action> actions_with_recompute_in_execution_order;
+			std::set<std::string> recomputed_layer_names;
+			std::set<std::string> fused_softmax_loss_layer_names;
 			std::map<std::string, std::vector<layer_name_with_action> > input_to_all_output_map;
 			std::map<std::string, std::set<layer_action> > layer_name_to_action_set_map;
 
 			std::map<std::string, layer_updater_plain::const_ptr> updaters;
+			// Configuration each updater is called with, it carries the algorithm setup_updaters resolved for the layer and its set of actions
+			std::map<std::string, plain_running_configuration::const_ptr> updater_plain_config_map;
+			// Bucket of the chunk size algorithms are tuned for, 0 until the first run when the heuristic choices are made
+			unsigned int tuning_entry_count;
 
 			size_t temporary_working_fixed_size;
 
 			std::vector<size_t> layer_buffer_set_per_entry_size_list;
+			// Offsets of layer buffers within the allocation of layer_buffers_per_entry_size bytes per entry, empty when offsets are not planned
+			std::vector<size_t> layer_buffer_set_per_entry_offset_list;
+			size_t layer_buffers_per_entry_size;
 			std::map<layer_name_with_action, unsigned int> temporary_working_per_entry_data_action_to_set_map;
 			std::map<layer_name_with_action, unsigned int> layer_buffer_action_to_set_map;
 			std::map<layer_name_with_action, unsigned int> temporary_per_entry_data_action_to_set_map;
@@ -105,6 +168,12 @@ namespace nnforge
 
 			buffer_plain_size_configuration buffer_config_without_data_and_momentum;
 
+			// Actions in execution order compiled by setup_steps
+			std::vector<step> steps;
+
+			// Keeps the memory of the buffers between runs
+			buffer_arena_plain arena;
+
 		private:
 			backward_propagation_plain(const backward_propagation_plain&);
 			backward_propagation_plain& operator =(const backward_propagation_plain&);
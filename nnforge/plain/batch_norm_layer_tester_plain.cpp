@@ -90,5 +90,64 @@ namespace nnforge
 		{
 			return 0;
 		}
+
+		bool batch_norm_layer_tester_plain::is_channel_blocked_layout_supported(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return true;
+		}
+
+		void batch_norm_layer_tester_plain::run_forward_propagation_channel_blocked(
+			plain_buffer::ptr output_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count) const
+		{
+			const unsigned int block_size = plain_config->channel_block_size;
+			const unsigned int block_count = output_configuration_specific.feature_map_count / block_size;
+			const int total_workload = static_cast<int>(entry_count * block_count);
+			float * const out_it = *output_buffer;
+			const float * const in_it = *input_buffers[0];
+			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const size_t block_elem_count = static_cast<size_t>(neuron_count_per_feature_map) * block_size;
+			const float * const gamma = &(*data)[0][0];
+			const float * const beta = &(*data)[1][0];
+			const float * const mean = &(*data)[2][0];
+			const float * const inverse_sigma = &(*data)[3][0];
+
+			#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
+			{
+				std::vector<float> mult(block_size);
+				std::vector<float> add(block_size);
+
+				#pragma omp for schedule(guided)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					const unsigned int entry_id = workload_id / block_count;
+					const unsigned int feature_map_start = (workload_id - entry_id * block_count) * block_size;
+					for(unsigned int lane = 0; lane < block_size; ++lane)
+					{
+						mult[lane] = gamma[feature_map_start + lane] * inverse_sigma[feature_map_start + lane];
+						add[lane] = beta[feature_map_start + lane] - mult[lane] * mean[feature_map_start + lane];
+					}
+
+					const float * current_in_it = in_it + workload_id * block_elem_count;
+					float * current_out_it = out_it + workload_id * block_elem_count;
+					for(unsigned int neuron_id = 0; neuron_id < neuron_count_per_feature_map; ++neuron_id, current_in_it += block_size, current_out_it += block_size)
+						for(unsigned int lane = 0; lane < block_size; ++lane)
+							current_out_it[lane] = current_in_it[lane] * mult[lane] + add[lane];
+				}
+			}
+		}
 	}
 }
@@ -49,6 +49,25 @@ namespace nnforge
 				layer::const_ptr layer_schema,
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
+
+			virtual bool is_channel_blocked_layout_supported(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			virtual void run_forward_propagation_channel_blocked(
+				plain_buffer::ptr output_buffer,
+				const std::vector<plain_buffer::const_ptr>& input_buffers,
+				plain_buffer::ptr temporary_working_fixed_buffer,
+				plain_buffer::ptr temporary_working_per_entry_buffer,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				layer_data::const_ptr data,
+				layer_data_custom::const_ptr data_custom,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count) const;
 		};
 	}
 }
@@ -0,0 +1,442 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "batch_norm_layer_updater_plain.h"
+
+#include "parallel_plain.h"
+#include "simd_kernels_plain.h"
+#include "../batch_norm_layer.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			// Splits the neurons of each feature map into work items of about simd_kernels_plain::chunk_elem_count elements,
+			// an item covers either a range of entries or a range of spatial positions of a single entry.
+			// Items of the same feature map are adjacent, so per item sums are reduced in fixed order
+			class batch_norm_partition
+			{
+			public:
+				struct item
+				{
+					unsigned int feature_map_id;
+					unsigned int entry_start;
+					unsigned int entry_end;
+					unsigned int offset;
+					unsigned int elem_count;
+				};
+
+				batch_norm_partition(
+					const layer_configuration_specific& output_configuration_specific,
+					unsigned int entry_count)
+					: neuron_count(output_configuration_specific.get_neuron_count())
+					, neuron_count_per_feature_map(output_configuration_specific.get_neuron_count_per_feature_map())
+					, feature_map_count(output_configuration_specific.feature_map_count)
+					, entry_count(entry_count)
+				{
+					const unsigned int chunk_elem_count = static_cast<unsigned int>(simd_kernels_plain::chunk_elem_count);
+					spatial_chunk_count = get_max_spatial_chunk_count(neuron_count_per_feature_map);
+					spatial_chunk_size = (neuron_count_per_feature_map + spatial_chunk_count - 1) / spatial_chunk_count;
+					entries_per_item = (spatial_chunk_count > 1) ? 1 : std::max(std::min(chunk_elem_count / neuron_count_per_feature_map, entry_count), 1U);
+					items_per_feature_map = ((entry_count + entries_per_item - 1) / entries_per_item) * spatial_chunk_count;
+				}
+
+				static unsigned int get_max_spatial_chunk_count(unsigned int neuron_count_per_feature_map)
+				{
+					const unsigned int chunk_elem_count = static_cast<unsigned int>(simd_kernels_plain::chunk_elem_count);
+					return std::max((neuron_count_per_feature_map + chunk_elem_count - 1) / chunk_elem_count, 1U);
+				}
+
+				int get_item_count() const
+				{
+					return static_cast<int>(items_per_feature_map * feature_map_count);
+				}
+
+				item get_item(int item_id) const
+				{
+					item res;
+					res.feature_map_id = static_cast<unsigned int>(item_id) / items_per_feature_map;
+					const unsigned int item_id_within_feature_map = static_cast<unsigned int>(item_id) - res.feature_map_id * items_per_feature_map;
+					const unsigned int entry_group_id = item_id_within_feature_map / spatial_chunk_count;
+					const unsigned int spatial_chunk_id = item_id_within_feature_map - entry_group_id * spatial_chunk_count;
+					res.entry_start = entry_group_id * entries_per_item;
+					res.entry_end = std::min(res.entry_start + entries_per_item, entry_count);
+					const unsigned int spatial_start = spatial_chunk_id * spatial_chunk_size;
+					res.offset = res.feature_map_id * neuron_count_per_feature_map + spatial_start;
+					res.elem_count = std::min(spatial_start + spatial_chunk_size, neuron_count_per_feature_map) - spatial_start;
+					return res;
+				}
+
+			public:
+				unsigned int neuron_count;
+				unsigned int neuron_count_per_feature_map;
+				unsigned int feature_map_count;
+				unsigned int entry_count;
+				unsigned int items_per_feature_map;
+
+			private:
+				unsigned int spatial_chunk_count;
+				unsigned int spatial_chunk_size;
+				unsigned int entries_per_item;
+			};
+
+			// Sum and sum of squares of the input in a single pass
+			struct batch_norm_stats_chunk
+			{
+				const batch_norm_partition * partition;
+				const float * in_it;
+				double * partial_sums;
+
+				void operator()(int start, int end) const
+				{
+					for(int item_id = start; item_id < end; ++item_id)
+					{
+						const batch_norm_partition::item current_item = partition->get_item(item_id);
+						double sum = 0.0;
+						double sum_squared = 0.0;
+						for(unsigned int entry_id = current_item.entry_start; entry_id < current_item.entry_end; ++entry_id)
+						{
+							const float * current_in_it = in_it + static_cast<size_t>(entry_id) * partition->neuron_count + current_item.offset;
+							for(unsigned int i = 0; i < current_item.elem_count; ++i)
+							{
+								double val = static_cast<double>(current_in_it[i]);
+								sum += val;
+								sum_squared += val * val;
+							}
+						}
+						partial_sums[item_id * 2] = sum;
+						partial_sums[item_id * 2 + 1] = sum_squared;
+					}
+				}
+			};
+
+			// Sum of output errors and sum of output errors multiplied by centered input
+			struct batch_norm_backward_stats_chunk
+			{
+				const batch_norm_partition * partition;
+				const float * in_it;
+				const float * out_err_it;
+				const float * mean;
+				double * partial_sums;
+
+				void operator()(int start, int end) const
+				{
+					for(int item_id = start; item_id < end; ++item_id)
+					{
+						const batch_norm_partition::item current_item = partition->get_item(item_id);
+						const float current_mean = mean[current_item.feature_map_id];
+						double sum = 0.0;
+						double sum_centered = 0.0;
+						for(unsigned int entry_id = current_item.entry_start; entry_id < current_item.entry_end; ++entry_id)
+						{
+							const size_t entry_offset = static_cast<size_t>(entry_id) * partition->neuron_count + current_item.offset;
+							const float * current_in_it = in_it + entry_offset;
+							const float * current_out_err_it = out_err_it + entry_offset;
+							for(unsigned int i = 0; i < current_item.elem_count; ++i)
+							{
+								double err = static_cast<double>(current_out_err_it[i]);
+								sum += err;
+								sum_centered += err * static_cast<double>(current_in_it[i] - current_mean);
+							}
+						}
+						partial_sums[item_id * 2] = sum;
+						partial_sums[item_id * 2 + 1] = sum_centered;
+					}
+				}
+			};
+
+			// dst = src * mult + add, with per feature map mult and add, is used both for forward and backward data
+			struct batch_norm_affine_chunk
+			{
+				const batch_norm_partition * partition;
+				const float * in_it;
+				float * out_it;
+				const float * mult;
+				const float * add;
+
+				void operator()(int start, int end) const
+				{
+					for(int item_id = start; item_id < end; ++item_id)
+					{
+						const batch_norm_partition::item current_item = partition->get_item(item_id);
+						const float current_mult = mult[current_item.feature_map_id];
+						const float current_add = add[current_item.feature_map_id];
+						for(unsigned int entry_id = current_item.entry_start; entry_id < current_item.entry_end; ++entry_id)
+						{
+							const size_t entry_offset = static_cast<size_t>(entry_id) * partition->neuron_count + current_item.offset;
+							const float * current_in_it = in_it + entry_offset;
+							float * current_out_it = out_it + entry_offset;
+							for(unsigned int i = 0; i < current_item.elem_count; ++i)
+								current_out_it[i] = current_in_it[i] * current_mult + current_add;
+						}
+					}
+				}
+			};
+
+			// input_err (+)= output_err * err_mult + input * in_mult + add
+			struct batch_norm_backward_data_chunk
+			{
+				const batch_norm_partition * partition;
+				const float * in_it;
+				const float * out_err_it;
+				float * in_err_it;
+				const float * err_mult;
+				const float * in_mult;
+				const float * add;
+				bool add_update_to_destination;
+
+				void operator()(int start, int end) const
+				{
+					for(int item_id = start; item_id < end; ++item_id)
+					{
+						const batch_norm_partition::item current_item = partition->get_item(item_id);
+						const float current_err_mult = err_mult[current_item.feature_map_id];
+						const float current_in_mult = in_mult[current_item.feature_map_id];
+						const float current_add = add[current_item.feature_map_id];
+						for(unsigned int entry_id = current_item.entry_start; entry_id < current_item.entry_end; ++entry_id)
+						{
+							const size_t entry_offset = static_cast<size_t>(entry_id) * partition->neuron_count + current_item.offset;
+							const float * current_in_it = in_it + entry_offset;
+							const float * current_out_err_it = out_err_it + entry_offset;
+							float * current_in_err_it = in_err_it + entry_offset;
+							if (add_update_to_destination)
+							{
+								for(unsigned int i = 0; i < current_item.elem_count; ++i)
+									current_in_err_it[i] += current_out_err_it[i] * current_err_mult + current_in_it[i] * current_in_mult + current_add;
+							}
+							else
+							{
+								for(unsigned int i = 0; i < current_item.elem_count; ++i)
+									current_in_err_it[i] = current_out_err_it[i] * current_err_mult + current_in_it[i] * current_in_mult + current_add;
+							}
+						}
+					}
+				}
+			};
+		}
+
+		const float batch_norm_layer_updater_plain::mean_and_variance_gradient_slope = 1.0F; // As if it were MSE/2
+
+		batch_norm_layer_updater_plain::batch_norm_layer_updater_plain()
+		{
+		}
+
+		batch_norm_layer_updater_plain::~batch_norm_layer_updater_plain()
+		{
+		}
+
+		std::string batch_norm_layer_updater_plain::get_type_name() const
+		{
+			return batch_norm_layer::layer_type_name;
+		}
+
+		void batch_norm_layer_updater_plain::run_forward_propagation(
+			plain_buffer::ptr output_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_buffer::ptr temporary_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const std::set<layer_action>& actions,
+			unsigned int entry_count) const
+		{
+			nnforge_shared_ptr<const batch_norm_layer> layer_derived = nnforge_dynamic_pointer_cast<const batch_norm_layer>(layer_schema);
+			const unsigned int feature_map_count = output_configuration_specific.feature_map_count;
+			const batch_norm_partition partition(output_configuration_specific, entry_count);
+			double * const partial_sums = *temporary_working_per_entry_buffer;
+
+			{
+				batch_norm_stats_chunk body;
+				body.partition = &partition;
+				body.in_it = *input_buffers[0];
+				body.partial_sums = partial_sums;
+				parallel_plain::parallel_for(*plain_config, partition.get_item_count(), body);
+			}
+
+			// Batch mean and inverse sigma are kept for backward prop
+			float * const mean = *temporary_per_entry_buffer;
+			float * const inverse_sigma = mean + feature_map_count;
+			std::vector<float> mult(feature_map_count);
+			std::vector<float> add(feature_map_count);
+			const double elem_count = static_cast<double>(entry_count) * static_cast<double>(partition.neuron_count_per_feature_map);
+			for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+			{
+				double sum = 0.0;
+				double sum_squared = 0.0;
+				const double * current_partial_sums = partial_sums + feature_map_id * partition.items_per_feature_map * 2;
+				for(unsigned int i = 0; i < partition.items_per_feature_map; ++i)
+				{
+					sum += current_partial_sums[i * 2];
+					sum_squared += current_partial_sums[i * 2 + 1];
+				}
+				double current_mean = sum / elem_count;
+				double variance = std::max(sum_squared / elem_count - current_mean * current_mean, 0.0);
+				float current_inverse_sigma = static_cast<float>(1.0 / sqrt(variance + static_cast<double>(layer_derived->epsilon)));
+				mean[feature_map_id] = static_cast<float>(current_mean);
+				inverse_sigma[feature_map_id] = current_inverse_sigma;
+				mult[feature_map_id] = (*data)[0][feature_map_id] * current_inverse_sigma;
+				add[feature_map_id] = (*data)[1][feature_map_id] - mult[feature_map_id] * mean[feature_map_id];
+			}
+
+			{
+				batch_norm_affine_chunk body;
+				body.partition = &partition;
+				body.in_it = *input_buffers[0];
+				body.out_it = *output_buffer;
+				body.mult = &mult[0];
+				body.add = &add[0];
+				parallel_plain::parallel_for(*plain_config, partition.get_item_count(), body);
+			}
+		}
+
+		void batch_norm_layer_updater_plain::run_backward_data_and_weights_propagation(
+			plain_buffer::ptr input_errors_buffer,
+			plain_buffer::const_ptr output_errors_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+			plain_buffer::const_ptr output_neurons_buffer,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_buffer::ptr temporary_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data::ptr gradient,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const bool add_update_to_destination,
+			const std::set<layer_action>& actions,
+			unsigned int entry_count) const
+		{
+			const unsigned int feature_map_count = output_configuration_specific.feature_map_count;
+			const batch_norm_partition partition(output_configuration_specific, entry_count);
+			double * const partial_sums = *temporary_working_per_entry_buffer;
+			const float * const mean = *temporary_per_entry_buffer;
+			const float * const inverse_sigma = mean + feature_map_count;
+
+			{
+				batch_norm_backward_stats_chunk body;
+				body.partition = &partition;
+				body.in_it = *input_neurons_buffers[0];
+				body.out_err_it = *output_errors_buffer;
+				body.mean = mean;
+				body.partial_sums = partial_sums;
+				parallel_plain::parallel_for(*plain_config, partition.get_item_count(), body);
+			}
+
+			// input_err = gamma * inverse_sigma * (output_err - (sum(output_err) + normalized_input * sum(output_err * normalized_input)) / elem_count)
+			std::vector<float> err_mult(feature_map_count);
+			std::vector<float> in_mult(feature_map_count);
+			std::vector<float> add(feature_map_count);
+			const double elem_count = static_cast<double>(entry_count) * static_cast<double>(partition.neuron_count_per_feature_map);
+			const float running_stats_mult = mean_and_variance_gradient_slope * static_cast<float>(entry_count);
+			for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+			{
+				double sum = 0.0;
+				double sum_centered = 0.0;
+				const double * current_partial_sums = partial_sums + feature_map_id * partition.items_per_feature_map * 2;
+				for(unsigned int i = 0; i < partition.items_per_feature_map; ++i)
+				{
+					sum += current_partial_sums[i * 2];
+					sum_centered += current_partial_sums[i * 2 + 1];
+				}
+				const double current_inverse_sigma = static_cast<double>(inverse_sigma[feature_map_id]);
+				const double gamma_gradient = sum_centered * current_inverse_sigma;
+				const double current_err_mult = static_cast<double>((*data)[0][feature_map_id]) * current_inverse_sigma;
+				const double current_in_mult = -current_err_mult * gamma_gradient * current_inverse_sigma / elem_count;
+				err_mult[feature_map_id] = static_cast<float>(current_err_mult);
+				in_mult[feature_map_id] = static_cast<float>(current_in_mult);
+				add[feature_map_id] = static_cast<float>(-current_err_mult * sum / elem_count - current_in_mult * static_cast<double>(mean[feature_map_id]));
+
+				(*gradient)[0][feature_map_id] += static_cast<float>(gamma_gradient);
+				(*gradient)[1][feature_map_id] += static_cast<float>(sum);
+				(*gradient)[2][feature_map_id] += running_stats_mult * (mean[feature_map_id] - (*data)[2][feature_map_id]);
+				(*gradient)[3][feature_map_id] += running_stats_mult * (inverse_sigma[feature_map_id] - (*data)[3][feature_map_id]);
+			}
+
+			{
+				batch_norm_backward_data_chunk body;
+				body.partition = &partition;
+				body.in_it = *input_neurons_buffers[0];
+				body.out_err_it = *output_errors_buffer;
+				body.in_err_it = *input_errors_buffer;
+				body.err_mult = &err_mult[0];
+				body.in_mult = &in_mult[0];
+				body.add = &add[0];
+				body.add_update_to_destination = add_update_to_destination;
+				parallel_plain::parallel_for(*plain_config, partition.get_item_count(), body);
+			}
+		}
+
+		int batch_norm_layer_updater_plain::get_input_index_layer_can_write(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			if (action.get_action_type() == layer_action::backward_data_and_weights)
+				return 0;
+			else
+				return -1;
+		}
+
+		size_t batch_norm_layer_updater_plain::get_temporary_working_per_entry_buffer_size(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			// Per item sums, there are at most that many items per entry
+			unsigned int max_item_count_per_entry = output_configuration_specific.feature_map_count * batch_norm_partition::get_max_spatial_chunk_count(output_configuration_specific.get_neuron_count_per_feature_map());
+			return max_item_count_per_entry * 2 * sizeof(double);
+		}
+
+		size_t batch_norm_layer_updater_plain::get_temporary_per_entry_buffer_size(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			// Batch mean and inverse sigma, only the part of the first entry is actually used
+			return output_configuration_specific.feature_map_count * 2 * sizeof(float);
+		}
+
+		bool batch_norm_layer_updater_plain::is_backward_data_and_weights_dependent_on_output_buffer(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return false;
+		}
+	}
+}
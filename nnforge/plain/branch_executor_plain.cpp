@@ -0,0 +1,264 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include "branch_executor_plain.h"
+
+#include "../neural_network_exception.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <exception>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			// State of a single run shared by the workers
+			class branch_execution_state
+			{
+			public:
+				branch_execution_state(
+					const std::vector<layer_name_with_action>& actions_in_execution_order,
+					const std::vector<std::vector<unsigned int> >& dependent_action_id_list,
+					const std::vector<unsigned int>& dependency_count_list,
+					branch_executor_plain::action_runner& runner)
+					: actions_in_execution_order(actions_in_execution_order)
+					, dependent_action_id_list(dependent_action_id_list)
+					, remaining_dependency_count_list(dependency_count_list)
+					, runner(runner)
+					, done_action_count(0)
+					, failed(false)
+				{
+					for(unsigned int action_id = 0; action_id < static_cast<unsigned int>(remaining_dependency_count_list.size()); ++action_id)
+						if (remaining_dependency_count_list[action_id] == 0)
+							ready_action_id_set.insert(action_id);
+				}
+
+				void run_worker(unsigned int worker_id)
+				{
+					boost::unique_lock<boost::mutex> lock(state_mutex);
+					while (true)
+					{
+						while (ready_action_id_set.empty() && (done_action_count < actions_in_execution_order.size()) && !failed)
+							state_changed.wait(lock);
+						if ((done_action_count == actions_in_execution_order.size()) || failed)
+							return;
+
+						unsigned int action_id = *ready_action_id_set.begin();
+						ready_action_id_set.erase(ready_action_id_set.begin());
+
+						lock.unlock();
+						try
+						{
+							runner.run_action(action_id, worker_id);
+						}
+						catch (const std::exception& e)
+						{
+							lock.lock();
+							if (!failed)
+							{
+								failed = true;
+								error_message = e.what();
+							}
+							state_changed.notify_all();
+							return;
+						}
+						lock.lock();
+
+						++done_action_count;
+						const std::vector<unsigned int>& dependent_action_ids = dependent_action_id_list[action_id];
+						for(std::vector<unsigned int>::const_iterator it = dependent_action_ids.begin(); it != dependent_action_ids.end(); ++it)
+							if (--remaining_dependency_count_list[*it] == 0)
+								ready_action_id_set.insert(*it);
+						state_changed.notify_all();
+					}
+				}
+
+				// Worker ids are handed out to the tasks, so that actions running concurrently never get the same one
+				void start_on_scheduler(
+					work_stealing_scheduler::task_group& group,
+					unsigned int worker_count)
+				{
+					boost::lock_guard<boost::mutex> lock(state_mutex);
+					for(unsigned int worker_id = worker_count; worker_id > 0; --worker_id)
+						free_worker_id_list.push_back(worker_id - 1);
+					post_ready_actions(group);
+				}
+
+				bool is_failed() const
+				{
+					return failed;
+				}
+
+				const std::string& get_error_message() const
+				{
+					return error_message;
+				}
+
+			private:
+				// Should be called with state_mutex locked
+				void post_ready_actions(work_stealing_scheduler::task_group& group)
+				{
+					while (!ready_action_id_set.empty() && !free_worker_id_list.empty() && !failed)
+					{
+						unsigned int action_id = *ready_action_id_set.begin();
+						ready_action_id_set.erase(ready_action_id_set.begin());
+						unsigned int worker_id = free_worker_id_list.back();
+						free_worker_id_list.pop_back();
+						group.run(boost::bind(&branch_execution_state::run_task, this, boost::ref(group), action_id, worker_id));
+					}
+				}
+
+				void run_task(
+					work_stealing_scheduler::task_group& group,
+					unsigned int action_id,
+					unsigned int worker_id)
+				{
+					try
+					{
+						runner.run_action(action_id, worker_id);
+					}
+					catch (const std::exception& e)
+					{
+						boost::lock_guard<boost::mutex> lock(state_mutex);
+						if (!failed)
+						{
+							failed = true;
+							error_message = e.what();
+						}
+						return;
+					}
+
+					boost::lock_guard<boost::mutex> lock(state_mutex);
+					++done_action_count;
+					free_worker_id_list.push_back(worker_id);
+					const std::vector<unsigned int>& dependent_action_ids = dependent_action_id_list[action_id];
+					for(std::vector<unsigned int>::const_iterator it = dependent_action_ids.begin(); it != dependent_action_ids.end(); ++it)
+						if (--remaining_dependency_count_list[*it] == 0)
+							ready_action_id_set.insert(*it);
+					post_ready_actions(group);
+				}
+
+			private:
+				const std::vector<layer_name_with_action>& actions_in_execution_order;
+				const std::vector<std::vector<unsigned int> >& dependent_action_id_list;
+				std::vector<unsigned int> remaining_dependency_count_list;
+				branch_executor_plain::action_runner& runner;
+
+				// Ordered by execution order, so that workers follow the same path the sequential execution does when possible
+				std::set<unsigned int> ready_action_id_set;
+				// Used when running on the scheduler only, the most recently freed id is taken first
+				std::vector<unsigned int> free_worker_id_list;
+				size_t done_action_count;
+				bool failed;
+				std::string error_message;
+
+				boost::mutex state_mutex;
+				boost::condition_variable state_changed;
+
+			private:
+				branch_execution_state(const branch_execution_state&);
+				branch_execution_state& operator =(const branch_execution_state&);
+			};
+
+			class branch_worker_task : public worker_pool_plain::task
+			{
+			public:
+				branch_worker_task(branch_execution_state& state)
+					: state(state)
+				{
+				}
+
+				virtual void run(unsigned int worker_id)
+				{
+					state.run_worker(worker_id);
+				}
+
+			private:
+				branch_execution_state& state;
+			};
+		}
+
+		branch_executor_plain::branch_executor_plain()
+		{
+		}
+
+		branch_executor_plain::branch_executor_plain(
+			const network_action_schema& schema,
+			const std::vector<layer_name_with_action>& actions_in_execution_order)
+			: actions_in_execution_order(actions_in_execution_order)
+			, dependent_action_id_list(actions_in_execution_order.size())
+			, dependency_count_list(actions_in_execution_order.size(), 0)
+		{
+			std::map<layer_name_with_action, unsigned int> action_to_id_map;
+			for(unsigned int action_id = 0; action_id < static_cast<unsigned int>(actions_in_execution_order.size()); ++action_id)
+				action_to_id_map.insert(std::make_pair(actions_in_execution_order[action_id], action_id));
+
+			for(unsigned int action_id = 0; action_id < static_cast<unsigned int>(actions_in_execution_order.size()); ++action_id)
+			{
+				std::vector<layer_name_with_action> dependencies = schema.get_dependencies(actions_in_execution_order[action_id]);
+				for(std::vector<layer_name_with_action>::const_iterator it = dependencies.begin(); it != dependencies.end(); ++it)
+				{
+					std::map<layer_name_with_action, unsigned int>::const_iterator it2 = action_to_id_map.find(*it);
+					if (it2 == action_to_id_map.end())
+						throw neural_network_exception((boost::format("Dependency %1% of action %2% for layer %3% is not in the execution order") % it->get_name() % actions_in_execution_order[action_id].get_action().str() % actions_in_execution_order[action_id].get_name()).str());
+					dependent_action_id_list[it2->second].push_back(action_id);
+					++dependency_count_list[action_id];
+				}
+			}
+		}
+
+		void branch_executor_plain::run(
+			action_runner& runner,
+			worker_pool_plain& workers) const
+		{
+			branch_execution_state state(actions_in_execution_order, dependent_action_id_list, dependency_count_list, runner);
+
+			branch_worker_task task(state);
+			workers.run(task);
+
+			if (state.is_failed())
+				throw neural_network_exception((boost::format("Concurrent branch execution failed: %1%") % state.get_error_message()).str());
+		}
+
+		void branch_executor_plain::run(
+			action_runner& runner,
+			work_stealing_scheduler& scheduler,
+			unsigned int worker_count) const
+		{
+			branch_execution_state state(actions_in_execution_order, dependent_action_id_list, dependency_count_list, runner);
+
+			// Tasks catch the errors of the actions themselves, the group is waited for before the state goes away
+			{
+				work_stealing_scheduler::task_group group(scheduler);
+				state.start_on_scheduler(group, std::max(worker_count, 1U));
+				group.wait();
+			}
+
+			if (state.is_failed())
+				throw neural_network_exception((boost::format("Concurrent branch execution failed: %1%") % state.get_error_message()).str());
+		}
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include "../layer_name_with_action.h"
+#include "../network_action_schema.h"
+#include "../work_stealing_scheduler.h"
+#include "worker_pool_plain.h"
+
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Runs actions of the schema on several worker threads respecting their dependencies,
+		// each worker takes the earliest action in execution order which has all its dependencies done
+		class branch_executor_plain
+		{
+		public:
+			class action_runner
+			{
+			public:
+				virtual ~action_runner()
+				{
+				}
+
+				// action_id is the index of the action in execution order,
+				// worker_id is in [0, worker_count) range, actions run by the same worker never overlap
+				virtual void run_action(
+					unsigned int action_id,
+					unsigned int worker_id) = 0;
+			};
+
+			branch_executor_plain();
+
+			branch_executor_plain(
+				const network_action_schema& schema,
+				const std::vector<layer_name_with_action>& actions_in_execution_order);
+
+			// Returns when all the actions are done, the first exception thrown by an action is rethrown as neural_network_exception
+			// Actions are run on all the workers of the pool, the calling thread is worker 0
+			void run(
+				action_runner& runner,
+				worker_pool_plain& workers) const;
+
+			// Runs each action as a task of the scheduler once it has all its dependencies done and one of worker_count worker ids is free,
+			// threads of the scheduler are not blocked waiting for dependencies then, and the calling thread takes part in running the tasks
+			void run(
+				action_runner& runner,
+				work_stealing_scheduler& scheduler,
+				unsigned int worker_count) const;
+
+		private:
+			std::vector<layer_name_with_action> actions_in_execution_order;
+			std::vector<std::vector<unsigned int> > dependent_action_id_list;
+			std::vector<unsigned int> dependency_count_list;
+		};
+	}
+}
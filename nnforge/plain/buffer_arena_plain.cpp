@@ -0,0 +1,179 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include "buffer_arena_plain.h"
+
+#include "../neural_network_exception.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <boost/format.hpp>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const size_t buffer_arena_plain::buffer_alignment = 64;
+		const size_t buffer_arena_plain::page_size = 4096;
+		const size_t buffer_arena_plain::huge_page_size = 2 * 1024 * 1024;
+
+		buffer_arena_plain::buffer_arena_plain(bool huge_pages)
+			: huge_pages(huge_pages)
+			, block_size(0)
+			, offset(0)
+			, run_allocated_size(0)
+			, high_water_mark(0)
+		{
+		}
+
+		buffer_arena_plain::~buffer_arena_plain()
+		{
+		}
+
+		bool buffer_arena_plain::begin_run(size_t required_size)
+		{
+			offset = 0;
+			run_allocated_size = 0;
+
+			if (required_size <= block_size)
+				return false;
+
+			// Buffers still alive from the previous run hold the old block
+			block.reset();
+			block_size = 0;
+			void * ptr = allocate_block(required_size, huge_pages);
+			block = nnforge_shared_ptr<void>(ptr, free_block);
+			block_size = required_size;
+
+			return true;
+		}
+
+		plain_buffer::ptr buffer_arena_plain::allocate(size_t size)
+		{
+			size_t aligned_size = get_aligned_size(size);
+			run_allocated_size += aligned_size;
+			high_water_mark = std::max(high_water_mark, run_allocated_size);
+
+			if (offset + aligned_size > block_size)
+				return plain_buffer::ptr(new plain_buffer(size));
+
+			plain_buffer::ptr res(new plain_buffer(static_cast<char *>(block.get()) + offset, size, block));
+			offset += aligned_size;
+			return res;
+		}
+
+		std::vector<plain_buffer::ptr> buffer_arena_plain::allocate_slots(
+			const std::vector<size_t>& per_entry_size_list,
+			const std::vector<size_t>& per_entry_offset_list,
+			size_t arena_per_entry_size,
+			unsigned int entry_count)
+		{
+			std::vector<plain_buffer::ptr> res;
+			if (per_entry_offset_list.empty())
+			{
+				for(std::vector<size_t>::const_iterator it = per_entry_size_list.begin(); it != per_entry_size_list.end(); ++it)
+					res.push_back(allocate(*it * entry_count));
+			}
+			else
+			{
+				plain_buffer::ptr slots_buffer = allocate(arena_per_entry_size * entry_count);
+				for(unsigned int slot_id = 0; slot_id < static_cast<unsigned int>(per_entry_size_list.size()); ++slot_id)
+					res.push_back(plain_buffer::ptr(new plain_buffer(static_cast<unsigned char *>(*slots_buffer) + per_entry_offset_list[slot_id] * entry_count, per_entry_size_list[slot_id] * entry_count, slots_buffer)));
+			}
+
+			return res;
+		}
+
+		size_t buffer_arena_plain::get_slots_size(
+			const std::vector<size_t>& per_entry_size_list,
+			const std::vector<size_t>& per_entry_offset_list,
+			size_t arena_per_entry_size,
+			unsigned int entry_count)
+		{
+			if (!per_entry_offset_list.empty())
+				return get_aligned_size(arena_per_entry_size * entry_count);
+
+			size_t res = 0;
+			for(std::vector<size_t>::const_iterator it = per_entry_size_list.begin(); it != per_entry_size_list.end(); ++it)
+				res += get_aligned_size(*it * entry_count);
+			return res;
+		}
+
+		void buffer_arena_plain::release()
+		{
+			block.reset();
+			block_size = 0;
+			offset = 0;
+		}
+
+		size_t buffer_arena_plain::get_size() const
+		{
+			return block_size;
+		}
+
+		size_t buffer_arena_plain::get_high_water_mark() const
+		{
+			return high_water_mark;
+		}
+
+		size_t buffer_arena_plain::get_aligned_size(size_t size)
+		{
+			return (size + buffer_alignment - 1) / buffer_alignment * buffer_alignment;
+		}
+
+		void * buffer_arena_plain::allocate_block(
+			size_t size,
+			bool huge_pages)
+		{
+			const size_t alignment = (huge_pages && (size >= huge_page_size)) ? huge_page_size : page_size;
+			const size_t allocated_size = (size + alignment - 1) / alignment * alignment;
+
+			void * res;
+			#ifdef _WIN32
+			res = _aligned_malloc(allocated_size, alignment);
+			#else
+			if (posix_memalign(&res, alignment, allocated_size) != 0)
+				res = 0;
+			#endif
+			if (!res)
+				throw neural_network_exception((boost::format("Unable to allocate %1% bytes for plain buffer arena") % allocated_size).str());
+
+			#if defined(__linux__) && defined(MADV_HUGEPAGE)
+			// The advice is a hint only, the arena works with regular pages if THP is disabled
+			if (alignment == huge_page_size)
+				madvise(res, allocated_size, MADV_HUGEPAGE);
+			#endif
+
+			return res;
+		}
+
+		void buffer_arena_plain::free_block(void * ptr)
+		{
+			#ifdef _WIN32
+			_aligned_free(ptr);
+			#else
+			free(ptr);
+			#endif
+		}
+	}
+}
@@ -0,0 +1,100 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include "plain_buffer.h"
+
+#include "../nn_types.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Memory for the buffers of a single propagation run, kept between runs until the buffer plan changes
+		// The arena is a single page aligned block, buffers are carved from it with cache line alignment
+		class buffer_arena_plain
+		{
+		public:
+			// When huge_pages is true large blocks are aligned to huge pages and advised to be backed by transparent huge pages
+			buffer_arena_plain(bool huge_pages);
+
+			~buffer_arena_plain();
+
+			// Starts a new run, required_size is the sum of get_aligned_size of all the buffers allocated during it;
+			// buffers allocated earlier should not be used afterwards;
+			// returns true when a new block is allocated, its pages are not touched yet then
+			bool begin_run(size_t required_size);
+
+			// The buffer is allocated separately when the arena is exhausted
+			plain_buffer::ptr allocate(size_t size);
+
+			// Allocates a buffer of per_entry_size_list[i] * entry_count bytes for each slot; when per_entry_offset_list is not empty
+			// the buffers are views of a single allocation of arena_per_entry_size * entry_count bytes at offsets scaled by entry_count,
+			// views overlap as planned by network_action_schema::get_buffer_offsets
+			std::vector<plain_buffer::ptr> allocate_slots(
+				const std::vector<size_t>& per_entry_size_list,
+				const std::vector<size_t>& per_entry_offset_list,
+				size_t arena_per_entry_size,
+				unsigned int entry_count);
+
+			// Frees the memory, the next run reallocates it
+			void release();
+
+			size_t get_size() const;
+
+			// Maximum memory allocated during a single run, including buffers which didn't fit the arena
+			size_t get_high_water_mark() const;
+
+			static size_t get_aligned_size(size_t size);
+
+			// Arena size taken by allocate_slots
+			static size_t get_slots_size(
+				const std::vector<size_t>& per_entry_size_list,
+				const std::vector<size_t>& per_entry_offset_list,
+				size_t arena_per_entry_size,
+				unsigned int entry_count);
+
+			static const size_t buffer_alignment;
+
+		private:
+			static void * allocate_block(
+				size_t size,
+				bool huge_pages);
+
+			static void free_block(void * ptr);
+
+		private:
+			bool huge_pages;
+			nnforge_shared_ptr<void> block;
+			size_t block_size;
+			size_t offset;
+			size_t run_allocated_size;
+			size_t high_water_mark;
+
+			static const size_t page_size;
+			static const size_t huge_page_size;
+
+		private:
+			buffer_arena_plain(const buffer_arena_plain&);
+			buffer_arena_plain& operator =(const buffer_arena_plain&);
+		};
+	}
+}
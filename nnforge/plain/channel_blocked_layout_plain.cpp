@@ -0,0 +1,76 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "channel_blocked_layout_plain.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		bool channel_blocked_layout_plain::is_compatible(
+			const layer_configuration_specific& config,
+			unsigned int block_size)
+		{
+			return (block_size > 0) && (config.feature_map_count % block_size == 0);
+		}
+
+		void channel_blocked_layout_plain::to_blocked(
+			const float * input,
+			float * output,
+			unsigned int feature_map_count,
+			unsigned int neuron_count_per_feature_map,
+			unsigned int block_size,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			const unsigned int block_count = feature_map_count / block_size;
+			const size_t block_elem_count = static_cast<size_t>(neuron_count_per_feature_map) * block_size;
+			const int total_workload = static_cast<int>(entry_count * block_count);
+			#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				const float * src = input + workload_id * block_elem_count;
+				float * dst = output + workload_id * block_elem_count;
+				for(unsigned int neuron_id = 0; neuron_id < neuron_count_per_feature_map; ++neuron_id)
+					for(unsigned int lane = 0; lane < block_size; ++lane)
+						dst[neuron_id * block_size + lane] = src[lane * neuron_count_per_feature_map + neuron_id];
+			}
+		}
+
+		void channel_blocked_layout_plain::to_plain(
+			const float * input,
+			float * output,
+			unsigned int feature_map_count,
+			unsigned int neuron_count_per_feature_map,
+			unsigned int block_size,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			const unsigned int block_count = feature_map_count / block_size;
+			const size_t block_elem_count = static_cast<size_t>(neuron_count_per_feature_map) * block_size;
+			const int total_workload = static_cast<int>(entry_count * block_count);
+			#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				const float * src = input + workload_id * block_elem_count;
+				float * dst = output + workload_id * block_elem_count;
+				for(unsigned int lane = 0; lane < block_size; ++lane)
+					for(unsigned int neuron_id = 0; neuron_id < neuron_count_per_feature_map; ++neuron_id)
+						dst[lane * neuron_count_per_feature_map + neuron_id] = src[neuron_id * block_size + lane];
+			}
+		}
+	}
+}
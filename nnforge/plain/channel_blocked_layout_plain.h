@@ -0,0 +1,57 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../layer_configuration_specific.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Conversions between plain [entry][feature_map][spatial] layout and channel blocked
+		// [entry][feature_map_block][spatial][feature_map_in_block] layout of activations
+		class channel_blocked_layout_plain
+		{
+		public:
+			static bool is_compatible(
+				const layer_configuration_specific& config,
+				unsigned int block_size);
+
+			static void to_blocked(
+				const float * input,
+				float * output,
+				unsigned int feature_map_count,
+				unsigned int neuron_count_per_feature_map,
+				unsigned int block_size,
+				unsigned int entry_count,
+				int thread_count);
+
+			static void to_plain(
+				const float * input,
+				float * output,
+				unsigned int feature_map_count,
+				unsigned int neuron_count_per_feature_map,
+				unsigned int block_size,
+				unsigned int entry_count,
+				int thread_count);
+
+		private:
+			channel_blocked_layout_plain();
+			~channel_blocked_layout_plain();
+		};
+	}
+}
@@ -0,0 +1,285 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include "chunk_pipeline_plain.h"
+
+#include "../neural_network_exception.h"
+
+#include <algorithm>
+#include <exception>
+#include <boost/format.hpp>
+#include <boost/chrono.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const unsigned int chunk_pipeline_plain::buffer_set_count = 3;
+		const char * chunk_pipeline_plain::reader_pseudo_layer_name = "[reader]";
+		const char * chunk_pipeline_plain::writer_pseudo_layer_name = "[writer]";
+
+		chunk_pipeline_plain::chunk_pipeline_plain(
+			structured_data_bunch_reader& reader,
+			structured_data_bunch_writer& writer,
+			const std::map<std::string, size_t>& dedicated_per_entry_data_name_to_size_map,
+			const std::set<std::string>& data_layer_names,
+			const std::vector<std::string>& output_layer_names,
+			unsigned int output_layers_tiling_factor,
+			const std::vector<unsigned int>& chunk_entry_count_list,
+			unsigned int reader_thread_count,
+			buffer_arena_plain& arena)
+			: reader(reader)
+			, writer(writer)
+			, dedicated_per_entry_data_name_to_size_map(dedicated_per_entry_data_name_to_size_map)
+			, data_layer_names(data_layer_names)
+			, output_layer_names(output_layer_names)
+			, output_layers_tiling_factor(output_layers_tiling_factor)
+			, chunk_entry_count_list(chunk_entry_count_list)
+			, reader_thread_count(reader_thread_count)
+			, current_chunk_valid(false)
+			, reading_finished(false)
+			, writing_in_progress(false)
+			, stop_requested(false)
+			, read_seconds(0.0)
+			, write_seconds(0.0)
+		{
+			if (chunk_entry_count_list.empty())
+				throw neural_network_exception("Empty chunk entry count list passed to chunk pipeline");
+
+			unsigned int max_chunk_entry_count = *std::max_element(chunk_entry_count_list.begin(), chunk_entry_count_list.end());
+			buffer_sets.resize(buffer_set_count);
+			for(unsigned int buffer_set_id = 0; buffer_set_id < buffer_set_count; ++buffer_set_id)
+			{
+				for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
+					buffer_sets[buffer_set_id].insert(std::make_pair(it->first, arena.allocate(it->second * max_chunk_entry_count)));
+				free_buffer_set_ids.push_back(buffer_set_id);
+			}
+
+			reader_thread = boost::thread(&chunk_pipeline_plain::read_chunks, this);
+			writer_thread = boost::thread(&chunk_pipeline_plain::write_chunks, this);
+		}
+
+		chunk_pipeline_plain::~chunk_pipeline_plain()
+		{
+			{
+				boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+				stop_requested = true;
+				pipeline_changed.notify_all();
+			}
+
+			reader_thread.join();
+			writer_thread.join();
+		}
+
+		size_t chunk_pipeline_plain::get_arena_size(
+			const std::map<std::string, size_t>& dedicated_per_entry_data_name_to_size_map,
+			unsigned int max_chunk_entry_count)
+		{
+			size_t res = 0;
+			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
+				res += buffer_arena_plain::get_aligned_size(it->second * max_chunk_entry_count);
+
+			return res * buffer_set_count;
+		}
+
+		bool chunk_pipeline_plain::get_next_chunk(
+			std::map<std::string, plain_buffer::ptr>& dedicated_buffers,
+			unsigned int& entry_count)
+		{
+			boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+
+			if (current_chunk_valid)
+				throw neural_network_exception("Next chunk requested before the current one is passed to writing");
+
+			while (read_chunk_queue.empty() && !reading_finished && error_message.empty())
+				pipeline_changed.wait(lock);
+			check_error();
+
+			if (read_chunk_queue.empty())
+				return false;
+
+			current_chunk = read_chunk_queue.front();
+			read_chunk_queue.pop_front();
+			current_chunk_valid = true;
+
+			const std::map<std::string, plain_buffer::ptr>& buffers = buffer_sets[current_chunk.buffer_set_id];
+			for(std::map<std::string, plain_buffer::ptr>::const_iterator it = buffers.begin(); it != buffers.end(); ++it)
+				dedicated_buffers[it->first] = it->second;
+			entry_count = current_chunk.entry_count;
+
+			return true;
+		}
+
+		void chunk_pipeline_plain::write_chunk()
+		{
+			boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+
+			if (!current_chunk_valid)
+				throw neural_network_exception("No current chunk to write");
+
+			write_chunk_queue.push_back(current_chunk);
+			current_chunk_valid = false;
+			pipeline_changed.notify_all();
+		}
+
+		void chunk_pipeline_plain::finish()
+		{
+			boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+
+			while ((!write_chunk_queue.empty() || writing_in_progress) && error_message.empty())
+				pipeline_changed.wait(lock);
+			check_error();
+		}
+
+		double chunk_pipeline_plain::get_read_seconds()
+		{
+			boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+			return read_seconds;
+		}
+
+		double chunk_pipeline_plain::get_write_seconds()
+		{
+			boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+			return write_seconds;
+		}
+
+		void chunk_pipeline_plain::check_error() const
+		{
+			if (!error_message.empty())
+				throw neural_network_exception((boost::format("Chunk pipeline failed: %1%") % error_message).str());
+		}
+
+		void chunk_pipeline_plain::read_chunks()
+		{
+			try
+			{
+				unsigned int entry_offset = 0;
+				unsigned int chunk_index = 0;
+				while (true)
+				{
+					unsigned int buffer_set_id;
+					{
+						boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+						while (free_buffer_set_ids.empty() && !stop_requested)
+							pipeline_changed.wait(lock);
+						if (stop_requested)
+							return;
+						buffer_set_id = free_buffer_set_ids.front();
+						free_buffer_set_ids.pop_front();
+					}
+
+					boost::chrono::steady_clock::time_point start = boost::chrono::high_resolution_clock::now();
+					const std::map<std::string, plain_buffer::ptr>& buffers = buffer_sets[buffer_set_id];
+					const int requested_entry_count = static_cast<int>(chunk_entry_count_list[chunk_index]);
+					int entry_read_count = 0;
+					#pragma omp parallel default(shared) num_threads(reader_thread_count) reduction(+:entry_read_count)
+					{
+						#pragma omp for schedule(dynamic)
+						for(int entry_id = 0; entry_id < requested_entry_count; ++entry_id)
+						{
+							std::map<std::string, float *> data_map;
+							for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
+								data_map.insert(std::make_pair(*it, ((float *)(*buffers.find(*it)->second)) + entry_id * (dedicated_per_entry_data_name_to_size_map.find(*it)->second / sizeof(float))));
+							if (reader.read(entry_offset + entry_id, data_map))
+								++entry_read_count;
+						}
+					}
+
+					boost::chrono::duration<double> sec = boost::chrono::high_resolution_clock::now() - start;
+
+					boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+					read_seconds += sec.count();
+					if (entry_read_count > 0)
+					{
+						chunk new_chunk;
+						new_chunk.buffer_set_id = buffer_set_id;
+						new_chunk.entry_offset = entry_offset;
+						new_chunk.entry_count = static_cast<unsigned int>(entry_read_count);
+						read_chunk_queue.push_back(new_chunk);
+					}
+					else
+						free_buffer_set_ids.push_back(buffer_set_id);
+
+					// Partially read chunk is the last one
+					if (entry_read_count < requested_entry_count)
+						reading_finished = true;
+					pipeline_changed.notify_all();
+					if (reading_finished)
+						return;
+
+					entry_offset += static_cast<unsigned int>(entry_read_count);
+					chunk_index = (chunk_index + 1) % static_cast<unsigned int>(chunk_entry_count_list.size());
+				}
+			}
+			catch (const std::exception& e)
+			{
+				boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+				if (error_message.empty())
+					error_message = e.what();
+				reading_finished = true;
+				pipeline_changed.notify_all();
+			}
+		}
+
+		void chunk_pipeline_plain::write_chunks()
+		{
+			try
+			{
+				while (true)
+				{
+					chunk current_write_chunk;
+					{
+						boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+						while (write_chunk_queue.empty() && !stop_requested)
+							pipeline_changed.wait(lock);
+						if (stop_requested)
+							return;
+						current_write_chunk = write_chunk_queue.front();
+						write_chunk_queue.pop_front();
+						writing_in_progress = true;
+					}
+
+					boost::chrono::steady_clock::time_point start = boost::chrono::high_resolution_clock::now();
+					const std::map<std::string, plain_buffer::ptr>& buffers = buffer_sets[current_write_chunk.buffer_set_id];
+					for(int entry_id = 0; entry_id < static_cast<int>(current_write_chunk.entry_count * output_layers_tiling_factor); ++entry_id)
+					{
+						std::map<std::string, const float *> data_map;
+						for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
+							data_map.insert(std::make_pair(*it, ((float *)(*buffers.find(*it)->second)) + entry_id * (dedicated_per_entry_data_name_to_size_map.find(*it)->second / sizeof(float) / output_layers_tiling_factor)));
+						writer.write(current_write_chunk.entry_offset + entry_id, data_map);
+					}
+
+					boost::chrono::duration<double> sec = boost::chrono::high_resolution_clock::now() - start;
+
+					boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+					write_seconds += sec.count();
+					writing_in_progress = false;
+					free_buffer_set_ids.push_back(current_write_chunk.buffer_set_id);
+					pipeline_changed.notify_all();
+				}
+			}
+			catch (const std::exception& e)
+			{
+				boost::unique_lock<boost::mutex> lock(pipeline_mutex);
+				if (error_message.empty())
+					error_message = e.what();
+				writing_in_progress = false;
+				pipeline_changed.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,142 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include "plain_buffer.h"
+#include "buffer_arena_plain.h"
+
+#include "../structured_data_bunch_reader.h"
+#include "../structured_data_bunch_writer.h"
+
+#include <map>
+#include <set>
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Reads chunks of entries into dedicated buffers and writes the outputs back on background threads,
+		// so that reading chunk N+1 and writing chunk N-1 overlap with running the network on chunk N
+		// Each buffer set holds the dedicated buffers of all the data and output layers for a single chunk,
+		// sets are cycled through free -> read -> compute -> write -> free states
+		class chunk_pipeline_plain
+		{
+		public:
+			// Chunk sizes are taken from chunk_entry_count_list cyclically,
+			// reading stops after the first chunk which couldn't be read completely
+			// Buffer sets are allocated from the arena, entries of a chunk are read on reader_thread_count OpenMP threads
+			chunk_pipeline_plain(
+				structured_data_bunch_reader& reader,
+				structured_data_bunch_writer& writer,
+				const std::map<std::string, size_t>& dedicated_per_entry_data_name_to_size_map,
+				const std::set<std::string>& data_layer_names,
+				const std::vector<std::string>& output_layer_names,
+				unsigned int output_layers_tiling_factor,
+				const std::vector<unsigned int>& chunk_entry_count_list,
+				unsigned int reader_thread_count,
+				buffer_arena_plain& arena);
+
+			// Arena size the buffer sets take
+			static size_t get_arena_size(
+				const std::map<std::string, size_t>& dedicated_per_entry_data_name_to_size_map,
+				unsigned int max_chunk_entry_count);
+
+			// Stops background threads, the chunks not written yet are dropped
+			~chunk_pipeline_plain();
+
+			// Waits for the next chunk to be read and fills dedicated_buffers with its buffers,
+			// returns false when there is no data left; the chunk should be passed to write_chunk before requesting the next one
+			bool get_next_chunk(
+				std::map<std::string, plain_buffer::ptr>& dedicated_buffers,
+				unsigned int& entry_count);
+
+			// Queues outputs of the current chunk for writing
+			void write_chunk();
+
+			// Waits for all the chunks queued to be written
+			void finish();
+
+			// Time the background threads spent reading and writing entries, these overlap with compute
+			double get_read_seconds();
+			double get_write_seconds();
+
+			// Dedicated buffers are allocated this number of times
+			static const unsigned int buffer_set_count;
+
+			// Names the reader and the writer are reported under in action timings
+			static const char * reader_pseudo_layer_name;
+			static const char * writer_pseudo_layer_name;
+
+		private:
+			class chunk
+			{
+			public:
+				unsigned int buffer_set_id;
+				unsigned int entry_offset;
+				unsigned int entry_count;
+			};
+
+			void read_chunks();
+
+			void write_chunks();
+
+			// Throws when any of the background threads has failed, should be called with the lock held
+			void check_error() const;
+
+		private:
+			structured_data_bunch_reader& reader;
+			structured_data_bunch_writer& writer;
+			std::map<std::string, size_t> dedicated_per_entry_data_name_to_size_map;
+			std::set<std::string> data_layer_names;
+			std::vector<std::string> output_layer_names;
+			unsigned int output_layers_tiling_factor;
+			std::vector<unsigned int> chunk_entry_count_list;
+			unsigned int reader_thread_count;
+
+			std::vector<std::map<std::string, plain_buffer::ptr> > buffer_sets;
+
+			std::deque<unsigned int> free_buffer_set_ids;
+			std::deque<chunk> read_chunk_queue;
+			std::deque<chunk> write_chunk_queue;
+			bool current_chunk_valid;
+			chunk current_chunk;
+			bool reading_finished;
+			bool writing_in_progress;
+			bool stop_requested;
+			std::string error_message;
+			double read_seconds;
+			double write_seconds;
+
+			boost::mutex pipeline_mutex;
+			boost::condition_variable pipeline_changed;
+
+			boost::thread reader_thread;
+			boost::thread writer_thread;
+
+		private:
+			chunk_pipeline_plain(const chunk_pipeline_plain&);
+			chunk_pipeline_plain& operator =(const chunk_pipeline_plain&);
+		};
+	}
+}
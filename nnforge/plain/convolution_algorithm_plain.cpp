@@ -0,0 +1,135 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_algorithm_plain.h"
+
+#include "convolution_gemm_plain.h"
+#include "convolution_winograd_plain.h"
+#include "../neural_network_exception.h"
+
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const unsigned int convolution_algorithm_plain::direct_max_reduction_size = 18;
+
+		convolution_algorithm_plain::algorithm convolution_algorithm_plain::parse_name(
+			const std::string& name,
+			const convolution_geometry_plain& geometry)
+		{
+			if (name.empty())
+				return get_heuristic_choice(geometry);
+			else if (name == "winograd")
+				return algorithm_winograd;
+			else if (name == "fft")
+				return algorithm_fft;
+			else if ((name == "gemm") || (name == "blocked"))
+				return algorithm_gemm;
+			else if (name == "direct")
+				return algorithm_direct;
+
+			throw neural_network_exception((boost::format("Unknown convolution algorithm: %1%") % name).str());
+		}
+
+		convolution_algorithm_plain::algorithm convolution_algorithm_plain::get_heuristic_choice(const convolution_geometry_plain& geometry)
+		{
+			// The column matrix of im2col is too thin to keep GEMM micro-kernels busy, and transforms of Winograd and FFT don't pay off
+			if ((geometry.input_feature_map_count * geometry.window_elem_count <= direct_max_reduction_size) && convolution_direct_plain::is_applicable(geometry))
+				return algorithm_direct;
+
+			return algorithm_winograd;
+		}
+
+		std::string convolution_algorithm_plain::get_name(algorithm value)
+		{
+			switch (value)
+			{
+			case algorithm_winograd:
+				return "winograd";
+			case algorithm_fft:
+				return "fft";
+			case algorithm_gemm:
+				return "gemm";
+			default:
+				return "direct";
+			}
+		}
+
+		std::vector<convolution_algorithm_plain::algorithm> convolution_algorithm_plain::get_candidates(const convolution_geometry_plain& geometry)
+		{
+			std::vector<algorithm> res;
+
+			if (convolution_winograd_plain::get_tile_size(geometry) > 0)
+				res.push_back(algorithm_winograd);
+
+			convolution_fft_plain::tiling fft_tiling;
+			if (convolution_fft_plain::get_tiling(geometry, fft_tiling))
+				res.push_back(algorithm_fft);
+
+			if (convolution_gemm_plain::is_applicable(geometry))
+				res.push_back(algorithm_gemm);
+
+			if (convolution_direct_plain::is_applicable(geometry))
+				res.push_back(algorithm_direct);
+
+			return res;
+		}
+
+		unsigned int convolution_algorithm_plain::get_winograd_tile_size(
+			const convolution_geometry_plain& geometry,
+			algorithm first)
+		{
+			if (first > algorithm_winograd)
+				return 0;
+
+			return convolution_winograd_plain::get_tile_size(geometry);
+		}
+
+		bool convolution_algorithm_plain::get_fft_tiling(
+			const convolution_geometry_plain& geometry,
+			algorithm first,
+			convolution_fft_plain::tiling& res)
+		{
+			if (first > algorithm_fft)
+				return false;
+
+			return convolution_fft_plain::get_tiling(geometry, res);
+		}
+
+		bool convolution_algorithm_plain::is_gemm_used(
+			const convolution_geometry_plain& geometry,
+			algorithm first)
+		{
+			if (first > algorithm_gemm)
+				return false;
+
+			return convolution_gemm_plain::is_applicable(geometry);
+		}
+
+		const convolution_direct_plain::kernels * convolution_algorithm_plain::get_direct_kernels(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			algorithm first)
+		{
+			if (first > algorithm_direct)
+				return 0;
+
+			return convolution_direct_plain::get_kernels(isa, geometry);
+		}
+	}
+}
@@ -0,0 +1,89 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "convolution_geometry_plain.h"
+#include "convolution_direct_plain.h"
+#include "convolution_fft_plain.h"
+
+#include <string>
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Convolution algorithms ordered by the preference. The algorithm chosen is the first one tried,
+		// when it doesn't apply to the geometry of the pass the next ones are tried in order
+		class convolution_algorithm_plain
+		{
+		public:
+			enum algorithm
+			{
+				algorithm_winograd = 0,
+				algorithm_fft = 1,
+				algorithm_gemm = 2,
+				algorithm_direct = 3
+			};
+
+			// Empty name stands for the heuristic choice, see get_heuristic_choice.
+			// "blocked" is the name of the channel blocked kernel, it replaces GEMM and direct kernels in forward propagation
+			static algorithm parse_name(
+				const std::string& name,
+				const convolution_geometry_plain& geometry);
+
+			static std::string get_name(algorithm value);
+
+			// Algorithms the forward pass of the geometry could run, in the order of preference
+			static std::vector<algorithm> get_candidates(const convolution_geometry_plain& geometry);
+
+			// Returns 0 when Winograd is not used
+			static unsigned int get_winograd_tile_size(
+				const convolution_geometry_plain& geometry,
+				algorithm first);
+
+			// Returns false when FFT is not used
+			static bool get_fft_tiling(
+				const convolution_geometry_plain& geometry,
+				algorithm first,
+				convolution_fft_plain::tiling& res);
+
+			static bool is_gemm_used(
+				const convolution_geometry_plain& geometry,
+				algorithm first);
+
+			// Returns 0 when direct kernels are not used
+			static const convolution_direct_plain::kernels * get_direct_kernels(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				algorithm first);
+
+		private:
+			// Specialized direct kernels are preferred when there are few input feature maps and window elements,
+			// the most preferred algorithm applicable is chosen otherwise
+			static algorithm get_heuristic_choice(const convolution_geometry_plain& geometry);
+
+		private:
+			// Input feature map count times window elem count up to which direct kernels beat im2col + GEMM and fast algorithms
+			static const unsigned int direct_max_reduction_size;
+
+		private:
+			convolution_algorithm_plain();
+			~convolution_algorithm_plain();
+		};
+	}
+}
@@ -0,0 +1,268 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_blocked_plain.h"
+
+#include "../neural_network_exception.h"
+
+#include <algorithm>
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			// Output positions along dimension 0 sharing each loaded weight vector
+			const unsigned int position_block_size = 4;
+
+			// Computes row_id-th output row of an entry for a single output feature map block,
+			// inlined into the variants compiled for each instruction set below
+			template<unsigned int block_size>
+			NNFORGE_PLAIN_FORCEINLINE void forward_row_body(
+				const convolution_geometry_plain& geometry,
+				const float * input,
+				const float * weights,
+				const float * biases,
+				float * output,
+				unsigned int row_id)
+			{
+				const unsigned int input_block_count = geometry.input_feature_map_count / block_size;
+				const size_t input_block_elem_count = static_cast<size_t>(geometry.input_neuron_count_per_feature_map) * block_size;
+				const size_t weight_count_per_input_block = static_cast<size_t>(geometry.window_elem_count) * block_size * block_size;
+				const unsigned int output_width = geometry.output_dimension_sizes[0];
+				const int input_width = static_cast<int>(geometry.input_dimension_sizes[0]);
+				const int stride_x = static_cast<int>(geometry.strides[0]);
+
+				nnforge_array<int, convolution_geometry_plain::max_dimension_count> input_start_position;
+				unsigned int remaining_row_id = row_id;
+				for(unsigned int i = 1; i < convolution_geometry_plain::max_dimension_count; ++i)
+				{
+					unsigned int output_position = remaining_row_id % geometry.output_dimension_sizes[i];
+					remaining_row_id /= geometry.output_dimension_sizes[i];
+					input_start_position[i] = static_cast<int>(output_position * geometry.strides[i]) - static_cast<int>(geometry.left_zero_padding[i]);
+				}
+
+				float * output_row = output + static_cast<size_t>(row_id) * output_width * block_size;
+				for(unsigned int x_start = 0; x_start < output_width; x_start += position_block_size)
+				{
+					const unsigned int position_count = std::min(position_block_size, output_width - x_start);
+					const int input_x_start = static_cast<int>(x_start) * stride_x - static_cast<int>(geometry.left_zero_padding[0]);
+
+					float sums[position_block_size][block_size];
+					for(unsigned int u = 0; u < position_block_size; ++u)
+						for(unsigned int lane = 0; lane < block_size; ++lane)
+							sums[u][lane] = biases ? biases[lane] : 0.0F;
+
+					for(unsigned int input_block_id = 0; input_block_id < input_block_count; ++input_block_id)
+					{
+						const float * input_block = input + input_block_id * input_block_elem_count;
+						const float * weights_block = weights + input_block_id * weight_count_per_input_block;
+						for(unsigned int kw = 0; kw < geometry.window_sizes[3]; ++kw)
+						{
+							const int w = input_start_position[3] + static_cast<int>(kw);
+							if (static_cast<unsigned int>(w) >= geometry.input_dimension_sizes[3])
+								continue;
+							for(unsigned int kz = 0; kz < geometry.window_sizes[2]; ++kz)
+							{
+								const int z = input_start_position[2] + static_cast<int>(kz);
+								if (static_cast<unsigned int>(z) >= geometry.input_dimension_sizes[2])
+									continue;
+								for(unsigned int ky = 0; ky < geometry.window_sizes[1]; ++ky)
+								{
+									const int y = input_start_position[1] + static_cast<int>(ky);
+									if (static_cast<unsigned int>(y) >= geometry.input_dimension_sizes[1])
+										continue;
+									const float * input_row = input_block + (((w * geometry.input_dimension_sizes[2] + z) * geometry.input_dimension_sizes[1] + y) * geometry.input_dimension_sizes[0]) * block_size;
+									const float * weights_row = weights_block + (((kw * geometry.window_sizes[2] + kz) * geometry.window_sizes[1] + ky) * geometry.window_sizes[0]) * block_size * block_size;
+									for(unsigned int kx = 0; kx < geometry.window_sizes[0]; ++kx)
+									{
+										const int x = input_x_start + static_cast<int>(kx);
+										const float * weights_tap = weights_row + kx * block_size * block_size;
+										if ((position_count == position_block_size) && (x >= 0) && (x + static_cast<int>(position_block_size - 1) * stride_x < input_width))
+										{
+											// All the positions are inside the input, the trip counts are known at compile time
+											for(unsigned int input_lane = 0; input_lane < block_size; ++input_lane)
+											{
+												const float * weights_vector = weights_tap + input_lane * block_size;
+												for(unsigned int u = 0; u < position_block_size; ++u)
+												{
+													const float input_val = input_row[(x + static_cast<int>(u) * stride_x) * static_cast<int>(block_size) + static_cast<int>(input_lane)];
+													for(unsigned int lane = 0; lane < block_size; ++lane)
+														sums[u][lane] += input_val * weights_vector[lane];
+												}
+											}
+										}
+										else
+										{
+											for(unsigned int input_lane = 0; input_lane < block_size; ++input_lane)
+											{
+												const float * weights_vector = weights_tap + input_lane * block_size;
+												for(unsigned int u = 0; u < position_count; ++u)
+												{
+													const int current_x = x + static_cast<int>(u) * stride_x;
+													if (static_cast<unsigned int>(current_x) >= static_cast<unsigned int>(input_width))
+														continue;
+													const float input_val = input_row[current_x * static_cast<int>(block_size) + static_cast<int>(input_lane)];
+													for(unsigned int lane = 0; lane < block_size; ++lane)
+														sums[u][lane] += input_val * weights_vector[lane];
+												}
+											}
+										}
+									}
+								}
+							}
+						}
+					}
+
+					for(unsigned int u = 0; u < position_count; ++u)
+						for(unsigned int lane = 0; lane < block_size; ++lane)
+							output_row[(x_start + u) * block_size + lane] = sums[u][lane];
+				}
+			}
+
+			typedef void (*forward_row_kernel)(
+				const convolution_geometry_plain& geometry,
+				const float * input,
+				const float * weights,
+				const float * biases,
+				float * output,
+				unsigned int row_id);
+
+			class kernel_table
+			{
+			public:
+				forward_row_kernel forward_row_8;
+				forward_row_kernel forward_row_16;
+			};
+
+			// Defines kernels compiled with target_attribute and their table in namespace isa_namespace
+#define NNFORGE_CONVOLUTION_BLOCKED_PLAIN_VARIANT(isa_namespace, target_attribute) \
+			namespace isa_namespace \
+			{ \
+				template<unsigned int block_size> \
+				target_attribute void forward_row(const convolution_geometry_plain& geometry, const float * input, const float * weights, const float * biases, float * output, unsigned int row_id) \
+				{ \
+					forward_row_body<block_size>(geometry, input, weights, biases, output, row_id); \
+				} \
+				const kernel_table table = { \
+					forward_row<8>, \
+					forward_row<16>}; \
+			}
+
+			NNFORGE_PLAIN_FOR_EACH_ISA(NNFORGE_CONVOLUTION_BLOCKED_PLAIN_VARIANT)
+
+#undef NNFORGE_CONVOLUTION_BLOCKED_PLAIN_VARIANT
+
+			template<unsigned int block_size>
+			void run_forward_blocked(
+				forward_row_kernel forward_row,
+				const convolution_geometry_plain& geometry,
+				const float * input,
+				float * output,
+				const float * blocked_weights,
+				const float * biases,
+				unsigned int entry_count,
+				int thread_count)
+			{
+				const unsigned int output_block_count = geometry.output_feature_map_count / block_size;
+				const unsigned int row_count = geometry.output_neuron_count_per_feature_map / geometry.output_dimension_sizes[0];
+				const size_t input_neuron_count = static_cast<size_t>(geometry.input_neuron_count_per_feature_map) * geometry.input_feature_map_count;
+				const size_t output_block_elem_count = static_cast<size_t>(geometry.output_neuron_count_per_feature_map) * block_size;
+				const size_t weight_count_per_output_block = static_cast<size_t>(geometry.window_elem_count) * geometry.input_feature_map_count * block_size;
+				const int total_workload = static_cast<int>(entry_count * output_block_count * row_count);
+				#pragma omp parallel for default(shared) schedule(guided) num_threads(thread_count)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					const unsigned int entry_output_block_id = workload_id / row_count;
+					const unsigned int row_id = workload_id - entry_output_block_id * row_count;
+					const unsigned int entry_id = entry_output_block_id / output_block_count;
+					const unsigned int output_block_id = entry_output_block_id - entry_id * output_block_count;
+					forward_row(
+						geometry,
+						input + entry_id * input_neuron_count,
+						blocked_weights + output_block_id * weight_count_per_output_block,
+						biases ? biases + output_block_id * block_size : 0,
+						output + entry_output_block_id * output_block_elem_count,
+						row_id);
+				}
+			}
+		}
+
+		bool convolution_blocked_plain::is_supported_block_size(unsigned int block_size)
+		{
+			return (block_size == 8) || (block_size == 16);
+		}
+
+		size_t convolution_blocked_plain::get_blocked_weights_elem_count(const convolution_geometry_plain& geometry)
+		{
+			return static_cast<size_t>(geometry.window_elem_count) * geometry.input_feature_map_count * geometry.output_feature_map_count;
+		}
+
+		void convolution_blocked_plain::transform_weights(
+			const convolution_geometry_plain& geometry,
+			unsigned int block_size,
+			const float * weights,
+			float * blocked_weights,
+			int thread_count)
+		{
+			const unsigned int input_block_count = geometry.input_feature_map_count / block_size;
+			const unsigned int window_elem_count = geometry.window_elem_count;
+			const int total_workload = static_cast<int>(geometry.output_feature_map_count);
+			#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+			for(int output_feature_map_id = 0; output_feature_map_id < total_workload; ++output_feature_map_id)
+			{
+				const unsigned int output_block_id = output_feature_map_id / block_size;
+				const unsigned int output_lane = output_feature_map_id - output_block_id * block_size;
+				for(unsigned int input_feature_map_id = 0; input_feature_map_id < geometry.input_feature_map_count; ++input_feature_map_id)
+				{
+					const unsigned int input_block_id = input_feature_map_id / block_size;
+					const unsigned int input_lane = input_feature_map_id - input_block_id * block_size;
+					const float * src = weights + (static_cast<size_t>(output_feature_map_id) * geometry.input_feature_map_count + input_feature_map_id) * window_elem_count;
+					float * dst = blocked_weights + ((static_cast<size_t>(output_block_id) * input_block_count + input_block_id) * window_elem_count * block_size + input_lane) * block_size + output_lane;
+					for(unsigned int window_elem_id = 0; window_elem_id < window_elem_count; ++window_elem_id)
+						dst[window_elem_id * block_size * block_size] = src[window_elem_id];
+				}
+			}
+		}
+
+		void convolution_blocked_plain::run_forward(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			unsigned int block_size,
+			const float * input,
+			float * output,
+			const float * blocked_weights,
+			const float * biases,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			const kernel_table& kernels = NNFORGE_PLAIN_SELECT_ISA(isa, table);
+			switch (block_size)
+			{
+			case 8:
+				run_forward_blocked<8>(kernels.forward_row_8, geometry, input, output, blocked_weights, biases, entry_count, thread_count);
+				break;
+			case 16:
+				run_forward_blocked<16>(kernels.forward_row_16, geometry, input, output, blocked_weights, biases, entry_count, thread_count);
+				break;
+			default:
+				throw neural_network_exception((boost::format("convolution_blocked_plain cannot handle block size %1%") % block_size).str());
+			}
+		}
+	}
+}
@@ -0,0 +1,61 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "convolution_geometry_plain.h"
+#include "cpu_dispatch_plain.h"
+
+#include <cstddef>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Direct convolution of inputs and outputs in channel blocked layout: sums for all the output feature maps
+		// of a block are accumulated together, for several neighbour output positions at once, with input values broadcast
+		// Blocked weights have layout [output_block][input_block][window_elem][input_in_block][output_in_block]
+		class convolution_blocked_plain
+		{
+		public:
+			static bool is_supported_block_size(unsigned int block_size);
+
+			static size_t get_blocked_weights_elem_count(const convolution_geometry_plain& geometry);
+
+			static void transform_weights(
+				const convolution_geometry_plain& geometry,
+				unsigned int block_size,
+				const float * weights,
+				float * blocked_weights,
+				int thread_count);
+
+			static void run_forward(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				unsigned int block_size,
+				const float * input,
+				float * output,
+				const float * blocked_weights,
+				const float * biases,
+				unsigned int entry_count,
+				int thread_count);
+
+		private:
+			convolution_blocked_plain();
+			~convolution_blocked_plain();
+		};
+	}
+}
@@ -0,0 +1,373 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_direct_plain.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			// Returns the row with element j moved to position j * dilation + offset and zeros elsewhere, row_size elements long;
+			// the row itself is returned when it already has this layout, buffer is used otherwise
+			inline const float * get_dilated_row(
+				const float * row,
+				unsigned int width,
+				unsigned int dilation,
+				int offset,
+				unsigned int row_size,
+				float * buffer)
+			{
+				if ((dilation == 1) && (offset == 0) && (row_size <= width))
+					return row;
+
+				const int first = (offset < 0) ? (-offset + static_cast<int>(dilation) - 1) / static_cast<int>(dilation) : 0;
+				const int last = std::max(std::min(static_cast<int>(width), (static_cast<int>(row_size) - offset + static_cast<int>(dilation) - 1) / static_cast<int>(dilation)), first);
+				if (dilation == 1)
+				{
+					std::fill(buffer, buffer + first + offset, 0.0F);
+					std::copy(row + first, row + last, buffer + first + offset);
+					std::fill(buffer + last + offset, buffer + row_size, 0.0F);
+				}
+				else
+				{
+					std::fill_n(buffer, row_size, 0.0F);
+					for(int j = first; j < last; ++j)
+						buffer[j * static_cast<int>(dilation) + offset] = row[j];
+				}
+
+				return buffer;
+			}
+
+			// Kernel bodies below are inlined into the variants compiled for each instruction set
+
+			// Keeps the last window_size rows passed through get_dilated_row, so that the rows shared by adjacent output rows are prepared once
+			// buffer holds row_size * (window_size + 1) elements
+			template<unsigned int window_size>
+			class dilated_row_cache
+			{
+			public:
+				dilated_row_cache(
+					float * buffer,
+					unsigned int row_size)
+					: row_size(row_size)
+					, buffer(buffer)
+				{
+					std::fill_n(buffer + row_size * window_size, row_size, 0.0F);
+					reset();
+				}
+
+				void reset()
+				{
+					std::fill_n(row_ids, window_size, -1);
+					std::fill_n(rows, window_size, get_zero_row());
+				}
+
+				// Row of zeros
+				const float * get_zero_row() const
+				{
+					return buffer + row_size * window_size;
+				}
+
+				const float * get_row(
+					int row_id,
+					const float * row,
+					unsigned int width,
+					unsigned int dilation,
+					int offset)
+				{
+					const unsigned int slot = static_cast<unsigned int>(row_id) % window_size;
+					if (row_ids[slot] != row_id)
+					{
+						rows[slot] = get_dilated_row(row, width, dilation, offset, row_size, buffer + row_size * slot);
+						row_ids[slot] = row_id;
+					}
+					return rows[slot];
+				}
+
+			private:
+				unsigned int row_size;
+				float * buffer;
+				int row_ids[window_size];
+				const float * rows[window_size];
+			};
+
+			template<unsigned int dimension_count, unsigned int window_size, unsigned int stride>
+			NNFORGE_PLAIN_FORCEINLINE void forward_feature_map_body(
+				const convolution_geometry_plain& geometry,
+				const float * input,
+				const float * weights,
+				float bias,
+				float * output,
+				unsigned int output_row_start,
+				unsigned int output_row_end,
+				float * scratch)
+			{
+				const unsigned int window_x = window_size;
+				const unsigned int window_y = (dimension_count > 1) ? window_size : 1;
+				const unsigned int stride_x = stride;
+				const unsigned int stride_y = (dimension_count > 1) ? stride : 1;
+				const unsigned int window_elem_count = window_x * window_y;
+
+				const unsigned int input_width = geometry.input_dimension_sizes[0];
+				const unsigned int input_height = geometry.input_dimension_sizes[1];
+				const int output_width = static_cast<int>(geometry.output_dimension_sizes[0]);
+				const int left_padding_x = static_cast<int>(geometry.left_zero_padding[0]);
+				const int left_padding_y = static_cast<int>(geometry.left_zero_padding[1]);
+				const unsigned int padded_row_size = (output_width - 1) * stride_x + window_x;
+
+				std::fill_n(output + output_row_start * output_width, (output_row_end - output_row_start) * output_width, bias);
+
+				dilated_row_cache<window_y> row_cache(scratch, padded_row_size);
+				const float * rows[window_y];
+				float w[window_elem_count];
+				for(unsigned int input_feature_map_id = 0; input_feature_map_id < geometry.input_feature_map_count; ++input_feature_map_id)
+				{
+					const float * in_feature_map = input + static_cast<size_t>(input_feature_map_id) * geometry.input_neuron_count_per_feature_map;
+					std::copy(weights + input_feature_map_id * window_elem_count, weights + (input_feature_map_id + 1) * window_elem_count, w);
+					row_cache.reset();
+
+					for(unsigned int y = output_row_start; y < output_row_end; ++y)
+					{
+						for(unsigned int ky = 0; ky < window_y; ++ky)
+						{
+							const int input_y = static_cast<int>(y * stride_y + ky) - left_padding_y;
+							rows[ky] = (static_cast<unsigned int>(input_y) < input_height)
+								? row_cache.get_row(input_y, in_feature_map + input_y * input_width, input_width, 1, left_padding_x)
+								: row_cache.get_zero_row();
+						}
+
+						float * out_row = output + y * output_width;
+						for(int x = 0; x < output_width; ++x)
+						{
+							float sum = 0.0F;
+							for(unsigned int ky = 0; ky < window_y; ++ky)
+								for(unsigned int kx = 0; kx < window_x; ++kx)
+									sum += rows[ky][x * stride_x + kx] * w[ky * window_x + kx];
+							out_row[x] += sum;
+						}
+					}
+				}
+			}
+
+			// Input position x gathers from positions [x, x + window_x) of the output errors rows dilated by the stride,
+			// with the weights flipped
+			template<unsigned int dimension_count, unsigned int window_size, unsigned int stride>
+			NNFORGE_PLAIN_FORCEINLINE void backward_data_feature_map_body(
+				const convolution_geometry_plain& geometry,
+				const float * output_errors,
+				const float * weights,
+				float * input_errors,
+				unsigned int input_row_start,
+				unsigned int input_row_end,
+				bool add_update_to_destination,
+				float * scratch)
+			{
+				const unsigned int window_x = window_size;
+				const unsigned int window_y = (dimension_count > 1) ? window_size : 1;
+				const unsigned int stride_x = stride;
+				const unsigned int stride_y = (dimension_count > 1) ? stride : 1;
+				const unsigned int window_elem_count = window_x * window_y;
+
+				const int input_width = static_cast<int>(geometry.input_dimension_sizes[0]);
+				const unsigned int output_width = geometry.output_dimension_sizes[0];
+				const unsigned int output_height = geometry.output_dimension_sizes[1];
+				const int left_padding_x = static_cast<int>(geometry.left_zero_padding[0]);
+				const int left_padding_y = static_cast<int>(geometry.left_zero_padding[1]);
+				const unsigned int weight_count_per_output_feature_map = window_elem_count * geometry.input_feature_map_count;
+				const unsigned int dilated_row_size = input_width + window_x - 1;
+
+				if (!add_update_to_destination)
+					std::fill_n(input_errors + input_row_start * input_width, (input_row_end - input_row_start) * input_width, 0.0F);
+
+				dilated_row_cache<window_y> row_cache(scratch, dilated_row_size);
+				const float * rows[window_y];
+				float w[window_elem_count];
+				for(unsigned int output_feature_map_id = 0; output_feature_map_id < geometry.output_feature_map_count; ++output_feature_map_id)
+				{
+					const float * err_feature_map = output_errors + static_cast<size_t>(output_feature_map_id) * geometry.output_neuron_count_per_feature_map;
+					const float * current_weights = weights + output_feature_map_id * weight_count_per_output_feature_map;
+					for(unsigned int i = 0; i < window_elem_count; ++i)
+						w[i] = current_weights[window_elem_count - 1 - i];
+					row_cache.reset();
+
+					for(unsigned int y = input_row_start; y < input_row_end; ++y)
+					{
+						for(unsigned int ky = 0; ky < window_y; ++ky)
+						{
+							const int strided_output_y = static_cast<int>(y + ky) - (static_cast<int>(window_y) - 1 - left_padding_y);
+							const bool valid = (strided_output_y >= 0) && (strided_output_y % stride_y == 0) && (static_cast<unsigned int>(strided_output_y) / stride_y < output_height);
+							const int output_y = strided_output_y / static_cast<int>(stride_y);
+							rows[ky] = valid
+								? row_cache.get_row(output_y, err_feature_map + output_y * output_width, output_width, stride_x, static_cast<int>(window_x) - 1 - left_padding_x)
+								: row_cache.get_zero_row();
+						}
+
+						float * in_err_row = input_errors + y * input_width;
+						for(int x = 0; x < input_width; ++x)
+						{
+							float sum = 0.0F;
+							for(unsigned int ky = 0; ky < window_y; ++ky)
+								for(unsigned int kx = 0; kx < window_x; ++kx)
+									sum += rows[ky][x + kx] * w[ky * window_x + kx];
+							in_err_row[x] += sum;
+						}
+					}
+				}
+			}
+
+			template<unsigned int dimension_count, unsigned int window_size, unsigned int stride>
+			NNFORGE_PLAIN_FORCEINLINE void backward_weights_feature_map_body(
+				const convolution_geometry_plain& geometry,
+				const float * input_feature_map,
+				const float * output_errors_feature_map,
+				float * gradient_weights,
+				float * scratch)
+			{
+				const unsigned int window_x = window_size;
+				const unsigned int window_y = (dimension_count > 1) ? window_size : 1;
+				const unsigned int stride_x = stride;
+				const unsigned int stride_y = (dimension_count > 1) ? stride : 1;
+				const unsigned int window_elem_count = window_x * window_y;
+
+				const unsigned int input_width = geometry.input_dimension_sizes[0];
+				const unsigned int input_height = geometry.input_dimension_sizes[1];
+				const int output_width = static_cast<int>(geometry.output_dimension_sizes[0]);
+				const unsigned int output_height = geometry.output_dimension_sizes[1];
+				const int left_padding_x = static_cast<int>(geometry.left_zero_padding[0]);
+				const int left_padding_y = static_cast<int>(geometry.left_zero_padding[1]);
+				const unsigned int padded_row_size = (output_width - 1) * stride_x + window_x;
+
+				float acc[window_elem_count];
+				std::fill_n(acc, window_elem_count, 0.0F);
+
+				dilated_row_cache<window_y> row_cache(scratch, padded_row_size);
+				const float * rows[window_y];
+				for(unsigned int y = 0; y < output_height; ++y)
+				{
+					for(unsigned int ky = 0; ky < window_y; ++ky)
+					{
+						const int input_y = static_cast<int>(y * stride_y + ky) - left_padding_y;
+						rows[ky] = (static_cast<unsigned int>(input_y) < input_height)
+							? row_cache.get_row(input_y, input_feature_map + input_y * input_width, input_width, 1, left_padding_x)
+							: row_cache.get_zero_row();
+					}
+
+					const float * err_row = output_errors_feature_map + y * output_width;
+					for(int x = 0; x < output_width; ++x)
+					{
+						const float err = err_row[x];
+						for(unsigned int ky = 0; ky < window_y; ++ky)
+							for(unsigned int kx = 0; kx < window_x; ++kx)
+								acc[ky * window_x + kx] += rows[ky][x * stride_x + kx] * err;
+					}
+				}
+
+				for(unsigned int i = 0; i < window_elem_count; ++i)
+					gradient_weights[i] += acc[i];
+			}
+
+#define NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(dimension_count, window_size, stride) \
+					{dimension_count, window_size, stride, forward_feature_map<dimension_count, window_size, stride>, backward_data_feature_map<dimension_count, window_size, stride>, backward_weights_feature_map<dimension_count, window_size, stride>}
+
+			// Defines kernels compiled with target_attribute and their table in namespace isa_namespace
+#define NNFORGE_CONVOLUTION_DIRECT_PLAIN_VARIANT(isa_namespace, target_attribute) \
+			namespace isa_namespace \
+			{ \
+				template<unsigned int dimension_count, unsigned int window_size, unsigned int stride> \
+				target_attribute void forward_feature_map(const convolution_geometry_plain& geometry, const float * input, const float * weights, float bias, float * output, unsigned int output_row_start, unsigned int output_row_end, float * scratch) \
+				{ \
+					forward_feature_map_body<dimension_count, window_size, stride>(geometry, input, weights, bias, output, output_row_start, output_row_end, scratch); \
+				} \
+				template<unsigned int dimension_count, unsigned int window_size, unsigned int stride> \
+				target_attribute void backward_data_feature_map(const convolution_geometry_plain& geometry, const float * output_errors, const float * weights, float * input_errors, unsigned int input_row_start, unsigned int input_row_end, bool add_update_to_destination, float * scratch) \
+				{ \
+					backward_data_feature_map_body<dimension_count, window_size, stride>(geometry, output_errors, weights, input_errors, input_row_start, input_row_end, add_update_to_destination, scratch); \
+				} \
+				template<unsigned int dimension_count, unsigned int window_size, unsigned int stride> \
+				target_attribute void backward_weights_feature_map(const convolution_geometry_plain& geometry, const float * input_feature_map, const float * output_errors_feature_map, float * gradient_weights, float * scratch) \
+				{ \
+					backward_weights_feature_map_body<dimension_count, window_size, stride>(geometry, input_feature_map, output_errors_feature_map, gradient_weights, scratch); \
+				} \
+				const convolution_direct_plain::kernels kernel_table[] = \
+				{ \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(1, 1, 1), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(1, 1, 2), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(1, 3, 1), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(1, 3, 2), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(1, 5, 1), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(1, 5, 2), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(1, 7, 1), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(1, 7, 2), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(2, 1, 1), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(2, 1, 2), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(2, 3, 1), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(2, 3, 2), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(2, 5, 1), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(2, 5, 2), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(2, 7, 1), \
+					NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS(2, 7, 2), \
+				}; \
+			}
+
+			NNFORGE_PLAIN_FOR_EACH_ISA(NNFORGE_CONVOLUTION_DIRECT_PLAIN_VARIANT)
+
+#undef NNFORGE_CONVOLUTION_DIRECT_PLAIN_VARIANT
+#undef NNFORGE_CONVOLUTION_DIRECT_PLAIN_KERNELS
+		}
+
+		const convolution_direct_plain::kernels * convolution_direct_plain::get_kernels(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry)
+		{
+			if ((geometry.dimension_count < 1) || (geometry.dimension_count > 2))
+				return 0;
+
+			const unsigned int window_size = geometry.window_sizes[0];
+			const unsigned int stride = geometry.strides[0];
+			for(unsigned int i = 1; i < geometry.dimension_count; ++i)
+				if ((geometry.window_sizes[i] != window_size) || (geometry.strides[i] != stride))
+					return 0;
+
+			const unsigned int kernel_count = sizeof(generic::kernel_table) / sizeof(generic::kernel_table[0]);
+			const kernels (&table)[kernel_count] = NNFORGE_PLAIN_SELECT_ISA(isa, kernel_table);
+			for(unsigned int i = 0; i < kernel_count; ++i)
+			{
+				const kernels& k = table[i];
+				if ((k.dimension_count == geometry.dimension_count) && (k.window_size == window_size) && (k.stride == stride))
+					return &k;
+			}
+
+			return 0;
+		}
+
+		bool convolution_direct_plain::is_applicable(const convolution_geometry_plain& geometry)
+		{
+			return (get_kernels(cpu_dispatch_plain::isa_generic, geometry) != 0);
+		}
+
+		size_t convolution_direct_plain::get_scratch_elem_count(const convolution_geometry_plain& geometry)
+		{
+			// Padded input rows of forward and backward weights, dilated output errors rows of backward data
+			const unsigned int padded_row_size = (geometry.output_dimension_sizes[0] - 1) * geometry.strides[0] + geometry.window_sizes[0];
+			const unsigned int dilated_row_size = geometry.input_dimension_sizes[0] + geometry.window_sizes[0] - 1;
+			return static_cast<size_t>(std::max(padded_row_size, dilated_row_size)) * (geometry.window_sizes[1] + 1);
+		}
+	}
+}
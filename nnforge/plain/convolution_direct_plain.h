@@ -0,0 +1,94 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "convolution_geometry_plain.h"
+#include "cpu_dispatch_plain.h"
+
+#include <cstddef>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Direct convolution kernels specialized at compile time for 1D and 2D layers with equal window sizes
+		// of 1, 3, 5 or 7 and equal strides of 1 or 2 in all the dimensions
+		// Rows are processed one tap at a time with the inner loop running contiguously over the row; zero padding
+		// (and, for the data backprop, the stride) is applied by copying the row to a zero-filled buffer, so there is no border code
+		// Each kernel takes scratch of get_scratch_elem_count elements for these rows, it is reused across calls by the same thread
+		class convolution_direct_plain
+		{
+		public:
+			// Computes rows [output_row_start, output_row_end) of the output feature map of a single entry from all the input feature maps,
+			// weights point to those of the output feature map, output points to the start of the feature map; 1D layers have a single row
+			typedef void (*forward_kernel)(
+				const convolution_geometry_plain& geometry,
+				const float * input,
+				const float * weights,
+				float bias,
+				float * output,
+				unsigned int output_row_start,
+				unsigned int output_row_end,
+				float * scratch);
+
+			// Computes rows [input_row_start, input_row_end) of the errors of a single input feature map of a single entry from all the output feature maps,
+			// weights point to those of the input feature map for the first output feature map, output_errors point to the start of the entry
+			typedef void (*backward_data_kernel)(
+				const convolution_geometry_plain& geometry,
+				const float * output_errors,
+				const float * weights,
+				float * input_errors,
+				unsigned int input_row_start,
+				unsigned int input_row_end,
+				bool add_update_to_destination,
+				float * scratch);
+
+			// Adds the weight gradient of a single input and output feature map pair of a single entry to gradient_weights
+			typedef void (*backward_weights_kernel)(
+				const convolution_geometry_plain& geometry,
+				const float * input_feature_map,
+				const float * output_errors_feature_map,
+				float * gradient_weights,
+				float * scratch);
+
+			class kernels
+			{
+			public:
+				unsigned int dimension_count;
+				unsigned int window_size;
+				unsigned int stride;
+				forward_kernel forward;
+				backward_data_kernel backward_data;
+				backward_weights_kernel backward_weights;
+			};
+
+			// Returns 0 when there is no specialization for the geometry, the generic code should be used then;
+			// kernels returned are compiled for the instruction set specified
+			static const kernels * get_kernels(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry);
+
+			static bool is_applicable(const convolution_geometry_plain& geometry);
+
+			static size_t get_scratch_elem_count(const convolution_geometry_plain& geometry);
+
+		private:
+			convolution_direct_plain();
+			~convolution_direct_plain();
+		};
+	}
+}
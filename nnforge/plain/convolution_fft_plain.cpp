@@ -0,0 +1,625 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_fft_plain.h"
+
+#include "gemm_plain.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const size_t convolution_fft_plain::max_working_buffer_size_per_entry = 64 * 1024 * 1024;
+		const size_t convolution_fft_plain::max_weights_spectrum_size = 256 * 1024 * 1024;
+		const unsigned int convolution_fft_plain::max_fft_elem_count = 16384;
+		const float convolution_fft_plain::transform_cost_factor = 30.0F;
+		const float convolution_fft_plain::multiply_cost_factor = 16.0F;
+
+		bool convolution_fft_plain::get_tiling(
+			const convolution_geometry_plain& geometry,
+			tiling& res)
+		{
+			if (geometry.dimension_count == 0)
+				return false;
+			for(unsigned int i = 0; i < convolution_geometry_plain::max_dimension_count; ++i)
+				if (geometry.strides[i] != 1)
+					return false;
+
+			// Candidate fft sizes range from the window size up to the size covering the whole output with a single tile
+			std::vector<unsigned int> candidates[convolution_geometry_plain::max_dimension_count];
+			for(unsigned int i = 0; i < convolution_geometry_plain::max_dimension_count; ++i)
+			{
+				bool real_transform = (i == 0);
+				if (geometry.output_dimension_sizes[i] == 1)
+				{
+					candidates[i].push_back(get_fft_size_candidate(geometry.window_sizes[i], real_transform));
+					continue;
+				}
+
+				unsigned int single_tile_size = get_fft_size_candidate(geometry.output_dimension_sizes[i] + geometry.window_sizes[i] - 1, real_transform);
+				for(unsigned int fft_size = get_fft_size_candidate(geometry.window_sizes[i], real_transform);
+					(fft_size <= single_tile_size) && (fft_size <= max_fft_elem_count);
+					fft_size = get_fft_size_candidate(fft_size + 1, real_transform))
+					candidates[i].push_back(fft_size);
+				if (candidates[i].empty())
+					return false;
+			}
+
+			const float input_feature_map_count = static_cast<float>(geometry.input_feature_map_count);
+			const float output_feature_map_count = static_cast<float>(geometry.output_feature_map_count);
+			float best_cost = static_cast<float>(geometry.window_elem_count) * input_feature_map_count * output_feature_map_count * static_cast<float>(geometry.output_neuron_count_per_feature_map);
+			bool found = false;
+
+			tiling current;
+			for(std::vector<unsigned int>::const_iterator it3 = candidates[3].begin(); (it3 != candidates[3].end()) && (*it3 <= max_fft_elem_count); ++it3)
+			{
+				for(std::vector<unsigned int>::const_iterator it2 = candidates[2].begin(); (it2 != candidates[2].end()) && (*it3 * *it2 <= max_fft_elem_count); ++it2)
+				{
+					for(std::vector<unsigned int>::const_iterator it1 = candidates[1].begin(); (it1 != candidates[1].end()) && (*it3 * *it2 * *it1 <= max_fft_elem_count); ++it1)
+					{
+						for(std::vector<unsigned int>::const_iterator it0 = candidates[0].begin(); (it0 != candidates[0].end()) && (*it3 * *it2 * *it1 * *it0 <= max_fft_elem_count); ++it0)
+						{
+							current.fft_sizes[0] = *it0;
+							current.fft_sizes[1] = *it1;
+							current.fft_sizes[2] = *it2;
+							current.fft_sizes[3] = *it3;
+							current.tile_count_per_entry = 1;
+							current.fft_elem_count = 1;
+							for(unsigned int i = 0; i < convolution_geometry_plain::max_dimension_count; ++i)
+							{
+								current.tile_sizes[i] = current.fft_sizes[i] - geometry.window_sizes[i] + 1;
+								current.tile_counts[i] = (geometry.output_dimension_sizes[i] + current.tile_sizes[i] - 1) / current.tile_sizes[i];
+								current.tile_count_per_entry *= current.tile_counts[i];
+								current.fft_elem_count *= current.fft_sizes[i];
+							}
+							current.spectrum_elem_count = current.fft_elem_count / current.fft_sizes[0] * (current.fft_sizes[0] / 2 + 1);
+
+							if (get_working_buffer_size_per_entry(geometry, current) > max_working_buffer_size_per_entry)
+								continue;
+							if (get_weights_spectrum_elem_count(geometry, current) * sizeof(float) > max_weights_spectrum_size)
+								continue;
+
+							float fft_elem_count = static_cast<float>(current.fft_elem_count);
+							float transform_cost = transform_cost_factor * fft_elem_count * std::max(logf(fft_elem_count) / logf(2.0F), 1.0F);
+							float multiply_cost = multiply_cost_factor * static_cast<float>(current.spectrum_elem_count) * input_feature_map_count * output_feature_map_count;
+							float cost = static_cast<float>(current.tile_count_per_entry) * ((input_feature_map_count + output_feature_map_count) * transform_cost + multiply_cost);
+							if (cost < best_cost)
+							{
+								best_cost = cost;
+								res = current;
+								found = true;
+							}
+						}
+					}
+				}
+			}
+
+			return found;
+		}
+
+		unsigned int convolution_fft_plain::get_fft_size_candidate(
+			unsigned int size,
+			bool real_transform)
+		{
+			if (!real_transform)
+				return fft_plain::get_supported_size(size);
+
+			// Real transform of size n runs complex transform of size n / 2
+			return fft_plain::get_supported_size((size + 1) / 2) * 2;
+		}
+
+		size_t convolution_fft_plain::get_weights_spectrum_elem_count(
+			const convolution_geometry_plain& geometry,
+			const tiling& t)
+		{
+			return static_cast<size_t>(t.spectrum_elem_count) * geometry.input_feature_map_count * geometry.output_feature_map_count * 2;
+		}
+
+		size_t convolution_fft_plain::get_working_buffer_size_per_entry(
+			const convolution_geometry_plain& geometry,
+			const tiling& t)
+		{
+			return static_cast<size_t>(t.spectrum_elem_count) * t.tile_count_per_entry * (geometry.input_feature_map_count + geometry.output_feature_map_count) * 2 * sizeof(float);
+		}
+
+		size_t convolution_fft_plain::get_backward_weights_working_buffer_size(
+			const convolution_geometry_plain& geometry,
+			const tiling& t)
+		{
+			return get_weights_spectrum_elem_count(geometry, t) * sizeof(float);
+		}
+
+		void convolution_fft_plain::create_plans(
+			cpu_dispatch_plain::isa isa,
+			const tiling& t,
+			std::vector<fft_plain>& plans)
+		{
+			plans.clear();
+			plans.push_back(fft_plain(t.fft_sizes[0] / 2, isa));
+			for(unsigned int i = 1; i < convolution_geometry_plain::max_dimension_count; ++i)
+				plans.push_back(fft_plain(t.fft_sizes[i], isa));
+		}
+
+		size_t convolution_fft_plain::get_scratch_elem_count(const tiling& t)
+		{
+			size_t res = t.fft_sizes[0];
+			for(unsigned int i = 1; i < convolution_geometry_plain::max_dimension_count; ++i)
+				res = std::max(res, static_cast<size_t>(t.fft_sizes[i]) * 2);
+			return res;
+		}
+
+		void convolution_fft_plain::transform_tile(
+			const tiling& t,
+			const std::vector<fft_plain>& plans,
+			const float * tile,
+			fft_plain::complex * spectrum,
+			fft_plain::complex * scratch)
+		{
+			const unsigned int row_size = t.fft_sizes[0];
+			const unsigned int row_spectrum_size = row_size / 2 + 1;
+			const unsigned int row_count = t.fft_elem_count / row_size;
+			for(unsigned int row_id = 0; row_id < row_count; ++row_id)
+				plans[0].transform_real_forward(tile + row_id * row_size, spectrum + row_id * row_spectrum_size, scratch);
+
+			unsigned int stride = row_spectrum_size;
+			for(unsigned int i = 1; i < convolution_geometry_plain::max_dimension_count; ++i)
+			{
+				const unsigned int size = t.fft_sizes[i];
+				if (size > 1)
+				{
+					const unsigned int outer_count = t.spectrum_elem_count / (stride * size);
+					for(unsigned int outer_id = 0; outer_id < outer_count; ++outer_id)
+					{
+						for(unsigned int inner_id = 0; inner_id < stride; ++inner_id)
+						{
+							fft_plain::complex * base = spectrum + outer_id * stride * size + inner_id;
+							for(unsigned int j = 0; j < size; ++j)
+								scratch[j] = base[j * stride];
+							plans[i].transform(scratch, scratch + size, false);
+							for(unsigned int j = 0; j < size; ++j)
+								base[j * stride] = scratch[size + j];
+						}
+					}
+				}
+				stride *= size;
+			}
+		}
+
+		void convolution_fft_plain::inverse_transform_tile(
+			const tiling& t,
+			const std::vector<fft_plain>& plans,
+			fft_plain::complex * spectrum,
+			float * tile,
+			fft_plain::complex * scratch)
+		{
+			const unsigned int row_size = t.fft_sizes[0];
+			const unsigned int row_spectrum_size = row_size / 2 + 1;
+
+			unsigned int stride = row_spectrum_size;
+			for(unsigned int i = 1; i < convolution_geometry_plain::max_dimension_count; ++i)
+			{
+				const unsigned int size = t.fft_sizes[i];
+				if (size > 1)
+				{
+					const unsigned int outer_count = t.spectrum_elem_count / (stride * size);
+					for(unsigned int outer_id = 0; outer_id < outer_count; ++outer_id)
+					{
+						for(unsigned int inner_id = 0; inner_id < stride; ++inner_id)
+						{
+							fft_plain::complex * base = spectrum + outer_id * stride * size + inner_id;
+							for(unsigned int j = 0; j < size; ++j)
+								scratch[j] = base[j * stride];
+							plans[i].transform(scratch, scratch + size, true);
+							for(unsigned int j = 0; j < size; ++j)
+								base[j * stride] = scratch[size + j];
+						}
+					}
+				}
+				stride *= size;
+			}
+
+			const unsigned int row_count = t.fft_elem_count / row_size;
+			for(unsigned int row_id = 0; row_id < row_count; ++row_id)
+				plans[0].transform_real_inverse(spectrum + row_id * row_spectrum_size, tile + row_id * row_size, scratch);
+		}
+
+		void convolution_fft_plain::load_tile(
+			const tiling& t,
+			const float * feature_map,
+			const nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count>& feature_map_sizes,
+			const nnforge_array<int, convolution_geometry_plain::max_dimension_count>& start_positions,
+			const nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count>& copy_sizes,
+			float * tile)
+		{
+			const int row_size = static_cast<int>(t.fft_sizes[0]);
+			const int x_begin = std::min(std::max(-start_positions[0], 0), row_size);
+			const int x_end = std::max(std::min(std::min(row_size, static_cast<int>(copy_sizes[0])), static_cast<int>(feature_map_sizes[0]) - start_positions[0]), x_begin);
+
+			float * row = tile;
+			for(unsigned int p3 = 0; p3 < t.fft_sizes[3]; ++p3)
+			{
+				int y3 = start_positions[3] + static_cast<int>(p3);
+				bool fit3 = (p3 < copy_sizes[3]) && ((unsigned int)y3 < feature_map_sizes[3]);
+				for(unsigned int p2 = 0; p2 < t.fft_sizes[2]; ++p2)
+				{
+					int y2 = start_positions[2] + static_cast<int>(p2);
+					bool fit2 = fit3 && (p2 < copy_sizes[2]) && ((unsigned int)y2 < feature_map_sizes[2]);
+					for(unsigned int p1 = 0; p1 < t.fft_sizes[1]; ++p1, row += row_size)
+					{
+						int y1 = start_positions[1] + static_cast<int>(p1);
+						bool fit1 = fit2 && (p1 < copy_sizes[1]) && ((unsigned int)y1 < feature_map_sizes[1]);
+						if (!fit1)
+						{
+							std::fill_n(row, row_size, 0.0F);
+							continue;
+						}
+
+						const float * src_row = feature_map + ((y3 * feature_map_sizes[2] + y2) * feature_map_sizes[1] + y1) * feature_map_sizes[0];
+						std::fill(row, row + x_begin, 0.0F);
+						std::copy(src_row + (start_positions[0] + x_begin), src_row + (start_positions[0] + x_end), row + x_begin);
+						std::fill(row + x_end, row + row_size, 0.0F);
+					}
+				}
+			}
+		}
+
+		void convolution_fft_plain::transform_feature_maps(
+			const tiling& t,
+			const std::vector<fft_plain>& plans,
+			const float * feature_maps,
+			const nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count>& feature_map_sizes,
+			unsigned int feature_map_count,
+			const nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count>& left_zero_padding,
+			bool clip_to_tile_sizes,
+			float * spectrum,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			unsigned int feature_map_elem_count = 1;
+			for(unsigned int i = 0; i < convolution_geometry_plain::max_dimension_count; ++i)
+				feature_map_elem_count *= feature_map_sizes[i];
+			const unsigned int tile_count_per_entry = t.tile_count_per_entry;
+			const unsigned int total_tile_count = tile_count_per_entry * entry_count;
+			const size_t plane_elem_count = static_cast<size_t>(t.spectrum_elem_count) * feature_map_count * total_tile_count;
+			const size_t frequency_stride = static_cast<size_t>(feature_map_count) * total_tile_count;
+			const int total_workload = entry_count * feature_map_count * tile_count_per_entry;
+
+			#pragma omp parallel default(shared) num_threads(thread_count)
+			{
+				std::vector<float> tile(t.fft_elem_count);
+				std::vector<fft_plain::complex> tile_spectrum(t.spectrum_elem_count);
+				std::vector<fft_plain::complex> scratch(get_scratch_elem_count(t));
+				nnforge_array<int, convolution_geometry_plain::max_dimension_count> start_positions;
+				nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count> copy_sizes;
+
+				#pragma omp for schedule(guided)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					unsigned int tile_id = workload_id % tile_count_per_entry;
+					unsigned int entry_feature_map_id = workload_id / tile_count_per_entry;
+					unsigned int feature_map_id = entry_feature_map_id % feature_map_count;
+					unsigned int entry_id = entry_feature_map_id / feature_map_count;
+
+					unsigned int remaining_tile_id = tile_id;
+					for(unsigned int i = 0; i < convolution_geometry_plain::max_dimension_count; ++i)
+					{
+						unsigned int tile_position = remaining_tile_id % t.tile_counts[i];
+						remaining_tile_id /= t.tile_counts[i];
+						start_positions[i] = static_cast<int>(tile_position * t.tile_sizes[i]) - static_cast<int>(left_zero_padding[i]);
+						copy_sizes[i] = clip_to_tile_sizes ? t.tile_sizes[i] : t.fft_sizes[i];
+					}
+
+					load_tile(
+						t,
+						feature_maps + static_cast<size_t>(entry_feature_map_id) * feature_map_elem_count,
+						feature_map_sizes,
+						start_positions,
+						copy_sizes,
+						&tile[0]);
+					transform_tile(t, plans, &tile[0], &tile_spectrum[0], &scratch[0]);
+
+					float * re_it = spectrum + static_cast<size_t>(feature_map_id) * total_tile_count + entry_id * tile_count_per_entry + tile_id;
+					float * im_it = re_it + plane_elem_count;
+					for(unsigned int f = 0; f < t.spectrum_elem_count; ++f, re_it += frequency_stride, im_it += frequency_stride)
+					{
+						*re_it = tile_spectrum[f].real();
+						*im_it = tile_spectrum[f].imag();
+					}
+				}
+			}
+		}
+
+		void convolution_fft_plain::transform_weights(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const tiling& t,
+			const float * weights,
+			float * weights_spectrum,
+			bool flip_and_transpose,
+			int thread_count)
+		{
+			std::vector<fft_plain> plans;
+			create_plans(isa, t, plans);
+
+			const unsigned int input_feature_map_count = geometry.input_feature_map_count;
+			const unsigned int output_feature_map_count = geometry.output_feature_map_count;
+			const unsigned int window_elem_count = geometry.window_elem_count;
+			const size_t plane_elem_count = static_cast<size_t>(t.spectrum_elem_count) * input_feature_map_count * output_feature_map_count;
+			const size_t frequency_stride = static_cast<size_t>(input_feature_map_count) * output_feature_map_count;
+			const float mult = 1.0F / static_cast<float>(t.fft_elem_count);
+			const int total_workload = output_feature_map_count * input_feature_map_count;
+
+			#pragma omp parallel default(shared) num_threads(thread_count)
+			{
+				std::vector<float> tile(t.fft_elem_count);
+				std::vector<fft_plain::complex> tile_spectrum(t.spectrum_elem_count);
+				std::vector<fft_plain::complex> scratch(get_scratch_elem_count(t));
+
+				#pragma omp for schedule(guided)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					unsigned int output_feature_map_id = workload_id / input_feature_map_count;
+					unsigned int input_feature_map_id = workload_id - output_feature_map_id * input_feature_map_count;
+
+					// Weights of the convolution computing input errors are those of the original layer with in and out swapped,
+					// flipping all the dimensions of the window is the same as reversing it
+					const float * src = weights + static_cast<size_t>(flip_and_transpose ? (input_feature_map_id * output_feature_map_count + output_feature_map_id) : workload_id) * window_elem_count;
+
+					std::fill(tile.begin(), tile.end(), 0.0F);
+					unsigned int window_elem_id = 0;
+					for(unsigned int p3 = 0; p3 < geometry.window_sizes[3]; ++p3)
+						for(unsigned int p2 = 0; p2 < geometry.window_sizes[2]; ++p2)
+							for(unsigned int p1 = 0; p1 < geometry.window_sizes[1]; ++p1)
+							{
+								float * dst = &tile[((p3 * t.fft_sizes[2] + p2) * t.fft_sizes[1] + p1) * t.fft_sizes[0]];
+								for(unsigned int p0 = 0; p0 < geometry.window_sizes[0]; ++p0, ++window_elem_id)
+									dst[p0] = flip_and_transpose ? src[window_elem_count - 1 - window_elem_id] : src[window_elem_id];
+							}
+
+					transform_tile(t, plans, &tile[0], &tile_spectrum[0], &scratch[0]);
+
+					// Conjugated spectrum turns products into cross-correlation, which is what convolution layer computes
+					float * re_it = weights_spectrum + workload_id;
+					float * im_it = re_it + plane_elem_count;
+					for(unsigned int f = 0; f < t.spectrum_elem_count; ++f, re_it += frequency_stride, im_it += frequency_stride)
+					{
+						*re_it = tile_spectrum[f].real() * mult;
+						*im_it = -tile_spectrum[f].imag() * mult;
+					}
+				}
+			}
+		}
+
+		void convolution_fft_plain::run_forward(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const tiling& t,
+			const float * input,
+			float * output,
+			const float * weights_spectrum,
+			const float * biases,
+			bool add_to_output,
+			float * working_buffer,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			std::vector<fft_plain> plans;
+			create_plans(isa, t, plans);
+
+			const unsigned int input_feature_map_count = geometry.input_feature_map_count;
+			const unsigned int output_feature_map_count = geometry.output_feature_map_count;
+			const unsigned int tile_count_per_entry = t.tile_count_per_entry;
+			const unsigned int total_tile_count = tile_count_per_entry * entry_count;
+			const size_t input_plane_elem_count = static_cast<size_t>(t.spectrum_elem_count) * input_feature_map_count * total_tile_count;
+			const size_t output_plane_elem_count = static_cast<size_t>(t.spectrum_elem_count) * output_feature_map_count * total_tile_count;
+			const size_t weights_plane_elem_count = static_cast<size_t>(t.spectrum_elem_count) * input_feature_map_count * output_feature_map_count;
+			float * const input_spectrum = working_buffer;
+			float * const output_spectrum = working_buffer + input_plane_elem_count * 2;
+
+			transform_feature_maps(
+				t,
+				plans,
+				input,
+				geometry.input_dimension_sizes,
+				input_feature_map_count,
+				geometry.left_zero_padding,
+				false,
+				input_spectrum,
+				entry_count,
+				thread_count);
+
+			// Complex product summed over input feature maps: Y = W * X for each frequency
+			const int spectrum_elem_count = t.spectrum_elem_count;
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(thread_count)
+			for(int f = 0; f < spectrum_elem_count; ++f)
+			{
+				const float * w_re = weights_spectrum + static_cast<size_t>(f) * output_feature_map_count * input_feature_map_count;
+				const float * w_im = w_re + weights_plane_elem_count;
+				const float * x_re = input_spectrum + static_cast<size_t>(f) * input_feature_map_count * total_tile_count;
+				const float * x_im = x_re + input_plane_elem_count;
+				float * y_re = output_spectrum + static_cast<size_t>(f) * output_feature_map_count * total_tile_count;
+				float * y_im = y_re + output_plane_elem_count;
+
+				gemm_plain::sgemm(isa, false, false, output_feature_map_count, total_tile_count, input_feature_map_count, 1.0F, w_re, input_feature_map_count, x_re, total_tile_count, 0.0F, y_re, total_tile_count);
+				gemm_plain::sgemm(isa, false, false, output_feature_map_count, total_tile_count, input_feature_map_count, -1.0F, w_im, input_feature_map_count, x_im, total_tile_count, 1.0F, y_re, total_tile_count);
+				gemm_plain::sgemm(isa, false, false, output_feature_map_count, total_tile_count, input_feature_map_count, 1.0F, w_re, input_feature_map_count, x_im, total_tile_count, 0.0F, y_im, total_tile_count);
+				gemm_plain::sgemm(isa, false, false, output_feature_map_count, total_tile_count, input_feature_map_count, 1.0F, w_im, input_feature_map_count, x_re, total_tile_count, 1.0F, y_im, total_tile_count);
+			}
+
+			const unsigned int output_neuron_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+			const size_t frequency_stride = static_cast<size_t>(output_feature_map_count) * total_tile_count;
+			const int total_workload = entry_count * output_feature_map_count * tile_count_per_entry;
+			#pragma omp parallel default(shared) num_threads(thread_count)
+			{
+				std::vector<float> tile(t.fft_elem_count);
+				std::vector<fft_plain::complex> tile_spectrum(t.spectrum_elem_count);
+				std::vector<fft_plain::complex> scratch(get_scratch_elem_count(t));
+				nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count> start_positions;
+
+				#pragma omp for schedule(guided)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					unsigned int tile_id = workload_id % tile_count_per_entry;
+					unsigned int entry_feature_map_id = workload_id / tile_count_per_entry;
+					unsigned int feature_map_id = entry_feature_map_id % output_feature_map_count;
+					unsigned int entry_id = entry_feature_map_id / output_feature_map_count;
+
+					const float * re_it = output_spectrum + static_cast<size_t>(feature_map_id) * total_tile_count + entry_id * tile_count_per_entry + tile_id;
+					const float * im_it = re_it + output_plane_elem_count;
+					for(unsigned int f = 0; f < t.spectrum_elem_count; ++f, re_it += frequency_stride, im_it += frequency_stride)
+						tile_spectrum[f] = fft_plain::complex(*re_it, *im_it);
+
+					inverse_transform_tile(t, plans, &tile_spectrum[0], &tile[0], &scratch[0]);
+
+					unsigned int remaining_tile_id = tile_id;
+					for(unsigned int i = 0; i < convolution_geometry_plain::max_dimension_count; ++i)
+					{
+						start_positions[i] = (remaining_tile_id % t.tile_counts[i]) * t.tile_sizes[i];
+						remaining_tile_id /= t.tile_counts[i];
+					}
+
+					// Only the first tile_sizes elements of each dimension are free of the cyclic wrap-around
+					const float bias = biases ? biases[feature_map_id] : 0.0F;
+					float * out_base = output + static_cast<size_t>(entry_feature_map_id) * output_neuron_count_per_feature_map;
+					const unsigned int x_count = std::min(t.tile_sizes[0], geometry.output_dimension_sizes[0] - start_positions[0]);
+					for(unsigned int p3 = 0; (p3 < t.tile_sizes[3]) && (start_positions[3] + p3 < geometry.output_dimension_sizes[3]); ++p3)
+					{
+						for(unsigned int p2 = 0; (p2 < t.tile_sizes[2]) && (start_positions[2] + p2 < geometry.output_dimension_sizes[2]); ++p2)
+						{
+							for(unsigned int p1 = 0; (p1 < t.tile_sizes[1]) && (start_positions[1] + p1 < geometry.output_dimension_sizes[1]); ++p1)
+							{
+								const float * src = &tile[((p3 * t.fft_sizes[2] + p2) * t.fft_sizes[1] + p1) * t.fft_sizes[0]];
+								float * dst = out_base + (((start_positions[3] + p3) * geometry.output_dimension_sizes[2] + start_positions[2] + p2) * geometry.output_dimension_sizes[1] + start_positions[1] + p1) * geometry.output_dimension_sizes[0] + start_positions[0];
+								if (add_to_output)
+									for(unsigned int x = 0; x < x_count; ++x)
+										dst[x] += src[x] + bias;
+								else
+									for(unsigned int x = 0; x < x_count; ++x)
+										dst[x] = src[x] + bias;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		void convolution_fft_plain::run_backward_weights(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const tiling& t,
+			const float * input,
+			const float * output_errors,
+			float * gradient_weights,
+			float * working_buffer,
+			float * fixed_working_buffer,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			std::vector<fft_plain> plans;
+			create_plans(isa, t, plans);
+
+			const unsigned int input_feature_map_count = geometry.input_feature_map_count;
+			const unsigned int output_feature_map_count = geometry.output_feature_map_count;
+			const unsigned int total_tile_count = t.tile_count_per_entry * entry_count;
+			const size_t input_plane_elem_count = static_cast<size_t>(t.spectrum_elem_count) * input_feature_map_count * total_tile_count;
+			const size_t output_plane_elem_count = static_cast<size_t>(t.spectrum_elem_count) * output_feature_map_count * total_tile_count;
+			const size_t gradient_plane_elem_count = static_cast<size_t>(t.spectrum_elem_count) * input_feature_map_count * output_feature_map_count;
+			float * const input_spectrum = working_buffer;
+			float * const output_errors_spectrum = working_buffer + input_plane_elem_count * 2;
+			float * const gradient_spectrum = fixed_working_buffer;
+
+			transform_feature_maps(
+				t,
+				plans,
+				input,
+				geometry.input_dimension_sizes,
+				input_feature_map_count,
+				geometry.left_zero_padding,
+				false,
+				input_spectrum,
+				entry_count,
+				thread_count);
+
+			// Output errors are zero outside of the tile, so that the whole window fits the fft size
+			nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count> no_padding;
+			std::fill_n(no_padding.begin(), convolution_geometry_plain::max_dimension_count, 0U);
+			transform_feature_maps(
+				t,
+				plans,
+				output_errors,
+				geometry.output_dimension_sizes,
+				output_feature_map_count,
+				no_padding,
+				true,
+				output_errors_spectrum,
+				entry_count,
+				thread_count);
+
+			// Cross-correlation of output errors and input summed over all the tiles: G = conj(E) * X^T for each frequency
+			const int spectrum_elem_count = t.spectrum_elem_count;
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(thread_count)
+			for(int f = 0; f < spectrum_elem_count; ++f)
+			{
+				const float * e_re = output_errors_spectrum + static_cast<size_t>(f) * output_feature_map_count * total_tile_count;
+				const float * e_im = e_re + output_plane_elem_count;
+				const float * x_re = input_spectrum + static_cast<size_t>(f) * input_feature_map_count * total_tile_count;
+				const float * x_im = x_re + input_plane_elem_count;
+				float * g_re = gradient_spectrum + static_cast<size_t>(f) * output_feature_map_count * input_feature_map_count;
+				float * g_im = g_re + gradient_plane_elem_count;
+
+				gemm_plain::sgemm(isa, false, true, output_feature_map_count, input_feature_map_count, total_tile_count, 1.0F, e_re, total_tile_count, x_re, total_tile_count, 0.0F, g_re, input_feature_map_count);
+				gemm_plain::sgemm(isa, false, true, output_feature_map_count, input_feature_map_count, total_tile_count, 1.0F, e_im, total_tile_count, x_im, total_tile_count, 1.0F, g_re, input_feature_map_count);
+				gemm_plain::sgemm(isa, false, true, output_feature_map_count, input_feature_map_count, total_tile_count, 1.0F, e_re, total_tile_count, x_im, total_tile_count, 0.0F, g_im, input_feature_map_count);
+				gemm_plain::sgemm(isa, false, true, output_feature_map_count, input_feature_map_count, total_tile_count, -1.0F, e_im, total_tile_count, x_re, total_tile_count, 1.0F, g_im, input_feature_map_count);
+			}
+
+			const unsigned int window_elem_count = geometry.window_elem_count;
+			const size_t frequency_stride = static_cast<size_t>(input_feature_map_count) * output_feature_map_count;
+			const float mult = 1.0F / static_cast<float>(t.fft_elem_count);
+			const int total_workload = output_feature_map_count * input_feature_map_count;
+			#pragma omp parallel default(shared) num_threads(thread_count)
+			{
+				std::vector<float> tile(t.fft_elem_count);
+				std::vector<fft_plain::complex> tile_spectrum(t.spectrum_elem_count);
+				std::vector<fft_plain::complex> scratch(get_scratch_elem_count(t));
+
+				#pragma omp for schedule(guided)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					const float * re_it = gradient_spectrum + workload_id;
+					const float * im_it = re_it + gradient_plane_elem_count;
+					for(unsigned int f = 0; f < t.spectrum_elem_count; ++f, re_it += frequency_stride, im_it += frequency_stride)
+						tile_spectrum[f] = fft_plain::complex(*re_it, *im_it);
+
+					inverse_transform_tile(t, plans, &tile_spectrum[0], &tile[0], &scratch[0]);
+
+					float * dst = gradient_weights + static_cast<size_t>(workload_id) * window_elem_count;
+					for(unsigned int p3 = 0; p3 < geometry.window_sizes[3]; ++p3)
+						for(unsigned int p2 = 0; p2 < geometry.window_sizes[2]; ++p2)
+							for(unsigned int p1 = 0; p1 < geometry.window_sizes[1]; ++p1)
+							{
+								const float * src = &tile[((p3 * t.fft_sizes[2] + p2) * t.fft_sizes[1] + p1) * t.fft_sizes[0]];
+								for(unsigned int p0 = 0; p0 < geometry.window_sizes[0]; ++p0, ++dst)
+									*dst += src[p0] * mult;
+							}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,175 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "convolution_geometry_plain.h"
+#include "cpu_dispatch_plain.h"
+#include "fft_plain.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Frequency domain convolution for stride 1 convolutions of 1 to 4 dimensions
+		// Output is split into tiles, each tile is computed from the input window of fft size with cyclic correlation,
+		// for each frequency the products are summed over input feature maps with complex GEMM
+		// Spectra are stored as separate real and imaginary planes, each with layout [frequency][feature_map][tile]
+		// Weight spectra are conjugated, normalized and have layout [frequency][output_feature_map][input_feature_map]
+		class convolution_fft_plain
+		{
+		public:
+			class tiling
+			{
+			public:
+				nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count> fft_sizes;
+				nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count> tile_sizes;
+				nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count> tile_counts;
+				unsigned int tile_count_per_entry;
+				unsigned int fft_elem_count;
+				unsigned int spectrum_elem_count;
+			};
+
+			// Returns false when FFT cannot be applied or its predicted cost is higher than that of the direct convolution
+			static bool get_tiling(
+				const convolution_geometry_plain& geometry,
+				tiling& res);
+
+			static size_t get_weights_spectrum_elem_count(
+				const convolution_geometry_plain& geometry,
+				const tiling& t);
+
+			// When flip_and_transpose is true the weights are converted to those of the convolution computing input errors
+			static void transform_weights(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const tiling& t,
+				const float * weights,
+				float * weights_spectrum,
+				bool flip_and_transpose,
+				int thread_count);
+
+			static size_t get_working_buffer_size_per_entry(
+				const convolution_geometry_plain& geometry,
+				const tiling& t);
+
+			// working_buffer should hold get_working_buffer_size_per_entry bytes per entry
+			static void run_forward(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const tiling& t,
+				const float * input,
+				float * output,
+				const float * weights_spectrum,
+				const float * biases,
+				bool add_to_output,
+				float * working_buffer,
+				unsigned int entry_count,
+				int thread_count);
+
+			static size_t get_backward_weights_working_buffer_size(
+				const convolution_geometry_plain& geometry,
+				const tiling& t);
+
+			// Weight gradient is added to gradient_weights
+			// working_buffer holds get_working_buffer_size_per_entry bytes per entry,
+			// fixed_working_buffer is of get_backward_weights_working_buffer_size bytes
+			static void run_backward_weights(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const tiling& t,
+				const float * input,
+				const float * output_errors,
+				float * gradient_weights,
+				float * working_buffer,
+				float * fixed_working_buffer,
+				unsigned int entry_count,
+				int thread_count);
+
+		private:
+			// plans[0] runs real transform along dimension 0, the rest run complex transforms
+			static void create_plans(
+				cpu_dispatch_plain::isa isa,
+				const tiling& t,
+				std::vector<fft_plain>& plans);
+
+			static size_t get_scratch_elem_count(const tiling& t);
+
+			static void transform_tile(
+				const tiling& t,
+				const std::vector<fft_plain>& plans,
+				const float * tile,
+				fft_plain::complex * spectrum,
+				fft_plain::complex * scratch);
+
+			// spectrum is overwritten
+			static void inverse_transform_tile(
+				const tiling& t,
+				const std::vector<fft_plain>& plans,
+				fft_plain::complex * spectrum,
+				float * tile,
+				fft_plain::complex * scratch);
+
+			// Copies copy_sizes elements starting at start_positions from the feature map to the tile of fft sizes,
+			// elements outside the feature map or beyond copy_sizes are set to zero
+			static void load_tile(
+				const tiling& t,
+				const float * feature_map,
+				const nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count>& feature_map_sizes,
+				const nnforge_array<int, convolution_geometry_plain::max_dimension_count>& start_positions,
+				const nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count>& copy_sizes,
+				float * tile);
+
+			// Transforms input tiles of feature maps from feature_map_count feature maps of each entry
+			static void transform_feature_maps(
+				const tiling& t,
+				const std::vector<fft_plain>& plans,
+				const float * feature_maps,
+				const nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count>& feature_map_sizes,
+				unsigned int feature_map_count,
+				const nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count>& left_zero_padding,
+				bool clip_to_tile_sizes,
+				float * spectrum,
+				unsigned int entry_count,
+				int thread_count);
+
+			static unsigned int get_fft_size_candidate(
+				unsigned int size,
+				bool real_transform);
+
+		private:
+			// Working buffer of a single entry larger than this is not allocated
+			static const size_t max_working_buffer_size_per_entry;
+
+			// Weight spectra larger than this are not allocated
+			static const size_t max_weights_spectrum_size;
+
+			static const unsigned int max_fft_elem_count;
+
+			// Costs relative to a single multiply-add of the direct convolution, which runs on packed GEMM:
+			// the transform of size n costs transform_cost_factor * n * log2(n), a complex multiply-add costs multiply_cost_factor
+			static const float transform_cost_factor;
+			static const float multiply_cost_factor;
+
+		private:
+			convolution_fft_plain();
+			~convolution_fft_plain();
+		};
+	}
+}
@@ -0,0 +1,632 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_gemm_plain.h"
+
+#include "gemm_plain.h"
+#include "gradient_reduction_plain.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			// Range of output x positions for which window x offset reads the input within its boundaries
+			NNFORGE_PLAIN_FORCEINLINE void get_output_x_range(
+				const convolution_geometry_plain& geometry,
+				unsigned int window_x,
+				unsigned int& output_x_start,
+				unsigned int& output_x_end)
+			{
+				const unsigned int output_width = geometry.output_dimension_sizes[0];
+				const unsigned int input_width = geometry.input_dimension_sizes[0];
+				const unsigned int stride_x = geometry.strides[0];
+				const int x_offset = static_cast<int>(window_x) - static_cast<int>(geometry.left_zero_padding[0]);
+
+				output_x_start = 0;
+				if (x_offset < 0)
+					output_x_start = std::min((static_cast<unsigned int>(-x_offset) + stride_x - 1) / stride_x, output_width);
+				output_x_end = 0;
+				if (static_cast<int>(input_width) - x_offset > 0)
+					output_x_end = std::min((static_cast<unsigned int>(static_cast<int>(input_width) - x_offset) + stride_x - 1) / stride_x, output_width);
+				output_x_end = std::max(output_x_end, output_x_start);
+			}
+
+			// Bodies below are inlined into the variants compiled for each instruction set
+
+			NNFORGE_PLAIN_FORCEINLINE void im2col_body(
+				const convolution_geometry_plain& geometry,
+				const float * input,
+				float * column,
+				unsigned int row_start,
+				unsigned int row_count)
+			{
+				const unsigned int window_elem_count = geometry.window_elem_count;
+				const unsigned int output_elem_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+				const unsigned int output_width = geometry.output_dimension_sizes[0];
+				const unsigned int input_width = geometry.input_dimension_sizes[0];
+				const unsigned int stride_x = geometry.strides[0];
+				const int left_padding_x = static_cast<int>(geometry.left_zero_padding[0]);
+
+				for(unsigned int row_id = row_start; row_id < row_start + row_count; ++row_id)
+				{
+					const unsigned int input_feature_map_id = row_id / window_elem_count;
+					unsigned int window_elem_id = row_id - input_feature_map_id * window_elem_count;
+
+					nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count> window_position;
+					for(unsigned int i = 0; i < convolution_geometry_plain::max_dimension_count; ++i)
+					{
+						window_position[i] = window_elem_id % geometry.window_sizes[i];
+						window_elem_id /= geometry.window_sizes[i];
+					}
+
+					const int x_offset = static_cast<int>(window_position[0]) - left_padding_x;
+					unsigned int output_x_start;
+					unsigned int output_x_end;
+					get_output_x_range(geometry, window_position[0], output_x_start, output_x_end);
+
+					const float * in_feature_map = input + static_cast<size_t>(input_feature_map_id) * geometry.input_neuron_count_per_feature_map;
+					float * dst = column + static_cast<size_t>(row_id) * output_elem_count_per_feature_map;
+
+					for(unsigned int w = 0; w < geometry.output_dimension_sizes[3]; ++w)
+					{
+						int input_w = static_cast<int>(w * geometry.strides[3] + window_position[3]) - static_cast<int>(geometry.left_zero_padding[3]);
+						bool fit3 = (static_cast<unsigned int>(input_w) < geometry.input_dimension_sizes[3]);
+						for(unsigned int z = 0; z < geometry.output_dimension_sizes[2]; ++z)
+						{
+							int input_z = static_cast<int>(z * geometry.strides[2] + window_position[2]) - static_cast<int>(geometry.left_zero_padding[2]);
+							bool fit2 = fit3 && (static_cast<unsigned int>(input_z) < geometry.input_dimension_sizes[2]);
+							for(unsigned int y = 0; y < geometry.output_dimension_sizes[1]; ++y, dst += output_width)
+							{
+								int input_y = static_cast<int>(y * geometry.strides[1] + window_position[1]) - static_cast<int>(geometry.left_zero_padding[1]);
+								bool fit1 = fit2 && (static_cast<unsigned int>(input_y) < geometry.input_dimension_sizes[1]);
+								if (!fit1)
+								{
+									std::fill_n(dst, output_width, 0.0F);
+									continue;
+								}
+
+								const float * src = in_feature_map + ((static_cast<size_t>(input_w) * geometry.input_dimension_sizes[2] + input_z) * geometry.input_dimension_sizes[1] + input_y) * input_width;
+								std::fill(dst, dst + output_x_start, 0.0F);
+								if (stride_x == 1)
+								{
+									std::copy(src + (static_cast<int>(output_x_start) + x_offset), src + (static_cast<int>(output_x_end) + x_offset), dst + output_x_start);
+								}
+								else
+								{
+									const float * src_it = src + (static_cast<int>(output_x_start * stride_x) + x_offset);
+									for(unsigned int x = output_x_start; x < output_x_end; ++x, src_it += stride_x)
+										dst[x] = *src_it;
+								}
+								std::fill(dst + output_x_end, dst + output_width, 0.0F);
+							}
+						}
+					}
+				}
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE void col2im_body(
+				const convolution_geometry_plain& geometry,
+				const float * column,
+				float * input,
+				bool add_to_input,
+				unsigned int input_feature_map_start,
+				unsigned int input_feature_map_count)
+			{
+				const unsigned int window_elem_count = geometry.window_elem_count;
+				const unsigned int output_elem_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+				const unsigned int output_width = geometry.output_dimension_sizes[0];
+				const unsigned int input_width = geometry.input_dimension_sizes[0];
+				const unsigned int stride_x = geometry.strides[0];
+				const int left_padding_x = static_cast<int>(geometry.left_zero_padding[0]);
+
+				for(unsigned int input_feature_map_id = input_feature_map_start; input_feature_map_id < input_feature_map_start + input_feature_map_count; ++input_feature_map_id)
+				{
+					float * in_feature_map = input + static_cast<size_t>(input_feature_map_id) * geometry.input_neuron_count_per_feature_map;
+					if (!add_to_input)
+						std::fill_n(in_feature_map, geometry.input_neuron_count_per_feature_map, 0.0F);
+
+					// All the rows of the feature map are summed by the same thread, no synchronization is needed
+					for(unsigned int window_elem_id = 0; window_elem_id < window_elem_count; ++window_elem_id)
+					{
+						nnforge_array<unsigned int, convolution_geometry_plain::max_dimension_count> window_position;
+						unsigned int remaining_window_elem_id = window_elem_id;
+						for(unsigned int i = 0; i < convolution_geometry_plain::max_dimension_count; ++i)
+						{
+							window_position[i] = remaining_window_elem_id % geometry.window_sizes[i];
+							remaining_window_elem_id /= geometry.window_sizes[i];
+						}
+
+						const int x_offset = static_cast<int>(window_position[0]) - left_padding_x;
+						unsigned int output_x_start;
+						unsigned int output_x_end;
+						get_output_x_range(geometry, window_position[0], output_x_start, output_x_end);
+
+						const float * src = column + static_cast<size_t>(input_feature_map_id * window_elem_count + window_elem_id) * output_elem_count_per_feature_map;
+
+						for(unsigned int w = 0; w < geometry.output_dimension_sizes[3]; ++w)
+						{
+							int input_w = static_cast<int>(w * geometry.strides[3] + window_position[3]) - static_cast<int>(geometry.left_zero_padding[3]);
+							bool fit3 = (static_cast<unsigned int>(input_w) < geometry.input_dimension_sizes[3]);
+							for(unsigned int z = 0; z < geometry.output_dimension_sizes[2]; ++z)
+							{
+								int input_z = static_cast<int>(z * geometry.strides[2] + window_position[2]) - static_cast<int>(geometry.left_zero_padding[2]);
+								bool fit2 = fit3 && (static_cast<unsigned int>(input_z) < geometry.input_dimension_sizes[2]);
+								for(unsigned int y = 0; y < geometry.output_dimension_sizes[1]; ++y, src += output_width)
+								{
+									int input_y = static_cast<int>(y * geometry.strides[1] + window_position[1]) - static_cast<int>(geometry.left_zero_padding[1]);
+									bool fit1 = fit2 && (static_cast<unsigned int>(input_y) < geometry.input_dimension_sizes[1]);
+									if (!fit1)
+										continue;
+
+									float * dst = in_feature_map + ((static_cast<size_t>(input_w) * geometry.input_dimension_sizes[2] + input_z) * geometry.input_dimension_sizes[1] + input_y) * input_width;
+									if (stride_x == 1)
+									{
+										float * dst_it = dst + (static_cast<int>(output_x_start) + x_offset);
+										for(unsigned int x = output_x_start; x < output_x_end; ++x, ++dst_it)
+											*dst_it += src[x];
+									}
+									else
+									{
+										float * dst_it = dst + (static_cast<int>(output_x_start * stride_x) + x_offset);
+										for(unsigned int x = output_x_start; x < output_x_end; ++x, dst_it += stride_x)
+											*dst_it += src[x];
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+
+			class kernel_table
+			{
+			public:
+				void (*im2col)(const convolution_geometry_plain&, const float *, float *, unsigned int, unsigned int);
+				void (*col2im)(const convolution_geometry_plain&, const float *, float *, bool, unsigned int, unsigned int);
+			};
+
+			// Defines kernels compiled with target_attribute and their table in namespace isa_namespace
+#define NNFORGE_CONVOLUTION_GEMM_PLAIN_VARIANT(isa_namespace, target_attribute) \
+			namespace isa_namespace \
+			{ \
+				target_attribute void im2col(const convolution_geometry_plain& geometry, const float * input, float * column, unsigned int row_start, unsigned int row_count) \
+				{ \
+					im2col_body(geometry, input, column, row_start, row_count); \
+				} \
+				target_attribute void col2im(const convolution_geometry_plain& geometry, const float * column, float * input, bool add_to_input, unsigned int input_feature_map_start, unsigned int input_feature_map_count) \
+				{ \
+					col2im_body(geometry, column, input, add_to_input, input_feature_map_start, input_feature_map_count); \
+				} \
+				const kernel_table table = { \
+					im2col, \
+					col2im}; \
+			}
+
+			NNFORGE_PLAIN_FOR_EACH_ISA(NNFORGE_CONVOLUTION_GEMM_PLAIN_VARIANT)
+
+#undef NNFORGE_CONVOLUTION_GEMM_PLAIN_VARIANT
+
+			const kernel_table& get_kernel_table(cpu_dispatch_plain::isa isa)
+			{
+				return NNFORGE_PLAIN_SELECT_ISA(isa, table);
+			}
+		}
+
+		const size_t convolution_gemm_plain::max_column_buffer_size_per_entry = 64 * 1024 * 1024;
+
+		bool convolution_gemm_plain::is_applicable(const convolution_geometry_plain& geometry)
+		{
+			size_t column_elem_count = static_cast<size_t>(geometry.input_feature_map_count) * geometry.window_elem_count * geometry.output_neuron_count_per_feature_map;
+			return (column_elem_count * sizeof(float) <= max_column_buffer_size_per_entry);
+		}
+
+		size_t convolution_gemm_plain::get_column_buffer_size_per_entry(const convolution_geometry_plain& geometry)
+		{
+			if (geometry.is_pointwise())
+				return 0;
+
+			return static_cast<size_t>(geometry.input_feature_map_count) * geometry.window_elem_count * geometry.output_neuron_count_per_feature_map * sizeof(float);
+		}
+
+		void convolution_gemm_plain::run_forward(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const float * input,
+			float * output,
+			const float * weights,
+			const float * biases,
+			float * column_buffer,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			const bool pointwise = geometry.is_pointwise();
+			const unsigned int input_neuron_count = geometry.input_neuron_count_per_feature_map * geometry.input_feature_map_count;
+			const unsigned int output_neuron_count = geometry.output_neuron_count_per_feature_map * geometry.output_feature_map_count;
+			const unsigned int row_count = geometry.input_feature_map_count * geometry.window_elem_count;
+			const size_t column_elem_count = static_cast<size_t>(row_count) * geometry.output_neuron_count_per_feature_map;
+
+			if ((static_cast<int>(entry_count) >= thread_count) || (thread_count <= 1))
+			{
+				// Enough entries to keep all the threads busy, each entry is processed by a single thread
+				#pragma omp parallel for default(shared) schedule(dynamic) num_threads(thread_count)
+				for(int entry_id = 0; entry_id < static_cast<int>(entry_count); ++entry_id)
+				{
+					const float * in = input + static_cast<size_t>(entry_id) * input_neuron_count;
+					const float * column = in;
+					if (!pointwise)
+					{
+						float * current_column = column_buffer + static_cast<size_t>(entry_id) * column_elem_count;
+						im2col(isa, geometry, in, current_column, 0, row_count);
+						column = current_column;
+					}
+
+					forward_entry(
+						isa,
+						geometry,
+						output + static_cast<size_t>(entry_id) * output_neuron_count,
+						weights,
+						biases,
+						column,
+						1);
+				}
+			}
+			else
+			{
+				// Few entries, parallelize both unfolding and multiplication within each entry
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+				{
+					const float * in = input + static_cast<size_t>(entry_id) * input_neuron_count;
+					const float * column = in;
+					if (!pointwise)
+					{
+						float * current_column = column_buffer + static_cast<size_t>(entry_id) * column_elem_count;
+						// Rows rather than input feature maps, the first layer has too few of them to keep the threads busy
+						#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+						for(int row_id = 0; row_id < static_cast<int>(row_count); ++row_id)
+							im2col(isa, geometry, in, current_column, row_id, 1);
+						column = current_column;
+					}
+
+					forward_entry(
+						isa,
+						geometry,
+						output + static_cast<size_t>(entry_id) * output_neuron_count,
+						weights,
+						biases,
+						column,
+						thread_count);
+				}
+			}
+		}
+
+		void convolution_gemm_plain::forward_entry(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			float * output,
+			const float * weights,
+			const float * biases,
+			const float * column,
+			int thread_count)
+		{
+			const unsigned int output_elem_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+			const unsigned int row_count = geometry.input_feature_map_count * geometry.window_elem_count;
+
+			if (biases)
+			{
+				for(unsigned int output_feature_map_id = 0; output_feature_map_id < geometry.output_feature_map_count; ++output_feature_map_id)
+					std::fill_n(output + output_feature_map_id * output_elem_count_per_feature_map, output_elem_count_per_feature_map, biases[output_feature_map_id]);
+			}
+
+			gemm_plain::sgemm(
+				isa,
+				false,
+				false,
+				geometry.output_feature_map_count,
+				output_elem_count_per_feature_map,
+				row_count,
+				1.0F,
+				weights,
+				row_count,
+				column,
+				output_elem_count_per_feature_map,
+				biases ? 1.0F : 0.0F,
+				output,
+				output_elem_count_per_feature_map,
+				thread_count);
+		}
+
+		void convolution_gemm_plain::run_backward_data(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const float * output_errors,
+			float * input_errors,
+			const float * weights,
+			bool add_to_input_errors,
+			float * column_buffer,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			const bool pointwise = geometry.is_pointwise();
+			const unsigned int input_neuron_count = geometry.input_neuron_count_per_feature_map * geometry.input_feature_map_count;
+			const unsigned int output_neuron_count = geometry.output_neuron_count_per_feature_map * geometry.output_feature_map_count;
+			const unsigned int output_elem_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+			const unsigned int row_count = geometry.input_feature_map_count * geometry.window_elem_count;
+			const size_t column_elem_count = static_cast<size_t>(row_count) * output_elem_count_per_feature_map;
+
+			if ((static_cast<int>(entry_count) >= thread_count) || (thread_count <= 1))
+			{
+				#pragma omp parallel for default(shared) schedule(dynamic) num_threads(thread_count)
+				for(int entry_id = 0; entry_id < static_cast<int>(entry_count); ++entry_id)
+				{
+					const float * out_err = output_errors + static_cast<size_t>(entry_id) * output_neuron_count;
+					float * in_err = input_errors + static_cast<size_t>(entry_id) * input_neuron_count;
+					if (pointwise)
+					{
+						// Column matrix is the input errors themselves
+						gemm_plain::sgemm(
+							isa,
+							true,
+							false,
+							row_count,
+							output_elem_count_per_feature_map,
+							geometry.output_feature_map_count,
+							1.0F,
+							weights,
+							row_count,
+							out_err,
+							output_elem_count_per_feature_map,
+							add_to_input_errors ? 1.0F : 0.0F,
+							in_err,
+							output_elem_count_per_feature_map);
+					}
+					else
+					{
+						float * current_column = column_buffer + static_cast<size_t>(entry_id) * column_elem_count;
+						backward_data_entry(isa, geometry, out_err, weights, current_column, 1);
+						col2im(isa, geometry, current_column, in_err, add_to_input_errors, 0, geometry.input_feature_map_count);
+					}
+				}
+			}
+			else
+			{
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+				{
+					const float * out_err = output_errors + static_cast<size_t>(entry_id) * output_neuron_count;
+					float * in_err = input_errors + static_cast<size_t>(entry_id) * input_neuron_count;
+					if (pointwise)
+					{
+						gemm_plain::sgemm(
+							isa,
+							true,
+							false,
+							row_count,
+							output_elem_count_per_feature_map,
+							geometry.output_feature_map_count,
+							1.0F,
+							weights,
+							row_count,
+							out_err,
+							output_elem_count_per_feature_map,
+							add_to_input_errors ? 1.0F : 0.0F,
+							in_err,
+							output_elem_count_per_feature_map,
+							thread_count);
+					}
+					else
+					{
+						float * current_column = column_buffer + static_cast<size_t>(entry_id) * column_elem_count;
+						backward_data_entry(isa, geometry, out_err, weights, current_column, thread_count);
+						#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+						for(int input_feature_map_id = 0; input_feature_map_id < static_cast<int>(geometry.input_feature_map_count); ++input_feature_map_id)
+							col2im(isa, geometry, current_column, in_err, add_to_input_errors, input_feature_map_id, 1);
+					}
+				}
+			}
+		}
+
+		unsigned int convolution_gemm_plain::get_backward_weights_work_item_count(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry)
+		{
+			const unsigned int row_count = geometry.input_feature_map_count * geometry.window_elem_count;
+			const unsigned int mr = gemm_plain::get_mr(isa);
+			const unsigned int nr = gemm_plain::get_nr(isa);
+			return ((geometry.output_feature_map_count + mr - 1) / mr) * ((row_count + nr - 1) / nr);
+		}
+
+		size_t convolution_gemm_plain::get_backward_weights_slab_buffer_size(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			int thread_count)
+		{
+			return gradient_reduction_plain::get_slab_buffer_size(
+				get_backward_weights_work_item_count(isa, geometry),
+				static_cast<size_t>(geometry.output_feature_map_count) * geometry.input_feature_map_count * geometry.window_elem_count,
+				thread_count);
+		}
+
+		void convolution_gemm_plain::run_backward_weights(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const float * input,
+			const float * output_errors,
+			float * gradient_weights,
+			float * column_buffer,
+			void * slab_buffer,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			const bool pointwise = geometry.is_pointwise();
+			const unsigned int input_neuron_count = geometry.input_neuron_count_per_feature_map * geometry.input_feature_map_count;
+			const unsigned int output_neuron_count = geometry.output_neuron_count_per_feature_map * geometry.output_feature_map_count;
+			const unsigned int row_count = geometry.input_feature_map_count * geometry.window_elem_count;
+			const size_t column_elem_count = static_cast<size_t>(row_count) * geometry.output_neuron_count_per_feature_map;
+			const size_t gradient_elem_count = static_cast<size_t>(geometry.output_feature_map_count) * row_count;
+
+			const unsigned int slice_count = gradient_reduction_plain::get_slice_count(
+				get_backward_weights_work_item_count(isa, geometry),
+				gradient_elem_count,
+				entry_count,
+				thread_count);
+
+			if (slice_count > 1)
+			{
+				// The gradient is too small to keep all the threads busy, each thread accumulates its own slice of entries
+				#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+				for(int slice_id = 0; slice_id < static_cast<int>(slice_count); ++slice_id)
+				{
+					float * slab = gradient_reduction_plain::get_slab(slab_buffer, gradient_elem_count, slice_id);
+					std::fill_n(slab, gradient_elem_count, 0.0F);
+
+					unsigned int entry_start;
+					unsigned int entry_end;
+					gradient_reduction_plain::get_entry_range(entry_count, slice_count, slice_id, entry_start, entry_end);
+					for(unsigned int entry_id = entry_start; entry_id < entry_end; ++entry_id)
+					{
+						const float * in = input + static_cast<size_t>(entry_id) * input_neuron_count;
+						const float * column = in;
+						if (!pointwise)
+						{
+							float * current_column = column_buffer + static_cast<size_t>(entry_id) * column_elem_count;
+							im2col(isa, geometry, in, current_column, 0, row_count);
+							column = current_column;
+						}
+
+						backward_weights_entry(
+							isa,
+							geometry,
+							output_errors + static_cast<size_t>(entry_id) * output_neuron_count,
+							column,
+							slab,
+							1);
+					}
+				}
+
+				gradient_reduction_plain::reduce(slab_buffer, gradient_elem_count, slice_count, gradient_weights, thread_count);
+			}
+			else
+			{
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+				{
+					const float * in = input + static_cast<size_t>(entry_id) * input_neuron_count;
+					const float * column = in;
+					if (!pointwise)
+					{
+						float * current_column = column_buffer + static_cast<size_t>(entry_id) * column_elem_count;
+						const unsigned int window_elem_count = geometry.window_elem_count;
+						#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+						for(int input_feature_map_id = 0; input_feature_map_id < static_cast<int>(geometry.input_feature_map_count); ++input_feature_map_id)
+							im2col(isa, geometry, in, current_column, input_feature_map_id * window_elem_count, window_elem_count);
+						column = current_column;
+					}
+
+					backward_weights_entry(
+						isa,
+						geometry,
+						output_errors + static_cast<size_t>(entry_id) * output_neuron_count,
+						column,
+						gradient_weights,
+						thread_count);
+				}
+			}
+		}
+
+		void convolution_gemm_plain::backward_weights_entry(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const float * output_errors,
+			const float * column,
+			float * gradient_weights,
+			int thread_count)
+		{
+			const unsigned int output_elem_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+			const unsigned int row_count = geometry.input_feature_map_count * geometry.window_elem_count;
+
+			gemm_plain::sgemm(
+				isa,
+				false,
+				true,
+				geometry.output_feature_map_count,
+				row_count,
+				output_elem_count_per_feature_map,
+				1.0F,
+				output_errors,
+				output_elem_count_per_feature_map,
+				column,
+				output_elem_count_per_feature_map,
+				1.0F,
+				gradient_weights,
+				row_count,
+				thread_count);
+		}
+
+		void convolution_gemm_plain::backward_data_entry(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const float * output_errors,
+			const float * weights,
+			float * column,
+			int thread_count)
+		{
+			const unsigned int output_elem_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+			const unsigned int row_count = geometry.input_feature_map_count * geometry.window_elem_count;
+
+			gemm_plain::sgemm(
+				isa,
+				true,
+				false,
+				row_count,
+				output_elem_count_per_feature_map,
+				geometry.output_feature_map_count,
+				1.0F,
+				weights,
+				row_count,
+				output_errors,
+				output_elem_count_per_feature_map,
+				0.0F,
+				column,
+				output_elem_count_per_feature_map,
+				thread_count);
+		}
+
+		void convolution_gemm_plain::im2col(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const float * input,
+			float * column,
+			unsigned int row_start,
+			unsigned int row_count)
+		{
+			get_kernel_table(isa).im2col(geometry, input, column, row_start, row_count);
+		}
+
+		void convolution_gemm_plain::col2im(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const float * column,
+			float * input,
+			bool add_to_input,
+			unsigned int input_feature_map_start,
+			unsigned int input_feature_map_count)
+		{
+			get_kernel_table(isa).col2im(geometry, column, input, add_to_input, input_feature_map_start, input_feature_map_count);
+		}
+	}
+}
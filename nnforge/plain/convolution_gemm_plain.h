@@ -0,0 +1,145 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "convolution_geometry_plain.h"
+#include "cpu_dispatch_plain.h"
+
+#include <cstddef>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Convolution lowered to matrix multiplication
+		// Input of a single entry is unfolded into column matrix (im2col) with
+		// (input_feature_map_count * window_elem_count) rows and output_neuron_count_per_feature_map columns,
+		// the row order matches weights layout so the weights are used as is, as output_feature_map_count x row_count matrix
+		// Backward data multiplies transposed weights by output errors into the column matrix, which is then folded (col2im)
+		// Weight gradient is the product of output errors and transposed column matrix, summed over entries
+		class convolution_gemm_plain
+		{
+		public:
+			// Returns false for shapes where the column matrix is too large, direct convolution should be used then
+			static bool is_applicable(const convolution_geometry_plain& geometry);
+
+			// Returns 0 when no column matrix is needed (pointwise convolution)
+			static size_t get_column_buffer_size_per_entry(const convolution_geometry_plain& geometry);
+
+			// column_buffer should hold get_column_buffer_size_per_entry bytes per entry
+			static void run_forward(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const float * input,
+				float * output,
+				const float * weights,
+				const float * biases,
+				float * column_buffer,
+				unsigned int entry_count,
+				int thread_count);
+
+			// column_buffer should hold get_column_buffer_size_per_entry bytes per entry
+			static void run_backward_data(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const float * output_errors,
+				float * input_errors,
+				const float * weights,
+				bool add_to_input_errors,
+				float * column_buffer,
+				unsigned int entry_count,
+				int thread_count);
+
+			// Returns 0 when the gradient is accumulated in place
+			static size_t get_backward_weights_slab_buffer_size(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				int thread_count);
+
+			// Weight gradient is added to gradient_weights
+			// column_buffer should hold get_column_buffer_size_per_entry bytes per entry,
+			// slab_buffer is of get_backward_weights_slab_buffer_size bytes
+			static void run_backward_weights(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const float * input,
+				const float * output_errors,
+				float * gradient_weights,
+				float * column_buffer,
+				void * slab_buffer,
+				unsigned int entry_count,
+				int thread_count);
+
+			static void im2col(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const float * input,
+				float * column,
+				unsigned int row_start,
+				unsigned int row_count);
+
+			// Sums column rows into input feature maps, each feature map is written by a single call
+			static void col2im(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const float * column,
+				float * input,
+				bool add_to_input,
+				unsigned int input_feature_map_start,
+				unsigned int input_feature_map_count);
+
+		private:
+			static void forward_entry(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				float * output,
+				const float * weights,
+				const float * biases,
+				const float * column,
+				int thread_count);
+
+			static void backward_data_entry(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const float * output_errors,
+				const float * weights,
+				float * column,
+				int thread_count);
+
+			static void backward_weights_entry(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const float * output_errors,
+				const float * column,
+				float * gradient_weights,
+				int thread_count);
+
+			// Number of register blocks in the weight gradient, the gradient GEMM cannot be split finer than that
+			static unsigned int get_backward_weights_work_item_count(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry);
+
+		private:
+			// Column matrix of a single entry larger than this is not materialized
+			static const size_t max_column_buffer_size_per_entry;
+
+		private:
+			convolution_gemm_plain();
+			~convolution_gemm_plain();
+		};
+	}
+}
@@ -0,0 +1,108 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_geometry_plain.h"
+
+#include "../convolution_layer.h"
+#include "../neural_network_exception.h"
+
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const unsigned int convolution_geometry_plain::max_dimension_count;
+
+		convolution_geometry_plain::convolution_geometry_plain(
+			layer::const_ptr layer_schema,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific)
+		{
+			nnforge_shared_ptr<const convolution_layer> layer_derived = nnforge_dynamic_pointer_cast<const convolution_layer>(layer_schema);
+
+			dimension_count = static_cast<unsigned int>(layer_derived->window_sizes.size());
+			if (dimension_count > max_dimension_count)
+				throw neural_network_exception((boost::format("convolution_geometry_plain cannot handle %1% dimensions") % dimension_count).str());
+
+			for(unsigned int i = 0; i < max_dimension_count; ++i)
+			{
+				bool active = (i < dimension_count);
+				window_sizes[i] = active ? layer_derived->window_sizes[i] : 1;
+				strides[i] = (active && (i < layer_derived->strides.size())) ? layer_derived->strides[i] : 1;
+				left_zero_padding[i] = (active && (i < layer_derived->left_zero_padding.size())) ? layer_derived->left_zero_padding[i] : 0;
+				right_zero_padding[i] = (active && (i < layer_derived->right_zero_padding.size())) ? layer_derived->right_zero_padding[i] : 0;
+				input_dimension_sizes[i] = active ? input_configuration_specific.dimension_sizes[i] : 1;
+				output_dimension_sizes[i] = active ? output_configuration_specific.dimension_sizes[i] : 1;
+			}
+
+			input_feature_map_count = input_configuration_specific.feature_map_count;
+			output_feature_map_count = output_configuration_specific.feature_map_count;
+			input_neuron_count_per_feature_map = input_configuration_specific.get_neuron_count_per_feature_map();
+			output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+
+			window_elem_count = 1;
+			for(unsigned int i = 0; i < max_dimension_count; ++i)
+				window_elem_count *= window_sizes[i];
+
+			bias = layer_derived->bias;
+		}
+
+		bool convolution_geometry_plain::is_pointwise() const
+		{
+			for(unsigned int i = 0; i < max_dimension_count; ++i)
+				if ((window_sizes[i] != 1) || (strides[i] != 1) || (left_zero_padding[i] != 0) || (right_zero_padding[i] != 0))
+					return false;
+			return true;
+		}
+
+		bool convolution_geometry_plain::is_fully_connected() const
+		{
+			for(unsigned int i = 0; i < max_dimension_count; ++i)
+				if ((window_sizes[i] != input_dimension_sizes[i]) || (left_zero_padding[i] != 0) || (right_zero_padding[i] != 0))
+					return false;
+			return true;
+		}
+
+		bool convolution_geometry_plain::has_backward_data_geometry() const
+		{
+			for(unsigned int i = 0; i < max_dimension_count; ++i)
+				if ((strides[i] != 1) || (left_zero_padding[i] >= window_sizes[i]) || (right_zero_padding[i] >= window_sizes[i]))
+					return false;
+			return true;
+		}
+
+		convolution_geometry_plain convolution_geometry_plain::get_backward_data_geometry() const
+		{
+			convolution_geometry_plain res = *this;
+
+			res.input_dimension_sizes = output_dimension_sizes;
+			res.output_dimension_sizes = input_dimension_sizes;
+			res.input_feature_map_count = output_feature_map_count;
+			res.output_feature_map_count = input_feature_map_count;
+			res.input_neuron_count_per_feature_map = output_neuron_count_per_feature_map;
+			res.output_neuron_count_per_feature_map = input_neuron_count_per_feature_map;
+			for(unsigned int i = 0; i < dimension_count; ++i)
+			{
+				res.left_zero_padding[i] = window_sizes[i] - 1 - left_zero_padding[i];
+				res.right_zero_padding[i] = window_sizes[i] - 1 - right_zero_padding[i];
+			}
+			res.bias = false;
+
+			return res;
+		}
+	}
+}
@@ -0,0 +1,67 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../layer.h"
+#include "../layer_configuration_specific.h"
+#include "../nn_types.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Shapes of the convolution, extended to max_dimension_count dimensions
+		class convolution_geometry_plain
+		{
+		public:
+			convolution_geometry_plain(
+				layer::const_ptr layer_schema,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific);
+
+			// True when each output element depends on the input elements at the same position only
+			bool is_pointwise() const;
+
+			// True when the window covers the whole unpadded input, each output feature map has a single element then
+			bool is_fully_connected() const;
+
+			// True when get_backward_data_geometry can be used: all strides are 1 and paddings are smaller than windows
+			bool has_backward_data_geometry() const;
+
+			// Geometry of the convolution computing input errors from output errors with flipped and transposed weights
+			convolution_geometry_plain get_backward_data_geometry() const;
+
+		public:
+			static const unsigned int max_dimension_count = 4;
+
+			unsigned int dimension_count;
+			nnforge_array<unsigned int, max_dimension_count> window_sizes;
+			nnforge_array<unsigned int, max_dimension_count> strides;
+			nnforge_array<unsigned int, max_dimension_count> left_zero_padding;
+			nnforge_array<unsigned int, max_dimension_count> right_zero_padding;
+			nnforge_array<unsigned int, max_dimension_count> input_dimension_sizes;
+			nnforge_array<unsigned int, max_dimension_count> output_dimension_sizes;
+
+			unsigned int input_feature_map_count;
+			unsigned int output_feature_map_count;
+			unsigned int input_neuron_count_per_feature_map;
+			unsigned int output_neuron_count_per_feature_map;
+			unsigned int window_elem_count;
+			bool bias;
+		};
+	}
+}
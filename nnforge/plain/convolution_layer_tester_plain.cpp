@@ -16,6 +16,13 @@
 
 #include "convolution_layer_tester_plain.h"
 
+#include "convolution_algorithm_plain.h"
+#include "convolution_blocked_plain.h"
+#include "convolution_direct_plain.h"
+#include "convolution_fft_plain.h"
+#include "convolution_gemm_plain.h"
+#include "convolution_winograd_plain.h"
+#include "spatial_split_plain.h"
 #include "../convolution_layer.h"
 #include "../nn_types.h"
 
@@ -53,6 +60,129 @@ namespace nnforge
 			const layer_configuration_specific& output_configuration_specific,
 			unsigned int entry_count) const
 		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			convolution_algorithm_plain::algorithm first = convolution_algorithm_plain::parse_name(get_algorithm(plain_config), geometry);
+			unsigned int winograd_tile_size = convolution_algorithm_plain::get_winograd_tile_size(geometry, first);
+			if (winograd_tile_size > 0)
+			{
+				// Transformed weights are cached in data by get_data, transform them here if the caller bypassed it
+				std::vector<float> transformed_weights_local;
+				const float * transformed_weights;
+				if (data->size() > (geometry.bias ? 2U : 1U))
+					transformed_weights = &data->back()[0];
+				else
+				{
+					transformed_weights_local.resize(convolution_winograd_plain::get_transformed_weights_elem_count(geometry, winograd_tile_size));
+					convolution_winograd_plain::transform_weights(geometry, winograd_tile_size, &(*data)[0][0], &transformed_weights_local[0], false, plain_config->openmp_thread_count);
+					transformed_weights = &transformed_weights_local[0];
+				}
+
+				convolution_winograd_plain::run_forward(
+					plain_config->cpu_isa,
+					geometry,
+					winograd_tile_size,
+					*input_buffers[0],
+					*output_buffer,
+					transformed_weights,
+					geometry.bias ? &(*data)[1][0] : 0,
+					false,
+					*temporary_working_per_entry_buffer,
+					entry_count,
+					plain_config->openmp_thread_count);
+				return;
+			}
+
+			convolution_fft_plain::tiling fft_tiling;
+			if (convolution_algorithm_plain::get_fft_tiling(geometry, first, fft_tiling))
+			{
+				// Weight spectra are cached in data by get_data, transform them here if the caller bypassed it
+				std::vector<float> weights_spectrum_local;
+				const float * weights_spectrum;
+				if (data->size() > (geometry.bias ? 2U : 1U))
+					weights_spectrum = &data->back()[0];
+				else
+				{
+					weights_spectrum_local.resize(convolution_fft_plain::get_weights_spectrum_elem_count(geometry, fft_tiling));
+					convolution_fft_plain::transform_weights(plain_config->cpu_isa, geometry, fft_tiling, &(*data)[0][0], &weights_spectrum_local[0], false, plain_config->openmp_thread_count);
+					weights_spectrum = &weights_spectrum_local[0];
+				}
+
+				convolution_fft_plain::run_forward(
+					plain_config->cpu_isa,
+					geometry,
+					fft_tiling,
+					*input_buffers[0],
+					*output_buffer,
+					weights_spectrum,
+					geometry.bias ? &(*data)[1][0] : 0,
+					false,
+					*temporary_working_per_entry_buffer,
+					entry_count,
+					plain_config->openmp_thread_count);
+				return;
+			}
+
+			if (convolution_algorithm_plain::is_gemm_used(geometry, first))
+			{
+				convolution_gemm_plain::run_forward(
+					plain_config->cpu_isa,
+					geometry,
+					*input_buffers[0],
+					*output_buffer,
+					&(*data)[0][0],
+					geometry.bias ? &(*data)[1][0] : 0,
+					temporary_working_per_entry_buffer ? static_cast<float *>(*temporary_working_per_entry_buffer) : 0,
+					entry_count,
+					plain_config->openmp_thread_count);
+				return;
+			}
+
+			const convolution_direct_plain::kernels * direct_kernels = convolution_algorithm_plain::get_direct_kernels(plain_config->cpu_isa, geometry, first);
+			if (direct_kernels)
+			{
+				const float * const input = *input_buffers[0];
+				float * const output = *output_buffer;
+				const float * const weights = &(*data)[0][0];
+				const float * const biases = geometry.bias ? &(*data)[1][0] : 0;
+				const unsigned int input_neuron_count = geometry.input_neuron_count_per_feature_map * geometry.input_feature_map_count;
+				const unsigned int output_elem_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+				const unsigned int weight_count_per_output_feature_map = geometry.window_elem_count * geometry.input_feature_map_count;
+				const unsigned int output_row_count = geometry.output_dimension_sizes[1];
+				const unsigned int row_split_count = spatial_split_plain::get_split_count(
+					*plain_config,
+					entry_count * geometry.output_feature_map_count,
+					output_row_count,
+					geometry.output_dimension_sizes[0] * weight_count_per_output_feature_map * 2);
+				const int total_workload = entry_count * geometry.output_feature_map_count * row_split_count;
+				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
+				{
+					std::vector<float> scratch(convolution_direct_plain::get_scratch_elem_count(geometry));
+
+					#pragma omp for schedule(guided)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						const unsigned int feature_map_workload_id = workload_id / row_split_count;
+						const unsigned int row_split_id = workload_id - feature_map_workload_id * row_split_count;
+						const unsigned int entry_id = feature_map_workload_id / geometry.output_feature_map_count;
+						const unsigned int output_feature_map_id = feature_map_workload_id - entry_id * geometry.output_feature_map_count;
+						unsigned int output_row_start;
+						unsigned int output_row_end;
+						spatial_split_plain::get_range(output_row_count, row_split_count, row_split_id, output_row_start, output_row_end);
+						direct_kernels->forward(
+							geometry,
+							input + static_cast<size_t>(entry_id) * input_neuron_count,
+							weights + static_cast<size_t>(output_feature_map_id) * weight_count_per_output_feature_map,
+							biases ? biases[output_feature_map_id] : 0.0F,
+							output + static_cast<size_t>(feature_map_workload_id) * output_elem_count_per_feature_map,
+							output_row_start,
+							output_row_end,
+							&scratch[0]);
+					}
+				}
+				return;
+			}
+
+			// Direct convolution for the shapes im2col cannot handle
 			const float * const in_it_global = *input_buffers[0];
 			float * const out_it_global = *output_buffer;
 			const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
@@ -190,5 +320,170 @@ namespace nnforge
 				}
 			}
 		}
+
+		bool convolution_layer_tester_plain::is_channel_blocked(
+			plain_running_configuration::const_ptr plain_config,
+			const convolution_geometry_plain& geometry,
+			convolution_algorithm_plain::algorithm first)
+		{
+			const unsigned int block_size = plain_config->channel_block_size;
+			if (!convolution_blocked_plain::is_supported_block_size(block_size))
+				return false;
+			if ((geometry.input_feature_map_count % block_size != 0) || (geometry.output_feature_map_count % block_size != 0))
+				return false;
+
+			if (convolution_algorithm_plain::get_winograd_tile_size(geometry, first) > 0)
+				return false;
+
+			convolution_fft_plain::tiling fft_tiling;
+			if (convolution_algorithm_plain::get_fft_tiling(geometry, first, fft_tiling))
+				return false;
+
+			return true;
+		}
+
+		bool convolution_layer_tester_plain::is_channel_blocked_layout_supported(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			convolution_algorithm_plain::algorithm first = convolution_algorithm_plain::parse_name(get_algorithm(plain_config), geometry);
+			return is_channel_blocked(plain_config, geometry, first);
+		}
+
+		std::vector<std::string> convolution_layer_tester_plain::get_algorithm_candidates(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			std::vector<convolution_algorithm_plain::algorithm> algorithms = convolution_algorithm_plain::get_candidates(geometry);
+			std::vector<std::string> res;
+			for(std::vector<convolution_algorithm_plain::algorithm>::const_iterator it = algorithms.begin(); it != algorithms.end(); ++it)
+			{
+				// The channel blocked kernel replaces GEMM and direct kernels
+				if (is_channel_blocked(plain_config, geometry, *it))
+				{
+					res.push_back("blocked");
+					break;
+				}
+				res.push_back(convolution_algorithm_plain::get_name(*it));
+			}
+
+			return res;
+		}
+
+		bool convolution_layer_tester_plain::is_channel_blocked_layout_preferred() const
+		{
+			return true;
+		}
+
+		void convolution_layer_tester_plain::run_forward_propagation_channel_blocked(
+			plain_buffer::ptr output_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+
+			// Blocked weights are cached in data by get_data, transform them here if the caller bypassed it
+			std::vector<float> blocked_weights_local;
+			const float * blocked_weights;
+			if (data->size() > (geometry.bias ? 2U : 1U))
+				blocked_weights = &data->back()[0];
+			else
+			{
+				blocked_weights_local.resize(convolution_blocked_plain::get_blocked_weights_elem_count(geometry));
+				convolution_blocked_plain::transform_weights(geometry, plain_config->channel_block_size, &(*data)[0][0], &blocked_weights_local[0], plain_config->openmp_thread_count);
+				blocked_weights = &blocked_weights_local[0];
+			}
+
+			convolution_blocked_plain::run_forward(
+				plain_config->cpu_isa,
+				geometry,
+				plain_config->channel_block_size,
+				*input_buffers[0],
+				*output_buffer,
+				blocked_weights,
+				geometry.bias ? &(*data)[1][0] : 0,
+				entry_count,
+				plain_config->openmp_thread_count);
+		}
+
+		size_t convolution_layer_tester_plain::get_temporary_working_per_entry_buffer_size(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			convolution_algorithm_plain::algorithm first = convolution_algorithm_plain::parse_name(get_algorithm(plain_config), geometry);
+			if (is_channel_blocked(plain_config, geometry, first))
+				return 0;
+
+			unsigned int winograd_tile_size = convolution_algorithm_plain::get_winograd_tile_size(geometry, first);
+			if (winograd_tile_size > 0)
+				return convolution_winograd_plain::get_working_buffer_size_per_entry(geometry, winograd_tile_size);
+
+			convolution_fft_plain::tiling fft_tiling;
+			if (convolution_algorithm_plain::get_fft_tiling(geometry, first, fft_tiling))
+				return convolution_fft_plain::get_working_buffer_size_per_entry(geometry, fft_tiling);
+
+			if (!convolution_algorithm_plain::is_gemm_used(geometry, first))
+				return 0;
+
+			return convolution_gemm_plain::get_column_buffer_size_per_entry(geometry);
+		}
+
+		layer_data::const_ptr convolution_layer_tester_plain::get_data(
+			layer_data::const_ptr host_data,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			convolution_algorithm_plain::algorithm first = convolution_algorithm_plain::parse_name(get_algorithm(plain_config), geometry);
+			if (!host_data)
+				return host_data;
+
+			if (is_channel_blocked(plain_config, geometry, first))
+			{
+				layer_data::ptr res(new layer_data(*host_data));
+				res->push_back(std::vector<float>(convolution_blocked_plain::get_blocked_weights_elem_count(geometry)));
+				convolution_blocked_plain::transform_weights(geometry, plain_config->channel_block_size, &(*host_data)[0][0], &res->back()[0], plain_config->openmp_thread_count);
+				return res;
+			}
+
+			unsigned int winograd_tile_size = convolution_algorithm_plain::get_winograd_tile_size(geometry, first);
+			if (winograd_tile_size > 0)
+			{
+				layer_data::ptr res(new layer_data(*host_data));
+				res->push_back(std::vector<float>(convolution_winograd_plain::get_transformed_weights_elem_count(geometry, winograd_tile_size)));
+				convolution_winograd_plain::transform_weights(geometry, winograd_tile_size, &(*host_data)[0][0], &res->back()[0], false, plain_config->openmp_thread_count);
+				return res;
+			}
+
+			convolution_fft_plain::tiling fft_tiling;
+			if (convolution_algorithm_plain::get_fft_tiling(geometry, first, fft_tiling))
+			{
+				layer_data::ptr res(new layer_data(*host_data));
+				res->push_back(std::vector<float>(convolution_fft_plain::get_weights_spectrum_elem_count(geometry, fft_tiling)));
+				convolution_fft_plain::transform_weights(plain_config->cpu_isa, geometry, fft_tiling, &(*host_data)[0][0], &res->back()[0], false, plain_config->openmp_thread_count);
+				return res;
+			}
+
+			return host_data;
+		}
 	}
 }
@@ -17,6 +17,8 @@
 #pragma once
 
 #include "layer_tester_plain.h"
+#include "convolution_algorithm_plain.h"
+#include "convolution_geometry_plain.h"
 
 namespace nnforge
 {
@@ -44,6 +46,54 @@ namespace nnforge
 				const layer_configuration_specific& output_configuration_specific,
 				unsigned int entry_count) const;
 
+			virtual bool is_channel_blocked_layout_supported(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			virtual bool is_channel_blocked_layout_preferred() const;
+
+			virtual void run_forward_propagation_channel_blocked(
+				plain_buffer::ptr output_buffer,
+				const std::vector<plain_buffer::const_ptr>& input_buffers,
+				plain_buffer::ptr temporary_working_fixed_buffer,
+				plain_buffer::ptr temporary_working_per_entry_buffer,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				layer_data::const_ptr data,
+				layer_data_custom::const_ptr data_custom,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count) const;
+
+			virtual size_t get_temporary_working_per_entry_buffer_size(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Appends Winograd transformed weights, FFT weight spectra or channel blocked weights when the layer qualifies
+			virtual layer_data::const_ptr get_data(
+				layer_data::const_ptr host_data,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			virtual std::vector<std::string> get_algorithm_candidates(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+		private:
+			// Winograd and FFT convolutions do fewer multiplications than the blocked direct one, such layers keep plain layout
+			static bool is_channel_blocked(
+				plain_running_configuration::const_ptr plain_config,
+				const convolution_geometry_plain& geometry,
+				convolution_algorithm_plain::algorithm first);
+
 		private:
 			static const int max_dimension_count;
 		};
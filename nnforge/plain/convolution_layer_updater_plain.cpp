@@ -16,6 +16,14 @@
 
 #include "convolution_layer_updater_plain.h"
 
+#include "convolution_algorithm_plain.h"
+#include "convolution_geometry_plain.h"
+#include "convolution_direct_plain.h"
+#include "convolution_fft_plain.h"
+#include "convolution_gemm_plain.h"
+#include "convolution_winograd_plain.h"
+#include "gradient_reduction_plain.h"
+#include "spatial_split_plain.h"
 #include "../convolution_layer.h"
 
 #include <array>
@@ -54,6 +62,112 @@ namespace nnforge
 			const std::set<layer_action>& actions,
 			unsigned int entry_count) const
 		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			convolution_algorithm_plain::algorithm first = convolution_algorithm_plain::parse_name(get_algorithm(plain_config), geometry);
+			unsigned int winograd_tile_size = convolution_algorithm_plain::get_winograd_tile_size(geometry, first);
+			if (winograd_tile_size > 0)
+			{
+				// Weights are updated between batches, so they are transformed on each run
+				std::vector<float> transformed_weights(convolution_winograd_plain::get_transformed_weights_elem_count(geometry, winograd_tile_size));
+				convolution_winograd_plain::transform_weights(geometry, winograd_tile_size, &(*data)[0][0], &transformed_weights[0], false, plain_config->openmp_thread_count);
+
+				convolution_winograd_plain::run_forward(
+					plain_config->cpu_isa,
+					geometry,
+					winograd_tile_size,
+					*input_buffers[0],
+					*output_buffer,
+					&transformed_weights[0],
+					geometry.bias ? &(*data)[1][0] : 0,
+					false,
+					*temporary_working_per_entry_buffer,
+					entry_count,
+					plain_config->openmp_thread_count);
+				return;
+			}
+
+			convolution_fft_plain::tiling fft_tiling;
+			if (convolution_algorithm_plain::get_fft_tiling(geometry, first, fft_tiling))
+			{
+				std::vector<float> weights_spectrum(convolution_fft_plain::get_weights_spectrum_elem_count(geometry, fft_tiling));
+				convolution_fft_plain::transform_weights(plain_config->cpu_isa, geometry, fft_tiling, &(*data)[0][0], &weights_spectrum[0], false, plain_config->openmp_thread_count);
+
+				convolution_fft_plain::run_forward(
+					plain_config->cpu_isa,
+					geometry,
+					fft_tiling,
+					*input_buffers[0],
+					*output_buffer,
+					&weights_spectrum[0],
+					geometry.bias ? &(*data)[1][0] : 0,
+					false,
+					*temporary_working_per_entry_buffer,
+					entry_count,
+					plain_config->openmp_thread_count);
+				return;
+			}
+
+			if (convolution_algorithm_plain::is_gemm_used(geometry, first))
+			{
+				convolution_gemm_plain::run_forward(
+					plain_config->cpu_isa,
+					geometry,
+					*input_buffers[0],
+					*output_buffer,
+					&(*data)[0][0],
+					geometry.bias ? &(*data)[1][0] : 0,
+					temporary_working_per_entry_buffer ? static_cast<float *>(*temporary_working_per_entry_buffer) : 0,
+					entry_count,
+					plain_config->openmp_thread_count);
+				return;
+			}
+
+			const convolution_direct_plain::kernels * direct_kernels = convolution_algorithm_plain::get_direct_kernels(plain_config->cpu_isa, geometry, first);
+			if (direct_kernels)
+			{
+				const float * const input = *input_buffers[0];
+				float * const output = *output_buffer;
+				const float * const weights = &(*data)[0][0];
+				const float * const biases = geometry.bias ? &(*data)[1][0] : 0;
+				const unsigned int input_neuron_count = geometry.input_neuron_count_per_feature_map * geometry.input_feature_map_count;
+				const unsigned int output_elem_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+				const unsigned int weight_count_per_output_feature_map = geometry.window_elem_count * geometry.input_feature_map_count;
+				const unsigned int output_row_count = geometry.output_dimension_sizes[1];
+				const unsigned int row_split_count = spatial_split_plain::get_split_count(
+					*plain_config,
+					entry_count * geometry.output_feature_map_count,
+					output_row_count,
+					geometry.output_dimension_sizes[0] * weight_count_per_output_feature_map * 2);
+				const int total_workload = entry_count * geometry.output_feature_map_count * row_split_count;
+				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
+				{
+					std::vector<float> scratch(convolution_direct_plain::get_scratch_elem_count(geometry));
+
+					#pragma omp for schedule(guided)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						const unsigned int feature_map_workload_id = workload_id / row_split_count;
+						const unsigned int row_split_id = workload_id - feature_map_workload_id * row_split_count;
+						const unsigned int entry_id = feature_map_workload_id / geometry.output_feature_map_count;
+						const unsigned int output_feature_map_id = feature_map_workload_id - entry_id * geometry.output_feature_map_count;
+						unsigned int output_row_start;
+						unsigned int output_row_end;
+						spatial_split_plain::get_range(output_row_count, row_split_count, row_split_id, output_row_start, output_row_end);
+						direct_kernels->forward(
+							geometry,
+							input + static_cast<size_t>(entry_id) * input_neuron_count,
+							weights + static_cast<size_t>(output_feature_map_id) * weight_count_per_output_feature_map,
+							biases ? biases[output_feature_map_id] : 0.0F,
+							output + static_cast<size_t>(feature_map_workload_id) * output_elem_count_per_feature_map,
+							output_row_start,
+							output_row_end,
+							&scratch[0]);
+					}
+				}
+				return;
+			}
+
+			// Direct convolution for the shapes im2col cannot handle
 			const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
 			const unsigned int input_neuron_count_per_feature_map = input_configuration_specific_list[0].get_neuron_count_per_feature_map();
 			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
@@ -211,6 +325,116 @@ namespace nnforge
 			const std::set<layer_action>& actions,
 			unsigned int entry_count) const
 		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			convolution_algorithm_plain::algorithm first = convolution_algorithm_plain::parse_name(get_algorithm(plain_config), geometry);
+			if (geometry.has_backward_data_geometry())
+			{
+				// Input errors are the convolution of output errors with flipped and transposed weights
+				convolution_geometry_plain backward_geometry = geometry.get_backward_data_geometry();
+				unsigned int winograd_tile_size = (convolution_algorithm_plain::get_winograd_tile_size(geometry, first) > 0) ? convolution_winograd_plain::get_tile_size(backward_geometry) : 0;
+				if (winograd_tile_size > 0)
+				{
+					std::vector<float> transformed_weights(convolution_winograd_plain::get_transformed_weights_elem_count(backward_geometry, winograd_tile_size));
+					convolution_winograd_plain::transform_weights(backward_geometry, winograd_tile_size, &(*data)[0][0], &transformed_weights[0], true, plain_config->openmp_thread_count);
+
+					convolution_winograd_plain::run_forward(
+						plain_config->cpu_isa,
+						backward_geometry,
+						winograd_tile_size,
+						*output_errors_buffer,
+						*input_errors_buffer,
+						&transformed_weights[0],
+						0,
+						add_update_to_destination,
+						*temporary_working_per_entry_buffer,
+						entry_count,
+						plain_config->openmp_thread_count);
+					return;
+				}
+
+				convolution_fft_plain::tiling fft_tiling;
+				if (convolution_algorithm_plain::get_fft_tiling(backward_geometry, first, fft_tiling))
+				{
+					std::vector<float> weights_spectrum(convolution_fft_plain::get_weights_spectrum_elem_count(backward_geometry, fft_tiling));
+					convolution_fft_plain::transform_weights(plain_config->cpu_isa, backward_geometry, fft_tiling, &(*data)[0][0], &weights_spectrum[0], true, plain_config->openmp_thread_count);
+
+					convolution_fft_plain::run_forward(
+						plain_config->cpu_isa,
+						backward_geometry,
+						fft_tiling,
+						*output_errors_buffer,
+						*input_errors_buffer,
+						&weights_spectrum[0],
+						0,
+						add_update_to_destination,
+						*temporary_working_per_entry_buffer,
+						entry_count,
+						plain_config->openmp_thread_count);
+					return;
+				}
+			}
+
+			if (convolution_algorithm_plain::is_gemm_used(geometry, first))
+			{
+				// Each input error is summed from the column matrix by the single thread owning its feature map
+				convolution_gemm_plain::run_backward_data(
+					plain_config->cpu_isa,
+					geometry,
+					*output_errors_buffer,
+					*input_errors_buffer,
+					&(*data)[0][0],
+					add_update_to_destination,
+					temporary_working_per_entry_buffer ? static_cast<float *>(*temporary_working_per_entry_buffer) : 0,
+					entry_count,
+					plain_config->openmp_thread_count);
+				return;
+			}
+
+			const convolution_direct_plain::kernels * direct_kernels = convolution_algorithm_plain::get_direct_kernels(plain_config->cpu_isa, geometry, first);
+			if (direct_kernels)
+			{
+				// Each input error is gathered from all the output feature maps by the single thread owning its rows
+				const float * const output_errors = *output_errors_buffer;
+				float * const input_errors = *input_errors_buffer;
+				const float * const weights = &(*data)[0][0];
+				const unsigned int output_neuron_count = geometry.output_neuron_count_per_feature_map * geometry.output_feature_map_count;
+				const unsigned int input_elem_count_per_feature_map = geometry.input_neuron_count_per_feature_map;
+				const unsigned int input_row_count = geometry.input_dimension_sizes[1];
+				const unsigned int row_split_count = spatial_split_plain::get_split_count(
+					*plain_config,
+					entry_count * geometry.input_feature_map_count,
+					input_row_count,
+					geometry.input_dimension_sizes[0] * geometry.window_elem_count * geometry.output_feature_map_count * 2);
+				const int total_workload = entry_count * geometry.input_feature_map_count * row_split_count;
+				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
+				{
+					std::vector<float> scratch(convolution_direct_plain::get_scratch_elem_count(geometry));
+
+					#pragma omp for schedule(guided)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						const unsigned int feature_map_workload_id = workload_id / row_split_count;
+						const unsigned int row_split_id = workload_id - feature_map_workload_id * row_split_count;
+						const unsigned int entry_id = feature_map_workload_id / geometry.input_feature_map_count;
+						const unsigned int input_feature_map_id = feature_map_workload_id - entry_id * geometry.input_feature_map_count;
+						unsigned int input_row_start;
+						unsigned int input_row_end;
+						spatial_split_plain::get_range(input_row_count, row_split_count, row_split_id, input_row_start, input_row_end);
+						direct_kernels->backward_data(
+							geometry,
+							output_errors + static_cast<size_t>(entry_id) * output_neuron_count,
+							weights + static_cast<size_t>(input_feature_map_id) * geometry.window_elem_count,
+							input_errors + static_cast<size_t>(feature_map_workload_id) * input_elem_count_per_feature_map,
+							input_row_start,
+							input_row_end,
+							add_update_to_destination,
+							&scratch[0]);
+					}
+				}
+				return;
+			}
+
+			// Direct scatter for the shapes im2col cannot handle
 			float * const in_err_it_global = *input_errors_buffer;
 			const float * const out_err_it_global = *output_errors_buffer;
 			const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
@@ -367,6 +591,81 @@ namespace nnforge
 			const std::set<layer_action>& actions,
 			unsigned int entry_count) const
 		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			convolution_algorithm_plain::algorithm first = convolution_algorithm_plain::parse_name(get_algorithm(plain_config), geometry);
+			if (convolution_algorithm_plain::get_winograd_tile_size(geometry, first) > 0)
+			{
+				convolution_winograd_plain::run_backward_weights(
+					plain_config->cpu_isa,
+					geometry,
+					*input_neurons_buffers[0],
+					*output_errors_buffer,
+					&(*gradient)[0][0],
+					*temporary_working_fixed_buffer,
+					entry_count,
+					plain_config->openmp_thread_count);
+
+				if (geometry.bias)
+					update_biases_gradient(
+						*output_errors_buffer,
+						&(*gradient)[1][0],
+						geometry.output_feature_map_count,
+						geometry.output_neuron_count_per_feature_map,
+						entry_count,
+						plain_config->openmp_thread_count);
+				return;
+			}
+
+			convolution_fft_plain::tiling fft_tiling;
+			if (convolution_algorithm_plain::get_fft_tiling(geometry, first, fft_tiling))
+			{
+				convolution_fft_plain::run_backward_weights(
+					plain_config->cpu_isa,
+					geometry,
+					fft_tiling,
+					*input_neurons_buffers[0],
+					*output_errors_buffer,
+					&(*gradient)[0][0],
+					*temporary_working_per_entry_buffer,
+					*temporary_working_fixed_buffer,
+					entry_count,
+					plain_config->openmp_thread_count);
+
+				if (geometry.bias)
+					update_biases_gradient(
+						*output_errors_buffer,
+						&(*gradient)[1][0],
+						geometry.output_feature_map_count,
+						geometry.output_neuron_count_per_feature_map,
+						entry_count,
+						plain_config->openmp_thread_count);
+				return;
+			}
+
+			if (convolution_algorithm_plain::is_gemm_used(geometry, first))
+			{
+				convolution_gemm_plain::run_backward_weights(
+					plain_config->cpu_isa,
+					geometry,
+					*input_neurons_buffers[0],
+					*output_errors_buffer,
+					&(*gradient)[0][0],
+					temporary_working_per_entry_buffer ? static_cast<float *>(*temporary_working_per_entry_buffer) : 0,
+					temporary_working_fixed_buffer ? static_cast<void *>(*temporary_working_fixed_buffer) : 0,
+					entry_count,
+					plain_config->openmp_thread_count);
+
+				if (geometry.bias)
+					update_biases_gradient(
+						*output_errors_buffer,
+						&(*gradient)[1][0],
+						geometry.output_feature_map_count,
+						geometry.output_neuron_count_per_feature_map,
+						entry_count,
+						plain_config->openmp_thread_count);
+				return;
+			}
+
 			const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
 			const unsigned int input_neuron_count_per_feature_map = input_configuration_specific_list[0].get_neuron_count_per_feature_map();
 			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
@@ -437,104 +736,237 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 			const int const_updater_count = entry_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
+			// With few feature map pairs entries are split into slices, each slice accumulating into its own slab
+			const size_t gradient_elem_count = (*gradient)[0].size();
+			const unsigned int slice_count = gradient_reduction_plain::get_slice_count(total_workload, gradient_elem_count, entry_count, plain_config->openmp_thread_count);
+			void * const slab_buffer = (slice_count > 1) ? static_cast<void *>(*temporary_working_fixed_buffer) : 0;
+			const int total_sliced_workload = total_workload * static_cast<int>(slice_count);
+
+			const convolution_direct_plain::kernels * const direct_kernels = convolution_algorithm_plain::get_direct_kernels(plain_config->cpu_isa, geometry, first);
+
+			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes,geometry)
 			{
 				nnforge_array<unsigned int, max_dimension_count> current_output_position;
 				nnforge_array<int, max_dimension_count> current_input_position;
 				std::vector<float> weights_local(const_window_elem_count, 0.0F);
+				std::vector<float> direct_scratch(direct_kernels ? convolution_direct_plain::get_scratch_elem_count(geometry) : 0);
 
 				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = 0; workload_id < total_sliced_workload; ++workload_id)
 				{
-					int feature_map_pair_id = workload_id;
+					int slice_id = workload_id / total_workload;
+					int feature_map_pair_id = workload_id - (slice_id * total_workload);
 					int output_feature_map_id = feature_map_pair_id / input_feature_map_count;
 					int input_feature_map_id = feature_map_pair_id - (output_feature_map_id * input_feature_map_count);
 
 					std::vector<float>::iterator gradient_weights_it_base = gradient_weights + (output_feature_map_id * (const_window_elem_count * input_feature_map_count)) + (const_window_elem_count * input_feature_map_id);
 					std::fill_n(weights_local.begin(), const_window_elem_count, 0.0F);
 
-					for(int entry_id = 0; entry_id < const_updater_count; ++entry_id)
+					unsigned int entry_start = 0;
+					unsigned int entry_end = const_updater_count;
+					if (slice_count > 1)
+						gradient_reduction_plain::get_entry_range(const_updater_count, slice_count, slice_id, entry_start, entry_end);
+					if (direct_kernels)
 					{
-						const float * in_it_base = in_it_global + (entry_id * input_neuron_count) + (input_feature_map_id * input_neuron_count_per_feature_map);
-						const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
-
-						std::fill_n(current_input_position.begin(), max_dimension_count, 0);
-						std::fill_n(current_output_position.begin(), max_dimension_count, 0);
-						for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it)
+						// Specialized kernel for common windows and strides
+						for(int entry_id = static_cast<int>(entry_start); entry_id < static_cast<int>(entry_end); ++entry_id)
+							direct_kernels->backward_weights(
+								geometry,
+								in_it_global + (entry_id * input_neuron_count) + (input_feature_map_id * input_neuron_count_per_feature_map),
+								out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map),
+								&weights_local[0],
+								&direct_scratch[0]);
+					}
+					else
+					{
+						for(int entry_id = static_cast<int>(entry_start); entry_id < static_cast<int>(entry_end); ++entry_id)
 						{
-							int in_it_offset = 0;
+							const float * in_it_base = in_it_global + (entry_id * input_neuron_count) + (input_feature_map_id * input_neuron_count_per_feature_map);
+							const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
 
-							for(unsigned int i = 0; i < dimension_count; ++i)
-								current_input_position[i] = static_cast<int>(current_output_position[i] * strides_it[i]) - static_cast<int>(left_zero_padding[i]);
+							std::fill_n(current_input_position.begin(), max_dimension_count, 0);
+							std::fill_n(current_output_position.begin(), max_dimension_count, 0);
+							for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it)
+							{
+								int in_it_offset = 0;
 
-							for(unsigned int i = 0; i < dimension_count; ++i)
-								in_it_offset += current_input_position[i] * (*(input_slices_it + i));
+								for(unsigned int i = 0; i < dimension_count; ++i)
+									current_input_position[i] = static_cast<int>(current_output_position[i] * strides_it[i]) - static_cast<int>(left_zero_padding[i]);
 
-							float current_err = *out_err_it;
+								for(unsigned int i = 0; i < dimension_count; ++i)
+									in_it_offset += current_input_position[i] * (*(input_slices_it + i));
 
-							int ind = 0;
-							for(int w = current_input_position[3]; w < current_input_position[3] + static_cast<int>(window_sizes[3]); ++w)
-							{
-								bool fit3 = ((unsigned int)w < (unsigned int)input_dimension_sizes[3]);
-								for(int z = current_input_position[2]; z < current_input_position[2] + static_cast<int>(window_sizes[2]); ++z)
+								float current_err = *out_err_it;
+
+								int ind = 0;
+								for(int w = current_input_position[3]; w < current_input_position[3] + static_cast<int>(window_sizes[3]); ++w)
 								{
-									bool fit2 = fit3 && ((unsigned int)z < (unsigned int)input_dimension_sizes[2]);
-									for(int y = current_input_position[1]; y < current_input_position[1] + static_cast<int>(window_sizes[1]); ++y)
+									bool fit3 = ((unsigned int)w < (unsigned int)input_dimension_sizes[3]);
+									for(int z = current_input_position[2]; z < current_input_position[2] + static_cast<int>(window_sizes[2]); ++z)
 									{
-										bool fit1 = fit2 && ((unsigned int)y < (unsigned int)input_dimension_sizes[1]);
-										for(int x = current_input_position[0]; x < current_input_position[0] + static_cast<int>(window_sizes[0]); ++x)
+										bool fit2 = fit3 && ((unsigned int)z < (unsigned int)input_dimension_sizes[2]);
+										for(int y = current_input_position[1]; y < current_input_position[1] + static_cast<int>(window_sizes[1]); ++y)
 										{
-											bool fit0 = fit1 && ((unsigned int)x < (unsigned int)input_dimension_sizes[0]);
-											if (fit0)
+											bool fit1 = fit2 && ((unsigned int)y < (unsigned int)input_dimension_sizes[1]);
+											for(int x = current_input_position[0]; x < current_input_position[0] + static_cast<int>(window_sizes[0]); ++x)
 											{
-												float in_neuron = *(in_it_base + (in_it_offset + *(offset_list_it + ind)));
-												weights_local[ind] += (in_neuron * current_err);
+												bool fit0 = fit1 && ((unsigned int)x < (unsigned int)input_dimension_sizes[0]);
+												if (fit0)
+												{
+													float in_neuron = *(in_it_base + (in_it_offset + *(offset_list_it + ind)));
+													weights_local[ind] += (in_neuron * current_err);
+												}
+												++ind;
 											}
-											++ind;
 										}
 									}
 								}
-							}
 
-							// Go to the next output element
-							for(unsigned int i = 0; i < dimension_count; ++i)
-							{
-								if ((++current_output_position[i]) < *(output_dimension_sizes_it + i))
-									break;
-								current_output_position[i] = 0;
+								// Go to the next output element
+								for(unsigned int i = 0; i < dimension_count; ++i)
+								{
+									if ((++current_output_position[i]) < *(output_dimension_sizes_it + i))
+										break;
+									current_output_position[i] = 0;
+								}
 							}
 						}
 					}
 
-					std::vector<float>::iterator weights_local_it = weights_local.begin();
-					for(std::vector<float>::iterator it = gradient_weights_it_base; it != gradient_weights_it_base + const_window_elem_count; ++it, ++weights_local_it)
-						*it += *weights_local_it;
+					if (slice_count > 1)
+					{
+						// Each slab element is written by a single work item, so the slabs need no clearing
+						float * slab = gradient_reduction_plain::get_slab(slab_buffer, gradient_elem_count, slice_id);
+						std::copy(weights_local.begin(), weights_local.end(), slab + (gradient_weights_it_base - gradient_weights));
+					}
+					else
+					{
+						std::vector<float>::iterator weights_local_it = weights_local.begin();
+						for(std::vector<float>::iterator it = gradient_weights_it_base; it != gradient_weights_it_base + const_window_elem_count; ++it, ++weights_local_it)
+							*it += *weights_local_it;
+					}
 				}
 			}
 
+			if (slice_count > 1)
+				gradient_reduction_plain::reduce(slab_buffer, gradient_elem_count, slice_count, &(*gradient)[0][0], plain_config->openmp_thread_count);
+
 			if (bias)
+				update_biases_gradient(
+					out_err_it_global,
+					&(*gradient)[1][0],
+					output_feature_map_count,
+					output_neuron_count_per_feature_map,
+					entry_count,
+					plain_config->openmp_thread_count);
+		}
+
+		void convolution_layer_updater_plain::update_biases_gradient(
+			const float * output_errors,
+			float * gradient_biases,
+			unsigned int output_feature_map_count,
+			unsigned int output_neuron_count_per_feature_map,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			const unsigned int output_neuron_count = output_feature_map_count * output_neuron_count_per_feature_map;
+			const int total_workload_bias = output_feature_map_count;
+			const int const_updater_count = entry_count;
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(thread_count)
+			for(int workload_id = 0; workload_id < total_workload_bias; ++workload_id)
 			{
-				const std::vector<float>::iterator gradient_biases = (*gradient)[1].begin();
-				const int total_workload_bias = output_feature_map_count;
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int workload_id = 0; workload_id < total_workload_bias; ++workload_id)
+				int output_feature_map_id = workload_id;
+
+				float sum = 0.0F;
+				for(int entry_id = 0; entry_id < const_updater_count; ++entry_id)
 				{
-					int output_feature_map_id = workload_id;
+					float local_sum = 0.0F;
+					const float * out_err_it_base = output_errors + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
+					for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it)
+						local_sum += *out_err_it;
 
-					float sum = 0.0F;
-					for(int entry_id = 0; entry_id < const_updater_count; ++entry_id)
-					{
-						float local_sum = 0.0F;
-						const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
-						for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it)
-							local_sum += *out_err_it;
+					sum += local_sum;
+				}
 
-						sum += local_sum;
-					}
+				*(gradient_biases + output_feature_map_id) += sum;
+			}
+		}
 
-					*(gradient_biases + output_feature_map_id) += sum;
+		size_t convolution_layer_updater_plain::get_temporary_working_per_entry_buffer_size(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			convolution_algorithm_plain::algorithm first = convolution_algorithm_plain::parse_name(get_algorithm(plain_config), geometry);
+			unsigned int winograd_tile_size = convolution_algorithm_plain::get_winograd_tile_size(geometry, first);
+			convolution_fft_plain::tiling fft_tiling;
+			if (action.get_action_type() == layer_action::forward)
+			{
+				if (winograd_tile_size > 0)
+					return convolution_winograd_plain::get_working_buffer_size_per_entry(geometry, winograd_tile_size);
+				if (convolution_algorithm_plain::get_fft_tiling(geometry, first, fft_tiling))
+					return convolution_fft_plain::get_working_buffer_size_per_entry(geometry, fft_tiling);
+				if (convolution_algorithm_plain::is_gemm_used(geometry, first))
+					return convolution_gemm_plain::get_column_buffer_size_per_entry(geometry);
+			}
+			else if (action.get_action_type() == layer_action::backward_data)
+			{
+				if (geometry.has_backward_data_geometry())
+				{
+					convolution_geometry_plain backward_geometry = geometry.get_backward_data_geometry();
+					unsigned int backward_winograd_tile_size = (winograd_tile_size > 0) ? convolution_winograd_plain::get_tile_size(backward_geometry) : 0;
+					if (backward_winograd_tile_size > 0)
+						return convolution_winograd_plain::get_working_buffer_size_per_entry(backward_geometry, backward_winograd_tile_size);
+					if (convolution_algorithm_plain::get_fft_tiling(backward_geometry, first, fft_tiling))
+						return convolution_fft_plain::get_working_buffer_size_per_entry(backward_geometry, fft_tiling);
 				}
+				if (convolution_algorithm_plain::is_gemm_used(geometry, first))
+					return convolution_gemm_plain::get_column_buffer_size_per_entry(geometry);
+			}
+			else if ((action.get_action_type() == layer_action::backward_weights) && (winograd_tile_size == 0))
+			{
+				if (convolution_algorithm_plain::get_fft_tiling(geometry, first, fft_tiling))
+					return convolution_fft_plain::get_working_buffer_size_per_entry(geometry, fft_tiling);
+				if (convolution_algorithm_plain::is_gemm_used(geometry, first))
+					return convolution_gemm_plain::get_column_buffer_size_per_entry(geometry);
 			}
+
+			return layer_updater_plain::get_temporary_working_per_entry_buffer_size(action, actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific);
+		}
+
+		size_t convolution_layer_updater_plain::get_temporary_working_fixed_buffer_size(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			if (action.get_action_type() == layer_action::backward_weights)
+			{
+				convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+				convolution_algorithm_plain::algorithm first = convolution_algorithm_plain::parse_name(get_algorithm(plain_config), geometry);
+				if (convolution_algorithm_plain::get_winograd_tile_size(geometry, first) > 0)
+					return convolution_winograd_plain::get_backward_weights_working_buffer_size(geometry);
+
+				convolution_fft_plain::tiling fft_tiling;
+				if (convolution_algorithm_plain::get_fft_tiling(geometry, first, fft_tiling))
+					return convolution_fft_plain::get_backward_weights_working_buffer_size(geometry, fft_tiling);
+
+				if (convolution_algorithm_plain::is_gemm_used(geometry, first))
+					return convolution_gemm_plain::get_backward_weights_slab_buffer_size(plain_config->cpu_isa, geometry, plain_config->openmp_thread_count);
+
+				return gradient_reduction_plain::get_slab_buffer_size(
+					geometry.output_feature_map_count * geometry.input_feature_map_count,
+					static_cast<size_t>(geometry.output_feature_map_count) * geometry.input_feature_map_count * geometry.window_elem_count,
+					plain_config->openmp_thread_count);
+			}
+
+			return layer_updater_plain::get_temporary_working_fixed_buffer_size(action, actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific);
 		}
 
 		bool convolution_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
@@ -570,5 +1002,21 @@ namespace nnforge
 		{
 			return true;
 		}
+
+		std::vector<std::string> convolution_layer_updater_plain::get_algorithm_candidates(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			std::vector<convolution_algorithm_plain::algorithm> algorithms = convolution_algorithm_plain::get_candidates(geometry);
+			std::vector<std::string> res;
+			for(std::vector<convolution_algorithm_plain::algorithm>::const_iterator it = algorithms.begin(); it != algorithms.end(); ++it)
+				res.push_back(convolution_algorithm_plain::get_name(*it));
+
+			return res;
+		}
 	}
 }
@@ -80,6 +80,22 @@ namespace nnforge
 				const std::set<layer_action>& actions,
 				unsigned int entry_count) const;
 
+			virtual size_t get_temporary_working_fixed_buffer_size(
+				const layer_action& action,
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			virtual size_t get_temporary_working_per_entry_buffer_size(
+				const layer_action& action,
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 			virtual bool is_backward_data_dependent_on_input_buffer(
 				unsigned int action_input_index,
 				unsigned int data_input_index,
@@ -105,6 +121,22 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+			virtual std::vector<std::string> get_algorithm_candidates(
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+		protected:
+			static void update_biases_gradient(
+				const float * output_errors,
+				float * gradient_biases,
+				unsigned int output_feature_map_count,
+				unsigned int output_neuron_count_per_feature_map,
+				unsigned int entry_count,
+				int thread_count);
+
 		private:
 			static const int max_dimension_count;
 		};
@@ -0,0 +1,673 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_winograd_plain.h"
+
+#include "gemm_plain.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			// Tile transforms are inlined into the variants compiled for each instruction set below,
+			// tile_size is a template parameter so that the loops over the tile are fully unrolled
+
+			template<unsigned int tile_size>
+			NNFORGE_PLAIN_FORCEINLINE void transform_input_body(
+				const convolution_geometry_plain& geometry,
+				const float * bt,
+				unsigned int tile_count,
+				const float * input,
+				float * transformed_input,
+				unsigned int feature_map_start,
+				unsigned int feature_map_count)
+			{
+				const unsigned int alpha = tile_size + 2;
+				const unsigned int tile_count_x = (geometry.output_dimension_sizes[0] + tile_size - 1) / tile_size;
+				const int input_width = static_cast<int>(geometry.input_dimension_sizes[0]);
+				const int input_height = static_cast<int>(geometry.input_dimension_sizes[1]);
+				const size_t point_stride = static_cast<size_t>(geometry.input_feature_map_count) * tile_count;
+
+				for(unsigned int feature_map_id = feature_map_start; feature_map_id < feature_map_start + feature_map_count; ++feature_map_id)
+				{
+					const float * in_feature_map = input + static_cast<size_t>(feature_map_id) * geometry.input_neuron_count_per_feature_map;
+					float * dst_base = transformed_input + static_cast<size_t>(feature_map_id) * tile_count;
+					for(unsigned int tile_id = 0; tile_id < tile_count; ++tile_id)
+					{
+						const unsigned int tile_y = tile_id / tile_count_x;
+						const unsigned int tile_x = tile_id - tile_y * tile_count_x;
+						const int y_start = static_cast<int>(tile_y * tile_size) - static_cast<int>(geometry.left_zero_padding[1]);
+						const int x_start = static_cast<int>(tile_x * tile_size) - static_cast<int>(geometry.left_zero_padding[0]);
+
+						float d[6][6];
+						for(unsigned int r = 0; r < alpha; ++r)
+						{
+							const int y = y_start + static_cast<int>(r);
+							const bool fit_y = (y >= 0) && (y < input_height);
+							for(unsigned int c = 0; c < alpha; ++c)
+							{
+								const int x = x_start + static_cast<int>(c);
+								d[r][c] = (fit_y && (x >= 0) && (x < input_width)) ? in_feature_map[y * input_width + x] : 0.0F;
+							}
+						}
+
+						float tmp[6][6];
+						for(unsigned int a = 0; a < alpha; ++a)
+							for(unsigned int c = 0; c < alpha; ++c)
+							{
+								float sum = 0.0F;
+								for(unsigned int r = 0; r < alpha; ++r)
+									sum += bt[a * alpha + r] * d[r][c];
+								tmp[a][c] = sum;
+							}
+
+						float * dst = dst_base + tile_id;
+						for(unsigned int a = 0; a < alpha; ++a)
+							for(unsigned int b = 0; b < alpha; ++b)
+							{
+								float sum = 0.0F;
+								for(unsigned int c = 0; c < alpha; ++c)
+									sum += tmp[a][c] * bt[b * alpha + c];
+								dst[(a * alpha + b) * point_stride] = sum;
+							}
+					}
+				}
+			}
+
+			template<unsigned int tile_size>
+			NNFORGE_PLAIN_FORCEINLINE void transform_output_body(
+				const convolution_geometry_plain& geometry,
+				const float * at,
+				unsigned int tile_count,
+				const float * transformed_output,
+				float * output,
+				const float * biases,
+				bool add_to_output,
+				unsigned int feature_map_start,
+				unsigned int feature_map_count)
+			{
+				const unsigned int alpha = tile_size + 2;
+				const unsigned int tile_count_x = (geometry.output_dimension_sizes[0] + tile_size - 1) / tile_size;
+				const unsigned int output_width = geometry.output_dimension_sizes[0];
+				const unsigned int output_height = geometry.output_dimension_sizes[1];
+				const size_t point_stride = static_cast<size_t>(geometry.output_feature_map_count) * tile_count;
+
+				for(unsigned int feature_map_id = feature_map_start; feature_map_id < feature_map_start + feature_map_count; ++feature_map_id)
+				{
+					const float bias = biases ? biases[feature_map_id] : 0.0F;
+					const float * src_base = transformed_output + static_cast<size_t>(feature_map_id) * tile_count;
+					float * out_feature_map = output + static_cast<size_t>(feature_map_id) * geometry.output_neuron_count_per_feature_map;
+					for(unsigned int tile_id = 0; tile_id < tile_count; ++tile_id)
+					{
+						const unsigned int tile_y = tile_id / tile_count_x;
+						const unsigned int tile_x = tile_id - tile_y * tile_count_x;
+
+						float m[6][6];
+						const float * src = src_base + tile_id;
+						for(unsigned int a = 0; a < alpha; ++a)
+							for(unsigned int b = 0; b < alpha; ++b)
+								m[a][b] = src[(a * alpha + b) * point_stride];
+
+						float tmp[4][6];
+						for(unsigned int i = 0; i < tile_size; ++i)
+							for(unsigned int b = 0; b < alpha; ++b)
+							{
+								float sum = 0.0F;
+								for(unsigned int a = 0; a < alpha; ++a)
+									sum += at[i * alpha + a] * m[a][b];
+								tmp[i][b] = sum;
+							}
+
+						const unsigned int row_count = std::min(tile_size, output_height - tile_y * tile_size);
+						const unsigned int col_count = std::min(tile_size, output_width - tile_x * tile_size);
+						for(unsigned int i = 0; i < row_count; ++i)
+						{
+							float * dst = out_feature_map + (tile_y * tile_size + i) * output_width + tile_x * tile_size;
+							for(unsigned int j = 0; j < col_count; ++j)
+							{
+								float sum = bias;
+								for(unsigned int b = 0; b < alpha; ++b)
+									sum += tmp[i][b] * at[j * alpha + b];
+								if (add_to_output)
+									dst[j] += sum;
+								else
+									dst[j] = sum;
+							}
+						}
+					}
+				}
+			}
+
+			template<unsigned int tile_size>
+			NNFORGE_PLAIN_FORCEINLINE void transform_output_errors_body(
+				const convolution_geometry_plain& geometry,
+				const float * at,
+				unsigned int tile_count,
+				const float * output_errors,
+				float * transformed_output_errors,
+				unsigned int feature_map_start,
+				unsigned int feature_map_count)
+			{
+				const unsigned int alpha = tile_size + 2;
+				const unsigned int tile_count_x = (geometry.output_dimension_sizes[0] + tile_size - 1) / tile_size;
+				const unsigned int output_width = geometry.output_dimension_sizes[0];
+				const unsigned int output_height = geometry.output_dimension_sizes[1];
+				const size_t point_stride = static_cast<size_t>(geometry.output_feature_map_count) * tile_count;
+
+				for(unsigned int feature_map_id = feature_map_start; feature_map_id < feature_map_start + feature_map_count; ++feature_map_id)
+				{
+					const float * out_err_feature_map = output_errors + static_cast<size_t>(feature_map_id) * geometry.output_neuron_count_per_feature_map;
+					float * dst_base = transformed_output_errors + static_cast<size_t>(feature_map_id) * tile_count;
+					for(unsigned int tile_id = 0; tile_id < tile_count; ++tile_id)
+					{
+						const unsigned int tile_y = tile_id / tile_count_x;
+						const unsigned int tile_x = tile_id - tile_y * tile_count_x;
+						const unsigned int row_count = std::min(tile_size, output_height - tile_y * tile_size);
+						const unsigned int col_count = std::min(tile_size, output_width - tile_x * tile_size);
+
+						float e[4][4];
+						for(unsigned int i = 0; i < tile_size; ++i)
+							for(unsigned int j = 0; j < tile_size; ++j)
+								e[i][j] = ((i < row_count) && (j < col_count)) ? out_err_feature_map[(tile_y * tile_size + i) * output_width + tile_x * tile_size + j] : 0.0F;
+
+						// Transposition principle: the error tile is transformed with A, so that weight gradient is G^T [...] G
+						float tmp[6][4];
+						for(unsigned int a = 0; a < alpha; ++a)
+							for(unsigned int j = 0; j < tile_size; ++j)
+							{
+								float sum = 0.0F;
+								for(unsigned int i = 0; i < tile_size; ++i)
+									sum += at[i * alpha + a] * e[i][j];
+								tmp[a][j] = sum;
+							}
+
+						float * dst = dst_base + tile_id;
+						for(unsigned int a = 0; a < alpha; ++a)
+							for(unsigned int b = 0; b < alpha; ++b)
+							{
+								float sum = 0.0F;
+								for(unsigned int j = 0; j < tile_size; ++j)
+									sum += tmp[a][j] * at[j * alpha + b];
+								dst[(a * alpha + b) * point_stride] = sum;
+							}
+					}
+				}
+			}
+
+			class transform_table
+			{
+			public:
+				void (*transform_input)(const convolution_geometry_plain&, unsigned int, const float *, unsigned int, const float *, float *, unsigned int, unsigned int);
+				void (*transform_output)(const convolution_geometry_plain&, unsigned int, const float *, unsigned int, const float *, float *, const float *, bool, unsigned int, unsigned int);
+				void (*transform_output_errors)(const convolution_geometry_plain&, unsigned int, const float *, unsigned int, const float *, float *, unsigned int, unsigned int);
+			};
+
+			// Defines transforms compiled with target_attribute and their table in namespace isa_namespace
+#define NNFORGE_WINOGRAD_PLAIN_VARIANT(isa_namespace, target_attribute) \
+			namespace isa_namespace \
+			{ \
+				target_attribute void transform_input(const convolution_geometry_plain& geometry, unsigned int tile_size, const float * bt, unsigned int tile_count, const float * input, float * transformed_input, unsigned int feature_map_start, unsigned int feature_map_count) \
+				{ \
+					if (tile_size == 4) \
+						transform_input_body<4>(geometry, bt, tile_count, input, transformed_input, feature_map_start, feature_map_count); \
+					else \
+						transform_input_body<2>(geometry, bt, tile_count, input, transformed_input, feature_map_start, feature_map_count); \
+				} \
+				target_attribute void transform_output(const convolution_geometry_plain& geometry, unsigned int tile_size, const float * at, unsigned int tile_count, const float * transformed_output, float * output, const float * biases, bool add_to_output, unsigned int feature_map_start, unsigned int feature_map_count) \
+				{ \
+					if (tile_size == 4) \
+						transform_output_body<4>(geometry, at, tile_count, transformed_output, output, biases, add_to_output, feature_map_start, feature_map_count); \
+					else \
+						transform_output_body<2>(geometry, at, tile_count, transformed_output, output, biases, add_to_output, feature_map_start, feature_map_count); \
+				} \
+				target_attribute void transform_output_errors(const convolution_geometry_plain& geometry, unsigned int tile_size, const float * at, unsigned int tile_count, const float * output_errors, float * transformed_output_errors, unsigned int feature_map_start, unsigned int feature_map_count) \
+				{ \
+					if (tile_size == 4) \
+						transform_output_errors_body<4>(geometry, at, tile_count, output_errors, transformed_output_errors, feature_map_start, feature_map_count); \
+					else \
+						transform_output_errors_body<2>(geometry, at, tile_count, output_errors, transformed_output_errors, feature_map_start, feature_map_count); \
+				} \
+				const transform_table table = { \
+					transform_input, \
+					transform_output, \
+					transform_output_errors}; \
+			}
+
+			NNFORGE_PLAIN_FOR_EACH_ISA(NNFORGE_WINOGRAD_PLAIN_VARIANT)
+
+#undef NNFORGE_WINOGRAD_PLAIN_VARIANT
+
+			const transform_table& get_transform_table(cpu_dispatch_plain::isa isa)
+			{
+				return NNFORGE_PLAIN_SELECT_ISA(isa, table);
+			}
+		}
+
+		const size_t convolution_winograd_plain::max_working_buffer_size_per_entry = 64 * 1024 * 1024;
+		const unsigned int convolution_winograd_plain::backward_weights_tile_size = 2;
+		const unsigned int convolution_winograd_plain::min_feature_map_count = 8;
+
+		const float convolution_winograd_plain::bt_2[4 * 4] = {
+			1.0F,  0.0F, -1.0F,  0.0F,
+			0.0F,  1.0F,  1.0F,  0.0F,
+			0.0F, -1.0F,  1.0F,  0.0F,
+			0.0F,  1.0F,  0.0F, -1.0F};
+		const float convolution_winograd_plain::g_2[4 * 3] = {
+			1.0F,  0.0F, 0.0F,
+			0.5F,  0.5F, 0.5F,
+			0.5F, -0.5F, 0.5F,
+			0.0F,  0.0F, 1.0F};
+		const float convolution_winograd_plain::at_2[2 * 4] = {
+			1.0F, 1.0F,  1.0F,  0.0F,
+			0.0F, 1.0F, -1.0F, -1.0F};
+
+		const float convolution_winograd_plain::bt_4[6 * 6] = {
+			4.0F,  0.0F, -5.0F,  0.0F, 1.0F, 0.0F,
+			0.0F, -4.0F, -4.0F,  1.0F, 1.0F, 0.0F,
+			0.0F,  4.0F, -4.0F, -1.0F, 1.0F, 0.0F,
+			0.0F, -2.0F, -1.0F,  2.0F, 1.0F, 0.0F,
+			0.0F,  2.0F, -1.0F, -2.0F, 1.0F, 0.0F,
+			0.0F,  4.0F,  0.0F, -5.0F, 0.0F, 1.0F};
+		const float convolution_winograd_plain::g_4[6 * 3] = {
+			1.0F / 4.0F,   0.0F,          0.0F,
+			-1.0F / 6.0F,  -1.0F / 6.0F,  -1.0F / 6.0F,
+			-1.0F / 6.0F,  1.0F / 6.0F,   -1.0F / 6.0F,
+			1.0F / 24.0F,  1.0F / 12.0F,  1.0F / 6.0F,
+			1.0F / 24.0F,  -1.0F / 12.0F, 1.0F / 6.0F,
+			0.0F,          0.0F,          1.0F};
+		const float convolution_winograd_plain::at_4[4 * 6] = {
+			1.0F, 1.0F,  1.0F, 1.0F,  1.0F, 0.0F,
+			0.0F, 1.0F, -1.0F, 2.0F, -2.0F, 0.0F,
+			0.0F, 1.0F,  1.0F, 4.0F,  4.0F, 0.0F,
+			0.0F, 1.0F, -1.0F, 8.0F, -8.0F, 1.0F};
+
+		unsigned int convolution_winograd_plain::get_tile_size(const convolution_geometry_plain& geometry)
+		{
+			if (geometry.dimension_count != 2)
+				return 0;
+
+			for(unsigned int i = 0; i < 2; ++i)
+			{
+				if ((geometry.window_sizes[i] != 3) || (geometry.strides[i] != 1))
+					return 0;
+				// Backward data runs the convolution with (window_size - 1 - padding) padding
+				if ((geometry.left_zero_padding[i] > 2) || (geometry.right_zero_padding[i] > 2))
+					return 0;
+			}
+
+			if ((geometry.input_feature_map_count < min_feature_map_count) || (geometry.output_feature_map_count < min_feature_map_count))
+				return 0;
+
+			unsigned int tile_size = ((geometry.output_dimension_sizes[0] >= 8) && (geometry.output_dimension_sizes[1] >= 8)) ? 4 : 2;
+			if (get_working_buffer_size_per_entry(geometry, tile_size) > max_working_buffer_size_per_entry)
+				return 0;
+
+			return tile_size;
+		}
+
+		void convolution_winograd_plain::get_matrices(
+			unsigned int tile_size,
+			const float *& bt,
+			const float *& g,
+			const float *& at)
+		{
+			if (tile_size == 4)
+			{
+				bt = bt_4;
+				g = g_4;
+				at = at_4;
+			}
+			else
+			{
+				bt = bt_2;
+				g = g_2;
+				at = at_2;
+			}
+		}
+
+		unsigned int convolution_winograd_plain::get_tile_count(
+			const convolution_geometry_plain& geometry,
+			unsigned int tile_size)
+		{
+			return ((geometry.output_dimension_sizes[0] + tile_size - 1) / tile_size) * ((geometry.output_dimension_sizes[1] + tile_size - 1) / tile_size);
+		}
+
+		size_t convolution_winograd_plain::get_transformed_weights_elem_count(
+			const convolution_geometry_plain& geometry,
+			unsigned int tile_size)
+		{
+			const unsigned int alpha = tile_size + 2;
+			return static_cast<size_t>(alpha * alpha) * geometry.output_feature_map_count * geometry.input_feature_map_count;
+		}
+
+		size_t convolution_winograd_plain::get_working_buffer_size_per_entry(
+			const convolution_geometry_plain& geometry,
+			unsigned int tile_size)
+		{
+			const unsigned int alpha = tile_size + 2;
+			return static_cast<size_t>(alpha * alpha) * (geometry.input_feature_map_count + geometry.output_feature_map_count) * get_tile_count(geometry, tile_size) * sizeof(float);
+		}
+
+		size_t convolution_winograd_plain::get_backward_weights_working_buffer_size(const convolution_geometry_plain& geometry)
+		{
+			const unsigned int alpha = backward_weights_tile_size + 2;
+			return get_working_buffer_size_per_entry(geometry, backward_weights_tile_size)
+				+ static_cast<size_t>(alpha * alpha) * geometry.output_feature_map_count * geometry.input_feature_map_count * sizeof(float);
+		}
+
+		void convolution_winograd_plain::transform_weights(
+			const convolution_geometry_plain& geometry,
+			unsigned int tile_size,
+			const float * weights,
+			float * transformed_weights,
+			bool flip_and_transpose,
+			int thread_count)
+		{
+			const float * bt;
+			const float * g;
+			const float * at;
+			get_matrices(tile_size, bt, g, at);
+
+			const unsigned int alpha = tile_size + 2;
+			const unsigned int input_feature_map_count = geometry.input_feature_map_count;
+			const unsigned int output_feature_map_count = geometry.output_feature_map_count;
+			const size_t point_stride = static_cast<size_t>(output_feature_map_count) * input_feature_map_count;
+			const int total_workload = static_cast<int>(output_feature_map_count * input_feature_map_count);
+
+			#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				const unsigned int output_feature_map_id = workload_id / input_feature_map_count;
+				const unsigned int input_feature_map_id = workload_id - output_feature_map_id * input_feature_map_count;
+
+				float w[3][3];
+				if (flip_and_transpose)
+				{
+					const float * src = weights + (input_feature_map_id * output_feature_map_count + output_feature_map_id) * 9;
+					for(unsigned int y = 0; y < 3; ++y)
+						for(unsigned int x = 0; x < 3; ++x)
+							w[y][x] = src[(2 - y) * 3 + (2 - x)];
+				}
+				else
+				{
+					const float * src = weights + (output_feature_map_id * input_feature_map_count + input_feature_map_id) * 9;
+					for(unsigned int y = 0; y < 3; ++y)
+						for(unsigned int x = 0; x < 3; ++x)
+							w[y][x] = src[y * 3 + x];
+				}
+
+				float tmp[6][3];
+				for(unsigned int a = 0; a < alpha; ++a)
+					for(unsigned int x = 0; x < 3; ++x)
+						tmp[a][x] = g[a * 3] * w[0][x] + g[a * 3 + 1] * w[1][x] + g[a * 3 + 2] * w[2][x];
+
+				float * dst = transformed_weights + output_feature_map_id * input_feature_map_count + input_feature_map_id;
+				for(unsigned int a = 0; a < alpha; ++a)
+					for(unsigned int b = 0; b < alpha; ++b)
+						dst[(a * alpha + b) * point_stride] = tmp[a][0] * g[b * 3] + tmp[a][1] * g[b * 3 + 1] + tmp[a][2] * g[b * 3 + 2];
+			}
+		}
+
+		void convolution_winograd_plain::run_forward(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			unsigned int tile_size,
+			const float * input,
+			float * output,
+			const float * transformed_weights,
+			const float * biases,
+			bool add_to_output,
+			float * working_buffer,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			const unsigned int alpha = tile_size + 2;
+			const unsigned int point_count = alpha * alpha;
+			const unsigned int tile_count = get_tile_count(geometry, tile_size);
+			const unsigned int input_neuron_count = geometry.input_neuron_count_per_feature_map * geometry.input_feature_map_count;
+			const unsigned int output_neuron_count = geometry.output_neuron_count_per_feature_map * geometry.output_feature_map_count;
+			const size_t transformed_input_elem_count = static_cast<size_t>(point_count) * geometry.input_feature_map_count * tile_count;
+			const size_t working_elem_count_per_entry = get_working_buffer_size_per_entry(geometry, tile_size) / sizeof(float);
+
+			if ((static_cast<int>(entry_count) >= thread_count) || (thread_count <= 1))
+			{
+				#pragma omp parallel for default(shared) schedule(dynamic) num_threads(thread_count)
+				for(int entry_id = 0; entry_id < static_cast<int>(entry_count); ++entry_id)
+				{
+					float * transformed_input = working_buffer + static_cast<size_t>(entry_id) * working_elem_count_per_entry;
+					float * transformed_output = transformed_input + transformed_input_elem_count;
+
+					transform_input_entry(isa, geometry, tile_size, input + static_cast<size_t>(entry_id) * input_neuron_count, transformed_input, 0, geometry.input_feature_map_count);
+					multiply_entry(isa, geometry, tile_size, transformed_weights, transformed_input, transformed_output, 0, point_count);
+					transform_output_entry(isa, geometry, tile_size, transformed_output, output + static_cast<size_t>(entry_id) * output_neuron_count, biases, add_to_output, 0, geometry.output_feature_map_count);
+				}
+			}
+			else
+			{
+				// Few entries, parallelize each stage within the entry
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+				{
+					float * transformed_input = working_buffer + static_cast<size_t>(entry_id) * working_elem_count_per_entry;
+					float * transformed_output = transformed_input + transformed_input_elem_count;
+					const float * in = input + static_cast<size_t>(entry_id) * input_neuron_count;
+					float * out = output + static_cast<size_t>(entry_id) * output_neuron_count;
+
+					#pragma omp parallel default(shared) num_threads(thread_count)
+					{
+						#pragma omp for schedule(static)
+						for(int input_feature_map_id = 0; input_feature_map_id < static_cast<int>(geometry.input_feature_map_count); ++input_feature_map_id)
+							transform_input_entry(isa, geometry, tile_size, in, transformed_input, input_feature_map_id, 1);
+
+						#pragma omp for schedule(dynamic)
+						for(int point_id = 0; point_id < static_cast<int>(point_count); ++point_id)
+							multiply_entry(isa, geometry, tile_size, transformed_weights, transformed_input, transformed_output, point_id, 1);
+
+						#pragma omp for schedule(static)
+						for(int output_feature_map_id = 0; output_feature_map_id < static_cast<int>(geometry.output_feature_map_count); ++output_feature_map_id)
+							transform_output_entry(isa, geometry, tile_size, transformed_output, out, biases, add_to_output, output_feature_map_id, 1);
+					}
+				}
+			}
+		}
+
+		void convolution_winograd_plain::transform_input_entry(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			unsigned int tile_size,
+			const float * input,
+			float * transformed_input,
+			unsigned int feature_map_start,
+			unsigned int feature_map_count)
+		{
+			const float * bt;
+			const float * g;
+			const float * at;
+			get_matrices(tile_size, bt, g, at);
+
+			get_transform_table(isa).transform_input(geometry, tile_size, bt, get_tile_count(geometry, tile_size), input, transformed_input, feature_map_start, feature_map_count);
+		}
+
+		void convolution_winograd_plain::multiply_entry(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			unsigned int tile_size,
+			const float * transformed_weights,
+			const float * transformed_input,
+			float * transformed_output,
+			unsigned int point_start,
+			unsigned int point_count)
+		{
+			const unsigned int tile_count = get_tile_count(geometry, tile_size);
+			const unsigned int input_feature_map_count = geometry.input_feature_map_count;
+			const unsigned int output_feature_map_count = geometry.output_feature_map_count;
+
+			for(unsigned int point_id = point_start; point_id < point_start + point_count; ++point_id)
+				gemm_plain::sgemm(
+					isa,
+					false,
+					false,
+					output_feature_map_count,
+					tile_count,
+					input_feature_map_count,
+					1.0F,
+					transformed_weights + static_cast<size_t>(point_id) * output_feature_map_count * input_feature_map_count,
+					input_feature_map_count,
+					transformed_input + static_cast<size_t>(point_id) * input_feature_map_count * tile_count,
+					tile_count,
+					0.0F,
+					transformed_output + static_cast<size_t>(point_id) * output_feature_map_count * tile_count,
+					tile_count);
+		}
+
+		void convolution_winograd_plain::transform_output_entry(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			unsigned int tile_size,
+			const float * transformed_output,
+			float * output,
+			const float * biases,
+			bool add_to_output,
+			unsigned int feature_map_start,
+			unsigned int feature_map_count)
+		{
+			const float * bt;
+			const float * g;
+			const float * at;
+			get_matrices(tile_size, bt, g, at);
+
+			get_transform_table(isa).transform_output(geometry, tile_size, at, get_tile_count(geometry, tile_size), transformed_output, output, biases, add_to_output, feature_map_start, feature_map_count);
+		}
+
+		void convolution_winograd_plain::transform_output_errors_entry(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			unsigned int tile_size,
+			const float * output_errors,
+			float * transformed_output_errors,
+			unsigned int feature_map_start,
+			unsigned int feature_map_count)
+		{
+			const float * bt;
+			const float * g;
+			const float * at;
+			get_matrices(tile_size, bt, g, at);
+
+			get_transform_table(isa).transform_output_errors(geometry, tile_size, at, get_tile_count(geometry, tile_size), output_errors, transformed_output_errors, feature_map_start, feature_map_count);
+		}
+
+		void convolution_winograd_plain::run_backward_weights(
+			cpu_dispatch_plain::isa isa,
+			const convolution_geometry_plain& geometry,
+			const float * input,
+			const float * output_errors,
+			float * gradient_weights,
+			float * working_buffer,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			const unsigned int tile_size = backward_weights_tile_size;
+			const float * bt;
+			const float * g;
+			const float * at;
+			get_matrices(tile_size, bt, g, at);
+
+			const unsigned int alpha = tile_size + 2;
+			const unsigned int point_count = alpha * alpha;
+			const unsigned int tile_count = get_tile_count(geometry, tile_size);
+			const unsigned int input_feature_map_count = geometry.input_feature_map_count;
+			const unsigned int output_feature_map_count = geometry.output_feature_map_count;
+			const unsigned int input_neuron_count = geometry.input_neuron_count_per_feature_map * input_feature_map_count;
+			const unsigned int output_neuron_count = geometry.output_neuron_count_per_feature_map * output_feature_map_count;
+			const size_t point_stride = static_cast<size_t>(output_feature_map_count) * input_feature_map_count;
+
+			float * transformed_gradient = working_buffer;
+			float * transformed_input = transformed_gradient + point_count * point_stride;
+			float * transformed_output_errors = transformed_input + static_cast<size_t>(point_count) * input_feature_map_count * tile_count;
+
+			std::fill_n(transformed_gradient, point_count * point_stride, 0.0F);
+
+			for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+			{
+				const float * in = input + static_cast<size_t>(entry_id) * input_neuron_count;
+				const float * out_err = output_errors + static_cast<size_t>(entry_id) * output_neuron_count;
+
+				#pragma omp parallel default(shared) num_threads(thread_count)
+				{
+					#pragma omp for schedule(static) nowait
+					for(int input_feature_map_id = 0; input_feature_map_id < static_cast<int>(input_feature_map_count); ++input_feature_map_id)
+						transform_input_entry(isa, geometry, tile_size, in, transformed_input, input_feature_map_id, 1);
+
+					#pragma omp for schedule(static)
+					for(int output_feature_map_id = 0; output_feature_map_id < static_cast<int>(output_feature_map_count); ++output_feature_map_id)
+						transform_output_errors_entry(isa, geometry, tile_size, out_err, transformed_output_errors, output_feature_map_id, 1);
+
+					#pragma omp for schedule(dynamic)
+					for(int point_id = 0; point_id < static_cast<int>(point_count); ++point_id)
+						gemm_plain::sgemm(
+							isa,
+							false,
+							true,
+							output_feature_map_count,
+							input_feature_map_count,
+							tile_count,
+							1.0F,
+							transformed_output_errors + static_cast<size_t>(point_id) * output_feature_map_count * tile_count,
+							tile_count,
+							transformed_input + static_cast<size_t>(point_id) * input_feature_map_count * tile_count,
+							tile_count,
+							1.0F,
+							transformed_gradient + point_id * point_stride,
+							input_feature_map_count);
+				}
+			}
+
+			const int total_workload = static_cast<int>(output_feature_map_count * input_feature_map_count);
+			#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				const float * src = transformed_gradient + workload_id;
+				float m[4][4];
+				for(unsigned int a = 0; a < alpha; ++a)
+					for(unsigned int b = 0; b < alpha; ++b)
+						m[a][b] = src[(a * alpha + b) * point_stride];
+
+				float tmp[3][4];
+				for(unsigned int p = 0; p < 3; ++p)
+					for(unsigned int b = 0; b < alpha; ++b)
+					{
+						float sum = 0.0F;
+						for(unsigned int a = 0; a < alpha; ++a)
+							sum += g[a * 3 + p] * m[a][b];
+						tmp[p][b] = sum;
+					}
+
+				float * dst = gradient_weights + static_cast<size_t>(workload_id) * 9;
+				for(unsigned int p = 0; p < 3; ++p)
+					for(unsigned int q = 0; q < 3; ++q)
+					{
+						float sum = 0.0F;
+						for(unsigned int b = 0; b < alpha; ++b)
+							sum += tmp[p][b] * g[b * 3 + q];
+						dst[p * 3 + q] += sum;
+					}
+			}
+		}
+	}
+}
@@ -0,0 +1,155 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "convolution_geometry_plain.h"
+#include "cpu_dispatch_plain.h"
+
+#include <cstddef>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Winograd minimal filtering F(m x m, 3 x 3) for 2D stride 1 convolutions, m is either 2 or 4
+		// Input tiles and filters are transformed to alpha x alpha (alpha = m + 2) domain,
+		// then for each of alpha * alpha points the products are summed over input feature maps with GEMM
+		// Transformed weights have layout [alpha * alpha][output_feature_map][input_feature_map]
+		class convolution_winograd_plain
+		{
+		public:
+			// Returns output tile size m, 0 is returned when Winograd cannot be applied
+			static unsigned int get_tile_size(const convolution_geometry_plain& geometry);
+
+			static size_t get_transformed_weights_elem_count(
+				const convolution_geometry_plain& geometry,
+				unsigned int tile_size);
+
+			// When flip_and_transpose is true the weights are converted to those of the convolution computing input errors
+			static void transform_weights(
+				const convolution_geometry_plain& geometry,
+				unsigned int tile_size,
+				const float * weights,
+				float * transformed_weights,
+				bool flip_and_transpose,
+				int thread_count);
+
+			static size_t get_working_buffer_size_per_entry(
+				const convolution_geometry_plain& geometry,
+				unsigned int tile_size);
+
+			// working_buffer should hold get_working_buffer_size_per_entry bytes per entry
+			static void run_forward(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				unsigned int tile_size,
+				const float * input,
+				float * output,
+				const float * transformed_weights,
+				const float * biases,
+				bool add_to_output,
+				float * working_buffer,
+				unsigned int entry_count,
+				int thread_count);
+
+			static size_t get_backward_weights_working_buffer_size(const convolution_geometry_plain& geometry);
+
+			// Weight gradient is added to gradient_weights, working_buffer is of get_backward_weights_working_buffer_size bytes
+			static void run_backward_weights(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				const float * input,
+				const float * output_errors,
+				float * gradient_weights,
+				float * working_buffer,
+				unsigned int entry_count,
+				int thread_count);
+
+		private:
+			static void transform_input_entry(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				unsigned int tile_size,
+				const float * input,
+				float * transformed_input,
+				unsigned int feature_map_start,
+				unsigned int feature_map_count);
+
+			static void multiply_entry(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				unsigned int tile_size,
+				const float * transformed_weights,
+				const float * transformed_input,
+				float * transformed_output,
+				unsigned int point_start,
+				unsigned int point_count);
+
+			static void transform_output_entry(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				unsigned int tile_size,
+				const float * transformed_output,
+				float * output,
+				const float * biases,
+				bool add_to_output,
+				unsigned int feature_map_start,
+				unsigned int feature_map_count);
+
+			static void transform_output_errors_entry(
+				cpu_dispatch_plain::isa isa,
+				const convolution_geometry_plain& geometry,
+				unsigned int tile_size,
+				const float * output_errors,
+				float * transformed_output_errors,
+				unsigned int feature_map_start,
+				unsigned int feature_map_count);
+
+			static unsigned int get_tile_count(
+				const convolution_geometry_plain& geometry,
+				unsigned int tile_size);
+
+			// bt is alpha x alpha, g is alpha x 3, at is tile_size x alpha
+			static void get_matrices(
+				unsigned int tile_size,
+				const float *& bt,
+				const float *& g,
+				const float *& at);
+
+		private:
+			// Working buffer of a single entry larger than this is not allocated
+			static const size_t max_working_buffer_size_per_entry;
+
+			// Output tile size used for weight gradient, larger tiles lose too much precision when accumulated over the batch
+			static const unsigned int backward_weights_tile_size;
+
+			// Transforms are not worth it for narrow layers
+			static const unsigned int min_feature_map_count;
+
+			static const float bt_2[4 * 4];
+			static const float g_2[4 * 3];
+			static const float at_2[2 * 4];
+			static const float bt_4[6 * 6];
+			static const float g_4[6 * 3];
+			static const float at_4[4 * 6];
+
+		private:
+			convolution_winograd_plain();
+			~convolution_winograd_plain();
+		};
+	}
+}
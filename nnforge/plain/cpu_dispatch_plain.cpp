@@ -0,0 +1,168 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "cpu_dispatch_plain.h"
+
+#include "../neural_network_exception.h"
+
+#include <boost/format.hpp>
+
+#if defined(NNFORGE_PLAIN_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+#if defined(NNFORGE_PLAIN_X86)
+			void cpuid(
+				unsigned int leaf,
+				unsigned int subleaf,
+				unsigned int regs[4])
+			{
+#if defined(_MSC_VER)
+				int res[4];
+				__cpuidex(res, static_cast<int>(leaf), static_cast<int>(subleaf));
+				for(int i = 0; i < 4; ++i)
+					regs[i] = static_cast<unsigned int>(res[i]);
+#else
+				__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+			}
+
+			// Register state components the OS saves on context switches
+			unsigned long long get_xcr0()
+			{
+#if defined(_MSC_VER)
+				return _xgetbv(0);
+#else
+				unsigned int eax;
+				unsigned int edx;
+				__asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+				return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+			}
+#endif
+		}
+
+		cpu_dispatch_plain::isa cpu_dispatch_plain::detect_isa()
+		{
+#if defined(NNFORGE_PLAIN_X86)
+			unsigned int regs[4];
+			cpuid(0, 0, regs);
+			const unsigned int max_leaf = regs[0];
+
+			cpuid(1, 0, regs);
+			const bool sse2 = (regs[3] & (1U << 26)) != 0;
+			const bool fma = (regs[2] & (1U << 12)) != 0;
+			const bool osxsave = (regs[2] & (1U << 27)) != 0;
+			const bool avx = (regs[2] & (1U << 28)) != 0;
+			if (!sse2)
+				return isa_generic;
+
+			if (!osxsave || !avx || (max_leaf < 7))
+				return isa_sse2;
+			const unsigned long long xcr0 = get_xcr0();
+			// XMM and YMM state
+			if ((xcr0 & 0x6) != 0x6)
+				return isa_sse2;
+
+			cpuid(7, 0, regs);
+			const bool avx2 = (regs[1] & (1U << 5)) != 0;
+			const bool avx512f = (regs[1] & (1U << 16)) != 0;
+			if (!avx2 || !fma)
+				return isa_sse2;
+
+			// Opmask, upper halves of ZMM0-15 and ZMM16-31 state
+			if (!avx512f || ((xcr0 & 0xE0) != 0xE0))
+				return isa_avx2;
+
+			return isa_avx512;
+#else
+			return isa_generic;
+#endif
+		}
+
+		cpu_dispatch_plain::isa cpu_dispatch_plain::get_detected_isa()
+		{
+			static const isa detected_isa = detect_isa();
+			return detected_isa;
+		}
+
+		cpu_dispatch_plain::isa cpu_dispatch_plain::get_isa(const std::string& name)
+		{
+			if (name.empty())
+				return get_detected_isa();
+
+			isa res = parse_isa_name(name);
+			if (res > get_detected_isa())
+				throw neural_network_exception((boost::format("Instruction set %1% is not supported by the CPU, the best one supported is %2%") % name % get_isa_name(get_detected_isa())).str());
+
+			return res;
+		}
+
+		std::string cpu_dispatch_plain::get_isa_name(isa value)
+		{
+			switch (value)
+			{
+			case isa_generic:
+				return "generic";
+			case isa_sse2:
+				return "sse2";
+			case isa_avx2:
+				return "avx2";
+			case isa_avx512:
+				return "avx512";
+			default:
+				throw neural_network_exception((boost::format("Unknown instruction set %1%") % static_cast<int>(value)).str());
+			}
+		}
+
+		unsigned int cpu_dispatch_plain::get_flops_per_cycle(isa value)
+		{
+			switch (value)
+			{
+			case isa_generic:
+				return 2;
+			case isa_sse2:
+				return 4 * 2;
+			case isa_avx2:
+				return 8 * 2 * 2;
+			case isa_avx512:
+				return 16 * 2 * 2;
+			default:
+				throw neural_network_exception((boost::format("Unknown instruction set %1%") % static_cast<int>(value)).str());
+			}
+		}
+
+		cpu_dispatch_plain::isa cpu_dispatch_plain::parse_isa_name(const std::string& name)
+		{
+			const isa isa_list[] = {isa_generic, isa_sse2, isa_avx2, isa_avx512};
+			for(unsigned int i = 0; i < sizeof(isa_list) / sizeof(isa_list[0]); ++i)
+				if (name == get_isa_name(isa_list[i]))
+					return isa_list[i];
+
+			throw neural_network_exception((boost::format("Unknown instruction set %1%, generic, sse2, avx2 and avx512 are supported") % name).str());
+		}
+	}
+}
@@ -0,0 +1,124 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define NNFORGE_PLAIN_X86
+#endif
+
+// Functions marked with these are compiled for the instruction set specified regardless of the compiler flags,
+// they should be called only when cpu_dispatch_plain reports the instruction set is selected.
+// MSVC accepts intrinsics of any instruction set without additional flags
+#if defined(NNFORGE_PLAIN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define NNFORGE_PLAIN_TARGET_SSE2 __attribute__((target("sse2")))
+#define NNFORGE_PLAIN_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NNFORGE_PLAIN_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+#define NNFORGE_PLAIN_TARGET_SSE2
+#define NNFORGE_PLAIN_TARGET_AVX2
+#define NNFORGE_PLAIN_TARGET_AVX512
+#endif
+
+// Invokes variant(isa_namespace, target_attribute) for each instruction set kernels are compiled for,
+// variants are then picked with NNFORGE_PLAIN_SELECT_ISA(value, name), name being defined in each isa_namespace
+#if defined(NNFORGE_PLAIN_X86)
+#define NNFORGE_PLAIN_FOR_EACH_ISA(variant) \
+	variant(generic, ) \
+	variant(sse2, NNFORGE_PLAIN_TARGET_SSE2) \
+	variant(avx2, NNFORGE_PLAIN_TARGET_AVX2) \
+	variant(avx512, NNFORGE_PLAIN_TARGET_AVX512)
+#define NNFORGE_PLAIN_SELECT_ISA(value, name) cpu_dispatch_plain::select(value, generic::name, sse2::name, avx2::name, avx512::name)
+#else
+#define NNFORGE_PLAIN_FOR_EACH_ISA(variant) \
+	variant(generic, )
+#define NNFORGE_PLAIN_SELECT_ISA(value, name) (generic::name)
+#endif
+
+#if defined(_MSC_VER)
+#define NNFORGE_PLAIN_FORCEINLINE __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+#define NNFORGE_PLAIN_FORCEINLINE inline __attribute__((always_inline))
+#else
+#define NNFORGE_PLAIN_FORCEINLINE inline
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Runtime selection of the instruction set used by the plain kernels compiled in several variants
+		class cpu_dispatch_plain
+		{
+		public:
+			// Ordered, each instruction set includes the previous ones
+			enum isa
+			{
+				isa_generic = 0,
+				isa_sse2 = 1,
+				isa_avx2 = 2,
+				isa_avx512 = 3
+			};
+
+			// The best instruction set supported by both the CPU and the OS, detected with CPUID on first call
+			static isa get_detected_isa();
+
+			// Returns the instruction set with the name specified, the detected one when the name is empty;
+			// throws when the CPU doesn't support the instruction set requested
+			static isa get_isa(const std::string& name);
+
+			static std::string get_isa_name(isa value);
+
+			// Peak single precision flops per cycle of a single core: vector width times 2 for multiply-add,
+			// times 2 more for AVX2 and AVX-512 as most of the cores supporting them have 2 FMA units
+			static unsigned int get_flops_per_cycle(isa value);
+
+			// Throws for unknown names
+			static isa parse_isa_name(const std::string& name);
+
+			// Returns the variant for the instruction set, avx512_value is returned for isa_avx512 and so on
+			template<typename value_type>
+			static const value_type& select(
+				isa value,
+				const value_type& generic_value,
+				const value_type& sse2_value,
+				const value_type& avx2_value,
+				const value_type& avx512_value)
+			{
+				switch (value)
+				{
+				case isa_avx512:
+					return avx512_value;
+				case isa_avx2:
+					return avx2_value;
+				case isa_sse2:
+					return sse2_value;
+				default:
+					return generic_value;
+				}
+			}
+
+		private:
+			static isa detect_isa();
+
+		private:
+			cpu_dispatch_plain();
+			~cpu_dispatch_plain();
+		};
+	}
+}
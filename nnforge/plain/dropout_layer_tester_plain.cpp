@@ -64,5 +64,14 @@ namespace nnforge
 		{
 			return 0;
 		}
+
+		bool dropout_layer_tester_plain::is_channel_blocked_layout_supported(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return true;
+		}
 	}
 }
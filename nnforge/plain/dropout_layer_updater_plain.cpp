@@ -16,15 +16,93 @@
 
 #include "dropout_layer_updater_plain.h"
 
+#include "parallel_plain.h"
+#include "philox_plain.h"
+#include "simd_kernels_plain.h"
 #include "../dropout_layer.h"
 #include "../nn_types.h"
 
-#include <cstring>
+#include <algorithm>
 
 namespace nnforge
 {
 	namespace plain
 	{
+		namespace
+		{
+			// Element elem_id is kept when the upper 24 bits of random number elem_id % 4
+			// generated for the counter (elem_id / 4, iteration) are below keep_threshold
+			struct dropout_mask
+			{
+				unsigned int key[2];
+				unsigned int iteration[2];
+				unsigned int keep_threshold;
+				float mult;
+
+				void get_mult_list(
+					int group_id,
+					float res[4]) const
+				{
+					const unsigned int counter[4] = {static_cast<unsigned int>(group_id), 0, iteration[0], iteration[1]};
+					unsigned int random_list[4];
+					philox_plain::generate(key, counter, random_list);
+					for(int i = 0; i < 4; ++i)
+						res[i] = ((random_list[i] >> 8) < keep_threshold) ? mult : 0.0F;
+				}
+			};
+
+			struct dropout_forward_chunk
+			{
+				dropout_mask mask;
+				const float * in_it;
+				float * out_it;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					const int end = start + current_elem_count;
+					for(int group_id = start / 4; group_id * 4 < end; ++group_id)
+					{
+						float mult_list[4];
+						mask.get_mult_list(group_id, mult_list);
+						const int group_start = group_id * 4;
+						const int lane_end = std::min(end - group_start, 4);
+						for(int lane = std::max(start - group_start, 0); lane < lane_end; ++lane)
+							out_it[group_start + lane] = in_it[group_start + lane] * mult_list[lane];
+					}
+				}
+			};
+
+			struct dropout_backward_chunk
+			{
+				dropout_mask mask;
+				const float * out_err_it;
+				float * in_err_it;
+				bool add_update_to_destination;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					const int end = start + current_elem_count;
+					for(int group_id = start / 4; group_id * 4 < end; ++group_id)
+					{
+						float mult_list[4];
+						mask.get_mult_list(group_id, mult_list);
+						const int group_start = group_id * 4;
+						const int lane_end = std::min(end - group_start, 4);
+						if (add_update_to_destination)
+						{
+							for(int lane = std::max(start - group_start, 0); lane < lane_end; ++lane)
+								in_err_it[group_start + lane] += out_err_it[group_start + lane] * mult_list[lane];
+						}
+						else
+						{
+							for(int lane = std::max(start - group_start, 0); lane < lane_end; ++lane)
+								in_err_it[group_start + lane] = out_err_it[group_start + lane] * mult_list[lane];
+						}
+					}
+				}
+			};
+		}
+
 		dropout_layer_updater_plain::dropout_layer_updater_plain()
 			: gen(rnd::get_random_generator())
 		{
@@ -54,31 +132,23 @@ namespace nnforge
 			const std::set<layer_action>& actions,
 			unsigned int entry_count) const
 		{
-			const float * const in_it_global = *input_buffers[0];
-			float * const out_it_global = *output_buffer;
-			unsigned char * keep_elem_ptr = *temporary_per_entry_buffer;
-
 			nnforge_shared_ptr<const dropout_layer> layer_derived = nnforge_dynamic_pointer_cast<const dropout_layer>(layer_schema);
-			const float dropout_rate = layer_derived->dropout_rate;
-			const float keep_rate = 1.0F - dropout_rate;
-			const float mult = 1.0F / keep_rate;
-
-			const int total_workload = output_configuration_specific.get_neuron_count() * entry_count;
+			const float keep_rate = 1.0F - layer_derived->dropout_rate;
 
-			nnforge_uniform_real_distribution<float> dist(0.0F, 1.0F);
+			// Without backward data the mask is never regenerated, so the next forward prop gets the next iteration
+			const bool advance = (actions.find(layer_action(layer_action::backward_data, 0)) == actions.end());
+			const mask_key current_key = get_mask_key(layer_schema->instance_name, advance);
 
-			for(int i = 0; i < total_workload; ++i)
-				keep_elem_ptr[i] = (dist(gen) <= keep_rate ? (unsigned char)1 : (unsigned char)0);
+			const int elem_count = static_cast<int>(entry_count * output_configuration_specific.get_neuron_count());
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr)
-			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					int elem_id = workload_id;
-					*(out_it_global + elem_id) = *(in_it_global + elem_id) * (keep_elem_ptr[elem_id] ? mult : 0.0F);
-				}
-			}
+			dropout_forward_chunk body;
+			std::copy(current_key.key, current_key.key + 2, body.mask.key);
+			std::copy(current_key.iteration, current_key.iteration + 2, body.mask.iteration);
+			body.mask.keep_threshold = static_cast<unsigned int>(keep_rate * 16777216.0F);
+			body.mask.mult = 1.0F / keep_rate;
+			body.in_it = *input_buffers[0];
+			body.out_it = *output_buffer;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count, body);
 		}
 
 		void dropout_layer_updater_plain::run_backward_data_propagation(
@@ -100,41 +170,23 @@ namespace nnforge
 			const std::set<layer_action>& actions,
 			unsigned int entry_count) const
 		{
-			float * const in_err_it_global = *input_errors_buffer;
-			const float * const out_err_it_global = *output_errors_buffer;
-			const unsigned char * keep_elem_ptr = *temporary_per_entry_buffer;
-
 			nnforge_shared_ptr<const dropout_layer> layer_derived = nnforge_dynamic_pointer_cast<const dropout_layer>(layer_schema);
-			const float dropout_rate = layer_derived->dropout_rate;
-			const float keep_rate = 1.0F - dropout_rate;
-			const float mult = 1.0F / keep_rate;
+			const float keep_rate = 1.0F - layer_derived->dropout_rate;
 
-			const int total_workload = output_configuration_specific.get_neuron_count() * entry_count;
+			// The mask of the forward prop is regenerated, the next forward prop gets the next iteration
+			const mask_key current_key = get_mask_key(layer_schema->instance_name, true);
 
-			if (add_update_to_destination)
-			{
-				#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr)
-				{
-					#pragma omp for schedule(guided)
-					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-					{
-						int elem_id = workload_id;
-						*(in_err_it_global + elem_id) += *(out_err_it_global + elem_id) * (keep_elem_ptr[elem_id] ? mult : 0.0F);
-					}
-				}
-			}
-			else
-			{
-				#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr)
-				{
-					#pragma omp for schedule(guided)
-					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-					{
-						int elem_id = workload_id;
-						*(in_err_it_global + elem_id) = *(out_err_it_global + elem_id) * (keep_elem_ptr[elem_id] ? mult : 0.0F);
-					}
-				}
-			}
+			const int elem_count = static_cast<int>(entry_count * output_configuration_specific.get_neuron_count());
+
+			dropout_backward_chunk body;
+			std::copy(current_key.key, current_key.key + 2, body.mask.key);
+			std::copy(current_key.iteration, current_key.iteration + 2, body.mask.iteration);
+			body.mask.keep_threshold = static_cast<unsigned int>(keep_rate * 16777216.0F);
+			body.mask.mult = 1.0F / keep_rate;
+			body.out_err_it = *output_errors_buffer;
+			body.in_err_it = *input_errors_buffer;
+			body.add_update_to_destination = add_update_to_destination;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count, body);
 		}
 
 		int dropout_layer_updater_plain::get_input_index_layer_can_write(
@@ -171,14 +223,44 @@ namespace nnforge
 			return false;
 		}
 
-		size_t dropout_layer_updater_plain::get_temporary_per_entry_buffer_size(
+		bool dropout_layer_updater_plain::is_forward_recomputable(
 			const std::set<layer_action>& actions,
 			plain_running_configuration::const_ptr plain_config,
 			layer::const_ptr layer_schema,
 			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 			const layer_configuration_specific& output_configuration_specific) const
 		{
-			return output_configuration_specific.get_neuron_count() * sizeof(unsigned char);
+			// Recomputing runs before backward data moves to the next iteration, so the same mask is generated.
+			// Without backward data each forward prop moves to the next iteration
+			return (actions.find(layer_action(layer_action::backward_data, 0)) != actions.end());
+		}
+
+		dropout_layer_updater_plain::mask_key dropout_layer_updater_plain::get_mask_key(
+			const std::string& layer_name,
+			bool advance) const
+		{
+			boost::lock_guard<boost::mutex> lock(mask_key_mutex);
+
+			std::map<std::string, mask_key>::iterator it = layer_name_to_mask_key_map.find(layer_name);
+			if (it == layer_name_to_mask_key_map.end())
+			{
+				mask_key new_key;
+				new_key.key[0] = static_cast<unsigned int>(gen());
+				new_key.key[1] = static_cast<unsigned int>(gen());
+				new_key.iteration[0] = 0;
+				new_key.iteration[1] = 0;
+				it = layer_name_to_mask_key_map.insert(std::make_pair(layer_name, new_key)).first;
+			}
+
+			mask_key res = it->second;
+			if (advance)
+			{
+				++(it->second.iteration[0]);
+				if (it->second.iteration[0] == 0)
+					++(it->second.iteration[1]);
+			}
+
+			return res;
 		}
 	}
 }
@@ -19,6 +19,9 @@
 #include "layer_updater_plain.h"
 #include "../rnd.h"
 
+#include <map>
+#include <boost/thread/thread.hpp>
+
 namespace nnforge
 {
 	namespace plain
@@ -91,15 +94,30 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
-			virtual size_t get_temporary_per_entry_buffer_size(
+			virtual bool is_forward_recomputable(
 				const std::set<layer_action>& actions,
 				plain_running_configuration::const_ptr plain_config,
 				layer::const_ptr layer_schema,
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+		private:
+			// Key of philox_plain, the counter is made of the element index and the iteration
+			struct mask_key
+			{
+				unsigned int key[2];
+				unsigned int iteration[2];
+			};
+
+			// Returns the key of the current iteration of the layer, then moves to the next iteration if advance is true
+			mask_key get_mask_key(
+				const std::string& layer_name,
+				bool advance) const;
+
 		private:
 			mutable random_generator gen;
+			mutable std::map<std::string, mask_key> layer_name_to_mask_key_map;
+			mutable boost::mutex mask_key_mutex;
 		};
 	}
 }
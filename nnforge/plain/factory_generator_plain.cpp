@@ -31,9 +31,33 @@ namespace nnforge
 	{
 		factory_generator_plain::factory_generator_plain(
 			float plain_max_global_memory_usage,
-			int plain_openmp_thread_count)
+			int plain_openmp_thread_count,
+			int plain_channel_block_size,
+			int plain_max_concurrent_branch_count,
+			int plain_reader_thread_count,
+			bool plain_huge_pages,
+			bool plain_low_latency,
+			bool plain_thread_affinity,
+			bool plain_numa_replicas,
+			bool plain_buffer_offsets,
+			int plain_checkpoint_segments,
+			const std::string& plain_checkpoint_layers,
+			float plain_cpu_frequency,
+			const std::string& plain_cpu_isa)
 			: plain_max_global_memory_usage(plain_max_global_memory_usage)
 			, plain_openmp_thread_count(plain_openmp_thread_count)
+			, plain_channel_block_size(plain_channel_block_size)
+			, plain_max_concurrent_branch_count(plain_max_concurrent_branch_count)
+			, plain_reader_thread_count(plain_reader_thread_count)
+			, plain_huge_pages(plain_huge_pages)
+			, plain_low_latency(plain_low_latency)
+			, plain_thread_affinity(plain_thread_affinity)
+			, plain_numa_replicas(plain_numa_replicas)
+			, plain_buffer_offsets(plain_buffer_offsets)
+			, plain_checkpoint_segments(plain_checkpoint_segments)
+			, plain_checkpoint_layers(plain_checkpoint_layers)
+			, plain_cpu_frequency(plain_cpu_frequency)
+			, plain_cpu_isa(plain_cpu_isa)
 		{
 		}
 
@@ -49,7 +73,20 @@ namespace nnforge
 		{
 			plain_config = plain_running_configuration::const_ptr(new plain_running_configuration(
 				plain_openmp_thread_count,
-				plain_max_global_memory_usage));
+				plain_max_global_memory_usage,
+				static_cast<unsigned int>(plain_channel_block_size),
+				static_cast<unsigned int>(plain_max_concurrent_branch_count),
+				static_cast<unsigned int>(plain_reader_thread_count),
+				plain_huge_pages,
+				plain_low_latency,
+				plain_thread_affinity,
+				plain_numa_replicas,
+				plain_buffer_offsets,
+				plain_checkpoint_segments,
+				plain_checkpoint_layers,
+				plain_cpu_frequency,
+				plain_cpu_isa,
+				tuning));
 		}
 
 		forward_propagation_factory::ptr factory_generator_plain::create_forward_propagation_factory() const
@@ -67,6 +104,7 @@ namespace nnforge
 			std::vector<float_option> res;
 
 			res.push_back(float_option("plain_max_global_memory_usage,M", &plain_max_global_memory_usage, 0.5F, "memory to be used by single plain configuration, in GB."));
+			res.push_back(float_option("plain_cpu_frequency", &plain_cpu_frequency, 0.0F, "CPU frequency in GHz used to estimate peak performance, detected if 0."));
 
 			return res;
 		}
@@ -78,6 +116,33 @@ namespace nnforge
 			#ifdef _OPENMP
 			res.push_back(int_option("plain_openmp_thread_count", &plain_openmp_thread_count, omp_get_max_threads(), "count of threads to be used in OpenMP."));
 			#endif
+			res.push_back(int_option("plain_channel_block_size", &plain_channel_block_size, 0, "feature map block size of the channel blocked activation layout (8 or 16), 0 disables it."));
+			res.push_back(int_option("plain_max_concurrent_branch_count", &plain_max_concurrent_branch_count, 1, "count of independent branches of the schema forward prop runs concurrently, more branches use more memory."));
+			res.push_back(int_option("plain_reader_thread_count", &plain_reader_thread_count, 0, "count of threads decoding input entries in the background while the network runs on the previous chunk, they compete with the compute threads for cores: more of them keep up with costly decoding, fewer leave more cores to the network; 0 picks a quarter of OpenMP threads."));
+			res.push_back(int_option("plain_checkpoint_segments", &plain_checkpoint_segments, 0, "count of segments backward prop splits layers into, keeping only outputs of the last layers of segments and recomputing the others, -1 picks square root of layer count, 0 keeps all outputs."));
+
+			return res;
+		}
+
+		std::vector<bool_option> factory_generator_plain::get_bool_options()
+		{
+			std::vector<bool_option> res;
+
+			res.push_back(bool_option("plain_huge_pages", &plain_huge_pages, false, "back buffer arenas with transparent huge pages."));
+			res.push_back(bool_option("plain_low_latency", &plain_low_latency, false, "split feature maps between threads when there are few entries, reduces latency of small batches."));
+			res.push_back(bool_option("plain_thread_affinity", &plain_thread_affinity, false, "bind OpenMP threads to CPUs spread evenly over NUMA nodes."));
+			res.push_back(bool_option("plain_numa_replicas", &plain_numa_replicas, false, "replicate weights on each NUMA node and split entries between nodes in forward prop."));
+			res.push_back(bool_option("plain_buffer_offsets", &plain_buffer_offsets, true, "place layer buffers at planned offsets of a single allocation instead of sharing whole buffers, takes less memory."));
+
+			return res;
+		}
+
+		std::vector<string_option> factory_generator_plain::get_string_options()
+		{
+			std::vector<string_option> res;
+
+			res.push_back(string_option("plain_cpu_isa", &plain_cpu_isa, "", "instruction set of plain kernels (generic, sse2, avx2, avx512), the best one supported by CPU is used if empty."));
+			res.push_back(string_option("plain_checkpoint_layers", &plain_checkpoint_layers, "", "colon separated names of layers whose outputs backward prop keeps while recomputing the others, overrides plain_checkpoint_segments."));
 
 			return res;
 		}
@@ -28,7 +28,19 @@ namespace nnforge
 		public:
 			factory_generator_plain(
 				float plain_max_global_memory_usage,
-				int plain_openmp_thread_count);
+				int plain_openmp_thread_count,
+				int plain_channel_block_size,
+				int plain_max_concurrent_branch_count,
+				int plain_reader_thread_count,
+				bool plain_huge_pages,
+				bool plain_low_latency,
+				bool plain_thread_affinity,
+				bool plain_numa_replicas,
+				bool plain_buffer_offsets,
+				int plain_checkpoint_segments,
+				const std::string& plain_checkpoint_layers,
+				float plain_cpu_frequency,
+				const std::string& plain_cpu_isa);
 
 			factory_generator_plain();
 
@@ -46,9 +58,25 @@ namespace nnforge
 
 			virtual std::vector<int_option> get_int_options();
 
+			virtual std::vector<bool_option> get_bool_options();
+
+			virtual std::vector<string_option> get_string_options();
+
 		protected:
 			float plain_max_global_memory_usage;
 			int plain_openmp_thread_count;
+			int plain_channel_block_size;
+			int plain_max_concurrent_branch_count;
+			int plain_reader_thread_count;
+			bool plain_huge_pages;
+			bool plain_low_latency;
+			bool plain_thread_affinity;
+			bool plain_numa_replicas;
+			bool plain_buffer_offsets;
+			int plain_checkpoint_segments;
+			std::string plain_checkpoint_layers;
+			float plain_cpu_frequency;
+			std::string plain_cpu_isa;
 
 			plain_running_configuration::const_ptr plain_config;
 		};
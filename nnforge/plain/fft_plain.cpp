@@ -0,0 +1,341 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "fft_plain.h"
+
+#include "../neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <cmath>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			typedef fft_plain::complex complex;
+
+			const unsigned int max_radix = 5;
+
+			// Plain complex product, std::complex operator* handles infinities and is way slower
+			NNFORGE_PLAIN_FORCEINLINE complex multiply(
+				const complex& a,
+				const complex& b)
+			{
+				return complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+			}
+
+			// Bodies are inlined into the variants compiled for each instruction set below
+
+			// Combines radix transforms of size sub_size, stored one after another in out, into the transform of size radix * sub_size
+			NNFORGE_PLAIN_FORCEINLINE void butterfly_body(
+				const complex * tw,
+				unsigned int size,
+				complex * out,
+				unsigned int radix,
+				unsigned int sub_size,
+				unsigned int twiddle_stride,
+				bool inverse)
+			{
+				if (radix == 2)
+				{
+					for(unsigned int k = 0; k < sub_size; ++k)
+					{
+						complex w = tw[k * twiddle_stride];
+						complex a = out[k];
+						complex b = multiply(out[sub_size + k], inverse ? std::conj(w) : w);
+						out[k] = a + b;
+						out[sub_size + k] = a - b;
+					}
+				}
+				else if (radix == 4)
+				{
+					for(unsigned int k = 0; k < sub_size; ++k)
+					{
+						complex w1 = tw[k * twiddle_stride];
+						complex w2 = tw[2 * k * twiddle_stride];
+						complex w3 = tw[3 * k * twiddle_stride];
+						complex a0 = out[k];
+						complex a1 = multiply(out[sub_size + k], inverse ? std::conj(w1) : w1);
+						complex a2 = multiply(out[2 * sub_size + k], inverse ? std::conj(w2) : w2);
+						complex a3 = multiply(out[3 * sub_size + k], inverse ? std::conj(w3) : w3);
+						complex s02 = a0 + a2;
+						complex d02 = a0 - a2;
+						complex s13 = a1 + a3;
+						complex d13 = a1 - a3;
+						// Multiply by -i for forward and by i for inverse transform
+						complex d13_rotated = inverse ? complex(-d13.imag(), d13.real()) : complex(d13.imag(), -d13.real());
+						out[k] = s02 + s13;
+						out[sub_size + k] = d02 + d13_rotated;
+						out[2 * sub_size + k] = s02 - s13;
+						out[3 * sub_size + k] = d02 - d13_rotated;
+					}
+				}
+				else if (radix == 3)
+				{
+					const float sin_60 = 0.866025403784438647F;
+					for(unsigned int k = 0; k < sub_size; ++k)
+					{
+						complex w1 = tw[k * twiddle_stride];
+						complex w2 = tw[2 * k * twiddle_stride];
+						complex a0 = out[k];
+						complex a1 = multiply(out[sub_size + k], inverse ? std::conj(w1) : w1);
+						complex a2 = multiply(out[2 * sub_size + k], inverse ? std::conj(w2) : w2);
+						complex s12 = a1 + a2;
+						complex center = a0 - s12 * 0.5F;
+						complex d12 = (a1 - a2) * sin_60;
+						// Multiply by -i for forward and by i for inverse transform
+						complex d12_rotated = inverse ? complex(-d12.imag(), d12.real()) : complex(d12.imag(), -d12.real());
+						out[k] = a0 + s12;
+						out[sub_size + k] = center + d12_rotated;
+						out[2 * sub_size + k] = center - d12_rotated;
+					}
+				}
+				else
+				{
+					const unsigned int radix_twiddle_stride = size / radix;
+					complex tmp[max_radix];
+					for(unsigned int k = 0; k < sub_size; ++k)
+					{
+						tmp[0] = out[k];
+						for(unsigned int r = 1; r < radix; ++r)
+						{
+							complex w = tw[r * k * twiddle_stride];
+							tmp[r] = multiply(out[r * sub_size + k], inverse ? std::conj(w) : w);
+						}
+
+						for(unsigned int q = 0; q < radix; ++q)
+						{
+							complex sum = tmp[0];
+							for(unsigned int r = 1; r < radix; ++r)
+							{
+								complex w = tw[((r * q) % radix) * radix_twiddle_stride];
+								sum += multiply(tmp[r], inverse ? std::conj(w) : w);
+							}
+							out[q * sub_size + k] = sum;
+						}
+					}
+				}
+			}
+
+			// Splits the transform of the packed sequence into the spectrum of the real sequence
+			NNFORGE_PLAIN_FORCEINLINE void real_forward_post_body(
+				const complex * real_twiddles,
+				unsigned int size,
+				const complex * packed_transformed,
+				complex * out)
+			{
+				for(unsigned int k = 0; k <= size; ++k)
+				{
+					complex z = packed_transformed[k % size];
+					complex z_mirrored = std::conj(packed_transformed[(size - k) % size]);
+					complex even = (z + z_mirrored) * 0.5F;
+					complex diff = z - z_mirrored;
+					complex odd(diff.imag() * 0.5F, -diff.real() * 0.5F);
+					out[k] = even + multiply(real_twiddles[k], odd);
+				}
+			}
+
+			// Merges the spectrum of the real sequence into that of the packed one
+			NNFORGE_PLAIN_FORCEINLINE void real_inverse_pre_body(
+				const complex * real_twiddles,
+				unsigned int size,
+				const complex * in,
+				complex * packed_transformed)
+			{
+				for(unsigned int k = 0; k < size; ++k)
+				{
+					complex x = in[k];
+					complex x_mirrored = std::conj(in[size - k]);
+					complex odd = multiply(std::conj(real_twiddles[k]), x - x_mirrored);
+					packed_transformed[k] = (x + x_mirrored) + complex(-odd.imag(), odd.real());
+				}
+			}
+
+			class kernel_table
+			{
+			public:
+				void (*transform)(const unsigned int *, const complex *, unsigned int, const complex *, complex *, unsigned int, unsigned int, unsigned int, unsigned int, bool);
+				void (*real_forward_post)(const complex *, unsigned int, const complex *, complex *);
+				void (*real_inverse_pre)(const complex *, unsigned int, const complex *, complex *);
+			};
+
+			// Defines kernels compiled with target_attribute and their table in namespace isa_namespace
+			// transform is the decimation in time recursion: each of radix interleaved subsequences is transformed, then combined
+#define NNFORGE_FFT_PLAIN_VARIANT(isa_namespace, target_attribute) \
+			namespace isa_namespace \
+			{ \
+				target_attribute void transform(const unsigned int * factors, const complex * tw, unsigned int size, const complex * in, complex * out, unsigned int in_stride, unsigned int current_size, unsigned int factor_id, unsigned int twiddle_stride, bool inverse) \
+				{ \
+					if (current_size == 1) \
+					{ \
+						out[0] = in[0]; \
+						return; \
+					} \
+					const unsigned int radix = factors[factor_id]; \
+					const unsigned int sub_size = current_size / radix; \
+					if (sub_size == 1) \
+					{ \
+						for(unsigned int r = 0; r < radix; ++r) \
+							out[r] = in[r * in_stride]; \
+					} \
+					else \
+					{ \
+						for(unsigned int r = 0; r < radix; ++r) \
+							transform(factors, tw, size, in + r * in_stride, out + r * sub_size, in_stride * radix, sub_size, factor_id + 1, twiddle_stride * radix, inverse); \
+					} \
+					butterfly_body(tw, size, out, radix, sub_size, twiddle_stride, inverse); \
+				} \
+				target_attribute void real_forward_post(const complex * real_twiddles, unsigned int size, const complex * packed_transformed, complex * out) \
+				{ \
+					real_forward_post_body(real_twiddles, size, packed_transformed, out); \
+				} \
+				target_attribute void real_inverse_pre(const complex * real_twiddles, unsigned int size, const complex * in, complex * packed_transformed) \
+				{ \
+					real_inverse_pre_body(real_twiddles, size, in, packed_transformed); \
+				} \
+				const kernel_table table = { \
+					transform, \
+					real_forward_post, \
+					real_inverse_pre}; \
+			}
+
+			NNFORGE_PLAIN_FOR_EACH_ISA(NNFORGE_FFT_PLAIN_VARIANT)
+
+#undef NNFORGE_FFT_PLAIN_VARIANT
+
+			const kernel_table& get_kernel_table(cpu_dispatch_plain::isa isa)
+			{
+				return NNFORGE_PLAIN_SELECT_ISA(isa, table);
+			}
+		}
+
+		fft_plain::fft_plain(
+			unsigned int size,
+			cpu_dispatch_plain::isa isa)
+			: size(size)
+			, isa(isa)
+		{
+			if (!is_supported_size(size))
+				throw neural_network_exception((boost::format("fft_plain cannot handle size %1%") % size).str());
+
+			unsigned int remaining_size = size;
+			while (remaining_size % 4 == 0)
+			{
+				factors.push_back(4);
+				remaining_size /= 4;
+			}
+			const unsigned int radix_list[] = {2, 3, 5};
+			for(unsigned int i = 0; i < sizeof(radix_list) / sizeof(radix_list[0]); ++i)
+			{
+				while (remaining_size % radix_list[i] == 0)
+				{
+					factors.push_back(radix_list[i]);
+					remaining_size /= radix_list[i];
+				}
+			}
+			// Never read as the recursion stops at size 1, keeps the list non-empty for the plan of size 1
+			factors.push_back(1);
+
+			const double pi = 3.14159265358979323846;
+			twiddles.resize(size);
+			for(unsigned int i = 0; i < size; ++i)
+			{
+				double angle = -2.0 * pi * static_cast<double>(i) / static_cast<double>(size);
+				twiddles[i] = complex(static_cast<float>(cos(angle)), static_cast<float>(sin(angle)));
+			}
+			real_twiddles.resize(size + 1);
+			for(unsigned int i = 0; i <= size; ++i)
+			{
+				double angle = -pi * static_cast<double>(i) / static_cast<double>(size);
+				real_twiddles[i] = complex(static_cast<float>(cos(angle)), static_cast<float>(sin(angle)));
+			}
+		}
+
+		fft_plain::~fft_plain()
+		{
+		}
+
+		unsigned int fft_plain::get_size() const
+		{
+			return size;
+		}
+
+		bool fft_plain::is_supported_size(unsigned int size)
+		{
+			if (size == 0)
+				return false;
+
+			const unsigned int radix_list[] = {2, 3, 5};
+			for(unsigned int i = 0; i < sizeof(radix_list) / sizeof(radix_list[0]); ++i)
+				while (size % radix_list[i] == 0)
+					size /= radix_list[i];
+
+			return (size == 1);
+		}
+
+		unsigned int fft_plain::get_supported_size(unsigned int size)
+		{
+			unsigned int res = std::max(size, 1U);
+			while (!is_supported_size(res))
+				++res;
+			return res;
+		}
+
+		void fft_plain::transform(
+			const complex * in,
+			complex * out,
+			bool inverse) const
+		{
+			get_kernel_table(isa).transform(&factors[0], &twiddles[0], size, in, out, 1, size, 0, 1, inverse);
+		}
+
+		void fft_plain::transform_real_forward(
+			const float * in,
+			complex * out,
+			complex * scratch) const
+		{
+			// Even and odd samples are packed into real and imaginary parts of the half size complex sequence
+			complex * packed = scratch;
+			complex * packed_transformed = scratch + size;
+			for(unsigned int i = 0; i < size; ++i)
+				packed[i] = complex(in[i * 2], in[i * 2 + 1]);
+
+			const kernel_table& kernels = get_kernel_table(isa);
+			kernels.transform(&factors[0], &twiddles[0], size, packed, packed_transformed, 1, size, 0, 1, false);
+			kernels.real_forward_post(&real_twiddles[0], size, packed_transformed, out);
+		}
+
+		void fft_plain::transform_real_inverse(
+			const complex * in,
+			float * out,
+			complex * scratch) const
+		{
+			complex * packed = scratch;
+			complex * packed_transformed = scratch + size;
+			const kernel_table& kernels = get_kernel_table(isa);
+			kernels.real_inverse_pre(&real_twiddles[0], size, in, packed_transformed);
+			kernels.transform(&factors[0], &twiddles[0], size, packed_transformed, packed, 1, size, 0, 1, true);
+
+			for(unsigned int i = 0; i < size; ++i)
+			{
+				out[i * 2] = packed[i].real();
+				out[i * 2 + 1] = packed[i].imag();
+			}
+		}
+	}
+}
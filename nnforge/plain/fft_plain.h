@@ -0,0 +1,77 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "cpu_dispatch_plain.h"
+
+#include <vector>
+#include <complex>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Mixed radix (2, 3, 4, 5) complex FFT plan, transforms are not normalized
+		// The same plan of size n also runs the real input transform of size 2 * n
+		// Passes are run with the variant for the instruction set the plan is created for
+		class fft_plain
+		{
+		public:
+			typedef std::complex<float> complex;
+
+			fft_plain(
+				unsigned int size,
+				cpu_dispatch_plain::isa isa);
+
+			~fft_plain();
+
+			unsigned int get_size() const;
+
+			// in and out should not overlap
+			void transform(
+				const complex * in,
+				complex * out,
+				bool inverse) const;
+
+			// Real transform of size 2 * get_size(), out receives get_size() + 1 elements
+			// scratch should hold 2 * get_size() elements
+			void transform_real_forward(
+				const float * in,
+				complex * out,
+				complex * scratch) const;
+
+			// Inverse of transform_real_forward, in holds get_size() + 1 elements and is not modified
+			// scratch should hold 2 * get_size() elements
+			void transform_real_inverse(
+				const complex * in,
+				float * out,
+				complex * scratch) const;
+
+			static bool is_supported_size(unsigned int size);
+
+			// Returns the smallest supported size which is not less than size
+			static unsigned int get_supported_size(unsigned int size);
+
+		private:
+			unsigned int size;
+			cpu_dispatch_plain::isa isa;
+			std::vector<unsigned int> factors;
+			std::vector<complex> twiddles;
+			std::vector<complex> real_twiddles;
+		};
+	}
+}
@@ -17,12 +17,25 @@
 #include "forward_propagation_plain.h"
 
 #include "layer_tester_plain_factory.h"
+#include "auto_tuner_plain.h"
+#include "channel_blocked_layout_plain.h"
+#include "chunk_pipeline_plain.h"
+#include "numa_plain.h"
+#include "softmax_negative_log_likelihood_layer_tester_plain.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/chrono.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <cstring>
+#include <algorithm>
 
 #include "../neural_network_exception.h"
+#include "../softmax_layer.h"
+#include "../negative_log_likelihood_layer.h"
 
 namespace nnforge
 {
@@ -38,38 +51,82 @@ namespace nnforge
 			plain_running_configuration::const_ptr plain_config)
 			: forward_propagation(schema, output_layer_names, debug, profile)
 			, plain_config(plain_config)
+			, tuning_entry_count(0)
 			, max_entry_count(0)
 			, temporary_working_fixed_size(0)
+			, channel_reorder_per_entry_size(0)
+			, branch_worker_count(1)
+			, numa_node_count(1)
+			, arena(plain_config->huge_pages)
 		{
 			actions_in_execution_order = action_schema->get_actions_in_execution_order();
 
-			// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
-			network_action_schema::ptr sequential_action_schema(new network_action_schema());
+			setup_fused_softmax_loss_layers();
+
+			if (plain_config->numa_weight_replicas && (plain_config->get_numa_node_count() > 1) && (plain_config->openmp_thread_count > 1))
 			{
-				std::vector<layer_name_with_action> dependencies;
-				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				numa_node_count = std::min(plain_config->get_numa_node_count(), static_cast<unsigned int>(plain_config->openmp_thread_count));
+				numa_node_plain_config = plain_config->get_thread_group_configuration(plain_config->openmp_thread_count / static_cast<int>(numa_node_count));
+				// OpenMP threads of the workers are started after the binding and inherit it
+				numa_node_workers = worker_pool_plain::ptr(new worker_pool_plain(numa_node_count, false));
+				numa_node_binding_task binding_task(*this);
+				numa_node_workers->run(binding_task);
+				if (debug->is_debug())
+					debug->output_message((boost::format("forward prop plain NUMA nodes: %1%, threads per node: %2%") % numa_node_count % numa_node_plain_config->openmp_thread_count).str().c_str());
+			}
+			else if (plain_config->max_concurrent_branch_count > 1)
+			{
+				// Each stream is a chain of actions, there is no point in having more workers than streams
+				std::vector<std::vector<layer_name_with_action> > action_stream_set = action_schema->get_action_stream_set();
+				branch_worker_count = std::min(plain_config->max_concurrent_branch_count, static_cast<unsigned int>(action_stream_set.size()));
+				branch_worker_count = std::min(branch_worker_count, static_cast<unsigned int>(std::max(plain_config->openmp_thread_count, 1)));
+
+				if (debug->is_debug())
 				{
-					sequential_action_schema->add_action(
-						this->schema->get_layer(it->get_name()),
-						it->get_action(),
-						dependencies);
-					dependencies.clear();
-					dependencies.push_back(*it);
+					std::map<layer_name_with_action, unsigned int> action_to_stream_set_map;
+					for(unsigned int stream_set_id = 0; stream_set_id < static_cast<unsigned int>(action_stream_set.size()); ++stream_set_id)
+						for(std::vector<layer_name_with_action>::const_iterator it = action_stream_set[stream_set_id].begin(); it != action_stream_set[stream_set_id].end(); ++it)
+							action_to_stream_set_map.insert(std::make_pair(*it, stream_set_id));
+					debug->output_message((boost::format("forward prop plain streams: %1%, concurrent branches: %2%") % action_stream_set.size() % branch_worker_count).str().c_str());
+					boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_streams", "gv"), std::ios_base::out | std::ios_base::trunc);
+					action_schema->write_gv(out, action_to_stream_set_map);
 				}
 			}
-			action_schema = sequential_action_schema;
 
-			if (debug->is_debug())
+			if (branch_worker_count > 1)
 			{
-				boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
-				action_schema->write_gv(out);
+				// The real dependencies are kept, so the buffer planner keeps outputs of the branches running concurrently apart
+				branch_executor = branch_executor_plain(*action_schema, actions_in_execution_order);
+				branch_plain_config = plain_config->get_thread_group_configuration(std::max(plain_config->openmp_thread_count / static_cast<int>(branch_worker_count), 1));
+				// Branches run as tasks of the work stealing scheduler when there is one, the pool is for OpenMP threads to start teams from;
+				// it is started before any thread binding is done, so the workers are not pinned to the CPU of the calling thread
+				if (!plain_config->scheduler)
+					branch_workers = worker_pool_plain::ptr(new worker_pool_plain(branch_worker_count));
 			}
+			else
+			{
+				// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
+				network_action_schema::ptr sequential_action_schema(new network_action_schema());
+				{
+					std::vector<layer_name_with_action> dependencies;
+					for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+					{
+						sequential_action_schema->add_action(
+							get_layer(it->get_name()),
+							it->get_action(),
+							dependencies);
+						dependencies.clear();
+						dependencies.push_back(*it);
+					}
+				}
+				action_schema = sequential_action_schema;
 
-			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
-				testers.insert(
-					std::make_pair(
-						it->get_name(),
-						layer_tester_plain_factory::singleton::get_const_instance().get_tester_plain_layer(this->schema->get_layer(it->get_name())->get_type_name())));
+				if (debug->is_debug())
+				{
+					boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
+					action_schema->write_gv(out);
+				}
+			}
 		}
 
 		forward_propagation_plain::~forward_propagation_plain()
@@ -79,11 +136,20 @@ namespace nnforge
 		void forward_propagation_plain::actual_set_data(network_data::const_ptr data)
 		{
 			net_data = data;
+
+			if (!layer_config_map.empty())
+				update_tester_data();
 		}
 
 		void forward_propagation_plain::actual_clear_data()
 		{
 			net_data.reset();
+			tester_data_map.clear();
+			for(std::vector<step>::iterator it = steps.begin(); it != steps.end(); ++it)
+			{
+				it->data.clear();
+				it->data_custom.clear();
+			}
 		}
 
 		void forward_propagation_plain::actual_run(
@@ -97,120 +163,823 @@ namespace nnforge
 			if (reader_entry_count > 0)
 				current_max_entry_count = std::min(current_max_entry_count, static_cast<unsigned int>(reader_entry_count));
 			current_max_entry_count = std::min(current_max_entry_count, max_max_entry_count);
-			const int current_max_entry_count_const = static_cast<int>(current_max_entry_count);
 
+			// Algorithms are tuned for the part of the chunk each NUMA node runs, the setup is redone when it falls into another bucket
+			if (plain_config->tuning && plain_config->tuning->is_tuning())
+			{
+				unsigned int new_tuning_entry_count = auto_tuner_plain::get_tuning_entry_count((current_max_entry_count + numa_node_count - 1) / numa_node_count);
+				if (new_tuning_entry_count != tuning_entry_count)
+				{
+					tuning_entry_count = new_tuning_entry_count;
+					layer_config_map_modified();
+					current_max_entry_count = std::min(current_max_entry_count, max_entry_count);
+				}
+			}
+
+			// Each NUMA node gets its own set of layer buffers sized for its part of the chunk
+			const unsigned int node_max_entry_count = (current_max_entry_count + numa_node_count - 1) / numa_node_count;
+			const unsigned int worker_count = std::max(branch_worker_count, numa_node_count);
+
+			bool new_arena_block;
+			{
+				size_t arena_size = chunk_pipeline_plain::get_arena_size(dedicated_per_entry_data_name_to_size_map, current_max_entry_count);
+				if (temporary_working_fixed_size > 0)
+					arena_size += buffer_arena_plain::get_aligned_size(temporary_working_fixed_size) * worker_count;
+				arena_size += buffer_arena_plain::get_slots_size(layer_buffer_set_per_entry_size_list, layer_buffer_set_per_entry_offset_list, layer_buffers_per_entry_size, node_max_entry_count) * numa_node_count;
+				if (channel_reorder_per_entry_size > 0)
+					arena_size += buffer_arena_plain::get_aligned_size(channel_reorder_per_entry_size * node_max_entry_count) * numa_node_count;
+				new_arena_block = arena.begin_run(arena_size);
+			}
+
+			// Dedicated buffers are owned by the pipeline, the map is updated for each chunk
 			std::map<std::string, plain_buffer::ptr> dedicated_buffers;
-			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
-				dedicated_buffers.insert(std::make_pair(it->first, plain_buffer::ptr(new plain_buffer(it->second * current_max_entry_count))));
+			chunk_pipeline_plain pipeline(
+				reader,
+				writer,
+				dedicated_per_entry_data_name_to_size_map,
+				data_layer_names,
+				output_layer_names,
+				output_layers_tiling_factor,
+				std::vector<unsigned int>(1, current_max_entry_count),
+				plain_config->reader_thread_count,
+				arena);
+
+			// Compute threads are bound once the reader and the writer are started, so these keep the CPUs of the caller
+			thread_binding_guard_plain caller_binding_guard;
+			plain_config->bind_openmp_threads();
 
-			plain_buffer::ptr temporary_working_fixed_buffer;
+			// Actions running concurrently cannot share the fixed buffer, each worker gets its own one
+			std::vector<plain_buffer::ptr> temporary_working_fixed_buffers(worker_count);
 			if (temporary_working_fixed_size > 0)
-				temporary_working_fixed_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_size));
+				for(std::vector<plain_buffer::ptr>::iterator it = temporary_working_fixed_buffers.begin(); it != temporary_working_fixed_buffers.end(); ++it)
+					*it = arena.allocate(temporary_working_fixed_size);
+
+			// Layer buffers are followed by dedicated ones, the latter are updated for each chunk
+			std::vector<std::vector<plain_buffer::ptr> > node_buffer_slots_list(numa_node_count);
+			std::vector<plain_buffer::ptr> node_reorder_buffers(numa_node_count);
+			for(unsigned int node_id = 0; node_id < numa_node_count; ++node_id)
+			{
+				std::vector<plain_buffer::ptr>& buffer_slots = node_buffer_slots_list[node_id];
+				buffer_slots = arena.allocate_slots(layer_buffer_set_per_entry_size_list, layer_buffer_set_per_entry_offset_list, layer_buffers_per_entry_size, node_max_entry_count);
+				buffer_slots.resize(layer_buffer_set_per_entry_size_list.size() + dedicated_per_entry_data_name_to_size_map.size());
+
+				if (channel_reorder_per_entry_size > 0)
+					node_reorder_buffers[node_id] = arena.allocate(channel_reorder_per_entry_size * node_max_entry_count);
+			}
+			std::vector<plain_buffer::ptr>& buffer_slots = node_buffer_slots_list.front();
+			plain_buffer::ptr reorder_buffer = node_reorder_buffers.front();
+
+			// Pages are placed on the nodes of the threads which will work on them, the threads of each node touch its own buffers
+			const bool first_touch = new_arena_block && plain_config->is_first_touch_required();
+			if (first_touch && (numa_node_count == 1))
+				for(unsigned int slot_id = 0; slot_id < static_cast<unsigned int>(layer_buffer_set_per_entry_size_list.size()); ++slot_id)
+					numa_plain::first_touch(*buffer_slots[slot_id], buffer_slots[slot_id]->get_size(), plain_config->openmp_thread_count);
+
+			std::vector<size_t> dedicated_per_entry_size_list;
+			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
+				dedicated_per_entry_size_list.push_back(it->second);
 
-			std::vector<plain_buffer::ptr> layer_buffers;
-			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
-				layer_buffers.push_back(plain_buffer::ptr(new plain_buffer(*it * current_max_entry_count)));
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "forward prop plain buffer arena: " << ((arena.get_size() + 1024 - 1) / 1024) << " KB, high-water mark " << ((arena.get_high_water_mark() + 1024 - 1) / 1024) << " KB";
+				debug->output_message(debug_str.str().c_str());
+			}
+
+			// Accumulated over all the chunks for each node, empty when not profiling
+			std::vector<std::vector<double> > node_step_seconds_list(numa_node_count);
+			if (profile->is_profile())
+				for(std::vector<std::vector<double> >::iterator it = node_step_seconds_list.begin(); it != node_step_seconds_list.end(); ++it)
+					it->resize(steps.size(), 0.0);
+			std::vector<double>& step_seconds = node_step_seconds_list.front();
 
 			unsigned int entry_processed_count = 0;
 
-			while(true)
+			unsigned int entry_read_count;
+			bool first_chunk = true;
+			while(pipeline.get_next_chunk(dedicated_buffers, entry_read_count))
 			{
-				int entry_read_count = 0;
-				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count) reduction(+:entry_read_count)
+				if (numa_node_count > 1)
 				{
-					#pragma omp for schedule(dynamic)
-					for(int entry_id = 0; entry_id < current_max_entry_count_const; ++entry_id)
+					// Each node gets a contiguous range of entries, its dedicated slots point to the range of the chunk buffers
+					std::vector<nnforge_shared_ptr<numa_node_task> > tasks(numa_node_count);
+					for(unsigned int node_id = 0; node_id < numa_node_count; ++node_id)
 					{
-						std::map<std::string, float *> data_map;
-						for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
-							data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float))));
-						if (reader.read(entry_processed_count + entry_id, data_map))
-							++entry_read_count;
+						const unsigned int entry_start = static_cast<unsigned int>(static_cast<size_t>(entry_read_count) * node_id / numa_node_count);
+						const unsigned int entry_end = static_cast<unsigned int>(static_cast<size_t>(entry_read_count) * (node_id + 1) / numa_node_count);
+						std::vector<plain_buffer::ptr>& node_buffer_slots = node_buffer_slots_list[node_id];
+						std::vector<plain_buffer::ptr>::iterator slot_it = node_buffer_slots.begin() + layer_buffer_set_per_entry_size_list.size();
+						std::vector<size_t>::const_iterator size_it = dedicated_per_entry_size_list.begin();
+						for(std::map<std::string, plain_buffer::ptr>::const_iterator it = dedicated_buffers.begin(); it != dedicated_buffers.end(); ++it, ++slot_it, ++size_it)
+							*slot_it = plain_buffer::ptr(new plain_buffer(static_cast<unsigned char *>(*it->second) + *size_it * entry_start, *size_it * (entry_end - entry_start), it->second));
+
+						// Nodes left without entries still touch their buffers on the first chunk
+						if ((entry_end == entry_start) && !(first_chunk && first_touch))
+							continue;
+
+						tasks[node_id] = nnforge_shared_ptr<numa_node_task>(new numa_node_task(
+							*this,
+							node_id,
+							node_buffer_slots,
+							temporary_working_fixed_buffers[node_id],
+							node_reorder_buffers[node_id],
+							entry_end - entry_start,
+							first_chunk && first_touch,
+							node_step_seconds_list[node_id].empty() ? 0 : &node_step_seconds_list[node_id]));
 					}
-				}
-				if (entry_read_count == 0)
-					break;
+					numa_node_chunk_task chunk_task(tasks);
+					numa_node_workers->run(chunk_task);
 
-				for(std::vector<layer_name_with_action>::const_iterator action_it = actions_in_execution_order.begin(); action_it  != actions_in_execution_order.end(); ++action_it)
+					for(std::vector<nnforge_shared_ptr<numa_node_task> >::const_iterator it = tasks.begin(); it != tasks.end(); ++it)
+						if (*it && !(*it)->error_message.empty())
+							throw neural_network_exception((boost::format("Forward prop on NUMA node failed: %1%") % (*it)->error_message).str());
+				}
+				else
 				{
-					const layer_name_with_action& current_layer_name_with_action = *action_it;
-					std::string layer_name = current_layer_name_with_action.get_name();;
-					layer_action action = current_layer_name_with_action.get_action();
-					layer::const_ptr current_layer = schema->find_layer(layer_name);
-
-					plain_buffer::ptr output_buffer;
 					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(current_layer_name_with_action);
-						if (it != layer_buffer_action_to_set_map.end())
-							output_buffer = layer_buffers[it->second];
-						else
-							output_buffer = dedicated_buffers.find(layer_name)->second;
+						// Both dedicated buffers and slots are ordered by layer name
+						std::vector<plain_buffer::ptr>::iterator slot_it = buffer_slots.begin() + layer_buffer_set_per_entry_size_list.size();
+						for(std::map<std::string, plain_buffer::ptr>::const_iterator it = dedicated_buffers.begin(); it != dedicated_buffers.end(); ++it, ++slot_it)
+							*slot_it = it->second;
 					}
 
-					std::vector<plain_buffer::const_ptr> input_buffers;
-					for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it)
+					if (branch_worker_count > 1)
 					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
-						if (it != layer_buffer_action_to_set_map.end())
-							input_buffers.push_back(layer_buffers[it->second]);
+						branch_action_runner runner(*this, buffer_slots, temporary_working_fixed_buffers, reorder_buffer, entry_read_count, step_seconds.empty() ? 0 : &step_seconds);
+						if (branch_workers)
+							branch_executor.run(runner, *branch_workers);
 						else
-							input_buffers.push_back(dedicated_buffers.find(*input_layer_name_it)->second);
+							branch_executor.run(runner, *plain_config->scheduler, branch_worker_count);
 					}
-
-					plain_buffer::ptr temporary_working_per_entry_buffer;
+					else
 					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_working_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
-						if (it != temporary_working_per_entry_data_action_to_set_map.end())
-							temporary_working_per_entry_buffer = layer_buffers[it->second];
+						for(unsigned int step_id = 0; step_id < static_cast<unsigned int>(steps.size()); ++step_id)
+							run_step(steps[step_id], buffer_slots, temporary_working_fixed_buffers.front(), reorder_buffer, entry_read_count, false, 0, step_seconds.empty() ? 0 : &step_seconds[step_id]);
 					}
 
-					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
-					for(std::vector<std::string>::const_iterator it2 = current_layer->input_layer_instance_names.begin(); it2 != current_layer->input_layer_instance_names.end(); ++it2)
-						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
-
-					testers.find(layer_name)->second->run_forward_propagation(
-						output_buffer,
-						input_buffers,
-						temporary_working_fixed_buffer,
-						temporary_working_per_entry_buffer,
-						plain_config,
-						current_layer,
-						net_data->data_list.find(layer_name),
-						net_data->data_custom_list.find(layer_name),
-						input_layer_configuration_specific_list,
-						layer_config_map[layer_name],
-						entry_read_count * cumulative_tiling_factor_map[layer_name]);
+					run_channel_reorders(output_channel_reorders, buffer_slots, reorder_buffer, entry_read_count, plain_config->openmp_thread_count);
 				}
 
-				for(int entry_id = 0; entry_id < entry_read_count * static_cast<int>(output_layers_tiling_factor); ++entry_id)
-				{
-					std::map<std::string, const float *> data_map;
-					for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
-						data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float) / output_layers_tiling_factor)));
-					writer.write(entry_processed_count + entry_id, data_map);
-				}
+				pipeline.write_chunk();
 
 				entry_processed_count += entry_read_count;
-
-				if (entry_read_count < current_max_entry_count_const)
-					break;
+				first_chunk = false;
 			}
+			pipeline.finish();
 
 			entries_processed = entry_processed_count;
 			action_seconds.clear();
+			if (!step_seconds.empty())
+			{
+				// Nodes run concurrently, the slowest one is reported
+				for(unsigned int step_id = 0; step_id < static_cast<unsigned int>(steps.size()); ++step_id)
+				{
+					double seconds = 0.0;
+					for(std::vector<std::vector<double> >::const_iterator it = node_step_seconds_list.begin(); it != node_step_seconds_list.end(); ++it)
+						seconds = std::max(seconds, (*it)[step_id]);
+					action_seconds.insert(std::make_pair(actions_in_execution_order[step_id], static_cast<float>(seconds)));
+				}
+				// Reading and writing overlap with compute
+				action_seconds.insert(std::make_pair(layer_name_with_action(chunk_pipeline_plain::reader_pseudo_layer_name, layer_action::forward), static_cast<float>(pipeline.get_read_seconds())));
+				action_seconds.insert(std::make_pair(layer_name_with_action(chunk_pipeline_plain::writer_pseudo_layer_name, layer_action::forward), static_cast<float>(pipeline.get_write_seconds())));
+			}
+		}
+
+		float forward_propagation_plain::get_max_flops() const
+		{
+			return plain_config->get_flops();
+		}
+
+		forward_propagation_plain::branch_action_runner::branch_action_runner(
+			const forward_propagation_plain& prop,
+			const std::vector<plain_buffer::ptr>& buffer_slots,
+			const std::vector<plain_buffer::ptr>& temporary_working_fixed_buffers,
+			plain_buffer::ptr reorder_buffer,
+			unsigned int entry_count,
+			std::vector<double> * step_seconds)
+			: prop(prop)
+			, buffer_slots(buffer_slots)
+			, temporary_working_fixed_buffers(temporary_working_fixed_buffers)
+			, reorder_buffer(reorder_buffer)
+			, entry_count(entry_count)
+			, step_seconds(step_seconds)
+		{
+		}
+
+		void forward_propagation_plain::branch_action_runner::run_action(
+			unsigned int action_id,
+			unsigned int worker_id)
+		{
+			prop.run_step(
+				prop.steps[action_id],
+				buffer_slots,
+				temporary_working_fixed_buffers[worker_id],
+				reorder_buffer,
+				entry_count,
+				true,
+				0,
+				step_seconds ? &(*step_seconds)[action_id] : 0);
+		}
+
+		forward_propagation_plain::numa_node_task::numa_node_task(
+			const forward_propagation_plain& prop,
+			unsigned int numa_node_id,
+			const std::vector<plain_buffer::ptr>& buffer_slots,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr reorder_buffer,
+			unsigned int entry_count,
+			bool first_touch,
+			std::vector<double> * step_seconds)
+			: prop(prop)
+			, numa_node_id(numa_node_id)
+			, buffer_slots(buffer_slots)
+			, temporary_working_fixed_buffer(temporary_working_fixed_buffer)
+			, reorder_buffer(reorder_buffer)
+			, entry_count(entry_count)
+			, first_touch(first_touch)
+			, step_seconds(step_seconds)
+		{
+		}
+
+		void forward_propagation_plain::numa_node_task::operator()()
+		{
+			try
+			{
+				const int thread_count = prop.numa_node_plain_config->openmp_thread_count;
+				if (first_touch)
+					for(unsigned int slot_id = 0; slot_id < static_cast<unsigned int>(prop.layer_buffer_set_per_entry_size_list.size()); ++slot_id)
+						numa_plain::first_touch(*buffer_slots[slot_id], buffer_slots[slot_id]->get_size(), thread_count);
+
+				if (entry_count == 0)
+					return;
+
+				for(unsigned int step_id = 0; step_id < static_cast<unsigned int>(prop.steps.size()); ++step_id)
+					prop.run_step(prop.steps[step_id], buffer_slots, temporary_working_fixed_buffer, reorder_buffer, entry_count, true, numa_node_id, step_seconds ? &(*step_seconds)[step_id] : 0);
+
+				prop.run_channel_reorders(prop.output_channel_reorders, buffer_slots, reorder_buffer, entry_count, thread_count);
+			}
+			catch (const std::exception& e)
+			{
+				error_message = e.what();
+				if (error_message.empty())
+					error_message = "unknown error";
+			}
+		}
+
+		forward_propagation_plain::numa_node_binding_task::numa_node_binding_task(const forward_propagation_plain& prop)
+			: prop(prop)
+		{
+		}
+
+		void forward_propagation_plain::numa_node_binding_task::run(unsigned int worker_id)
+		{
+			prop.plain_config->bind_current_thread_to_numa_node(worker_id);
+			prop.numa_node_plain_config->bind_openmp_threads(worker_id);
+		}
+
+		forward_propagation_plain::numa_node_chunk_task::numa_node_chunk_task(const std::vector<nnforge_shared_ptr<numa_node_task> >& node_tasks)
+			: node_tasks(node_tasks)
+		{
+		}
+
+		void forward_propagation_plain::numa_node_chunk_task::run(unsigned int worker_id)
+		{
+			if (node_tasks[worker_id])
+				(*node_tasks[worker_id])();
+		}
+
+		void forward_propagation_plain::run_step(
+			const step& current_step,
+			const std::vector<plain_buffer::ptr>& buffer_slots,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr reorder_buffer,
+			unsigned int entry_count,
+			bool thread_group,
+			unsigned int replica_id,
+			double * seconds) const
+		{
+			const plain_running_configuration::const_ptr& step_plain_config = thread_group ? current_step.thread_group_plain_config : current_step.plain_config;
+
+			boost::chrono::steady_clock::time_point start;
+			if (seconds)
+				start = boost::chrono::high_resolution_clock::now();
+
+			if (!current_step.reorders.empty())
+				run_channel_reorders(current_step.reorders, buffer_slots, reorder_buffer, entry_count, step_plain_config->openmp_thread_count);
+
+			std::vector<plain_buffer::const_ptr> input_buffers(current_step.input_buffer_slots.size());
+			for(unsigned int i = 0; i < static_cast<unsigned int>(input_buffers.size()); ++i)
+				input_buffers[i] = buffer_slots[current_step.input_buffer_slots[i]];
+
+			plain_buffer::ptr temporary_working_per_entry_buffer;
+			if (current_step.temporary_working_per_entry_buffer_slot >= 0)
+				temporary_working_per_entry_buffer = buffer_slots[current_step.temporary_working_per_entry_buffer_slot];
+
+			if (current_step.channel_blocked)
+				current_step.tester->run_forward_propagation_channel_blocked(
+					buffer_slots[current_step.output_buffer_slot],
+					input_buffers,
+					temporary_working_fixed_buffer,
+					temporary_working_per_entry_buffer,
+					step_plain_config,
+					current_step.layer_schema,
+					current_step.data[replica_id],
+					current_step.data_custom[replica_id],
+					current_step.input_configuration_specific_list,
+					current_step.output_configuration_specific,
+					entry_count * current_step.tiling_factor);
+			else
+				current_step.tester->run_forward_propagation(
+					buffer_slots[current_step.output_buffer_slot],
+					input_buffers,
+					temporary_working_fixed_buffer,
+					temporary_working_per_entry_buffer,
+					step_plain_config,
+					current_step.layer_schema,
+					current_step.data[replica_id],
+					current_step.data_custom[replica_id],
+					current_step.input_configuration_specific_list,
+					current_step.output_configuration_specific,
+					entry_count * current_step.tiling_factor);
+
+			if (seconds)
+			{
+				boost::chrono::duration<double> sec = boost::chrono::high_resolution_clock::now() - start;
+				*seconds += sec.count();
+			}
 		}
 
 		void forward_propagation_plain::layer_config_map_modified()
 		{
+			// Buffer plan is about to change
+			arena.release();
+
+			setup_testers();
+
+			setup_channel_layouts();
+
 			setup_dedicated_buffer_sizes();
 
 			setup_layer_buffer_sizes();
 
 			setup_temporary_working_fixed_buffer_sizes();
 
+			setup_steps();
+
+			update_tester_data();
+
 			update_max_entry_count();
 		}
 
+		void forward_propagation_plain::setup_testers()
+		{
+			// Testers are chosen once layer configurations are known, specialized ones depend on them
+			testers.clear();
+			tester_plain_config_map.clear();
+			bool decisions_made = false;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				layer::const_ptr l = get_layer(it->get_name());
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+				if (fused_softmax_loss_layer_map.find(it->get_name()) != fused_softmax_loss_layer_map.end())
+					testers.insert(std::make_pair(it->get_name(), layer_tester_plain::const_ptr(new softmax_negative_log_likelihood_layer_tester_plain())));
+				else
+					testers.insert(
+						std::make_pair(
+							it->get_name(),
+							layer_tester_plain_factory::singleton::get_const_instance().get_tester_plain_layer(
+								plain_config,
+								l,
+								input_layer_configuration_specific_list,
+								layer_config_map[it->get_name()])));
+
+				// Algorithm decisions should be made before layouts and buffer sizes are set up
+				decisions_made = auto_tuner_plain::tune_tester(
+					plain_config,
+					testers[it->get_name()],
+					l,
+					input_layer_configuration_specific_list,
+					layer_config_map[it->get_name()],
+					tuning_entry_count,
+					debug) || decisions_made;
+
+				// The decision is looked up once, the tester reads it from the configuration it is called with
+				std::string algorithm = auto_tuner_plain::get_tester_algorithm(
+					plain_config,
+					l,
+					input_layer_configuration_specific_list,
+					layer_config_map[it->get_name()],
+					tuning_entry_count);
+				tester_plain_config_map.insert(std::make_pair(it->get_name(), algorithm.empty() ? plain_config : plain_config->get_algorithm_configuration(algorithm)));
+			}
+
+			// The cache file is rewritten once for all the decisions made
+			if (decisions_made)
+				plain_config->tuning->save();
+		}
+
+		void forward_propagation_plain::setup_fused_softmax_loss_layers()
+		{
+			fused_softmax_loss_layer_map.clear();
+
+			std::map<std::string, unsigned int> layer_name_to_consumer_count_map;
+			{
+				std::vector<layer::const_ptr> layer_list = schema->get_layers();
+				for(std::vector<layer::const_ptr>::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it)
+					for(std::vector<std::string>::const_iterator it2 = (*it)->input_layer_instance_names.begin(); it2 != (*it)->input_layer_instance_names.end(); ++it2)
+						++layer_name_to_consumer_count_map[*it2];
+			}
+
+			std::set<layer_name_with_action> fused_softmax_actions;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				layer::const_ptr l = schema->get_layer(it->get_name());
+				if (l->get_type_name() != negative_log_likelihood_layer::layer_type_name)
+					continue;
+				const std::string& softmax_layer_name = l->input_layer_instance_names[0];
+				if (data_layer_names.find(softmax_layer_name) != data_layer_names.end())
+					continue;
+				layer::const_ptr softmax_l = schema->get_layer(softmax_layer_name);
+				if (softmax_l->get_type_name() != softmax_layer::layer_type_name)
+					continue;
+				// Output of the softmax layer is used by the loss layer only
+				if (layer_name_to_consumer_count_map[softmax_layer_name] != 1)
+					continue;
+				if (std::find(output_layer_names.begin(), output_layer_names.end(), softmax_layer_name) != output_layer_names.end())
+					continue;
+
+				layer::ptr fused_l = l->clone();
+				fused_l->input_layer_instance_names[0] = softmax_l->input_layer_instance_names[0];
+				fused_softmax_loss_layer_map.insert(std::make_pair(l->instance_name, layer::const_ptr(fused_l)));
+				fused_softmax_actions.insert(layer_name_with_action(softmax_layer_name, layer_action::forward));
+
+				if (debug->is_debug())
+				{
+					std::stringstream debug_str;
+					debug_str << "forward prop plain fuses " << softmax_layer_name << " into " << l->instance_name;
+					debug->output_message(debug_str.str().c_str());
+				}
+			}
+
+			if (fused_softmax_actions.empty())
+				return;
+
+			// The softmax actions are dropped, the loss actions depend on what they depended on
+			network_action_schema::ptr fused_action_schema(new network_action_schema());
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				if (fused_softmax_actions.find(*it) != fused_softmax_actions.end())
+					continue;
+
+				std::vector<layer_name_with_action> dependencies;
+				std::vector<layer_name_with_action> original_dependencies = action_schema->get_dependencies(*it);
+				for(std::vector<layer_name_with_action>::const_iterator it2 = original_dependencies.begin(); it2 != original_dependencies.end(); ++it2)
+				{
+					std::vector<layer_name_with_action> current_dependencies(1, *it2);
+					if (fused_softmax_actions.find(*it2) != fused_softmax_actions.end())
+						current_dependencies = action_schema->get_dependencies(*it2);
+					for(std::vector<layer_name_with_action>::const_iterator it3 = current_dependencies.begin(); it3 != current_dependencies.end(); ++it3)
+						if (std::find(dependencies.begin(), dependencies.end(), *it3) == dependencies.end())
+							dependencies.push_back(*it3);
+				}
+
+				fused_action_schema->add_action(
+					get_layer(it->get_name()),
+					it->get_action(),
+					dependencies);
+			}
+			action_schema = fused_action_schema;
+			actions_in_execution_order = action_schema->get_actions_in_execution_order();
+		}
+
+		layer::const_ptr forward_propagation_plain::get_layer(const std::string& layer_name) const
+		{
+			std::map<std::string, layer::const_ptr>::const_iterator it = fused_softmax_loss_layer_map.find(layer_name);
+			if (it != fused_softmax_loss_layer_map.end())
+				return it->second;
+
+			return schema->get_layer(layer_name);
+		}
+
+		void forward_propagation_plain::setup_channel_layouts()
+		{
+			layer_channel_block_size_map.clear();
+			action_to_channel_reorder_list_map.clear();
+			output_channel_reorder_list.clear();
+			channel_reorder_per_entry_size = 0;
+
+			// Reorders convert layer outputs in place, which is safe with sequential execution only
+			const unsigned int block_size = (branch_worker_count > 1) ? 0 : plain_config->channel_block_size;
+
+			// Data layers are filled by the reader in plain layout, the layouts are tracked in execution order
+			std::map<std::string, unsigned int> current_block_size_map;
+			for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
+				current_block_size_map.insert(std::make_pair(*it, 0U));
+
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				const std::string& layer_name = it->get_name();
+				layer::const_ptr l = get_layer(layer_name);
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+				const layer_configuration_specific& output_layer_configuration_specific = layer_config_map[layer_name];
+
+				unsigned int layer_block_size = 0;
+				if (block_size > 0)
+				{
+					bool compatible = channel_blocked_layout_plain::is_compatible(output_layer_configuration_specific, block_size);
+					bool inputs_blocked = !l->input_layer_instance_names.empty();
+					for(unsigned int i = 0; i < static_cast<unsigned int>(l->input_layer_instance_names.size()); ++i)
+					{
+						compatible = compatible && channel_blocked_layout_plain::is_compatible(input_layer_configuration_specific_list[i], block_size);
+						inputs_blocked = inputs_blocked && (current_block_size_map[l->input_layer_instance_names[i]] == block_size);
+					}
+					layer_tester_plain::const_ptr tester = testers[layer_name];
+					if (compatible
+						&& (inputs_blocked || tester->is_channel_blocked_layout_preferred())
+						&& tester->is_channel_blocked_layout_supported(tester_plain_config_map[layer_name], l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+						layer_block_size = block_size;
+				}
+				layer_channel_block_size_map.insert(std::make_pair(layer_name, layer_block_size));
+
+				std::vector<std::pair<std::string, unsigned int> > reorder_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+				{
+					unsigned int& input_block_size = current_block_size_map[*it2];
+					if (input_block_size != layer_block_size)
+					{
+						reorder_list.push_back(std::make_pair(*it2, layer_block_size));
+						input_block_size = layer_block_size;
+					}
+				}
+				if (!reorder_list.empty())
+					action_to_channel_reorder_list_map.insert(std::make_pair(*it, reorder_list));
+
+				current_block_size_map[layer_name] = layer_block_size;
+			}
+
+			for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
+				if (current_block_size_map[*it] != 0)
+					output_channel_reorder_list.push_back(std::make_pair(*it, 0U));
+
+			std::set<std::string> reordered_layer_names;
+			for(std::map<layer_name_with_action, std::vector<std::pair<std::string, unsigned int> > >::const_iterator it = action_to_channel_reorder_list_map.begin(); it != action_to_channel_reorder_list_map.end(); ++it)
+				for(std::vector<std::pair<std::string, unsigned int> >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+					reordered_layer_names.insert(it2->first);
+			for(std::vector<std::pair<std::string, unsigned int> >::const_iterator it = output_channel_reorder_list.begin(); it != output_channel_reorder_list.end(); ++it)
+				reordered_layer_names.insert(it->first);
+			for(std::set<std::string>::const_iterator it = reordered_layer_names.begin(); it != reordered_layer_names.end(); ++it)
+				channel_reorder_per_entry_size = std::max(channel_reorder_per_entry_size, layer_config_map[*it].get_neuron_count() * cumulative_tiling_factor_map[*it] * sizeof(float));
+
+			if (debug->is_debug() && (block_size > 0))
+			{
+				std::stringstream debug_str;
+				debug_str << "forward prop plain channel blocked layout, block size " << block_size << ":";
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+					if (layer_channel_block_size_map[it->get_name()] > 0)
+						debug_str << " " << it->get_name();
+				debug->output_message(debug_str.str().c_str());
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				{
+					std::map<layer_name_with_action, std::vector<std::pair<std::string, unsigned int> > >::const_iterator it2 = action_to_channel_reorder_list_map.find(*it);
+					if (it2 == action_to_channel_reorder_list_map.end())
+						continue;
+					std::stringstream debug_str;
+					debug_str << " - before " << it->get_name() << " reorder";
+					for(std::vector<std::pair<std::string, unsigned int> >::const_iterator it3 = it2->second.begin(); it3 != it2->second.end(); ++it3)
+						debug_str << " " << it3->first << (it3->second > 0 ? " to blocked" : " to plain");
+					debug->output_message(debug_str.str().c_str());
+				}
+				if (!output_channel_reorder_list.empty())
+				{
+					std::stringstream debug_str;
+					debug_str << " - before writing reorder";
+					for(std::vector<std::pair<std::string, unsigned int> >::const_iterator it = output_channel_reorder_list.begin(); it != output_channel_reorder_list.end(); ++it)
+						debug_str << " " << it->first << " to plain";
+					debug->output_message(debug_str.str().c_str());
+				}
+			}
+		}
+
+		unsigned int forward_propagation_plain::get_buffer_slot(const std::string& layer_name) const
+		{
+			std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
+			if (it != layer_buffer_action_to_set_map.end())
+				return it->second;
+
+			unsigned int slot = static_cast<unsigned int>(layer_buffer_set_per_entry_size_list.size());
+			for(std::map<std::string, size_t>::const_iterator it2 = dedicated_per_entry_data_name_to_size_map.begin(); it2 != dedicated_per_entry_data_name_to_size_map.end(); ++it2, ++slot)
+				if (it2->first == layer_name)
+					return slot;
+
+			throw neural_network_exception((boost::format("No buffer found for the output of layer %1%") % layer_name).str());
+		}
+
+		std::vector<forward_propagation_plain::channel_reorder> forward_propagation_plain::get_channel_reorders(const std::vector<std::pair<std::string, unsigned int> >& reorder_list) const
+		{
+			std::vector<channel_reorder> res;
+			for(std::vector<std::pair<std::string, unsigned int> >::const_iterator it = reorder_list.begin(); it != reorder_list.end(); ++it)
+			{
+				const layer_configuration_specific& config = layer_config_map.find(it->first)->second;
+				channel_reorder new_reorder;
+				new_reorder.buffer_slot = get_buffer_slot(it->first);
+				new_reorder.feature_map_count = config.feature_map_count;
+				new_reorder.neuron_count_per_feature_map = config.get_neuron_count_per_feature_map();
+				new_reorder.tiling_factor = cumulative_tiling_factor_map.find(it->first)->second;
+				new_reorder.block_size = it->second;
+				res.push_back(new_reorder);
+			}
+
+			return res;
+		}
+
+		void forward_propagation_plain::setup_steps()
+		{
+			// Only one of them is set, NUMA nodes don't run concurrent branches
+			plain_running_configuration::const_ptr thread_group_plain_config = numa_node_plain_config ? numa_node_plain_config : branch_plain_config;
+
+			steps.clear();
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				const std::string& layer_name = it->get_name();
+				step new_step;
+				new_step.layer_schema = get_layer(layer_name);
+				new_step.tester = testers.find(layer_name)->second;
+				new_step.plain_config = tester_plain_config_map[layer_name];
+				if (thread_group_plain_config)
+				{
+					const std::string& algorithm = new_step.plain_config->algorithm;
+					new_step.thread_group_plain_config = algorithm.empty() ? thread_group_plain_config : thread_group_plain_config->get_algorithm_configuration(algorithm);
+				}
+				for(std::vector<std::string>::const_iterator it2 = new_step.layer_schema->input_layer_instance_names.begin(); it2 != new_step.layer_schema->input_layer_instance_names.end(); ++it2)
+				{
+					new_step.input_configuration_specific_list.push_back(layer_config_map[*it2]);
+					new_step.input_buffer_slots.push_back(get_buffer_slot(*it2));
+				}
+				new_step.output_configuration_specific = layer_config_map[layer_name];
+				new_step.tiling_factor = cumulative_tiling_factor_map[layer_name];
+				new_step.channel_blocked = (layer_channel_block_size_map[layer_name] > 0);
+				new_step.output_buffer_slot = get_buffer_slot(layer_name);
+				{
+					std::map<layer_name_with_action, unsigned int>::const_iterator it2 = temporary_working_per_entry_data_action_to_set_map.find(*it);
+					new_step.temporary_working_per_entry_buffer_slot = (it2 != temporary_working_per_entry_data_action_to_set_map.end()) ? static_cast<int>(it2->second) : -1;
+				}
+				{
+					std::map<layer_name_with_action, std::vector<std::pair<std::string, unsigned int> > >::const_iterator it2 = action_to_channel_reorder_list_map.find(*it);
+					if (it2 != action_to_channel_reorder_list_map.end())
+						new_step.reorders = get_channel_reorders(it2->second);
+				}
+				steps.push_back(new_step);
+			}
+
+			output_channel_reorders = get_channel_reorders(output_channel_reorder_list);
+		}
+
+		void forward_propagation_plain::run_channel_reorders(
+			const std::vector<channel_reorder>& reorders,
+			const std::vector<plain_buffer::ptr>& buffer_slots,
+			plain_buffer::ptr reorder_buffer,
+			unsigned int entry_count,
+			int thread_count) const
+		{
+			for(std::vector<channel_reorder>::const_iterator it = reorders.begin(); it != reorders.end(); ++it)
+			{
+				const plain_buffer::ptr& buffer = buffer_slots[it->buffer_slot];
+				const unsigned int current_entry_count = entry_count * it->tiling_factor;
+				if (it->block_size > 0)
+					channel_blocked_layout_plain::to_blocked(
+						*buffer,
+						*reorder_buffer,
+						it->feature_map_count,
+						it->neuron_count_per_feature_map,
+						it->block_size,
+						current_entry_count,
+						thread_count);
+				else
+					channel_blocked_layout_plain::to_plain(
+						*buffer,
+						*reorder_buffer,
+						it->feature_map_count,
+						it->neuron_count_per_feature_map,
+						plain_config->channel_block_size,
+						current_entry_count,
+						thread_count);
+				memcpy(*buffer, *reorder_buffer, it->feature_map_count * it->neuron_count_per_feature_map * current_entry_count * sizeof(float));
+			}
+		}
+
+		void forward_propagation_plain::update_tester_data()
+		{
+			tester_data_map.clear();
+			if (!net_data)
+				return;
+
+			for(std::map<std::string, layer_tester_plain::const_ptr>::const_iterator it = testers.begin(); it != testers.end(); ++it)
+			{
+				layer::const_ptr l = get_layer(it->first);
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+				tester_data_map.insert(std::make_pair(
+					it->first,
+					it->second->get_data(
+						net_data->data_list.find(it->first),
+						tester_plain_config_map[it->first],
+						l,
+						input_layer_configuration_specific_list,
+						layer_config_map[it->first])));
+			}
+
+			for(std::vector<step>::iterator it = steps.begin(); it != steps.end(); ++it)
+			{
+				const std::string& layer_name = it->layer_schema->instance_name;
+				it->data.assign(1, tester_data_map.find(layer_name)->second);
+				it->data_custom.assign(1, net_data->data_custom_list.find(layer_name));
+			}
+
+			if (numa_node_count > 1)
+				replicate_step_data();
+		}
+
+		namespace
+		{
+			// Copies made by the thread bound to the node are first touched there
+			void replicate_step_data_on_numa_node(
+				const plain_running_configuration& config,
+				unsigned int numa_node_id,
+				const std::vector<layer_data::const_ptr>& data_list,
+				const std::vector<layer_data_custom::const_ptr>& data_custom_list,
+				std::vector<layer_data::const_ptr>& replica_data_list,
+				std::vector<layer_data_custom::const_ptr>& replica_data_custom_list,
+				std::string& error_message)
+			{
+				try
+				{
+					config.bind_current_thread_to_numa_node(numa_node_id);
+					for(unsigned int i = 0; i < static_cast<unsigned int>(data_list.size()); ++i)
+					{
+						if (data_list[i])
+							replica_data_list[i] = layer_data::const_ptr(new layer_data(*data_list[i]));
+						if (data_custom_list[i])
+							replica_data_custom_list[i] = layer_data_custom::const_ptr(new layer_data_custom(*data_custom_list[i]));
+					}
+				}
+				catch (const std::exception& e)
+				{
+					error_message = e.what();
+					if (error_message.empty())
+						error_message = "unknown error";
+				}
+			}
+		}
+
+		void forward_propagation_plain::replicate_step_data()
+		{
+			std::vector<layer_data::const_ptr> data_list;
+			std::vector<layer_data_custom::const_ptr> data_custom_list;
+			for(std::vector<step>::const_iterator it = steps.begin(); it != steps.end(); ++it)
+			{
+				data_list.push_back(it->data.front());
+				data_custom_list.push_back(it->data_custom.front());
+			}
+
+			std::vector<std::vector<layer_data::const_ptr> > replica_data_list_list(numa_node_count, std::vector<layer_data::const_ptr>(steps.size()));
+			std::vector<std::vector<layer_data_custom::const_ptr> > replica_data_custom_list_list(numa_node_count, std::vector<layer_data_custom::const_ptr>(steps.size()));
+			std::vector<std::string> error_message_list(numa_node_count);
+			{
+				boost::thread_group workers;
+				for(unsigned int node_id = 0; node_id < numa_node_count; ++node_id)
+					workers.create_thread(boost::bind(
+						replicate_step_data_on_numa_node,
+						boost::cref(*plain_config),
+						node_id,
+						boost::cref(data_list),
+						boost::cref(data_custom_list),
+						boost::ref(replica_data_list_list[node_id]),
+						boost::ref(replica_data_custom_list_list[node_id]),
+						boost::ref(error_message_list[node_id])));
+				workers.join_all();
+			}
+			for(std::vector<std::string>::const_iterator it = error_message_list.begin(); it != error_message_list.end(); ++it)
+				if (!it->empty())
+					throw neural_network_exception((boost::format("Replicating weights on NUMA node failed: %1%") % *it).str());
+
+			for(unsigned int step_id = 0; step_id < static_cast<unsigned int>(steps.size()); ++step_id)
+			{
+				step& current_step = steps[step_id];
+				current_step.data.resize(numa_node_count);
+				current_step.data_custom.resize(numa_node_count);
+				for(unsigned int node_id = 0; node_id < numa_node_count; ++node_id)
+				{
+					current_step.data[node_id] = replica_data_list_list[node_id][step_id];
+					current_step.data_custom[node_id] = replica_data_custom_list_list[node_id][step_id];
+				}
+			}
+		}
+
 		void forward_propagation_plain::setup_dedicated_buffer_sizes()
 		{
 			dedicated_per_entry_data_name_to_size_map.clear();
@@ -227,13 +996,13 @@ namespace nnforge
 			for(std::map<std::string, layer_tester_plain::const_ptr>::const_iterator it = testers.begin(); it != testers.end(); ++it)
 			{
 				layer_configuration_specific output_layer_configuration_specific = layer_config_map[it->first];
-				layer::const_ptr l = schema->get_layer(it->first);
+				layer::const_ptr l = get_layer(it->first);
 				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
 				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 				size_t new_temporary_working_fixed_size = it->second->get_temporary_working_fixed_buffer_size(
-					plain_config,
-					schema->get_layer(it->first),
+					tester_plain_config_map[it->first],
+					get_layer(it->first),
 					input_layer_configuration_specific_list,
 					output_layer_configuration_specific);
 				temporary_working_fixed_size = std::max(temporary_working_fixed_size, new_temporary_working_fixed_size);
@@ -255,20 +1024,20 @@ namespace nnforge
 				for(std::map<std::string, layer_tester_plain::const_ptr>::const_iterator it = testers.begin(); it != testers.end(); ++it)
 				{
 					layer_configuration_specific output_layer_configuration_specific = layer_config_map[it->first];
-					layer::const_ptr l = schema->get_layer(it->first);
+					layer::const_ptr l = get_layer(it->first);
 					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
 					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 					int input_index_layer_can_write = it->second->get_input_index_layer_can_write(
-						plain_config,
-						schema->get_layer(it->first),
+						tester_plain_config_map[it->first],
+						get_layer(it->first),
 						input_layer_configuration_specific_list,
 						output_layer_configuration_specific);
 					if (input_index_layer_can_write >= 0)
 						input_index_layer_can_write_output_map.insert(std::make_pair(layer_name_with_action(it->first, layer_action::forward), static_cast<unsigned int>(input_index_layer_can_write)));
 				}
 
-				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > > buffers;
+				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, size_t> > > buffers;
 				std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > > dependencies;
 				std::set<std::string> dedicated_output_buffers(output_layer_names.begin(), output_layer_names.end());
 				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
@@ -276,19 +1045,19 @@ namespace nnforge
 					std::string layer_name = it->get_name();
 					size_t buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
 					if (dedicated_output_buffers.find(layer_name) == dedicated_output_buffers.end())
-						buffers.insert(std::make_pair(*it, std::vector<std::pair<buffer_lifetime, float> >(1, std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)))));
-					layer::const_ptr l = schema->get_layer(layer_name);
+						buffers.insert(std::make_pair(*it, std::vector<std::pair<buffer_lifetime, size_t> >(1, std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), buffer_size_per_entry))));
+					layer::const_ptr l = get_layer(layer_name);
 
 					int input_index_layer_can_write;
 					{
 						layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
-						layer::const_ptr l = schema->get_layer(layer_name);
+						layer::const_ptr l = get_layer(layer_name);
 						std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
 						for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 							input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 						input_index_layer_can_write = testers[layer_name]->get_input_index_layer_can_write(
-							plain_config,
-							schema->get_layer(layer_name),
+							tester_plain_config_map[layer_name],
+							get_layer(layer_name),
 							input_layer_configuration_specific_list,
 							output_layer_configuration_specific);
 					}
@@ -309,23 +1078,42 @@ namespace nnforge
 				for(std::map<std::string, layer_tester_plain::const_ptr>::const_iterator it = testers.begin(); it != testers.end(); ++it)
 				{
 					layer_configuration_specific output_layer_configuration_specific = layer_config_map[it->first];
-					layer::const_ptr l = schema->get_layer(it->first);
+					layer::const_ptr l = get_layer(it->first);
 					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
 					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 					size_t temporary_working_per_entry_buffer_size = it->second->get_temporary_working_per_entry_buffer_size(
-						plain_config,
-						schema->get_layer(it->first),
+						tester_plain_config_map[it->first],
+						get_layer(it->first),
 						input_layer_configuration_specific_list,
 						output_layer_configuration_specific);
 					if (temporary_working_per_entry_buffer_size > 0)
-						buffers.insert(std::make_pair(layer_name_with_action(it->first, layer_action::forward), std::vector<std::pair<buffer_lifetime, float> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::working_buffer), static_cast<float>(temporary_working_per_entry_buffer_size)));
+						buffers.insert(std::make_pair(layer_name_with_action(it->first, layer_action::forward), std::vector<std::pair<buffer_lifetime, size_t> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::working_buffer), temporary_working_per_entry_buffer_size));
 				}
 
-				layer_buffer_set_list = action_schema->get_buffer_set(
-					buffers,
-					dependencies,
-					std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >());
+				layer_buffer_set_per_entry_offset_list.clear();
+				layer_buffers_per_entry_size = 0;
+				if (plain_config->buffer_offset_planning)
+				{
+					std::vector<std::pair<size_t, std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > > layer_buffer_offset_list = action_schema->get_buffer_offsets(
+						buffers,
+						dependencies,
+						std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >(),
+						buffer_arena_plain::buffer_alignment,
+						layer_buffers_per_entry_size);
+					for(std::vector<std::pair<size_t, std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > >::const_iterator it = layer_buffer_offset_list.begin(); it != layer_buffer_offset_list.end(); ++it)
+					{
+						layer_buffer_set_per_entry_offset_list.push_back(it->first);
+						layer_buffer_set_list.push_back(it->second);
+					}
+				}
+				else
+				{
+					layer_buffer_set_list = action_schema->get_buffer_set(
+						buffers,
+						dependencies,
+						std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >());
+				}
 			}
 
 			layer_buffer_set_per_entry_size_list.clear();
@@ -349,13 +1137,13 @@ namespace nnforge
 						temporary_working_per_entry_data_action_to_set_map.insert(std::make_pair(it->first, set_id));
 
 						layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
-						layer::const_ptr l = schema->get_layer(layer_name);
+						layer::const_ptr l = get_layer(layer_name);
 						std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
 						for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 							input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 						size_t temporary_working_per_entry_buffer_size = testers.find(layer_name)->second->get_temporary_working_per_entry_buffer_size(
-							plain_config,
-							schema->get_layer(layer_name),
+							tester_plain_config_map[layer_name],
+							get_layer(layer_name),
 							input_layer_configuration_specific_list,
 							output_layer_configuration_specific);
 
@@ -375,11 +1163,16 @@ namespace nnforge
 				for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
 						total_buffer_size += *it;
 				debug_str << ", total size " << ((total_buffer_size + 1024 - 1) / 1024) << " KB";
+				if (!layer_buffer_set_per_entry_offset_list.empty())
+					debug_str << ", planned peak " << ((layer_buffers_per_entry_size + 1024 - 1) / 1024) << " KB";
 				debug->output_message(debug_str.str().c_str());
 				for(unsigned int set_id = 0; set_id < static_cast<unsigned int>(layer_buffer_set_per_entry_size_list.size()); ++set_id)
 				{
 					std::stringstream debug_str;
-					debug_str << " - " << ((layer_buffer_set_per_entry_size_list[set_id] + 1024 - 1) / 1024) << " KB: ";
+					debug_str << " - ";
+					if (!layer_buffer_set_per_entry_offset_list.empty())
+						debug_str << "at " << (layer_buffer_set_per_entry_offset_list[set_id] / 1024) << " KB ";
+					debug_str << ((layer_buffer_set_per_entry_size_list[set_id] + 1024 - 1) / 1024) << " KB: ";
 					const std::vector<std::pair<layer_name_with_action, buffer_lifetime> >& action_list = layer_buffer_set_list[set_id];
 					for(std::vector<std::pair<layer_name_with_action, buffer_lifetime> >::const_iterator it = action_list.begin(); it != action_list.end(); ++it)
 					{
@@ -416,13 +1209,38 @@ namespace nnforge
 					buffer_configuration.add_constant_buffer(it2->size() * sizeof(int));
 			}
 
-			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
-				buffer_configuration.add_per_entry_buffer(*it);
+			// Data transformed by testers is kept along with the original one
+			for(std::map<std::string, layer_data::const_ptr>::const_iterator it = tester_data_map.begin(); it != tester_data_map.end(); ++it)
+			{
+				if (!it->second || (it->second == net_data->data_list.find(it->first)))
+					continue;
+				for(layer_data::const_iterator it2 = it->second->begin(); it2 != it->second->end(); ++it2)
+					buffer_configuration.add_constant_buffer(it2->size() * sizeof(float));
+			}
+
+			if (!layer_buffer_set_per_entry_offset_list.empty())
+				buffer_configuration.add_per_entry_buffer(layer_buffers_per_entry_size);
+			else
+				for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
+					buffer_configuration.add_per_entry_buffer(*it);
 
 			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
-				buffer_configuration.add_per_entry_buffer(it->second);
+				for(unsigned int buffer_set_id = 0; buffer_set_id < chunk_pipeline_plain::buffer_set_count; ++buffer_set_id)
+					buffer_configuration.add_per_entry_buffer(it->second);
+
+			// Weight replicas are kept in addition to the original data
+			if (numa_node_count > 1)
+				for(std::vector<step>::const_iterator it = steps.begin(); it != steps.end(); ++it)
+					for(unsigned int node_id = 0; node_id < static_cast<unsigned int>(it->data.size()); ++node_id)
+						if (it->data[node_id])
+							for(layer_data::const_iterator it2 = it->data[node_id]->begin(); it2 != it->data[node_id]->end(); ++it2)
+								buffer_configuration.add_constant_buffer(it2->size() * sizeof(float));
+
+			for(unsigned int worker_id = 0; worker_id < std::max(branch_worker_count, numa_node_count); ++worker_id)
+				buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
 
-			buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
+			if (channel_reorder_per_entry_size > 0)
+				buffer_configuration.add_per_entry_buffer(channel_reorder_per_entry_size);
 
 			max_entry_count = plain_config->get_max_entry_count(buffer_configuration);
 
@@ -19,6 +19,9 @@
 #include "../forward_propagation.h"
 #include "plain_running_configuration.h"
 #include "layer_tester_plain.h"
+#include "branch_executor_plain.h"
+#include "worker_pool_plain.h"
+#include "buffer_arena_plain.h"
 
 #include <map>
 
@@ -55,7 +58,21 @@ namespace nnforge
 			// The layer_config_map is guaranteed to be compatible with schema
 			virtual void layer_config_map_modified();
 
+			virtual float get_max_flops() const;
+
 		private:
+			// Finds negative log likelihood layers fed by softmax layers with no other consumers, the softmax actions are dropped
+			// and the loss layers get the input of the softmax instead, they are run by softmax_negative_log_likelihood_layer_tester_plain
+			void setup_fused_softmax_loss_layers();
+
+			// Returns the layer as it is run, which is the fused one for the loss layers softmax is fused into
+			layer::const_ptr get_layer(const std::string& layer_name) const;
+
+			void setup_testers();
+
+			// Chooses the layout of each layer output and the reorders between layouts, called after setup_testers
+			void setup_channel_layouts();
+
 			void setup_dedicated_buffer_sizes();
 
 			void setup_layer_buffer_sizes();
@@ -64,24 +81,214 @@ namespace nnforge
 
 			void update_max_entry_count();
 
+			void update_tester_data();
+
+		private:
+			// Output layer of channel_reorder is converted to block_size channel blocks, 0 stands for plain layout
+			class channel_reorder
+			{
+			public:
+				unsigned int buffer_slot;
+				unsigned int feature_map_count;
+				unsigned int neuron_count_per_feature_map;
+				unsigned int tiling_factor;
+				unsigned int block_size;
+			};
+
+			// Action with everything resolved but the buffers, which are referenced by their slots:
+			// layer buffers come first, dedicated buffers follow in the order of their names
+			class step
+			{
+			public:
+				layer::const_ptr layer_schema;
+				layer_tester_plain::const_ptr tester;
+				// Both carry the algorithm resolved for the layer, the thread group one is null unless branches or NUMA nodes run on thread groups
+				plain_running_configuration::const_ptr plain_config;
+				plain_running_configuration::const_ptr thread_group_plain_config;
+				std::vector<layer_configuration_specific> input_configuration_specific_list;
+				layer_configuration_specific output_configuration_specific;
+				unsigned int tiling_factor;
+				bool channel_blocked;
+				unsigned int output_buffer_slot;
+				std::vector<unsigned int> input_buffer_slots;
+				// -1 when the tester doesn't need temporary working per entry buffer
+				int temporary_working_per_entry_buffer_slot;
+				std::vector<channel_reorder> reorders;
+				// Set by update_tester_data, indexed by NUMA node when weights are replicated, single element otherwise
+				std::vector<layer_data::const_ptr> data;
+				std::vector<layer_data_custom::const_ptr> data_custom;
+			};
+
+		private:
+			// Compiles actions into steps, called after all the buffers are assigned
+			void setup_steps();
+
+			unsigned int get_buffer_slot(const std::string& layer_name) const;
+
+			std::vector<channel_reorder> get_channel_reorders(const std::vector<std::pair<std::string, unsigned int> >& reorder_list) const;
+
+			// Converts layer outputs to the layouts requested in place, using reorder_buffer as a scratch
+			void run_channel_reorders(
+				const std::vector<channel_reorder>& reorders,
+				const std::vector<plain_buffer::ptr>& buffer_slots,
+				plain_buffer::ptr reorder_buffer,
+				unsigned int entry_count,
+				int thread_count) const;
+
+			// Runs the step on the threads of a thread group or of the whole configuration with the data replica specified,
+			// might be called concurrently for independent steps. The time it takes is added to seconds unless it is null
+			void run_step(
+				const step& current_step,
+				const std::vector<plain_buffer::ptr>& buffer_slots,
+				plain_buffer::ptr temporary_working_fixed_buffer,
+				plain_buffer::ptr reorder_buffer,
+				unsigned int entry_count,
+				bool thread_group,
+				unsigned int replica_id,
+				double * seconds) const;
+
+			// Copies the data of the steps to each NUMA node, each copy is made by a thread bound to its node
+			void replicate_step_data();
+
+		private:
+			class branch_action_runner : public branch_executor_plain::action_runner
+			{
+			public:
+				branch_action_runner(
+					const forward_propagation_plain& prop,
+					const std::vector<plain_buffer::ptr>& buffer_slots,
+					const std::vector<plain_buffer::ptr>& temporary_working_fixed_buffers,
+					plain_buffer::ptr reorder_buffer,
+					unsigned int entry_count,
+					std::vector<double> * step_seconds);
+
+				virtual void run_action(
+					unsigned int action_id,
+					unsigned int worker_id);
+
+			private:
+				const forward_propagation_plain& prop;
+				const std::vector<plain_buffer::ptr>& buffer_slots;
+				const std::vector<plain_buffer::ptr>& temporary_working_fixed_buffers;
+				plain_buffer::ptr reorder_buffer;
+				unsigned int entry_count;
+				// Null when not profiling, each element is updated by a single worker at a time
+				std::vector<double> * step_seconds;
+			};
+
+			// Runs all the steps for the part of the chunk assigned to a NUMA node, on the threads of the node
+			class numa_node_task
+			{
+			public:
+				numa_node_task(
+					const forward_propagation_plain& prop,
+					unsigned int numa_node_id,
+					const std::vector<plain_buffer::ptr>& buffer_slots,
+					plain_buffer::ptr temporary_working_fixed_buffer,
+					plain_buffer::ptr reorder_buffer,
+					unsigned int entry_count,
+					bool first_touch,
+					std::vector<double> * step_seconds);
+
+				void operator()();
+
+				// Empty unless the task failed
+				std::string error_message;
+
+			private:
+				const forward_propagation_plain& prop;
+				unsigned int numa_node_id;
+				const std::vector<plain_buffer::ptr>& buffer_slots;
+				plain_buffer::ptr temporary_working_fixed_buffer;
+				plain_buffer::ptr reorder_buffer;
+				unsigned int entry_count;
+				bool first_touch;
+				std::vector<double> * step_seconds;
+			};
+
+			// Binds each worker of the NUMA node pool and its OpenMP threads to the node with the id of the worker
+			class numa_node_binding_task : public worker_pool_plain::task
+			{
+			public:
+				numa_node_binding_task(const forward_propagation_plain& prop);
+
+				virtual void run(unsigned int worker_id);
+
+			private:
+				const forward_propagation_plain& prop;
+			};
+
+			// Runs the task of the node with the id of the worker, null tasks are skipped
+			class numa_node_chunk_task : public worker_pool_plain::task
+			{
+			public:
+				numa_node_chunk_task(const std::vector<nnforge_shared_ptr<numa_node_task> >& node_tasks);
+
+				virtual void run(unsigned int worker_id);
+
+			private:
+				const std::vector<nnforge_shared_ptr<numa_node_task> >& node_tasks;
+			};
+
 		private:
 			plain_running_configuration::const_ptr plain_config;
 
 			std::vector<layer_name_with_action> actions_in_execution_order;
 
 			std::map<std::string, layer_tester_plain::const_ptr> testers;
+			// Configuration each tester is called with, it carries the algorithm setup_testers resolved for the layer
+			std::map<std::string, plain_running_configuration::const_ptr> tester_plain_config_map;
+			// Bucket of the chunk size algorithms are tuned for, 0 until the first run when the heuristic choices are made
+			unsigned int tuning_entry_count;
+			// Loss layers softmax is fused into, with the input of the softmax layer as their first input
+			std::map<std::string, layer::const_ptr> fused_softmax_loss_layer_map;
 			network_data::const_ptr net_data;
+			std::map<std::string, layer_data::const_ptr> tester_data_map;
 
 			size_t temporary_working_fixed_size;
 
 			std::vector<size_t> layer_buffer_set_per_entry_size_list;
+			// Offsets of layer buffers within the allocation of layer_buffers_per_entry_size bytes per entry, empty when offsets are not planned
+			std::vector<size_t> layer_buffer_set_per_entry_offset_list;
+			size_t layer_buffers_per_entry_size;
 			std::map<layer_name_with_action, unsigned int> temporary_working_per_entry_data_action_to_set_map;
 			std::map<layer_name_with_action, unsigned int> layer_buffer_action_to_set_map;
 
 			std::map<std::string, size_t> dedicated_per_entry_data_name_to_size_map;
 
+			// Channel block size of the output of each layer run, 0 stands for plain layout
+			std::map<std::string, unsigned int> layer_channel_block_size_map;
+			// Layer outputs to be converted to the channel block size specified before running the action
+			std::map<layer_name_with_action, std::vector<std::pair<std::string, unsigned int> > > action_to_channel_reorder_list_map;
+			// Output layers to be converted back to plain layout before writing them
+			std::vector<std::pair<std::string, unsigned int> > output_channel_reorder_list;
+			size_t channel_reorder_per_entry_size;
+
+			// Actions in execution order compiled by setup_steps
+			std::vector<step> steps;
+			std::vector<channel_reorder> output_channel_reorders;
+
 			unsigned int max_entry_count;
 
+			// Number of workers running independent branches concurrently, 1 stands for sequential execution
+			unsigned int branch_worker_count;
+			branch_executor_plain branch_executor;
+			// Kept between chunks and runs, null for sequential execution and when branches run on the scheduler of the configuration
+			worker_pool_plain::ptr branch_workers;
+			// Configuration with the threads of a single worker
+			plain_running_configuration::const_ptr branch_plain_config;
+
+			// Number of NUMA nodes each chunk is split between, 1 when weights are not replicated;
+			// concurrent branches are not run then
+			unsigned int numa_node_count;
+			// Configuration with the threads of a single node
+			plain_running_configuration::const_ptr numa_node_plain_config;
+			// A worker per node bound to it once, kept between chunks and runs; null when weights are not replicated
+			worker_pool_plain::ptr numa_node_workers;
+
+			// Keeps the memory of the buffers between runs
+			buffer_arena_plain arena;
+
 		private:
 			static const unsigned int max_max_entry_count;
 
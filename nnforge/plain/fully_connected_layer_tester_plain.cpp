@@ -0,0 +1,114 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "fully_connected_layer_tester_plain.h"
+
+#include "convolution_geometry_plain.h"
+#include "convolution_gemm_plain.h"
+#include "gemm_plain.h"
+#include "../convolution_layer.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		fully_connected_layer_tester_plain::fully_connected_layer_tester_plain()
+		{
+		}
+
+		fully_connected_layer_tester_plain::~fully_connected_layer_tester_plain()
+		{
+		}
+
+		std::string fully_connected_layer_tester_plain::get_type_name() const
+		{
+			return convolution_layer::layer_type_name;
+		}
+
+		bool fully_connected_layer_tester_plain::is_applicable(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			return geometry.is_fully_connected() || geometry.is_pointwise();
+		}
+
+		void fully_connected_layer_tester_plain::run_forward_propagation(
+			plain_buffer::ptr output_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			const float * weights = &(*data)[0][0];
+			const float * biases = geometry.bias ? &(*data)[1][0] : 0;
+
+			if (!geometry.is_fully_connected())
+			{
+				// 1x1 window, the input of each entry is the column matrix itself
+				convolution_gemm_plain::run_forward(
+					plain_config->cpu_isa,
+					geometry,
+					*input_buffers[0],
+					*output_buffer,
+					weights,
+					biases,
+					0,
+					entry_count,
+					plain_config->openmp_thread_count);
+				return;
+			}
+
+			// Single multiplication for all the entries: output (entry x output neuron) = input (entry x input neuron) * transposed weights
+			const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
+			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
+			float * const out = *output_buffer;
+			if (biases)
+			{
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+					std::copy(biases, biases + output_neuron_count, out + static_cast<size_t>(entry_id) * output_neuron_count);
+			}
+
+			gemm_plain::sgemm(
+				plain_config->cpu_isa,
+				false,
+				true,
+				entry_count,
+				output_neuron_count,
+				input_neuron_count,
+				1.0F,
+				*input_buffers[0],
+				input_neuron_count,
+				weights,
+				input_neuron_count,
+				biases ? 1.0F : 0.0F,
+				out,
+				output_neuron_count,
+				plain_config->openmp_thread_count);
+		}
+	}
+}
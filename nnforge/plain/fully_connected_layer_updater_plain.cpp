@@ -0,0 +1,258 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "fully_connected_layer_updater_plain.h"
+
+#include "convolution_geometry_plain.h"
+#include "convolution_gemm_plain.h"
+#include "gemm_plain.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		fully_connected_layer_updater_plain::fully_connected_layer_updater_plain()
+		{
+		}
+
+		fully_connected_layer_updater_plain::~fully_connected_layer_updater_plain()
+		{
+		}
+
+		bool fully_connected_layer_updater_plain::is_applicable(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			return geometry.is_fully_connected() || geometry.is_pointwise();
+		}
+
+		void fully_connected_layer_updater_plain::run_forward_propagation(
+			plain_buffer::ptr output_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_buffer::ptr temporary_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const std::set<layer_action>& actions,
+			unsigned int entry_count) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			const float * weights = &(*data)[0][0];
+			const float * biases = geometry.bias ? &(*data)[1][0] : 0;
+
+			if (!geometry.is_fully_connected())
+			{
+				convolution_gemm_plain::run_forward(
+					plain_config->cpu_isa,
+					geometry,
+					*input_buffers[0],
+					*output_buffer,
+					weights,
+					biases,
+					0,
+					entry_count,
+					plain_config->openmp_thread_count);
+				return;
+			}
+
+			const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
+			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
+			float * const out = *output_buffer;
+			if (biases)
+			{
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+					std::copy(biases, biases + output_neuron_count, out + static_cast<size_t>(entry_id) * output_neuron_count);
+			}
+
+			gemm_plain::sgemm(
+				plain_config->cpu_isa,
+				false,
+				true,
+				entry_count,
+				output_neuron_count,
+				input_neuron_count,
+				1.0F,
+				*input_buffers[0],
+				input_neuron_count,
+				weights,
+				input_neuron_count,
+				biases ? 1.0F : 0.0F,
+				out,
+				output_neuron_count,
+				plain_config->openmp_thread_count);
+		}
+
+		void fully_connected_layer_updater_plain::run_backward_data_propagation(
+			unsigned int input_index,
+			plain_buffer::ptr input_errors_buffer,
+			plain_buffer::const_ptr output_errors_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+			plain_buffer::const_ptr output_neurons_buffer,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_buffer::ptr temporary_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const bool add_update_to_destination,
+			const std::set<layer_action>& actions,
+			unsigned int entry_count) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+			const float * weights = &(*data)[0][0];
+
+			if (!geometry.is_fully_connected())
+			{
+				convolution_gemm_plain::run_backward_data(
+					plain_config->cpu_isa,
+					geometry,
+					*output_errors_buffer,
+					*input_errors_buffer,
+					weights,
+					add_update_to_destination,
+					0,
+					entry_count,
+					plain_config->openmp_thread_count);
+				return;
+			}
+
+			// input errors (entry x input neuron) = output errors (entry x output neuron) * weights
+			const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
+			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
+			gemm_plain::sgemm(
+				plain_config->cpu_isa,
+				false,
+				false,
+				entry_count,
+				input_neuron_count,
+				output_neuron_count,
+				1.0F,
+				*output_errors_buffer,
+				output_neuron_count,
+				weights,
+				input_neuron_count,
+				add_update_to_destination ? 1.0F : 0.0F,
+				*input_errors_buffer,
+				input_neuron_count,
+				plain_config->openmp_thread_count);
+		}
+
+		void fully_connected_layer_updater_plain::run_backward_weights_propagation(
+			const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+			plain_buffer::const_ptr output_errors_buffer,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_buffer::ptr temporary_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::ptr gradient,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const std::set<layer_action>& actions,
+			unsigned int entry_count) const
+		{
+			convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+
+			if (geometry.is_fully_connected())
+			{
+				// weight gradient (output neuron x input neuron) += transposed output errors * input neurons, summed over entries by the multiplication itself
+				const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
+				const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
+				gemm_plain::sgemm(
+					plain_config->cpu_isa,
+					true,
+					false,
+					output_neuron_count,
+					input_neuron_count,
+					entry_count,
+					1.0F,
+					*output_errors_buffer,
+					output_neuron_count,
+					*input_neurons_buffers[0],
+					input_neuron_count,
+					1.0F,
+					&(*gradient)[0][0],
+					input_neuron_count,
+					plain_config->openmp_thread_count);
+			}
+			else
+			{
+				convolution_gemm_plain::run_backward_weights(
+					plain_config->cpu_isa,
+					geometry,
+					*input_neurons_buffers[0],
+					*output_errors_buffer,
+					&(*gradient)[0][0],
+					0,
+					temporary_working_fixed_buffer ? static_cast<void *>(*temporary_working_fixed_buffer) : 0,
+					entry_count,
+					plain_config->openmp_thread_count);
+			}
+
+			if (geometry.bias)
+				update_biases_gradient(
+					*output_errors_buffer,
+					&(*gradient)[1][0],
+					geometry.output_feature_map_count,
+					geometry.output_neuron_count_per_feature_map,
+					entry_count,
+					plain_config->openmp_thread_count);
+		}
+
+		size_t fully_connected_layer_updater_plain::get_temporary_working_fixed_buffer_size(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			if (action.get_action_type() == layer_action::backward_weights)
+			{
+				convolution_geometry_plain geometry(layer_schema, input_configuration_specific_list[0], output_configuration_specific);
+				if (!geometry.is_fully_connected())
+					return convolution_gemm_plain::get_backward_weights_slab_buffer_size(plain_config->cpu_isa, geometry, plain_config->openmp_thread_count);
+			}
+
+			return layer_updater_plain::get_temporary_working_fixed_buffer_size(action, actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific);
+		}
+
+		size_t fully_connected_layer_updater_plain::get_temporary_working_per_entry_buffer_size(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return layer_updater_plain::get_temporary_working_per_entry_buffer_size(action, actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific);
+		}
+	}
+}
@@ -0,0 +1,505 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "gemm_plain.h"
+
+#include <vector>
+#include <algorithm>
+
+#if defined(NNFORGE_PLAIN_X86)
+#include <immintrin.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			typedef void (*micro_kernel_function)(
+				unsigned int k_count,
+				const float * packed_a,
+				const float * packed_b,
+				float alpha,
+				float beta,
+				float * c,
+				unsigned int ldc);
+
+			class micro_kernel_info
+			{
+			public:
+				unsigned int mr;
+				unsigned int nr;
+				micro_kernel_function kernel;
+			};
+
+			// Largest register block over all the micro-kernels
+			const unsigned int max_mr = 12;
+			const unsigned int max_nr = 32;
+
+			void micro_kernel_generic(
+				unsigned int k_count,
+				const float * packed_a,
+				const float * packed_b,
+				float alpha,
+				float beta,
+				float * c,
+				unsigned int ldc)
+			{
+				float acc[4][4] = {{0.0F}};
+				for(unsigned int p = 0; p < k_count; ++p, packed_a += 4, packed_b += 4)
+					for(unsigned int i = 0; i < 4; ++i)
+						for(unsigned int j = 0; j < 4; ++j)
+							acc[i][j] += packed_a[i] * packed_b[j];
+
+				for(unsigned int i = 0; i < 4; ++i, c += ldc)
+					for(unsigned int j = 0; j < 4; ++j)
+						c[j] = (beta == 0.0F) ? acc[i][j] * alpha : acc[i][j] * alpha + c[j] * beta;
+			}
+
+#if defined(NNFORGE_PLAIN_X86)
+			NNFORGE_PLAIN_TARGET_SSE2 void micro_kernel_sse2(
+				unsigned int k_count,
+				const float * packed_a,
+				const float * packed_b,
+				float alpha,
+				float beta,
+				float * c,
+				unsigned int ldc)
+			{
+				__m128 c00 = _mm_setzero_ps(), c01 = _mm_setzero_ps();
+				__m128 c10 = _mm_setzero_ps(), c11 = _mm_setzero_ps();
+				__m128 c20 = _mm_setzero_ps(), c21 = _mm_setzero_ps();
+				__m128 c30 = _mm_setzero_ps(), c31 = _mm_setzero_ps();
+
+				for(unsigned int p = 0; p < k_count; ++p, packed_a += 4, packed_b += 8)
+				{
+					__m128 b0 = _mm_loadu_ps(packed_b);
+					__m128 b1 = _mm_loadu_ps(packed_b + 4);
+					__m128 a;
+					a = _mm_set1_ps(packed_a[0]); c00 = _mm_add_ps(c00, _mm_mul_ps(a, b0)); c01 = _mm_add_ps(c01, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(packed_a[1]); c10 = _mm_add_ps(c10, _mm_mul_ps(a, b0)); c11 = _mm_add_ps(c11, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(packed_a[2]); c20 = _mm_add_ps(c20, _mm_mul_ps(a, b0)); c21 = _mm_add_ps(c21, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(packed_a[3]); c30 = _mm_add_ps(c30, _mm_mul_ps(a, b0)); c31 = _mm_add_ps(c31, _mm_mul_ps(a, b1));
+				}
+
+				__m128 acc[8] = {c00, c01, c10, c11, c20, c21, c30, c31};
+				__m128 alpha_vec = _mm_set1_ps(alpha);
+				if (beta == 0.0F)
+				{
+					for(unsigned int i = 0; i < 4; ++i, c += ldc)
+					{
+						_mm_storeu_ps(c, _mm_mul_ps(acc[i * 2], alpha_vec));
+						_mm_storeu_ps(c + 4, _mm_mul_ps(acc[i * 2 + 1], alpha_vec));
+					}
+				}
+				else
+				{
+					__m128 beta_vec = _mm_set1_ps(beta);
+					for(unsigned int i = 0; i < 4; ++i, c += ldc)
+					{
+						_mm_storeu_ps(c, _mm_add_ps(_mm_mul_ps(acc[i * 2], alpha_vec), _mm_mul_ps(_mm_loadu_ps(c), beta_vec)));
+						_mm_storeu_ps(c + 4, _mm_add_ps(_mm_mul_ps(acc[i * 2 + 1], alpha_vec), _mm_mul_ps(_mm_loadu_ps(c + 4), beta_vec)));
+					}
+				}
+			}
+
+			NNFORGE_PLAIN_TARGET_AVX2 void micro_kernel_avx2(
+				unsigned int k_count,
+				const float * packed_a,
+				const float * packed_b,
+				float alpha,
+				float beta,
+				float * c,
+				unsigned int ldc)
+			{
+				__m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+				__m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+				__m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+				__m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+				__m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+				__m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+				for(unsigned int p = 0; p < k_count; ++p, packed_a += 6, packed_b += 16)
+				{
+					__m256 b0 = _mm256_loadu_ps(packed_b);
+					__m256 b1 = _mm256_loadu_ps(packed_b + 8);
+					__m256 a;
+					a = _mm256_broadcast_ss(packed_a); c00 = _mm256_fmadd_ps(a, b0, c00); c01 = _mm256_fmadd_ps(a, b1, c01);
+					a = _mm256_broadcast_ss(packed_a + 1); c10 = _mm256_fmadd_ps(a, b0, c10); c11 = _mm256_fmadd_ps(a, b1, c11);
+					a = _mm256_broadcast_ss(packed_a + 2); c20 = _mm256_fmadd_ps(a, b0, c20); c21 = _mm256_fmadd_ps(a, b1, c21);
+					a = _mm256_broadcast_ss(packed_a + 3); c30 = _mm256_fmadd_ps(a, b0, c30); c31 = _mm256_fmadd_ps(a, b1, c31);
+					a = _mm256_broadcast_ss(packed_a + 4); c40 = _mm256_fmadd_ps(a, b0, c40); c41 = _mm256_fmadd_ps(a, b1, c41);
+					a = _mm256_broadcast_ss(packed_a + 5); c50 = _mm256_fmadd_ps(a, b0, c50); c51 = _mm256_fmadd_ps(a, b1, c51);
+				}
+
+				__m256 acc[12] = {c00, c01, c10, c11, c20, c21, c30, c31, c40, c41, c50, c51};
+				__m256 alpha_vec = _mm256_set1_ps(alpha);
+				if (beta == 0.0F)
+				{
+					for(unsigned int i = 0; i < 6; ++i, c += ldc)
+					{
+						_mm256_storeu_ps(c, _mm256_mul_ps(acc[i * 2], alpha_vec));
+						_mm256_storeu_ps(c + 8, _mm256_mul_ps(acc[i * 2 + 1], alpha_vec));
+					}
+				}
+				else
+				{
+					__m256 beta_vec = _mm256_set1_ps(beta);
+					for(unsigned int i = 0; i < 6; ++i, c += ldc)
+					{
+						_mm256_storeu_ps(c, _mm256_fmadd_ps(acc[i * 2], alpha_vec, _mm256_mul_ps(_mm256_loadu_ps(c), beta_vec)));
+						_mm256_storeu_ps(c + 8, _mm256_fmadd_ps(acc[i * 2 + 1], alpha_vec, _mm256_mul_ps(_mm256_loadu_ps(c + 8), beta_vec)));
+					}
+				}
+			}
+
+			NNFORGE_PLAIN_TARGET_AVX512 void micro_kernel_avx512(
+				unsigned int k_count,
+				const float * packed_a,
+				const float * packed_b,
+				float alpha,
+				float beta,
+				float * c,
+				unsigned int ldc)
+			{
+				__m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+				__m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+				__m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+				__m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+				__m512 c40 = _mm512_setzero_ps(), c41 = _mm512_setzero_ps();
+				__m512 c50 = _mm512_setzero_ps(), c51 = _mm512_setzero_ps();
+				__m512 c60 = _mm512_setzero_ps(), c61 = _mm512_setzero_ps();
+				__m512 c70 = _mm512_setzero_ps(), c71 = _mm512_setzero_ps();
+				__m512 c80 = _mm512_setzero_ps(), c81 = _mm512_setzero_ps();
+				__m512 c90 = _mm512_setzero_ps(), c91 = _mm512_setzero_ps();
+				__m512 ca0 = _mm512_setzero_ps(), ca1 = _mm512_setzero_ps();
+				__m512 cb0 = _mm512_setzero_ps(), cb1 = _mm512_setzero_ps();
+
+				for(unsigned int p = 0; p < k_count; ++p, packed_a += 12, packed_b += 32)
+				{
+					__m512 b0 = _mm512_loadu_ps(packed_b);
+					__m512 b1 = _mm512_loadu_ps(packed_b + 16);
+					__m512 a;
+					a = _mm512_set1_ps(packed_a[0]); c00 = _mm512_fmadd_ps(a, b0, c00); c01 = _mm512_fmadd_ps(a, b1, c01);
+					a = _mm512_set1_ps(packed_a[1]); c10 = _mm512_fmadd_ps(a, b0, c10); c11 = _mm512_fmadd_ps(a, b1, c11);
+					a = _mm512_set1_ps(packed_a[2]); c20 = _mm512_fmadd_ps(a, b0, c20); c21 = _mm512_fmadd_ps(a, b1, c21);
+					a = _mm512_set1_ps(packed_a[3]); c30 = _mm512_fmadd_ps(a, b0, c30); c31 = _mm512_fmadd_ps(a, b1, c31);
+					a = _mm512_set1_ps(packed_a[4]); c40 = _mm512_fmadd_ps(a, b0, c40); c41 = _mm512_fmadd_ps(a, b1, c41);
+					a = _mm512_set1_ps(packed_a[5]); c50 = _mm512_fmadd_ps(a, b0, c50); c51 = _mm512_fmadd_ps(a, b1, c51);
+					a = _mm512_set1_ps(packed_a[6]); c60 = _mm512_fmadd_ps(a, b0, c60); c61 = _mm512_fmadd_ps(a, b1, c61);
+					a = _mm512_set1_ps(packed_a[7]); c70 = _mm512_fmadd_ps(a, b0, c70); c71 = _mm512_fmadd_ps(a, b1, c71);
+					a = _mm512_set1_ps(packed_a[8]); c80 = _mm512_fmadd_ps(a, b0, c80); c81 = _mm512_fmadd_ps(a, b1, c81);
+					a = _mm512_set1_ps(packed_a[9]); c90 = _mm512_fmadd_ps(a, b0, c90); c91 = _mm512_fmadd_ps(a, b1, c91);
+					a = _mm512_set1_ps(packed_a[10]); ca0 = _mm512_fmadd_ps(a, b0, ca0); ca1 = _mm512_fmadd_ps(a, b1, ca1);
+					a = _mm512_set1_ps(packed_a[11]); cb0 = _mm512_fmadd_ps(a, b0, cb0); cb1 = _mm512_fmadd_ps(a, b1, cb1);
+				}
+
+				__m512 acc[24] = {c00, c01, c10, c11, c20, c21, c30, c31, c40, c41, c50, c51, c60, c61, c70, c71, c80, c81, c90, c91, ca0, ca1, cb0, cb1};
+				__m512 alpha_vec = _mm512_set1_ps(alpha);
+				if (beta == 0.0F)
+				{
+					for(unsigned int i = 0; i < 12; ++i, c += ldc)
+					{
+						_mm512_storeu_ps(c, _mm512_mul_ps(acc[i * 2], alpha_vec));
+						_mm512_storeu_ps(c + 16, _mm512_mul_ps(acc[i * 2 + 1], alpha_vec));
+					}
+				}
+				else
+				{
+					__m512 beta_vec = _mm512_set1_ps(beta);
+					for(unsigned int i = 0; i < 12; ++i, c += ldc)
+					{
+						_mm512_storeu_ps(c, _mm512_fmadd_ps(acc[i * 2], alpha_vec, _mm512_mul_ps(_mm512_loadu_ps(c), beta_vec)));
+						_mm512_storeu_ps(c + 16, _mm512_fmadd_ps(acc[i * 2 + 1], alpha_vec, _mm512_mul_ps(_mm512_loadu_ps(c + 16), beta_vec)));
+					}
+				}
+			}
+#endif
+
+			const micro_kernel_info generic_info = {4, 4, micro_kernel_generic};
+#if defined(NNFORGE_PLAIN_X86)
+			const micro_kernel_info sse2_info = {4, 8, micro_kernel_sse2};
+			const micro_kernel_info avx2_info = {6, 16, micro_kernel_avx2};
+			const micro_kernel_info avx512_info = {12, 32, micro_kernel_avx512};
+#endif
+
+			const micro_kernel_info& get_micro_kernel_info(cpu_dispatch_plain::isa isa)
+			{
+#if defined(NNFORGE_PLAIN_X86)
+				return cpu_dispatch_plain::select(isa, generic_info, sse2_info, avx2_info, avx512_info);
+#else
+				return generic_info;
+#endif
+			}
+
+			// Handles the register blocks partially covered by C
+			void micro_kernel_edge(
+				const micro_kernel_info& info,
+				unsigned int k_count,
+				const float * packed_a,
+				const float * packed_b,
+				float alpha,
+				float beta,
+				float * c,
+				unsigned int ldc,
+				unsigned int row_count,
+				unsigned int col_count)
+			{
+				float tmp[max_mr * max_nr];
+				info.kernel(k_count, packed_a, packed_b, alpha, 0.0F, tmp, info.nr);
+
+				const float * src = tmp;
+				for(unsigned int i = 0; i < row_count; ++i, c += ldc, src += info.nr)
+				{
+					if (beta == 0.0F)
+						std::copy(src, src + col_count, c);
+					else
+						for(unsigned int j = 0; j < col_count; ++j)
+							c[j] = src[j] + c[j] * beta;
+				}
+			}
+		}
+
+		const unsigned int gemm_plain::mc = 96;
+		const unsigned int gemm_plain::nc = 1024;
+		const unsigned int gemm_plain::kc = 256;
+
+		unsigned int gemm_plain::get_mr(cpu_dispatch_plain::isa isa)
+		{
+			return get_micro_kernel_info(isa).mr;
+		}
+
+		unsigned int gemm_plain::get_nr(cpu_dispatch_plain::isa isa)
+		{
+			return get_micro_kernel_info(isa).nr;
+		}
+
+		void gemm_plain::sgemm(
+			cpu_dispatch_plain::isa isa,
+			bool transpose_a,
+			bool transpose_b,
+			unsigned int m,
+			unsigned int n,
+			unsigned int k,
+			float alpha,
+			const float * a,
+			unsigned int lda,
+			const float * b,
+			unsigned int ldb,
+			float beta,
+			float * c,
+			unsigned int ldc,
+			int thread_count)
+		{
+			if ((m == 0) || (n == 0))
+				return;
+
+			if ((k == 0) || (alpha == 0.0F))
+			{
+				scale_c(m, n, beta, c, ldc);
+				return;
+			}
+
+			const micro_kernel_info& info = get_micro_kernel_info(isa);
+			const unsigned int mr = info.mr;
+			const unsigned int nr = info.nr;
+
+			unsigned int current_mc = std::min(mc, ((m + mr - 1) / mr) * mr);
+			unsigned int current_nc = std::min(nc, ((n + nr - 1) / nr) * nr);
+			const unsigned int current_kc = std::min(kc, k);
+
+			// Make sure there is enough tiles to keep all the threads busy
+			if (thread_count > 1)
+			{
+				const unsigned int min_tile_count = static_cast<unsigned int>(thread_count) * 2;
+				while (((m + current_mc - 1) / current_mc) * ((n + current_nc - 1) / current_nc) < min_tile_count)
+				{
+					if (current_nc >= current_mc * 2 && current_nc > nr * 4)
+						current_nc = ((current_nc / 2 + nr - 1) / nr) * nr;
+					else if (current_mc > mr * 2)
+						current_mc = ((current_mc / 2 + mr - 1) / mr) * mr;
+					else if (current_nc > nr)
+						current_nc = ((current_nc / 2 + nr - 1) / nr) * nr;
+					else
+						break;
+				}
+			}
+
+			const unsigned int row_block_count = (m + current_mc - 1) / current_mc;
+			const unsigned int col_block_count = (n + current_nc - 1) / current_nc;
+			const int tile_count = static_cast<int>(row_block_count * col_block_count);
+			const int actual_thread_count = std::max(std::min(thread_count, tile_count), 1);
+
+			#pragma omp parallel default(shared) num_threads(actual_thread_count)
+			{
+				std::vector<float> packed_a(current_mc * current_kc);
+				std::vector<float> packed_b(current_kc * current_nc);
+
+				#pragma omp for schedule(dynamic)
+				for(int tile_id = 0; tile_id < tile_count; ++tile_id)
+				{
+					const unsigned int row_block_id = static_cast<unsigned int>(tile_id) % row_block_count;
+					const unsigned int col_block_id = static_cast<unsigned int>(tile_id) / row_block_count;
+					const unsigned int row_start = row_block_id * current_mc;
+					const unsigned int row_count = std::min(current_mc, m - row_start);
+					const unsigned int col_start = col_block_id * current_nc;
+					const unsigned int col_count = std::min(current_nc, n - col_start);
+
+					for(unsigned int k_start = 0; k_start < k; k_start += current_kc)
+					{
+						const unsigned int k_count = std::min(current_kc, k - k_start);
+						const float current_beta = (k_start == 0) ? beta : 1.0F;
+
+						pack_b(transpose_b, b, ldb, k_start, k_count, col_start, col_count, nr, &packed_b[0]);
+						pack_a(transpose_a, a, lda, row_start, row_count, k_start, k_count, mr, &packed_a[0]);
+
+						for(unsigned int col_offset = 0; col_offset < col_count; col_offset += nr)
+						{
+							const unsigned int current_col_count = std::min(nr, col_count - col_offset);
+							const float * current_packed_b = &packed_b[0] + col_offset * k_count;
+							for(unsigned int row_offset = 0; row_offset < row_count; row_offset += mr)
+							{
+								const unsigned int current_row_count = std::min(mr, row_count - row_offset);
+								const float * current_packed_a = &packed_a[0] + row_offset * k_count;
+								float * current_c = c + (row_start + row_offset) * ldc + (col_start + col_offset);
+								if ((current_row_count == mr) && (current_col_count == nr))
+									info.kernel(k_count, current_packed_a, current_packed_b, alpha, current_beta, current_c, ldc);
+								else
+									micro_kernel_edge(info, k_count, current_packed_a, current_packed_b, alpha, current_beta, current_c, ldc, current_row_count, current_col_count);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		void gemm_plain::pack_a(
+			bool transpose_a,
+			const float * a,
+			unsigned int lda,
+			unsigned int row_start,
+			unsigned int row_count,
+			unsigned int k_start,
+			unsigned int k_count,
+			unsigned int mr,
+			float * packed_a)
+		{
+			for(unsigned int panel_row_start = 0; panel_row_start < row_count; panel_row_start += mr)
+			{
+				const unsigned int panel_row_count = std::min(mr, row_count - panel_row_start);
+				if (transpose_a)
+				{
+					const float * src = a + k_start * lda + (row_start + panel_row_start);
+					for(unsigned int p = 0; p < k_count; ++p, src += lda, packed_a += mr)
+					{
+						for(unsigned int i = 0; i < panel_row_count; ++i)
+							packed_a[i] = src[i];
+						for(unsigned int i = panel_row_count; i < mr; ++i)
+							packed_a[i] = 0.0F;
+					}
+				}
+				else
+				{
+					const float * src = a + (row_start + panel_row_start) * lda + k_start;
+					for(unsigned int i = 0; i < panel_row_count; ++i)
+					{
+						const float * src_row = src + i * lda;
+						float * dst = packed_a + i;
+						for(unsigned int p = 0; p < k_count; ++p)
+							dst[p * mr] = src_row[p];
+					}
+					for(unsigned int i = panel_row_count; i < mr; ++i)
+					{
+						float * dst = packed_a + i;
+						for(unsigned int p = 0; p < k_count; ++p)
+							dst[p * mr] = 0.0F;
+					}
+					packed_a += mr * k_count;
+				}
+			}
+		}
+
+		void gemm_plain::pack_b(
+			bool transpose_b,
+			const float * b,
+			unsigned int ldb,
+			unsigned int k_start,
+			unsigned int k_count,
+			unsigned int col_start,
+			unsigned int col_count,
+			unsigned int nr,
+			float * packed_b)
+		{
+			for(unsigned int panel_col_start = 0; panel_col_start < col_count; panel_col_start += nr)
+			{
+				const unsigned int panel_col_count = std::min(nr, col_count - panel_col_start);
+				if (transpose_b)
+				{
+					const float * src = b + (col_start + panel_col_start) * ldb + k_start;
+					for(unsigned int j = 0; j < panel_col_count; ++j)
+					{
+						const float * src_col = src + j * ldb;
+						float * dst = packed_b + j;
+						for(unsigned int p = 0; p < k_count; ++p)
+							dst[p * nr] = src_col[p];
+					}
+					for(unsigned int j = panel_col_count; j < nr; ++j)
+					{
+						float * dst = packed_b + j;
+						for(unsigned int p = 0; p < k_count; ++p)
+							dst[p * nr] = 0.0F;
+					}
+					packed_b += nr * k_count;
+				}
+				else
+				{
+					const float * src = b + k_start * ldb + (col_start + panel_col_start);
+					if (panel_col_count == nr)
+					{
+						for(unsigned int p = 0; p < k_count; ++p, src += ldb, packed_b += nr)
+							std::copy(src, src + nr, packed_b);
+					}
+					else
+					{
+						for(unsigned int p = 0; p < k_count; ++p, src += ldb, packed_b += nr)
+						{
+							std::copy(src, src + panel_col_count, packed_b);
+							std::fill(packed_b + panel_col_count, packed_b + nr, 0.0F);
+						}
+					}
+				}
+			}
+		}
+
+		void gemm_plain::scale_c(
+			unsigned int m,
+			unsigned int n,
+			float beta,
+			float * c,
+			unsigned int ldc)
+		{
+			for(unsigned int i = 0; i < m; ++i, c += ldc)
+			{
+				if (beta == 0.0F)
+					std::fill_n(c, n, 0.0F);
+				else if (beta != 1.0F)
+					for(unsigned int j = 0; j < n; ++j)
+						c[j] *= beta;
+			}
+		}
+	}
+}
@@ -0,0 +1,96 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "cpu_dispatch_plain.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Single precision GEMM for row-major matrices: C = alpha * op(A) * op(B) + beta * C
+		// op(A) is m x k matrix, op(B) is k x n matrix, C is m x n matrix
+		// Both operands are packed into cache-sized panels which are multiplied by register-blocked SIMD micro-kernel,
+		// the micro-kernel is chosen at runtime for the instruction set passed, usually plain_running_configuration::cpu_isa
+		class gemm_plain
+		{
+		public:
+			// When thread_count > 1 the function spawns its own OpenMP parallel region,
+			// call it with thread_count = 1 from inside an existing parallel region
+			static void sgemm(
+				cpu_dispatch_plain::isa isa,
+				bool transpose_a,
+				bool transpose_b,
+				unsigned int m,
+				unsigned int n,
+				unsigned int k,
+				float alpha,
+				const float * a,
+				unsigned int lda,
+				const float * b,
+				unsigned int ldb,
+				float beta,
+				float * c,
+				unsigned int ldc,
+				int thread_count = 1);
+
+			// Register block of the micro-kernel of the instruction set
+			static unsigned int get_mr(cpu_dispatch_plain::isa isa);
+			static unsigned int get_nr(cpu_dispatch_plain::isa isa);
+
+		private:
+			static void pack_a(
+				bool transpose_a,
+				const float * a,
+				unsigned int lda,
+				unsigned int row_start,
+				unsigned int row_count,
+				unsigned int k_start,
+				unsigned int k_count,
+				unsigned int mr,
+				float * packed_a);
+
+			static void pack_b(
+				bool transpose_b,
+				const float * b,
+				unsigned int ldb,
+				unsigned int k_start,
+				unsigned int k_count,
+				unsigned int col_start,
+				unsigned int col_count,
+				unsigned int nr,
+				float * packed_b);
+
+			static void scale_c(
+				unsigned int m,
+				unsigned int n,
+				float beta,
+				float * c,
+				unsigned int ldc);
+
+		private:
+			// Cache blocks
+			static const unsigned int mc;
+			static const unsigned int nc;
+			static const unsigned int kc;
+
+		private:
+			gemm_plain();
+			~gemm_plain();
+		};
+	}
+}
@@ -0,0 +1,137 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "gradient_reduction_plain.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const size_t gradient_reduction_plain::cache_line_size = 64;
+		const size_t gradient_reduction_plain::max_slab_buffer_size = 256 * 1024 * 1024;
+		const unsigned int gradient_reduction_plain::min_work_item_count_per_thread = 4;
+		const size_t gradient_reduction_plain::reduction_chunk_elem_count = 4096;
+
+		unsigned int gradient_reduction_plain::get_max_slice_count(
+			unsigned int work_item_count,
+			size_t gradient_elem_count,
+			int thread_count)
+		{
+			if (thread_count <= 1)
+				return 1;
+			if (work_item_count >= static_cast<unsigned int>(thread_count) * min_work_item_count_per_thread)
+				return 1;
+
+			size_t slab_size = get_aligned_elem_count(gradient_elem_count) * sizeof(float);
+			size_t max_slice_count_by_memory = (max_slab_buffer_size - cache_line_size) / std::max(slab_size, static_cast<size_t>(1));
+			unsigned int res = static_cast<unsigned int>(std::min(static_cast<size_t>(thread_count), max_slice_count_by_memory));
+
+			return (res < 2) ? 1 : res;
+		}
+
+		unsigned int gradient_reduction_plain::get_slice_count(
+			unsigned int work_item_count,
+			size_t gradient_elem_count,
+			unsigned int entry_count,
+			int thread_count)
+		{
+			unsigned int res = std::min(get_max_slice_count(work_item_count, gradient_elem_count, thread_count), entry_count);
+
+			return (res < 2) ? 1 : res;
+		}
+
+		size_t gradient_reduction_plain::get_slab_buffer_size(
+			unsigned int work_item_count,
+			size_t gradient_elem_count,
+			int thread_count)
+		{
+			unsigned int max_slice_count = get_max_slice_count(work_item_count, gradient_elem_count, thread_count);
+			if (max_slice_count <= 1)
+				return 0;
+
+			// Extra cache line allows aligning the start of the first slab
+			return get_aligned_elem_count(gradient_elem_count) * sizeof(float) * max_slice_count + cache_line_size;
+		}
+
+		float * gradient_reduction_plain::get_slab(
+			void * slab_buffer,
+			size_t gradient_elem_count,
+			unsigned int slice_id)
+		{
+			size_t aligned_address = (reinterpret_cast<size_t>(slab_buffer) + cache_line_size - 1) & ~(cache_line_size - 1);
+			return reinterpret_cast<float *>(aligned_address) + get_aligned_elem_count(gradient_elem_count) * slice_id;
+		}
+
+		void gradient_reduction_plain::get_entry_range(
+			unsigned int entry_count,
+			unsigned int slice_count,
+			unsigned int slice_id,
+			unsigned int& entry_start,
+			unsigned int& entry_end)
+		{
+			entry_start = static_cast<unsigned int>(static_cast<size_t>(entry_count) * slice_id / slice_count);
+			entry_end = static_cast<unsigned int>(static_cast<size_t>(entry_count) * (slice_id + 1) / slice_count);
+		}
+
+		size_t gradient_reduction_plain::get_aligned_elem_count(size_t elem_count)
+		{
+			const size_t elem_count_per_cache_line = cache_line_size / sizeof(float);
+			return (elem_count + elem_count_per_cache_line - 1) / elem_count_per_cache_line * elem_count_per_cache_line;
+		}
+
+		void gradient_reduction_plain::reduce(
+			void * slab_buffer,
+			size_t gradient_elem_count,
+			unsigned int slice_count,
+			float * gradient,
+			int thread_count)
+		{
+			const size_t chunk_count = (gradient_elem_count + reduction_chunk_elem_count - 1) / reduction_chunk_elem_count;
+
+			// Pairwise tree over slabs, each level is split into chunks so that all the threads are busy
+			for(unsigned int step = 1; step < slice_count; step *= 2)
+			{
+				const unsigned int pair_count = (slice_count - step + 2 * step - 1) / (2 * step);
+				const int total_workload = static_cast<int>(pair_count * chunk_count);
+				#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					const unsigned int pair_id = static_cast<unsigned int>(workload_id / chunk_count);
+					const size_t chunk_id = workload_id - pair_id * chunk_count;
+					float * dst = get_slab(slab_buffer, gradient_elem_count, pair_id * 2 * step);
+					const float * src = get_slab(slab_buffer, gradient_elem_count, pair_id * 2 * step + step);
+					const size_t start = chunk_id * reduction_chunk_elem_count;
+					const size_t end = std::min(start + reduction_chunk_elem_count, gradient_elem_count);
+					for(size_t i = start; i < end; ++i)
+						dst[i] += src[i];
+				}
+			}
+
+			const float * src = get_slab(slab_buffer, gradient_elem_count, 0);
+			const int total_workload = static_cast<int>(chunk_count);
+			#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+			for(int chunk_id = 0; chunk_id < total_workload; ++chunk_id)
+			{
+				const size_t start = chunk_id * reduction_chunk_elem_count;
+				const size_t end = std::min(start + reduction_chunk_elem_count, gradient_elem_count);
+				for(size_t i = start; i < end; ++i)
+					gradient[i] += src[i];
+			}
+		}
+	}
+}
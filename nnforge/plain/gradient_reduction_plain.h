@@ -0,0 +1,90 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Privatized gradient accumulation: entries are split into slices, each slice is accumulated
+		// into its own cache line aligned slab, then the slabs are summed into the gradient with tree reduction
+		class gradient_reduction_plain
+		{
+		public:
+			// Maximum number of slices, used to size the slab buffer; returns 1 when work items alone
+			// keep all the threads busy or when the slabs don't fit memory, the gradient is updated in place then
+			static unsigned int get_max_slice_count(
+				unsigned int work_item_count,
+				size_t gradient_elem_count,
+				int thread_count);
+
+			// Returns 1 when the gradient should be updated in place
+			static unsigned int get_slice_count(
+				unsigned int work_item_count,
+				size_t gradient_elem_count,
+				unsigned int entry_count,
+				int thread_count);
+
+			// Returns 0 when max slice count is 1
+			static size_t get_slab_buffer_size(
+				unsigned int work_item_count,
+				size_t gradient_elem_count,
+				int thread_count);
+
+			static float * get_slab(
+				void * slab_buffer,
+				size_t gradient_elem_count,
+				unsigned int slice_id);
+
+			static void get_entry_range(
+				unsigned int entry_count,
+				unsigned int slice_count,
+				unsigned int slice_id,
+				unsigned int& entry_start,
+				unsigned int& entry_end);
+
+			// Sums all the slabs and adds the result to gradient, slabs are overwritten
+			static void reduce(
+				void * slab_buffer,
+				size_t gradient_elem_count,
+				unsigned int slice_count,
+				float * gradient,
+				int thread_count);
+
+		private:
+			static size_t get_aligned_elem_count(size_t elem_count);
+
+		private:
+			static const size_t cache_line_size;
+
+			// Slabs taking more memory than this are not allocated
+			static const size_t max_slab_buffer_size;
+
+			// Work items per thread enough for the load to be balanced without splitting entries
+			static const unsigned int min_work_item_count_per_thread;
+
+			// Number of elements summed by a single task of the reduction
+			static const size_t reduction_chunk_elem_count;
+
+		private:
+			gradient_reduction_plain();
+			~gradient_reduction_plain();
+		};
+	}
+}
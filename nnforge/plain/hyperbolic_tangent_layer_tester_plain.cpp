@@ -16,13 +16,35 @@
 
 #include "hyperbolic_tangent_layer_tester_plain.h"
 
+#include "parallel_plain.h"
+#include "simd_kernels_plain.h"
+#include "spatial_split_plain.h"
 #include "../hyperbolic_tangent_layer.h"
 #include "../nn_types.h"
 
+#include <algorithm>
+
 namespace nnforge
 {
 	namespace plain
 	{
+		namespace
+		{
+			struct hyperbolic_tangent_forward_chunk
+			{
+				cpu_dispatch_plain::isa isa;
+				const float * in_it;
+				float * out_it;
+				float hyperbolic_tangent_steepness2;
+				float hyperbolic_tangent_major_multiplier;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					simd_kernels_plain::hyperbolic_tangent(isa, in_it + start, out_it + start, current_elem_count, hyperbolic_tangent_steepness2, hyperbolic_tangent_major_multiplier);
+				}
+			};
+		}
+
 		hyperbolic_tangent_layer_tester_plain::hyperbolic_tangent_layer_tester_plain()
 		{
 		}
@@ -57,14 +79,14 @@ namespace nnforge
 			const float hyperbolic_tangent_steepness2 = layer_derived->steepness * 2.0F;
 			const float hyperbolic_tangent_major_multiplier = layer_derived->scale;
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
-			{
-				float inp = *(in_it + i);
-				float inp2 = expf(inp * hyperbolic_tangent_steepness2);
-				float res = (inp2 - 1.0F) / (inp2 + 1.0F) * hyperbolic_tangent_major_multiplier;
-				*(out_it + i) = res;
-			}
+			const int chunk_elem_count = spatial_split_plain::get_chunk_elem_count(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count);
+			hyperbolic_tangent_forward_chunk body;
+			body.isa = plain_config->cpu_isa;
+			body.in_it = in_it;
+			body.out_it = out_it;
+			body.hyperbolic_tangent_steepness2 = hyperbolic_tangent_steepness2;
+			body.hyperbolic_tangent_major_multiplier = hyperbolic_tangent_major_multiplier;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, chunk_elem_count, body);
 		}
 
 		int hyperbolic_tangent_layer_tester_plain::get_input_index_layer_can_write(
@@ -75,5 +97,14 @@ namespace nnforge
 		{
 			return 0;
 		}
+
+		bool hyperbolic_tangent_layer_tester_plain::is_channel_blocked_layout_supported(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return true;
+		}
 	}
 }
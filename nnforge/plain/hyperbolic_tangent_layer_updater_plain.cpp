@@ -16,12 +16,49 @@
 
 #include "hyperbolic_tangent_layer_updater_plain.h"
 
+#include "parallel_plain.h"
+#include "simd_kernels_plain.h"
 #include "../hyperbolic_tangent_layer.h"
 
+#include <algorithm>
+
 namespace nnforge
 {
 	namespace plain
 	{
+		namespace
+		{
+			struct hyperbolic_tangent_forward_chunk
+			{
+				cpu_dispatch_plain::isa isa;
+				const float * in_it;
+				float * out_it;
+				float hyperbolic_tangent_steepness2;
+				float hyperbolic_tangent_major_multiplier;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					simd_kernels_plain::hyperbolic_tangent(isa, in_it + start, out_it + start, current_elem_count, hyperbolic_tangent_steepness2, hyperbolic_tangent_major_multiplier);
+				}
+			};
+
+			struct hyperbolic_tangent_backward_chunk
+			{
+				cpu_dispatch_plain::isa isa;
+				const float * out_it;
+				const float * out_err_it;
+				float * in_err_it;
+				float hyperbolic_tangent_major_multiplier_reverse;
+				float hyperbolic_tangent_steepness3;
+				bool add_update_to_destination;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					simd_kernels_plain::hyperbolic_tangent_backward(isa, out_it + start, out_err_it + start, in_err_it + start, current_elem_count, hyperbolic_tangent_major_multiplier_reverse, hyperbolic_tangent_steepness3, add_update_to_destination);
+				}
+			};
+		}
+
 		hyperbolic_tangent_layer_updater_plain::hyperbolic_tangent_layer_updater_plain()
 		{
 		}
@@ -58,14 +95,13 @@ namespace nnforge
 			const float hyperbolic_tangent_steepness2 = layer_derived->steepness * 2.0F;
 			const float hyperbolic_tangent_major_multiplier = layer_derived->scale;
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
-			{
-				float inp = *(in_it + i);
-				float inp2 = expf(inp * hyperbolic_tangent_steepness2);
-				float res = (inp2 - 1.0F) / (inp2 + 1.0F) * hyperbolic_tangent_major_multiplier;
-				*(out_it + i) = res;
-			}
+			hyperbolic_tangent_forward_chunk body;
+			body.isa = plain_config->cpu_isa;
+			body.in_it = in_it;
+			body.out_it = out_it;
+			body.hyperbolic_tangent_steepness2 = hyperbolic_tangent_steepness2;
+			body.hyperbolic_tangent_major_multiplier = hyperbolic_tangent_major_multiplier;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count, body);
 		}
 
 		void hyperbolic_tangent_layer_updater_plain::run_backward_data_propagation(
@@ -95,28 +131,15 @@ namespace nnforge
 			nnforge_shared_ptr<const hyperbolic_tangent_layer> layer_derived = nnforge_dynamic_pointer_cast<const hyperbolic_tangent_layer>(layer_schema);
 			const float hyperbolic_tangent_major_multiplier_reverse = 1.0F / layer_derived->scale;
 			const float hyperbolic_tangent_steepness3 = layer_derived->steepness * layer_derived->scale;
-			if (add_update_to_destination)
-			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
-				{
-					float out_neuron = *(out_it + i);
-					float normalized_value = out_neuron * hyperbolic_tangent_major_multiplier_reverse;
-					float der1st = hyperbolic_tangent_steepness3 * (1.0F - (normalized_value * normalized_value));
-					*(in_err_it + i) += *(out_err_it + i) * der1st;
-				}
-			}
-			else
-			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
-				{
-					float out_neuron = *(out_it + i);
-					float normalized_value = out_neuron * hyperbolic_tangent_major_multiplier_reverse;
-					float der1st = hyperbolic_tangent_steepness3 * (1.0F - (normalized_value * normalized_value));
-					*(in_err_it + i) = *(out_err_it + i) * der1st;
-				}
-			}
+			hyperbolic_tangent_backward_chunk body;
+			body.isa = plain_config->cpu_isa;
+			body.out_it = out_it;
+			body.out_err_it = out_err_it;
+			body.in_err_it = in_err_it;
+			body.hyperbolic_tangent_major_multiplier_reverse = hyperbolic_tangent_major_multiplier_reverse;
+			body.hyperbolic_tangent_steepness3 = hyperbolic_tangent_steepness3;
+			body.add_update_to_destination = add_update_to_destination;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count, body);
 		}
 
 		int hyperbolic_tangent_layer_updater_plain::get_input_index_layer_can_write(
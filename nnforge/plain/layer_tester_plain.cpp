@@ -28,6 +28,56 @@ namespace nnforge
 		{
 		}
 
+		bool layer_tester_plain::is_applicable(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return true;
+		}
+
+		bool layer_tester_plain::is_channel_blocked_layout_supported(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return false;
+		}
+
+		bool layer_tester_plain::is_channel_blocked_layout_preferred() const
+		{
+			return false;
+		}
+
+		void layer_tester_plain::run_forward_propagation_channel_blocked(
+			plain_buffer::ptr output_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count) const
+		{
+			run_forward_propagation(
+				output_buffer,
+				input_buffers,
+				temporary_working_fixed_buffer,
+				temporary_working_per_entry_buffer,
+				plain_config,
+				layer_schema,
+				data,
+				data_custom,
+				input_configuration_specific_list,
+				output_configuration_specific,
+				entry_count);
+		}
+
 		int layer_tester_plain::get_input_index_layer_can_write(
 			plain_running_configuration::const_ptr plain_config,
 			layer::const_ptr layer_schema,
@@ -54,5 +104,29 @@ namespace nnforge
 		{
 			return 0;
 		}
+
+		layer_data::const_ptr layer_tester_plain::get_data(
+			layer_data::const_ptr host_data,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return host_data;
+		}
+
+		std::vector<std::string> layer_tester_plain::get_algorithm_candidates(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return std::vector<std::string>();
+		}
+
+		const std::string& layer_tester_plain::get_algorithm(plain_running_configuration::const_ptr plain_config) const
+		{
+			return plain_config->algorithm;
+		}
 	}
 }
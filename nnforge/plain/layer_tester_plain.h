@@ -40,6 +40,14 @@ namespace nnforge
 
 			virtual std::string get_type_name() const = 0;
 
+			// Specialized testers, registered with register_specialized_layer_tester_plain, are used only for the layers
+			// they report being applicable to, the generic tester for the layer type is used otherwise. Default impl returns true
+			virtual bool is_applicable(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 			virtual void run_forward_propagation(
 				plain_buffer::ptr output_buffer,
 				const std::vector<plain_buffer::const_ptr>& input_buffers,
@@ -53,6 +61,34 @@ namespace nnforge
 				const layer_configuration_specific& output_configuration_specific,
 				unsigned int entry_count) const = 0;
 
+			// Returns true when the tester can run with all the inputs and the output in channel blocked layout
+			// of plain_config->channel_block_size. It is called only when feature map counts of all the inputs
+			// and of the output are multiples of the block size. Default impl returns false
+			virtual bool is_channel_blocked_layout_supported(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Testers returning true switch to channel blocked layout even when their inputs are in plain layout,
+			// the rest use it only when all their inputs are already blocked. Default impl returns false
+			virtual bool is_channel_blocked_layout_preferred() const;
+
+			// Called instead of run_forward_propagation when the inputs and the output are in channel blocked layout.
+			// Default impl calls run_forward_propagation, which is correct for testers processing each neuron independently
+			virtual void run_forward_propagation_channel_blocked(
+				plain_buffer::ptr output_buffer,
+				const std::vector<plain_buffer::const_ptr>& input_buffers,
+				plain_buffer::ptr temporary_working_fixed_buffer,
+				plain_buffer::ptr temporary_working_per_entry_buffer,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				layer_data::const_ptr data,
+				layer_data_custom::const_ptr data_custom,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count) const;
+
 			virtual int get_input_index_layer_can_write(
 				plain_running_configuration::const_ptr plain_config,
 				layer::const_ptr layer_schema,
@@ -71,9 +107,29 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+			// The method is called when either network data or layer configuration is modified,
+			// the data returned is then passed to run_forward_propagation. Default impl returns host_data
+			virtual layer_data::const_ptr get_data(
+				layer_data::const_ptr host_data,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Names of the algorithms auto_tuner_plain times to choose the fastest one, which is then returned by get_algorithm.
+			// Default impl returns empty list, the layer is not tuned then
+			virtual std::vector<std::string> get_algorithm_candidates(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 		protected:
 			layer_tester_plain();
 
+			// Returns the algorithm forward prop resolved for the layer when setting it up, empty string means the heuristic choice should be made
+			const std::string& get_algorithm(plain_running_configuration::const_ptr plain_config) const;
+
 		private:
 			layer_tester_plain(const layer_tester_plain&);
 			layer_tester_plain& operator =(const layer_tester_plain&);
@@ -20,6 +20,7 @@
 #include "layer_tester_plain.h"
 
 #include <map>
+#include <vector>
 #include <boost/serialization/singleton.hpp>
 
 namespace nnforge
@@ -33,13 +34,27 @@ namespace nnforge
 
 			bool register_layer_tester_plain(layer_tester_plain::const_ptr sample_layer_tester_plain);
 
+			// Specialized testers are tried in the order of registration before the generic one
+			void register_specialized_layer_tester_plain(layer_tester_plain::const_ptr sample_layer_tester_plain);
+
+			// Unregisters both generic and specialized testers
 			bool unregister_layer_tester_plain(const std::string& layer_type_name);
 
 			layer_tester_plain::const_ptr get_tester_plain_layer(const std::string& layer_type_name) const;
 
+			// Returns the first specialized tester applicable to the layer, the generic one if there is none
+			layer_tester_plain::const_ptr get_tester_plain_layer(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 		private:
 			typedef std::map<std::string, layer_tester_plain::const_ptr> sample_map;
 			sample_map sample_layer_tester_plain_map;
+
+			typedef std::map<std::string, std::vector<layer_tester_plain::const_ptr> > specialized_sample_map;
+			specialized_sample_map specialized_sample_layer_tester_plain_map;
 		};
 	}
 }
@@ -30,6 +30,15 @@ namespace nnforge
 		{
 		}
 
+		bool layer_updater_plain::is_applicable(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return true;
+		}
+
 		void layer_updater_plain::run_backward_data_propagation(
 			unsigned int input_index,
 			plain_buffer::ptr input_errors_buffer,
@@ -70,6 +79,28 @@ namespace nnforge
 			throw neural_network_exception((boost::format("run_backward_data_propagation is not implemented for layer %1%") % layer_schema->instance_name).str());
 		}
 
+		void layer_updater_plain::run_backward_data_and_weights_propagation(
+			plain_buffer::ptr input_errors_buffer,
+			plain_buffer::const_ptr output_errors_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+			plain_buffer::const_ptr output_neurons_buffer,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_buffer::ptr temporary_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data::ptr gradient,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const bool add_update_to_destination,
+			const std::set<layer_action>& actions,
+			unsigned int entry_count) const
+		{
+			throw neural_network_exception((boost::format("run_backward_data_and_weights_propagation is not implemented for layer %1%") % layer_schema->instance_name).str());
+		}
+
 		int layer_updater_plain::get_input_index_layer_can_write(
 			const layer_action& action,
 			const std::set<layer_action>& actions,
@@ -194,5 +225,70 @@ namespace nnforge
 
 			return (get_temporary_per_entry_buffer_size(actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific) != 0);
 		}
+
+		bool layer_updater_plain::is_backward_data_and_weights_dependent_on_input_buffer(
+			unsigned int data_input_index,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			if (actions.find(layer_action(layer_action::backward_data_and_weights)) == actions.end())
+				throw neural_network_exception((boost::format("is_backward_data_and_weights_dependent_on_input_buffer called for layer %1% while it is not configured to run action %2%") % layer_schema->instance_name % layer_action(layer_action::backward_data_and_weights).str()).str());
+
+			return true;
+		}
+
+		bool layer_updater_plain::is_backward_data_and_weights_dependent_on_output_buffer(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			if (actions.find(layer_action(layer_action::backward_data_and_weights)) == actions.end())
+				throw neural_network_exception((boost::format("is_backward_data_and_weights_dependent_on_output_buffer called for layer %1% while it is not configured to run action %2%") % layer_schema->instance_name % layer_action(layer_action::backward_data_and_weights).str()).str());
+
+			return true;
+		}
+
+		bool layer_updater_plain::is_backward_data_and_weights_dependent_on_temporary_per_entry_buffer(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			if (actions.find(layer_action(layer_action::backward_data_and_weights)) == actions.end())
+				throw neural_network_exception((boost::format("is_backward_data_and_weights_dependent_on_temporary_per_entry_buffer called for layer %1% while it is not configured to run action %2%") % layer_schema->instance_name % layer_action(layer_action::backward_data_and_weights).str()).str());
+
+			return (get_temporary_per_entry_buffer_size(actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific) != 0);
+		}
+
+		bool layer_updater_plain::is_forward_recomputable(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return true;
+		}
+
+		std::vector<std::string> layer_updater_plain::get_algorithm_candidates(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return std::vector<std::string>();
+		}
+
+		const std::string& layer_updater_plain::get_algorithm(plain_running_configuration::const_ptr plain_config) const
+		{
+			return plain_config->algorithm;
+		}
 	}
 }
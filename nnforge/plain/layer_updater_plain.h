@@ -38,6 +38,14 @@ namespace nnforge
 
 			virtual std::string get_type_name() const = 0;
 
+			// Specialized updaters, registered with register_specialized_layer_updater_plain, are used only for the layers
+			// they report being applicable to, the generic updater for the layer type is used otherwise. Default impl returns true
+			virtual bool is_applicable(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 			virtual void run_forward_propagation(
 				plain_buffer::ptr output_buffer,
 				const std::vector<plain_buffer::const_ptr>& input_buffers,
@@ -87,6 +95,27 @@ namespace nnforge
 				const std::set<layer_action>& actions,
 				unsigned int entry_count) const;
 
+			// Runs both backward data and backward weights for the layers having fused backward_data_and_weights action,
+			// such layers have the only input
+			virtual void run_backward_data_and_weights_propagation(
+				plain_buffer::ptr input_errors_buffer,
+				plain_buffer::const_ptr output_errors_buffer,
+				const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+				plain_buffer::const_ptr output_neurons_buffer,
+				plain_buffer::ptr temporary_working_fixed_buffer,
+				plain_buffer::ptr temporary_working_per_entry_buffer,
+				plain_buffer::ptr temporary_per_entry_buffer,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				layer_data::const_ptr data,
+				layer_data::ptr gradient,
+				layer_data_custom::const_ptr data_custom,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				const bool add_update_to_destination,
+				const std::set<layer_action>& actions,
+				unsigned int entry_count) const;
+
 			// Default impl returns -1
 			virtual int get_input_index_layer_can_write(
 				const layer_action& action,
@@ -165,9 +194,56 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+			// Default impl returns true
+			virtual bool is_backward_data_and_weights_dependent_on_input_buffer(
+				unsigned int data_input_index,
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Default impl returns true
+			virtual bool is_backward_data_and_weights_dependent_on_output_buffer(
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Default impl returns get_temporary_per_entry_buffer_size() != 0
+			virtual bool is_backward_data_and_weights_dependent_on_temporary_per_entry_buffer(
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Whether running forward prop once more gives the same output and temporary per entry buffer and changes nothing else,
+			// backward prop keeps outputs of the layers which are not recomputable. Default impl returns true
+			virtual bool is_forward_recomputable(
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Names of the algorithms auto_tuner_plain times to choose the fastest one, which is then returned by get_algorithm.
+			// Default impl returns empty list, the layer is not tuned then
+			virtual std::vector<std::string> get_algorithm_candidates(
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 		protected:
 			layer_updater_plain();
 
+			// Returns the algorithm backward prop resolved for the layer and its set of actions when setting it up,
+			// empty string means the heuristic choice should be made
+			const std::string& get_algorithm(plain_running_configuration::const_ptr plain_config) const;
+
 		private:
 			layer_updater_plain(const layer_updater_plain&);
 			layer_updater_plain& operator =(const layer_updater_plain&);
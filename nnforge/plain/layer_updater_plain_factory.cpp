@@ -29,8 +29,14 @@ namespace nnforge
 			return sample_layer_updater_plain_map.insert(sample_map::value_type(sample_layer_updater_plain->get_type_name(), sample_layer_updater_plain)).second;
 		}
 
+		void layer_updater_plain_factory::register_specialized_layer_updater_plain(layer_updater_plain::const_ptr sample_layer_updater_plain)
+		{
+			specialized_sample_layer_updater_plain_map[sample_layer_updater_plain->get_type_name()].push_back(sample_layer_updater_plain);
+		}
+
 		bool layer_updater_plain_factory::unregister_layer_updater_plain(const std::string& layer_type_name)
 		{
+			specialized_sample_layer_updater_plain_map.erase(layer_type_name);
 			return sample_layer_updater_plain_map.erase(layer_type_name) == 1;
 		}
 
@@ -43,5 +49,22 @@ namespace nnforge
 
 			return i->second;
 		}
+
+		layer_updater_plain::const_ptr layer_updater_plain_factory::get_updater_plain_layer(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			specialized_sample_map::const_iterator i = specialized_sample_layer_updater_plain_map.find(layer_schema->get_type_name());
+			if (i != specialized_sample_layer_updater_plain_map.end())
+			{
+				for(std::vector<layer_updater_plain::const_ptr>::const_iterator it = i->second.begin(); it != i->second.end(); ++it)
+					if ((*it)->is_applicable(plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific))
+						return *it;
+			}
+
+			return get_updater_plain_layer(layer_schema->get_type_name());
+		}
 	}
 }
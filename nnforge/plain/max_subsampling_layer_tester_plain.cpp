@@ -16,6 +16,8 @@
 
 #include "max_subsampling_layer_tester_plain.h"
 
+#include "simd_kernels_plain.h"
+#include "spatial_split_plain.h"
 #include "../max_subsampling_layer.h"
 #include "../nn_types.h"
 #include "../neural_network_exception.h"
@@ -76,6 +78,121 @@ namespace nnforge
 					entry_count);
 		}
 
+		bool max_subsampling_layer_tester_plain::is_channel_blocked_layout_supported(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			nnforge_shared_ptr<const max_subsampling_layer> layer_derived = nnforge_dynamic_pointer_cast<const max_subsampling_layer>(layer_schema);
+
+			if (layer_derived->tiling)
+				return false;
+			if ((layer_derived->feature_map_subsampling_size != 1) || (layer_derived->entry_subsampling_size != 1))
+				return false;
+			for(std::vector<bool>::const_iterator it = layer_derived->round_ups.begin(); it != layer_derived->round_ups.end(); ++it)
+				if (*it)
+					return false;
+
+			return true;
+		}
+
+		void max_subsampling_layer_tester_plain::run_forward_propagation_channel_blocked(
+			plain_buffer::ptr output_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count) const
+		{
+			nnforge_shared_ptr<const max_subsampling_layer> layer_derived = nnforge_dynamic_pointer_cast<const max_subsampling_layer>(layer_schema);
+
+			const layer_configuration_specific& input_configuration_specific = input_configuration_specific_list[0];
+			const unsigned int block_size = plain_config->channel_block_size;
+			const unsigned int block_count = output_configuration_specific.feature_map_count / block_size;
+			const unsigned int spatial_dimension_count = static_cast<unsigned int>(output_configuration_specific.dimension_sizes.size());
+			const float * const in_it_global = *input_buffers[0];
+			float * const out_it_global = *output_buffer;
+			const unsigned int input_neuron_count_per_feature_map = input_configuration_specific.get_neuron_count_per_feature_map();
+			const unsigned int output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const size_t input_block_elem_count = static_cast<size_t>(input_neuron_count_per_feature_map) * block_size;
+			const size_t output_block_elem_count = static_cast<size_t>(output_neuron_count_per_feature_map) * block_size;
+			std::vector<unsigned int> strides = layer_derived->strides;
+			strides.resize(spatial_dimension_count, 1);
+			std::vector<unsigned int> subsampling_sizes = layer_derived->subsampling_sizes;
+			subsampling_sizes.resize(spatial_dimension_count, 1);
+			std::vector<unsigned int> input_slices(spatial_dimension_count + 1);
+			input_slices[0] = 1;
+			for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+				input_slices[i + 1] = input_slices[i] * input_configuration_specific.dimension_sizes[i];
+			unsigned int subsampling_elem_count = 1;
+			for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+				subsampling_elem_count *= subsampling_sizes[i];
+			const bool is_min = layer_derived->is_min;
+			const cpu_dispatch_plain::isa isa = plain_config->cpu_isa;
+
+			// Offsets are in spatial positions, each position holds block_size feature maps
+			std::vector<unsigned int> current_local_input_position(spatial_dimension_count, 0);
+			std::vector<unsigned int> offset_list(subsampling_elem_count);
+			for(unsigned int i = 1; i < subsampling_elem_count; ++i)
+			{
+				int offset = 0;
+				for(unsigned int j = 0; j < spatial_dimension_count; ++j)
+				{
+					offset += static_cast<int>(input_slices[j]);
+					if ((++current_local_input_position[j]) < subsampling_sizes[j])
+					{
+						offset_list[i] = offset_list[i-1] + offset;
+						break;
+					}
+					current_local_input_position[j] = 0;
+					offset -= static_cast<int>(subsampling_sizes[j] * input_slices[j]);
+				}
+			}
+
+			const int total_workload = static_cast<int>(entry_count * block_count);
+			const std::vector<unsigned int>& output_dimension_sizes = output_configuration_specific.dimension_sizes;
+
+			#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
+			{
+				nnforge_array<unsigned int, max_dimension_count> current_output_position;
+
+				#pragma omp for schedule(guided)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					const float * in_it_base = in_it_global + workload_id * input_block_elem_count;
+					float * out_it = out_it_global + workload_id * output_block_elem_count;
+
+					std::fill_n(current_output_position.begin(), spatial_dimension_count, 0);
+					for(unsigned int output_neuron_id = 0; output_neuron_id < output_neuron_count_per_feature_map; ++output_neuron_id, out_it += block_size)
+					{
+						unsigned int input_offset = 0;
+						for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+							input_offset += current_output_position[i] * strides[i] * input_slices[i];
+
+						// The window is accumulated in the output directly, offset_list[0] is always 0
+						const float * in_it_window = in_it_base + input_offset * block_size;
+						std::copy(in_it_window, in_it_window + block_size, out_it);
+						for(unsigned int i = 1; i < subsampling_elem_count; ++i)
+							simd_kernels_plain::max_accumulate(isa, out_it, in_it_window + offset_list[i] * block_size, block_size, is_min);
+
+						// Go to the next output element
+						for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+						{
+							if ((++current_output_position[i]) < output_dimension_sizes[i])
+								break;
+							current_output_position[i] = 0;
+						}
+					}
+				}
+			}
+		}
+
 		void max_subsampling_layer_tester_plain::test_tiling(
 			plain_buffer::ptr output_buffer,
 			plain_buffer::const_ptr input_buffer,
@@ -249,7 +366,12 @@ namespace nnforge
 				}
 			}
 
-			const int total_workload = entry_count * output_configuration_specific.feature_map_count;
+			const unsigned int spatial_split_count = spatial_split_plain::get_split_count(
+				*plain_config,
+				entry_count * output_feature_map_count,
+				output_neuron_count_per_feature_map,
+				const_subsampling_elem_count);
+			const int total_workload = entry_count * output_configuration_specific.feature_map_count * spatial_split_count;
 			const std::vector<unsigned int>::const_iterator dimension_sizes_it = output_dimension_sizes.begin();
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
@@ -262,14 +384,24 @@ namespace nnforge
 				#pragma omp for schedule(guided)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
-					int output_entry_id = workload_id / output_feature_map_count;
-					int output_feature_map_id = workload_id - (output_entry_id * output_feature_map_count);
+					int feature_map_workload_id = workload_id / spatial_split_count;
+					int spatial_split_id = workload_id - (feature_map_workload_id * spatial_split_count);
+					int output_entry_id = feature_map_workload_id / output_feature_map_count;
+					int output_feature_map_id = feature_map_workload_id - (output_entry_id * output_feature_map_count);
+					unsigned int output_neuron_start;
+					unsigned int output_neuron_end;
+					spatial_split_plain::get_range(output_neuron_count_per_feature_map, spatial_split_count, spatial_split_id, output_neuron_start, output_neuron_end);
 
 					const float * in_it_base = in_it_global + (output_entry_id * entry_subsampling_size * input_neuron_count) + (output_feature_map_id * feature_map_subsampling_size * input_neuron_count_per_feature_map);
 					float * out_it_base = out_it_global + (output_entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
 
-					std::fill_n(current_output_position.begin(), spatial_dimension_count, 0);
-					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; ++out_it)
+					unsigned int remaining_output_neuron_id = output_neuron_start;
+					for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+					{
+						current_output_position[i] = remaining_output_neuron_id % *(dimension_sizes_it + i);
+						remaining_output_neuron_id /= *(dimension_sizes_it + i);
+					}
+					for(float * out_it = out_it_base + output_neuron_start; out_it != out_it_base + output_neuron_end; ++out_it)
 					{
 						// Define the starting position of the first input elem
 						const float * in_it = in_it_base;
@@ -16,6 +16,7 @@
 
 #include "max_subsampling_layer_updater_plain.h"
 
+#include "simd_kernels_plain.h"
 #include "../max_subsampling_layer.h"
 #include "../nn_types.h"
 #include "../neural_network_exception.h"
@@ -26,7 +27,331 @@ namespace nnforge
 {
 	namespace plain
 	{
-		const int max_subsampling_layer_updater_plain::max_dimension_count = 4;
+		namespace
+		{
+			// Input offsets of the window elements, shared by forward and backward prop
+			struct max_subsampling_geometry
+			{
+				max_subsampling_geometry(
+					const max_subsampling_layer& layer_derived,
+					const layer_configuration_specific& input_configuration_specific,
+					const layer_configuration_specific& output_configuration_specific)
+				{
+					input_dimension_sizes = input_configuration_specific.dimension_sizes;
+					if (input_dimension_sizes.empty())
+						input_dimension_sizes.push_back(1);
+					output_dimension_sizes = output_configuration_specific.dimension_sizes;
+					if (output_dimension_sizes.empty())
+						output_dimension_sizes.push_back(1);
+
+					input_neuron_count = input_configuration_specific.get_neuron_count();
+					input_neuron_count_per_feature_map = input_configuration_specific.get_neuron_count_per_feature_map();
+					output_neuron_count = output_configuration_specific.get_neuron_count();
+					output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+					output_feature_map_count = output_configuration_specific.feature_map_count;
+					strides = layer_derived.strides;
+					if (strides.empty())
+						strides.push_back(1);
+					subsampling_sizes = layer_derived.subsampling_sizes;
+					if (subsampling_sizes.empty())
+						subsampling_sizes.push_back(1);
+					feature_map_subsampling_size = layer_derived.feature_map_subsampling_size;
+					subsampling_sizes.push_back(feature_map_subsampling_size);
+					entry_subsampling_size = layer_derived.entry_subsampling_size;
+					subsampling_sizes.push_back(entry_subsampling_size);
+					const unsigned int subsampling_dimension_count = static_cast<unsigned int>(subsampling_sizes.size());
+					spatial_dimension_count = static_cast<unsigned int>(output_dimension_sizes.size());
+					input_slices.resize(subsampling_sizes.size());
+					input_slices[0] = 1;
+					for(unsigned int i = 0; i < subsampling_dimension_count - 1; ++i)
+					{
+						int dimension_size = (i < spatial_dimension_count) ? input_dimension_sizes[i] : input_configuration_specific.feature_map_count;
+						input_slices[i + 1] = input_slices[i] * dimension_size;
+					}
+					subsampling_elem_count = 1;
+					for(unsigned int i = 0; i < subsampling_dimension_count; ++i)
+						subsampling_elem_count *= subsampling_sizes[i];
+
+					std::vector<unsigned int> current_local_input_position(subsampling_dimension_count, 0);
+					offset_list.resize(subsampling_elem_count);
+					for(unsigned int i = 1; i < subsampling_elem_count; ++i)
+					{
+						int offset = 0;
+						for(unsigned int j = 0; j < subsampling_dimension_count; ++j)
+						{
+							offset += static_cast<int>(input_slices[j]);
+							if ((++current_local_input_position[j]) < subsampling_sizes[j])
+							{
+								offset_list[i] = offset_list[i-1] + offset;
+								break;
+							}
+							current_local_input_position[j] = 0;
+							offset -= static_cast<int>(subsampling_sizes[j] * input_slices[j]);
+						}
+					}
+				}
+
+				// 2D window of 2x2 or 3x3 with stride 2 over a single feature map and entry
+				unsigned int get_stride2_window_size() const
+				{
+					if ((spatial_dimension_count != 2) || (feature_map_subsampling_size != 1) || (entry_subsampling_size != 1))
+						return 0;
+					if ((strides[0] != 2) || (strides[1] != 2) || (subsampling_sizes[0] != subsampling_sizes[1]))
+						return 0;
+					if ((subsampling_sizes[0] != 2) && (subsampling_sizes[0] != 3))
+						return 0;
+					return subsampling_sizes[0];
+				}
+
+				// 2x2 windows with stride 2 cover each input elem exactly once, so backward prop doesn't need to clear input errors
+				bool is_stride2_window_covering_input() const
+				{
+					return (get_stride2_window_size() == 2) && (input_dimension_sizes[0] == output_dimension_sizes[0] * 2) && (input_dimension_sizes[1] == output_dimension_sizes[1] * 2);
+				}
+
+				std::vector<unsigned int> input_dimension_sizes;
+				std::vector<unsigned int> output_dimension_sizes;
+				std::vector<unsigned int> strides;
+				std::vector<unsigned int> subsampling_sizes;
+				std::vector<unsigned int> input_slices;
+				std::vector<unsigned int> offset_list;
+				unsigned int input_neuron_count;
+				unsigned int input_neuron_count_per_feature_map;
+				unsigned int output_neuron_count;
+				unsigned int output_neuron_count_per_feature_map;
+				unsigned int output_feature_map_count;
+				unsigned int feature_map_subsampling_size;
+				unsigned int entry_subsampling_size;
+				unsigned int spatial_dimension_count;
+				unsigned int subsampling_elem_count;
+			};
+
+			// Max positions are stored as the number of the elem inside the window, in the smallest type which fits it
+			size_t get_max_index_elem_size(unsigned int subsampling_elem_count)
+			{
+				if (subsampling_elem_count <= 0x100)
+					return sizeof(unsigned char);
+				if (subsampling_elem_count <= 0x10000)
+					return sizeof(unsigned short);
+				return sizeof(unsigned int);
+			}
+
+			const int max_dimension_count = 4;
+
+			template<typename index_type>
+			void run_forward_generic(
+				const max_subsampling_geometry& geometry,
+				const float * const in_it_global,
+				float * const out_it_global,
+				index_type * const max_indexes_it_global,
+				const bool is_min,
+				unsigned int entry_count,
+				int thread_count)
+			{
+				const unsigned int input_neuron_count = geometry.input_neuron_count;
+				const unsigned int input_neuron_count_per_feature_map = geometry.input_neuron_count_per_feature_map;
+				const unsigned int output_neuron_count = geometry.output_neuron_count;
+				const unsigned int output_neuron_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+				const unsigned int output_feature_map_count = geometry.output_feature_map_count;
+				const unsigned int feature_map_subsampling_size = geometry.feature_map_subsampling_size;
+				const unsigned int entry_subsampling_size = geometry.entry_subsampling_size;
+				const unsigned int spatial_dimension_count = geometry.spatial_dimension_count;
+				const unsigned int const_subsampling_elem_count = geometry.subsampling_elem_count;
+
+				const int total_workload = entry_count * output_feature_map_count;
+				const std::vector<unsigned int>::const_iterator dimension_sizes_it = geometry.output_dimension_sizes.begin();
+				const std::vector<unsigned int>::const_iterator strides_it = geometry.strides.begin();
+				const std::vector<unsigned int>::const_iterator input_slices_it = geometry.input_slices.begin();
+				const std::vector<unsigned int>::const_iterator offset_list_it = geometry.offset_list.begin();
+
+				#pragma omp parallel default(none) num_threads(thread_count)
+				{
+					nnforge_array<unsigned int, max_dimension_count> current_output_position;
+
+					#pragma omp for schedule(guided)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						int output_entry_id = workload_id / output_feature_map_count;
+						int output_feature_map_id = workload_id - (output_entry_id * output_feature_map_count);
+
+						const int in_base_offset = (output_entry_id * entry_subsampling_size * input_neuron_count) + (output_feature_map_id * feature_map_subsampling_size * input_neuron_count_per_feature_map);
+						float * out_it_base = out_it_global + (output_entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
+						index_type * max_indexes_it_base = max_indexes_it_global + (output_entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
+
+						std::fill_n(current_output_position.begin(), spatial_dimension_count, 0);
+						index_type * max_indexes_it = max_indexes_it_base;
+						for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; ++out_it, ++max_indexes_it)
+						{
+							// Define the starting position of the first input elem
+							int in_offset = in_base_offset;
+							for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+								in_offset += current_output_position[i] * (*(strides_it + i)) * (*(input_slices_it + i));
+
+							unsigned int max_index = 0;
+							float best_val = is_min ? 1.0e37F : -1.0e37F;
+							for(unsigned int i = 0; i < const_subsampling_elem_count; ++i)
+							{
+								float new_val = *(in_it_global + in_offset + *(offset_list_it + i));
+								if ((i == 0) || (((new_val > best_val) && !is_min) || ((new_val < best_val) && is_min)))
+								{
+									best_val = new_val;
+									max_index = i;
+								}
+							}
+							*out_it = best_val;
+							*max_indexes_it = static_cast<index_type>(max_index);
+
+							// Go to the next output element
+							for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+							{
+								if ((++current_output_position[i]) < *( dimension_sizes_it + i))
+									break;
+								current_output_position[i] = 0;
+							}
+						}
+					}
+				}
+			}
+
+			// Windows of different workloads cover different input elems, so the errors are accumulated without races
+			template<typename index_type>
+			void run_backward_data_generic(
+				const max_subsampling_geometry& geometry,
+				const float * const out_err_it_global,
+				const index_type * const max_indexes_it_global,
+				float * const in_err_it_global,
+				unsigned int entry_count,
+				int thread_count)
+			{
+				const unsigned int input_neuron_count = geometry.input_neuron_count;
+				const unsigned int input_neuron_count_per_feature_map = geometry.input_neuron_count_per_feature_map;
+				const unsigned int output_neuron_count = geometry.output_neuron_count;
+				const unsigned int output_neuron_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+				const unsigned int output_feature_map_count = geometry.output_feature_map_count;
+				const unsigned int feature_map_subsampling_size = geometry.feature_map_subsampling_size;
+				const unsigned int entry_subsampling_size = geometry.entry_subsampling_size;
+				const unsigned int spatial_dimension_count = geometry.spatial_dimension_count;
+
+				const int total_workload = entry_count * output_feature_map_count;
+				const std::vector<unsigned int>::const_iterator dimension_sizes_it = geometry.output_dimension_sizes.begin();
+				const std::vector<unsigned int>::const_iterator strides_it = geometry.strides.begin();
+				const std::vector<unsigned int>::const_iterator input_slices_it = geometry.input_slices.begin();
+				const std::vector<unsigned int>::const_iterator offset_list_it = geometry.offset_list.begin();
+
+				#pragma omp parallel default(none) num_threads(thread_count)
+				{
+					nnforge_array<unsigned int, max_dimension_count> current_output_position;
+
+					#pragma omp for schedule(guided)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						int output_entry_id = workload_id / output_feature_map_count;
+						int output_feature_map_id = workload_id - (output_entry_id * output_feature_map_count);
+
+						const int in_base_offset = (output_entry_id * entry_subsampling_size * input_neuron_count) + (output_feature_map_id * feature_map_subsampling_size * input_neuron_count_per_feature_map);
+						const int out_base_offset = (output_entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
+						const float * out_err_it_base = out_err_it_global + out_base_offset;
+						const index_type * max_indexes_it = max_indexes_it_global + out_base_offset;
+
+						std::fill_n(current_output_position.begin(), spatial_dimension_count, 0);
+						for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it, ++max_indexes_it)
+						{
+							int in_offset = in_base_offset;
+							for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+								in_offset += current_output_position[i] * (*(strides_it + i)) * (*(input_slices_it + i));
+
+							*(in_err_it_global + in_offset + *(offset_list_it + *max_indexes_it)) += *out_err_it;
+
+							// Go to the next output element
+							for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+							{
+								if ((++current_output_position[i]) < *( dimension_sizes_it + i))
+									break;
+								current_output_position[i] = 0;
+							}
+						}
+					}
+				}
+			}
+
+			void run_forward_stride2(
+				cpu_dispatch_plain::isa isa,
+				const max_subsampling_geometry& geometry,
+				const float * const in_it_global,
+				float * const out_it_global,
+				unsigned char * const max_indexes_it_global,
+				const bool is_min,
+				unsigned int entry_count,
+				int thread_count)
+			{
+				const unsigned int window_size = geometry.get_stride2_window_size();
+				const unsigned int input_width = geometry.input_dimension_sizes[0];
+				const unsigned int input_neuron_count_per_feature_map = geometry.input_neuron_count_per_feature_map;
+				const unsigned int output_width = geometry.output_dimension_sizes[0];
+				const unsigned int output_height = geometry.output_dimension_sizes[1];
+				const unsigned int output_neuron_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+				const int total_workload = entry_count * geometry.output_feature_map_count;
+
+				#pragma omp parallel for default(none) schedule(guided) num_threads(thread_count)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					const float * in_it = in_it_global + workload_id * input_neuron_count_per_feature_map;
+					float * out_it = out_it_global + workload_id * output_neuron_count_per_feature_map;
+					unsigned char * max_indexes_it = max_indexes_it_global + workload_id * output_neuron_count_per_feature_map;
+					for(unsigned int output_y = 0; output_y < output_height; ++output_y)
+					{
+						simd_kernels_plain::max_subsampling_stride2_row(
+							isa,
+							in_it + output_y * 2 * input_width,
+							input_width,
+							out_it + output_y * output_width,
+							max_indexes_it + output_y * output_width,
+							output_width,
+							window_size,
+							is_min);
+					}
+				}
+			}
+
+			void run_backward_data_stride2(
+				cpu_dispatch_plain::isa isa,
+				const max_subsampling_geometry& geometry,
+				const float * const out_err_it_global,
+				const unsigned char * const max_indexes_it_global,
+				float * const in_err_it_global,
+				const bool add_update_to_destination,
+				unsigned int entry_count,
+				int thread_count)
+			{
+				const unsigned int window_size = geometry.get_stride2_window_size();
+				const unsigned int input_width = geometry.input_dimension_sizes[0];
+				const unsigned int input_neuron_count_per_feature_map = geometry.input_neuron_count_per_feature_map;
+				const unsigned int output_width = geometry.output_dimension_sizes[0];
+				const unsigned int output_height = geometry.output_dimension_sizes[1];
+				const unsigned int output_neuron_count_per_feature_map = geometry.output_neuron_count_per_feature_map;
+				const int total_workload = entry_count * geometry.output_feature_map_count;
+
+				#pragma omp parallel for default(none) schedule(guided) num_threads(thread_count)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					const float * out_err_it = out_err_it_global + workload_id * output_neuron_count_per_feature_map;
+					const unsigned char * max_indexes_it = max_indexes_it_global + workload_id * output_neuron_count_per_feature_map;
+					float * in_err_it = in_err_it_global + workload_id * input_neuron_count_per_feature_map;
+					for(unsigned int output_y = 0; output_y < output_height; ++output_y)
+					{
+						simd_kernels_plain::max_subsampling_stride2_backward_row(
+							isa,
+							out_err_it + output_y * output_width,
+							max_indexes_it + output_y * output_width,
+							in_err_it + output_y * 2 * input_width,
+							input_width,
+							output_width,
+							window_size,
+							add_update_to_destination);
+					}
+				}
+			}
+		}
 
 		max_subsampling_layer_updater_plain::max_subsampling_layer_updater_plain()
 		{
@@ -56,13 +381,6 @@ namespace nnforge
 			const std::set<layer_action>& actions,
 			unsigned int entry_count) const
 		{
-			std::vector<unsigned int> input_dimension_sizes = input_configuration_specific_list[0].dimension_sizes;
-			if (input_dimension_sizes.empty())
-				input_dimension_sizes.push_back(1);
-			std::vector<unsigned int> output_dimension_sizes = output_configuration_specific.dimension_sizes;
-			if (output_dimension_sizes.empty())
-				output_dimension_sizes.push_back(1);
-
 			nnforge_shared_ptr<const max_subsampling_layer> layer_derived = nnforge_dynamic_pointer_cast<const max_subsampling_layer>(layer_schema);
 
 			if (layer_derived->tiling)
@@ -72,110 +390,25 @@ namespace nnforge
 				if (*it)
 					throw neural_network_exception("round up is not implemented for max_subsampling_layer_tester_plain");
 
+			const max_subsampling_geometry geometry(*layer_derived, input_configuration_specific_list[0], output_configuration_specific);
 			const float * const in_it_global = *input_buffers[0];
 			float * const out_it_global = *output_buffer;
-			unsigned int * const max_indexes_it_global = *temporary_per_entry_buffer;
-			const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
-			const unsigned int input_neuron_count_per_feature_map = input_configuration_specific_list[0].get_neuron_count_per_feature_map();
-			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
-			const unsigned int output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
-			std::vector<unsigned int> strides = layer_derived->strides;
-			if (strides.empty())
-				strides.push_back(1);
-			std::vector<unsigned int> subsampling_sizes = layer_derived->subsampling_sizes;
-			if (subsampling_sizes.empty())
-				subsampling_sizes.push_back(1);
-			const unsigned int feature_map_subsampling_size = layer_derived->feature_map_subsampling_size;
-			subsampling_sizes.push_back(feature_map_subsampling_size);
-			const unsigned int entry_subsampling_size = layer_derived->entry_subsampling_size;
-			subsampling_sizes.push_back(entry_subsampling_size);
-			const unsigned int subsampling_dimension_count = static_cast<unsigned int>(subsampling_sizes.size());
-			const unsigned int spatial_dimension_count = static_cast<unsigned int>(output_dimension_sizes.size());
-			std::vector<unsigned int> input_slices(subsampling_sizes.size());
-			input_slices[0] = 1;
-			for(unsigned int i = 0; i < subsampling_dimension_count - 1; ++i)
-			{
-				int dimension_size = (i < spatial_dimension_count) ? input_dimension_sizes[i] : input_configuration_specific_list[0].feature_map_count;
-				input_slices[i + 1] = input_slices[i] * dimension_size;
-			}
-			unsigned int subsampling_elem_count = 1;
-			for(unsigned int i = 0; i < subsampling_dimension_count; ++i)
-				subsampling_elem_count *= subsampling_sizes[i];
-			const unsigned int const_subsampling_elem_count = subsampling_elem_count;
-			const unsigned int output_feature_map_count = output_configuration_specific.feature_map_count;
 			const bool is_min = layer_derived->is_min;
 
-			std::vector<unsigned int> current_local_input_position(subsampling_dimension_count, 0);
-			std::vector<unsigned int> offset_list(subsampling_elem_count);
-			for(unsigned int i = 1; i < subsampling_elem_count; ++i)
-			{
-				int offset = 0;
-				for(unsigned int j = 0; j < subsampling_dimension_count; ++j)
-				{
-					offset += static_cast<int>(input_slices[j]);
-					if ((++current_local_input_position[j]) < subsampling_sizes[j])
-					{
-						offset_list[i] = offset_list[i-1] + offset;
-						break;
-					}
-					current_local_input_position[j] = 0;
-					offset -= static_cast<int>(subsampling_sizes[j] * input_slices[j]);
-				}
-			}
-
-			const int total_workload = entry_count * output_configuration_specific.feature_map_count;
-			const std::vector<unsigned int>::const_iterator dimension_sizes_it = output_dimension_sizes.begin();
-			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
-			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
-			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
-
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			switch (get_max_index_elem_size(geometry.subsampling_elem_count))
 			{
-				nnforge_array<unsigned int, max_dimension_count> current_output_position;
-
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					int output_entry_id = workload_id / output_feature_map_count;
-					int output_feature_map_id = workload_id - (output_entry_id * output_feature_map_count);
-
-					const int in_base_offset = (output_entry_id * entry_subsampling_size * input_neuron_count) + (output_feature_map_id * feature_map_subsampling_size * input_neuron_count_per_feature_map);
-					float * out_it_base = out_it_global + (output_entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
-					unsigned int * max_indexes_it_base = max_indexes_it_global + (output_entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
-
-					std::fill_n(current_output_position.begin(), spatial_dimension_count, 0);
-					unsigned int * max_indexes_it = max_indexes_it_base;
-					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; ++out_it, ++max_indexes_it)
-					{
-						// Define the starting position of the first input elem
-						int in_offset = in_base_offset;
-						for(unsigned int i = 0; i < spatial_dimension_count; ++i)
-							in_offset += current_output_position[i] * (*(strides_it + i)) * (*(input_slices_it + i));
-
-						unsigned int max_index = 0;
-						float best_val = is_min ? 1.0e37F : -1.0e37F;
-						for(unsigned int i = 0; i < const_subsampling_elem_count; ++i)
-						{
-							int current_offset = in_offset + *(offset_list_it + i);
-							float new_val = *(in_it_global + current_offset);
-							if ((i == 0) || (((new_val > best_val) && !is_min) || ((new_val < best_val) && is_min)))
-							{
-								best_val = new_val;
-								max_index = current_offset;
-							}
-						}
-						*out_it = best_val;
-						*max_indexes_it = max_index;
-
-						// Go to the next output element
-						for(unsigned int i = 0; i < spatial_dimension_count; ++i)
-						{
-							if ((++current_output_position[i]) < *( dimension_sizes_it + i))
-								break;
-							current_output_position[i] = 0;
-						}
-					}
-				}
+			case sizeof(unsigned char):
+				if (geometry.get_stride2_window_size() != 0)
+					run_forward_stride2(plain_config->cpu_isa, geometry, in_it_global, out_it_global, *temporary_per_entry_buffer, is_min, entry_count, plain_config->openmp_thread_count);
+				else
+					run_forward_generic<unsigned char>(geometry, in_it_global, out_it_global, *temporary_per_entry_buffer, is_min, entry_count, plain_config->openmp_thread_count);
+				break;
+			case sizeof(unsigned short):
+				run_forward_generic<unsigned short>(geometry, in_it_global, out_it_global, *temporary_per_entry_buffer, is_min, entry_count, plain_config->openmp_thread_count);
+				break;
+			default:
+				run_forward_generic<unsigned int>(geometry, in_it_global, out_it_global, *temporary_per_entry_buffer, is_min, entry_count, plain_config->openmp_thread_count);
+				break;
 			}
 		}
 
@@ -200,14 +433,15 @@ namespace nnforge
 		{
 			float * const in_err_it_global = *input_errors_buffer;
 			const float * const out_err_it_global = *output_errors_buffer;
-			const unsigned int * const max_indexes_it_global = *temporary_per_entry_buffer;
 
 			nnforge_shared_ptr<const max_subsampling_layer> layer_derived = nnforge_dynamic_pointer_cast<const max_subsampling_layer>(layer_schema);
-			const unsigned int entry_subsampling_size = layer_derived->entry_subsampling_size;
+			const max_subsampling_geometry geometry(*layer_derived, input_configuration_specific_list[0], output_configuration_specific);
+			const unsigned int max_index_elem_size = get_max_index_elem_size(geometry.subsampling_elem_count);
+			const bool assign_input_errors = !add_update_to_destination && (max_index_elem_size == sizeof(unsigned char)) && geometry.is_stride2_window_covering_input();
 
-			if (!add_update_to_destination)
+			if (!add_update_to_destination && !assign_input_errors)
 			{
-				const int total_clean_workload = entry_count * entry_subsampling_size * input_configuration_specific_list[0].get_neuron_count();
+				const int total_clean_workload = entry_count * geometry.entry_subsampling_size * geometry.input_neuron_count;
 				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
 				for(int workload_id = 0; workload_id < total_clean_workload; ++workload_id)
 				{
@@ -215,30 +449,22 @@ namespace nnforge
 				}
 			}
 
-			const int total_workload = entry_count * output_configuration_specific.get_neuron_count();
-
-			if (add_update_to_destination)
+			switch (max_index_elem_size)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					unsigned int max_index = *(max_indexes_it_global + workload_id);
-					float err = *(out_err_it_global + workload_id);
-					*(in_err_it_global + max_index) += err;
-				}
-			}
-			else
-			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					unsigned int max_index = *(max_indexes_it_global + workload_id);
-					float err = *(out_err_it_global + workload_id);
-					*(in_err_it_global + max_index) = err;
-				}
+			case sizeof(unsigned char):
+				if (geometry.get_stride2_window_size() != 0)
+					run_backward_data_stride2(plain_config->cpu_isa, geometry, out_err_it_global, *temporary_per_entry_buffer, in_err_it_global, !assign_input_errors, entry_count, plain_config->openmp_thread_count);
+				else
+					run_backward_data_generic<unsigned char>(geometry, out_err_it_global, *temporary_per_entry_buffer, in_err_it_global, entry_count, plain_config->openmp_thread_count);
+				break;
+			case sizeof(unsigned short):
+				run_backward_data_generic<unsigned short>(geometry, out_err_it_global, *temporary_per_entry_buffer, in_err_it_global, entry_count, plain_config->openmp_thread_count);
+				break;
+			default:
+				run_backward_data_generic<unsigned int>(geometry, out_err_it_global, *temporary_per_entry_buffer, in_err_it_global, entry_count, plain_config->openmp_thread_count);
+				break;
 			}
 		}
-
 		bool max_subsampling_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
 			unsigned int action_input_index,
 			unsigned int data_input_index,
@@ -269,7 +495,10 @@ namespace nnforge
 			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 			const layer_configuration_specific& output_configuration_specific) const
 		{
-			return output_configuration_specific.get_neuron_count() * sizeof(unsigned int);
+			nnforge_shared_ptr<const max_subsampling_layer> layer_derived = nnforge_dynamic_pointer_cast<const max_subsampling_layer>(layer_schema);
+			const max_subsampling_geometry geometry(*layer_derived, input_configuration_specific_list[0], output_configuration_specific);
+
+			return output_configuration_specific.get_neuron_count() * get_max_index_elem_size(geometry.subsampling_elem_count);
 		}
 	}
 }
@@ -0,0 +1,165 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "numa_plain.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const size_t numa_plain::page_size = 4096;
+
+		std::vector<std::vector<unsigned int> > numa_plain::detect_node_cpu_lists()
+		{
+			std::vector<std::vector<unsigned int> > res;
+
+		#ifdef __linux__
+			cpu_set_t allowed_cpus;
+			CPU_ZERO(&allowed_cpus);
+			if (sched_getaffinity(0, sizeof(allowed_cpus), &allowed_cpus) != 0)
+				return res;
+
+			boost::filesystem::path node_folder("/sys/devices/system/node");
+			boost::system::error_code ec;
+			if (!boost::filesystem::is_directory(node_folder, ec))
+				return res;
+
+			// Nodes might be numbered sparsely, they are ordered by their IDs
+			std::vector<std::pair<unsigned int, std::vector<unsigned int> > > node_id_and_cpu_list_list;
+			for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(node_folder, ec); it != boost::filesystem::directory_iterator(); it.increment(ec))
+			{
+				std::string name = it->path().filename().string();
+				if ((name.size() <= 4) || (name.compare(0, 4, "node") != 0) || (name.find_first_not_of("0123456789", 4) != std::string::npos))
+					continue;
+
+				std::ifstream in((it->path() / "cpulist").string().c_str());
+				std::string cpu_list_str;
+				if (!in || !std::getline(in, cpu_list_str))
+					continue;
+
+				std::vector<unsigned int> cpu_list;
+				std::vector<unsigned int> all_cpu_list = parse_cpu_list(cpu_list_str);
+				for(std::vector<unsigned int>::const_iterator it2 = all_cpu_list.begin(); it2 != all_cpu_list.end(); ++it2)
+					if ((*it2 < CPU_SETSIZE) && CPU_ISSET(*it2, &allowed_cpus))
+						cpu_list.push_back(*it2);
+
+				// Memory only nodes and nodes the process cannot run on are skipped
+				if (!cpu_list.empty())
+					node_id_and_cpu_list_list.push_back(std::make_pair(static_cast<unsigned int>(atoi(name.c_str() + 4)), cpu_list));
+			}
+			std::sort(node_id_and_cpu_list_list.begin(), node_id_and_cpu_list_list.end());
+
+			for(std::vector<std::pair<unsigned int, std::vector<unsigned int> > >::const_iterator it = node_id_and_cpu_list_list.begin(); it != node_id_and_cpu_list_list.end(); ++it)
+				res.push_back(it->second);
+		#endif
+
+			return res;
+		}
+
+		bool numa_plain::bind_current_thread(const std::vector<unsigned int>& cpu_list)
+		{
+		#ifdef __linux__
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			for(std::vector<unsigned int>::const_iterator it = cpu_list.begin(); it != cpu_list.end(); ++it)
+				if (*it < CPU_SETSIZE)
+					CPU_SET(*it, &cpus);
+			if (CPU_COUNT(&cpus) == 0)
+				return false;
+			return (sched_setaffinity(0, sizeof(cpus), &cpus) == 0);
+		#else
+			return false;
+		#endif
+		}
+
+		std::vector<unsigned int> numa_plain::get_current_thread_cpu_list()
+		{
+			std::vector<unsigned int> res;
+
+		#ifdef __linux__
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0)
+				return res;
+			for(unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+				if (CPU_ISSET(cpu, &cpus))
+					res.push_back(cpu);
+		#endif
+
+			return res;
+		}
+
+		void numa_plain::first_touch(
+			void * buf,
+			size_t size,
+			int thread_count)
+		{
+			const int page_count = static_cast<int>((size + page_size - 1) / page_size);
+			#pragma omp parallel for default(shared) schedule(static) num_threads(thread_count)
+			for(int page_id = 0; page_id < page_count; ++page_id)
+			{
+				size_t start = static_cast<size_t>(page_id) * page_size;
+				memset(static_cast<char *>(buf) + start, 0, std::min(page_size, size - start));
+			}
+		}
+
+		std::vector<unsigned int> numa_plain::parse_cpu_list(const std::string& str)
+		{
+			std::vector<unsigned int> res;
+
+			std::string::size_type pos = 0;
+			while (pos < str.size())
+			{
+				std::string::size_type end_pos = str.find(',', pos);
+				if (end_pos == std::string::npos)
+					end_pos = str.size();
+				std::string range_str = str.substr(pos, end_pos - pos);
+				pos = end_pos + 1;
+
+				if (range_str.find_first_of("0123456789") == std::string::npos)
+					continue;
+				std::string::size_type dash_pos = range_str.find('-');
+				unsigned int first_cpu = static_cast<unsigned int>(atoi(range_str.c_str()));
+				unsigned int last_cpu = (dash_pos == std::string::npos) ? first_cpu : static_cast<unsigned int>(atoi(range_str.c_str() + dash_pos + 1));
+				for(unsigned int cpu = first_cpu; cpu <= last_cpu; ++cpu)
+					res.push_back(cpu);
+			}
+
+			return res;
+		}
+
+		thread_binding_guard_plain::thread_binding_guard_plain()
+			: cpu_list(numa_plain::get_current_thread_cpu_list())
+		{
+		}
+
+		thread_binding_guard_plain::~thread_binding_guard_plain()
+		{
+			if (!cpu_list.empty())
+				numa_plain::bind_current_thread(cpu_list);
+		}
+	}
+}
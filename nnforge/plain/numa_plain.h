@@ -0,0 +1,79 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// NUMA topology and thread placement, supported on Linux only:
+		// elsewhere a single node is reported and threads are not bound
+		class numa_plain
+		{
+		public:
+			// CPUs of each node with at least one CPU the process is allowed to run on, read from sysfs;
+			// returns empty list when the topology is unknown
+			static std::vector<std::vector<unsigned int> > detect_node_cpu_lists();
+
+			// Binds the calling thread to the CPUs, threads it creates afterwards inherit the binding;
+			// returns false when binding is not supported or fails
+			static bool bind_current_thread(const std::vector<unsigned int>& cpu_list);
+
+			// CPUs the calling thread is allowed to run on, empty list when not supported
+			static std::vector<unsigned int> get_current_thread_cpu_list();
+
+			// Writes zeros to the buffer with thread_count threads splitting it statically, the way elementwise kernels do,
+			// so that the OS places each page on the node of the thread touching it first
+			static void first_touch(
+				void * buf,
+				size_t size,
+				int thread_count);
+
+		private:
+			// Parses lists like "0-3,8,10-11"
+			static std::vector<unsigned int> parse_cpu_list(const std::string& str);
+
+		private:
+			static const size_t page_size;
+
+		private:
+			numa_plain();
+			~numa_plain();
+		};
+
+		// Binds the calling thread back to the CPUs it was allowed to run on when the guard was created,
+		// the thread binding OpenMP threads is the master of the team and gets pinned together with them
+		class thread_binding_guard_plain
+		{
+		public:
+			thread_binding_guard_plain();
+
+			~thread_binding_guard_plain();
+
+		private:
+			std::vector<unsigned int> cpu_list;
+
+		private:
+			thread_binding_guard_plain(const thread_binding_guard_plain&);
+			thread_binding_guard_plain& operator =(const thread_binding_guard_plain&);
+		};
+	}
+}
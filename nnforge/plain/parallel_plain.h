@@ -0,0 +1,102 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+
+#include <algorithm>
+
+#ifdef NNFORGE_PLAIN_WORK_STEALING
+#include <boost/ref.hpp>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Parallel loops of the kernels, run on the work stealing scheduler of the configuration
+		// when the backend is built with NNFORGE_PLAIN_WORK_STEALING and on OpenMP threads otherwise
+		class parallel_plain
+		{
+		public:
+			// Calls body(start, end) for subranges covering [0, item_count), each item should be worth scheduling on its own
+			template<typename body_type>
+			static void parallel_for(
+				const plain_running_configuration& config,
+				int item_count,
+				const body_type& body)
+			{
+			#ifdef NNFORGE_PLAIN_WORK_STEALING
+				if (config.scheduler)
+					config.scheduler->parallel_for(0, item_count, 1, boost::cref(body));
+				else if (item_count > 0)
+					body(0, item_count);
+			#else
+				#pragma omp parallel for default(shared) schedule(guided) num_threads(config.openmp_thread_count)
+				for(int item_id = 0; item_id < item_count; ++item_id)
+					body(item_id, item_id + 1);
+			#endif
+			}
+
+			// Splits elem_count elements into chunks of chunk_elem_count elements and calls body(start, current_elem_count) for each of them
+			template<typename body_type>
+			static void for_each_chunk(
+				const plain_running_configuration& config,
+				int elem_count,
+				int chunk_elem_count,
+				const body_type& body)
+			{
+				chunk_range<body_type> range(body, elem_count, chunk_elem_count);
+				parallel_for(config, (elem_count + chunk_elem_count - 1) / chunk_elem_count, range);
+			}
+
+		private:
+			template<typename body_type>
+			class chunk_range
+			{
+			public:
+				chunk_range(
+					const body_type& body,
+					int elem_count,
+					int chunk_elem_count)
+					: body(body)
+					, elem_count(elem_count)
+					, chunk_elem_count(chunk_elem_count)
+				{
+				}
+
+				void operator()(int chunk_start, int chunk_end) const
+				{
+					for(int chunk_id = chunk_start; chunk_id < chunk_end; ++chunk_id)
+					{
+						const int start = chunk_id * chunk_elem_count;
+						body(start, std::min(elem_count - start, chunk_elem_count));
+					}
+				}
+
+			private:
+				const body_type& body;
+				int elem_count;
+				int chunk_elem_count;
+			};
+
+		private:
+			parallel_plain();
+			~parallel_plain();
+		};
+	}
+}
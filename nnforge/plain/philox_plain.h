@@ -0,0 +1,64 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Philox4x32-10 counter based generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+		// Random numbers are a function of the key and the counter only, so they are generated
+		// in any order on any thread and the same ones are regenerated later instead of being stored
+		class philox_plain
+		{
+		public:
+			static inline void generate(
+				const unsigned int key[2],
+				const unsigned int counter[4],
+				unsigned int res[4])
+			{
+				unsigned int c0 = counter[0];
+				unsigned int c1 = counter[1];
+				unsigned int c2 = counter[2];
+				unsigned int c3 = counter[3];
+				unsigned int k0 = key[0];
+				unsigned int k1 = key[1];
+				for(int round_id = 0; round_id < 10; ++round_id)
+				{
+					const unsigned long long p0 = static_cast<unsigned long long>(0xD2511F53U) * c0;
+					const unsigned long long p1 = static_cast<unsigned long long>(0xCD9E8D57U) * c2;
+					const unsigned int new_c0 = static_cast<unsigned int>(p1 >> 32) ^ c1 ^ k0;
+					const unsigned int new_c2 = static_cast<unsigned int>(p0 >> 32) ^ c3 ^ k1;
+					c1 = static_cast<unsigned int>(p1);
+					c3 = static_cast<unsigned int>(p0);
+					c0 = new_c0;
+					c2 = new_c2;
+					k0 += 0x9E3779B9U;
+					k1 += 0xBB67AE85U;
+				}
+				res[0] = c0;
+				res[1] = c1;
+				res[2] = c2;
+				res[3] = c3;
+			}
+
+		private:
+			philox_plain();
+			~philox_plain();
+		};
+	}
+}
@@ -34,6 +34,7 @@
 #include "softmax_layer_tester_plain.h"
 #include "convolution_layer_tester_plain.h"
 #include "sparse_convolution_layer_tester_plain.h"
+#include "fully_connected_layer_tester_plain.h"
 #include "local_contrast_subtractive_layer_tester_plain.h"
 #include "lerror_layer_tester_plain.h"
 #include "cross_entropy_layer_tester_plain.h"
@@ -67,6 +68,7 @@
 #include "parametric_rectified_linear_layer_updater_plain.h"
 #include "convolution_layer_updater_plain.h"
 #include "sparse_convolution_layer_updater_plain.h"
+#include "fully_connected_layer_updater_plain.h"
 #include "lerror_layer_updater_plain.h"
 #include "cross_entropy_layer_updater_plain.h"
 #include "negative_log_likelihood_layer_updater_plain.h"
@@ -82,6 +84,7 @@
 #include "entry_convolution_layer_updater_plain.h"
 #include "affine_grid_generator_layer_updater_plain.h"
 #include "linear_sampler_layer_updater_plain.h"
+#include "batch_norm_layer_updater_plain.h"
 
 namespace nnforge
 {
@@ -122,6 +125,8 @@ namespace nnforge
 			layer_tester_plain_factory::singleton::get_mutable_instance().register_layer_tester_plain(layer_tester_plain::ptr(new batch_norm_layer_tester_plain()));
 			layer_tester_plain_factory::singleton::get_mutable_instance().register_layer_tester_plain(layer_tester_plain::ptr(new affine_grid_generator_layer_tester_plain()));
 
+			layer_tester_plain_factory::singleton::get_mutable_instance().register_specialized_layer_tester_plain(layer_tester_plain::ptr(new fully_connected_layer_tester_plain()));
+
 			layer_updater_plain_factory::singleton::get_mutable_instance().register_layer_updater_plain(layer_updater_plain::ptr(new hyperbolic_tangent_layer_updater_plain()));
 			layer_updater_plain_factory::singleton::get_mutable_instance().register_layer_updater_plain(layer_updater_plain::ptr(new sigmoid_layer_updater_plain()));
 			layer_updater_plain_factory::singleton::get_mutable_instance().register_layer_updater_plain(layer_updater_plain::ptr(new average_subsampling_layer_updater_plain()));
@@ -150,6 +155,9 @@ namespace nnforge
 			layer_updater_plain_factory::singleton::get_mutable_instance().register_layer_updater_plain(layer_updater_plain::ptr(new entry_convolution_layer_updater_plain()));
 			layer_updater_plain_factory::singleton::get_mutable_instance().register_layer_updater_plain(layer_updater_plain::ptr(new affine_grid_generator_layer_updater_plain()));
 			layer_updater_plain_factory::singleton::get_mutable_instance().register_layer_updater_plain(layer_updater_plain::ptr(new linear_sampler_layer_updater_plain()));
+			layer_updater_plain_factory::singleton::get_mutable_instance().register_layer_updater_plain(layer_updater_plain::ptr(new batch_norm_layer_updater_plain()));
+
+			layer_updater_plain_factory::singleton::get_mutable_instance().register_specialized_layer_updater_plain(layer_updater_plain::ptr(new fully_connected_layer_updater_plain()));
 		}
 	}
 }
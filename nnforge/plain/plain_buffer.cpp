@@ -30,9 +30,20 @@ namespace nnforge
 			this->size = size;
 		}
 
+		plain_buffer::plain_buffer(
+			void * buf,
+			size_t size,
+			nnforge_shared_ptr<void> holder)
+			: buf(buf)
+			, size(size)
+			, holder(holder)
+		{
+		}
+
 		plain_buffer::~plain_buffer()
 		{
-			free(buf);
+			if (!holder)
+				free(buf);
 		}
 
 		void * plain_buffer::get_buf()
@@ -90,6 +101,16 @@ namespace nnforge
 			return (unsigned char *)(get_buf());
 		}
 
+		plain_buffer::operator unsigned short *()
+		{
+			return (unsigned short *)(get_buf());
+		}
+
+		plain_buffer::operator const unsigned short *() const
+		{
+			return (unsigned short *)(get_buf());
+		}
+
 		plain_buffer::operator unsigned int *()
 		{
 			return (unsigned int *)(get_buf());
@@ -31,6 +31,12 @@ namespace nnforge
 
 			plain_buffer(size_t size);
 
+			// The buffer doesn't own buf, the memory is kept alive by holder as long as the buffer exists
+			plain_buffer(
+				void * buf,
+				size_t size,
+				nnforge_shared_ptr<void> holder);
+
 			virtual ~plain_buffer();
 
 			// Size in bytes
@@ -52,6 +58,10 @@ namespace nnforge
 
 			operator const unsigned char *() const;
 
+			operator unsigned short *();
+
+			operator const unsigned short *() const;
+
 			operator unsigned int *();
 
 			operator const unsigned int *() const;
@@ -67,6 +77,7 @@ namespace nnforge
 		private:
 			void * buf;
 			size_t size;
+			nnforge_shared_ptr<void> holder;
 		};
 	}
 }
@@ -16,25 +16,262 @@
 
 #include "plain_running_configuration.h"
 
+#include "numa_plain.h"
+
+#include "../neural_network_exception.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
 namespace nnforge
 {
 	namespace plain
 	{
 		plain_running_configuration::plain_running_configuration(
 			int openmp_thread_count,
-			float max_memory_usage_gigabytes)
+			float max_memory_usage_gigabytes,
+			unsigned int channel_block_size,
+			unsigned int max_concurrent_branch_count,
+			unsigned int reader_thread_count,
+			bool huge_pages,
+			bool low_latency,
+			bool thread_affinity,
+			bool numa_weight_replicas,
+			bool buffer_offset_planning,
+			int checkpoint_segment_count,
+			const std::string& checkpoint_layer_names,
+			float cpu_frequency_ghz,
+			const std::string& cpu_isa_name,
+			tuning_state::ptr tuning)
 			: openmp_thread_count(openmp_thread_count)
 			, max_memory_usage_gigabytes(max_memory_usage_gigabytes)
+			, channel_block_size(channel_block_size)
+			, max_concurrent_branch_count(max_concurrent_branch_count)
+			, reader_thread_count(reader_thread_count)
+			, huge_pages(huge_pages)
+			, low_latency(low_latency)
+			, thread_affinity(thread_affinity)
+			, numa_weight_replicas(numa_weight_replicas)
+			, buffer_offset_planning(buffer_offset_planning)
+			, checkpoint_segment_count(checkpoint_segment_count)
+			, cpu_frequency_ghz(cpu_frequency_ghz)
+			, cpu_isa(cpu_dispatch_plain::get_isa(cpu_isa_name))
+			, tuning(tuning)
+		{
+			if ((channel_block_size != 0) && (channel_block_size != 8) && (channel_block_size != 16))
+				throw neural_network_exception((boost::format("Invalid channel block size %1%, 0, 8 and 16 are supported") % channel_block_size).str());
+
+			if (max_concurrent_branch_count == 0)
+				throw neural_network_exception("Max concurrent branch count should be positive");
+
+			if (checkpoint_segment_count < -1)
+				throw neural_network_exception((boost::format("Invalid checkpoint segment count %1%") % checkpoint_segment_count).str());
+			if (!checkpoint_layer_names.empty())
+			{
+				std::vector<std::string> strs;
+				boost::split(strs, checkpoint_layer_names, boost::is_any_of(":"));
+				for(std::vector<std::string>::const_iterator it = strs.begin(); it != strs.end(); ++it)
+					if (!it->empty())
+						this->checkpoint_layer_names.insert(*it);
+			}
+
+			if (cpu_frequency_ghz < 0.0F)
+				throw neural_network_exception((boost::format("Invalid CPU frequency %1% GHz") % cpu_frequency_ghz).str());
+			if (cpu_frequency_ghz == 0.0F)
+				this->cpu_frequency_ghz = detect_cpu_frequency_ghz();
+
+			numa_node_cpu_lists = numa_plain::detect_node_cpu_lists();
+
+			#ifndef _OPENMP
+			this->openmp_thread_count = 1;
+			#endif
+			total_openmp_thread_count = this->openmp_thread_count;
+
+			// Decoding keeps pace with compute for most inputs with a quarter of the threads
+			if (reader_thread_count == 0)
+				this->reader_thread_count = static_cast<unsigned int>(std::max(this->openmp_thread_count / 4, 1));
+
+			#ifdef NNFORGE_PLAIN_WORK_STEALING
+			// The thread running the loop takes part in it
+			if (openmp_thread_count > 1)
+				scheduler = work_stealing_scheduler::ptr(new work_stealing_scheduler(static_cast<unsigned int>(openmp_thread_count - 1)));
+			#endif
+		}
+
+		plain_running_configuration::plain_running_configuration(
+			const plain_running_configuration& parent,
+			int thread_count)
+			: openmp_thread_count(thread_count)
+			, max_memory_usage_gigabytes(parent.max_memory_usage_gigabytes)
+			, total_openmp_thread_count(parent.total_openmp_thread_count)
+			, channel_block_size(parent.channel_block_size)
+			, max_concurrent_branch_count(1)
+			, reader_thread_count(parent.reader_thread_count)
+			, huge_pages(parent.huge_pages)
+			, low_latency(parent.low_latency)
+			, thread_affinity(parent.thread_affinity)
+			, numa_weight_replicas(parent.numa_weight_replicas)
+			, buffer_offset_planning(parent.buffer_offset_planning)
+			, checkpoint_segment_count(parent.checkpoint_segment_count)
+			, checkpoint_layer_names(parent.checkpoint_layer_names)
+			, numa_node_cpu_lists(parent.numa_node_cpu_lists)
+			, cpu_frequency_ghz(parent.cpu_frequency_ghz)
+			, cpu_isa(parent.cpu_isa)
+			, tuning(parent.tuning)
+			, algorithm(parent.algorithm)
+			, scheduler(parent.scheduler)
 		{
 			#ifndef _OPENMP
 			this->openmp_thread_count = 1;
 			#endif
 		}
 
+		plain_running_configuration::plain_running_configuration(
+			const plain_running_configuration& parent,
+			const std::string& algorithm)
+			: openmp_thread_count(parent.openmp_thread_count)
+			, max_memory_usage_gigabytes(parent.max_memory_usage_gigabytes)
+			, total_openmp_thread_count(parent.total_openmp_thread_count)
+			, channel_block_size(parent.channel_block_size)
+			, max_concurrent_branch_count(parent.max_concurrent_branch_count)
+			, reader_thread_count(parent.reader_thread_count)
+			, huge_pages(parent.huge_pages)
+			, low_latency(parent.low_latency)
+			, thread_affinity(parent.thread_affinity)
+			, numa_weight_replicas(parent.numa_weight_replicas)
+			, buffer_offset_planning(parent.buffer_offset_planning)
+			, checkpoint_segment_count(parent.checkpoint_segment_count)
+			, checkpoint_layer_names(parent.checkpoint_layer_names)
+			, numa_node_cpu_lists(parent.numa_node_cpu_lists)
+			, cpu_frequency_ghz(parent.cpu_frequency_ghz)
+			, cpu_isa(parent.cpu_isa)
+			, tuning(parent.tuning)
+			, algorithm(algorithm)
+			, scheduler(parent.scheduler)
+		{
+		}
+
+		plain_running_configuration::const_ptr plain_running_configuration::get_thread_group_configuration(int thread_count) const
+		{
+			return const_ptr(new plain_running_configuration(*this, thread_count));
+		}
+
+		plain_running_configuration::const_ptr plain_running_configuration::get_algorithm_configuration(const std::string& algorithm) const
+		{
+			return const_ptr(new plain_running_configuration(*this, algorithm));
+		}
+
+		float plain_running_configuration::get_flops() const
+		{
+			if (cpu_frequency_ghz <= 0.0F)
+				throw neural_network_exception("CPU frequency is unknown, specify it with plain_cpu_frequency option");
+
+			// Hyper-threads share FMA units of the core
+			unsigned int core_count = static_cast<unsigned int>(openmp_thread_count);
+			unsigned int physical_core_count = boost::thread::physical_concurrency();
+			if (physical_core_count > 0)
+				core_count = std::min(core_count, physical_core_count);
+
+			return static_cast<float>(core_count * cpu_dispatch_plain::get_flops_per_cycle(cpu_isa)) * cpu_frequency_ghz * 1.0e+9F;
+		}
+
+		unsigned int plain_running_configuration::get_numa_node_count() const
+		{
+			return std::max(static_cast<unsigned int>(numa_node_cpu_lists.size()), 1U);
+		}
+
+		void plain_running_configuration::bind_openmp_threads(int numa_node_id) const
+		{
+			if (!thread_affinity || numa_node_cpu_lists.empty())
+				return;
+
+			std::vector<std::vector<unsigned int> > node_cpu_lists;
+			if (numa_node_id >= 0)
+				node_cpu_lists.push_back(numa_node_cpu_lists.at(numa_node_id));
+			else
+				node_cpu_lists = numa_node_cpu_lists;
+			const unsigned int node_count = static_cast<unsigned int>(node_cpu_lists.size());
+			const int thread_count = openmp_thread_count;
+
+			// OpenMP keeps its threads between parallel regions of the same size, so the binding sticks
+			#pragma omp parallel default(shared) num_threads(thread_count)
+			{
+				unsigned int thread_id = 0;
+				#ifdef _OPENMP
+				thread_id = static_cast<unsigned int>(omp_get_thread_num());
+				#endif
+				unsigned int node_id = thread_id * node_count / static_cast<unsigned int>(thread_count);
+				unsigned int node_thread_start = (node_id * static_cast<unsigned int>(thread_count) + node_count - 1) / node_count;
+				const std::vector<unsigned int>& cpu_list = node_cpu_lists[node_id];
+				numa_plain::bind_current_thread(std::vector<unsigned int>(1, cpu_list[(thread_id - node_thread_start) % cpu_list.size()]));
+			}
+		}
+
+		void plain_running_configuration::bind_current_thread_to_numa_node(unsigned int numa_node_id) const
+		{
+			if (numa_node_id < numa_node_cpu_lists.size())
+				numa_plain::bind_current_thread(numa_node_cpu_lists[numa_node_id]);
+		}
+
+		bool plain_running_configuration::is_first_touch_required() const
+		{
+			return thread_affinity && (numa_node_cpu_lists.size() > 1);
+		}
+
+		float plain_running_configuration::detect_cpu_frequency_ghz()
+		{
+		#ifdef _WIN32
+			HKEY key;
+			if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, "HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0", 0, KEY_READ, &key) != ERROR_SUCCESS)
+				return 0.0F;
+			DWORD mhz = 0;
+			DWORD size = sizeof(mhz);
+			LONG status = RegQueryValueExA(key, "~MHz", NULL, NULL, reinterpret_cast<LPBYTE>(&mhz), &size);
+			RegCloseKey(key);
+			return (status == ERROR_SUCCESS) ? static_cast<float>(mhz) * 1.0e-3F : 0.0F;
+		#else
+			// Max frequency of the first core in kHz
+			{
+				std::ifstream in("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+				unsigned long khz = 0;
+				if (in && (in >> khz) && (khz > 0))
+					return static_cast<float>(khz) * 1.0e-6F;
+			}
+
+			// Current frequency, used when cpufreq is not available, in virtual machines for example
+			{
+				std::ifstream in("/proc/cpuinfo");
+				std::string line;
+				while (std::getline(in, line))
+				{
+					if (line.compare(0, 7, "cpu MHz") != 0)
+						continue;
+					std::string::size_type pos = line.find(':');
+					if (pos == std::string::npos)
+						continue;
+					float mhz = static_cast<float>(atof(line.c_str() + pos + 1));
+					if (mhz > 0.0F)
+						return mhz * 1.0e-3F;
+				}
+			}
+
+			return 0.0F;
+		#endif
+		}
+
 		unsigned int plain_running_configuration::get_max_entry_count(
 			const buffer_plain_size_configuration& buffers_config,
 			float ratio) const
@@ -56,11 +293,52 @@ namespace nnforge
 			#else
 			out << "Built without OpenMP support" << std::endl;
 			#endif
+			out << "Detected CPU instruction set = " << cpu_dispatch_plain::get_isa_name(cpu_dispatch_plain::get_detected_isa()) << std::endl;
 
 			out << "--- Settings ---" << std::endl;
 
 			out << "Max memory usage = " << running_configuration.max_memory_usage_gigabytes << " GB" << std::endl;
 			out << "OpenMP thread count = " << running_configuration.openmp_thread_count << std::endl;
+			#ifdef NNFORGE_PLAIN_WORK_STEALING
+			out << "Work stealing scheduler thread count = " << (running_configuration.scheduler ? running_configuration.scheduler->get_thread_count() : 1) << std::endl;
+			#endif
+			if (running_configuration.channel_block_size > 0)
+				out << "Channel block size = " << running_configuration.channel_block_size << std::endl;
+			else
+				out << "Channel blocked layout disabled" << std::endl;
+			out << "Max concurrent branch count = " << running_configuration.max_concurrent_branch_count << std::endl;
+			out << "Reader thread count = " << running_configuration.reader_thread_count << std::endl;
+			out << "Transparent huge pages " << (running_configuration.huge_pages ? "requested" : "not requested") << std::endl;
+			out << "Low latency mode " << (running_configuration.low_latency ? "on" : "off") << std::endl;
+			if (running_configuration.numa_node_cpu_lists.empty())
+				out << "NUMA topology unknown" << std::endl;
+			else
+			{
+				out << "NUMA nodes = " << running_configuration.numa_node_cpu_lists.size() << ", CPUs:";
+				for(std::vector<std::vector<unsigned int> >::const_iterator it = running_configuration.numa_node_cpu_lists.begin(); it != running_configuration.numa_node_cpu_lists.end(); ++it)
+					out << " " << it->size();
+				out << std::endl;
+			}
+			out << "Thread affinity " << (running_configuration.thread_affinity ? "on" : "off") << std::endl;
+			out << "NUMA weight replicas " << (running_configuration.numa_weight_replicas ? "on" : "off") << std::endl;
+			out << "Buffer offset planning " << (running_configuration.buffer_offset_planning ? "on" : "off") << std::endl;
+			if (!running_configuration.checkpoint_layer_names.empty())
+				out << "Checkpoint layers = " << running_configuration.checkpoint_layer_names.size() << std::endl;
+			else if (running_configuration.checkpoint_segment_count == -1)
+				out << "Checkpoint segments = sqrt of layer count" << std::endl;
+			else if (running_configuration.checkpoint_segment_count > 0)
+				out << "Checkpoint segments = " << running_configuration.checkpoint_segment_count << std::endl;
+			else
+				out << "Checkpointing disabled" << std::endl;
+			out << "CPU instruction set = " << cpu_dispatch_plain::get_isa_name(running_configuration.cpu_isa) << std::endl;
+			if (running_configuration.cpu_frequency_ghz > 0.0F)
+			{
+				out << "CPU frequency = " << running_configuration.cpu_frequency_ghz << " GHz" << std::endl;
+				out << "Estimated GFLOPS = " << static_cast<int>(running_configuration.get_flops() / 1.0e+9F) << std::endl;
+			}
+			else
+				out << "CPU frequency unknown" << std::endl;
+			out << "Auto tuning = " << tuning_state::get_mode_name(running_configuration.tuning ? running_configuration.tuning->get_mode() : tuning_state::tuning_mode_off) << std::endl;
 
 			return out;
 		}
@@ -17,10 +17,16 @@
 #pragma once
 
 #include <ostream>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "buffer_plain_size_configuration.h"
+#include "cpu_dispatch_plain.h"
 
 #include "../nn_types.h"
+#include "../tuning_state.h"
+#include "../work_stealing_scheduler.h"
 
 namespace nnforge
 {
@@ -33,15 +39,128 @@ namespace nnforge
 
 			plain_running_configuration(
 				int openmp_thread_count,
-				float max_memory_usage_gigabytes);
+				float max_memory_usage_gigabytes,
+				unsigned int channel_block_size,
+				unsigned int max_concurrent_branch_count,
+				unsigned int reader_thread_count,
+				bool huge_pages,
+				bool low_latency,
+				bool thread_affinity,
+				bool numa_weight_replicas,
+				bool buffer_offset_planning,
+				int checkpoint_segment_count,
+				const std::string& checkpoint_layer_names,
+				float cpu_frequency_ghz,
+				const std::string& cpu_isa_name,
+				tuning_state::ptr tuning);
 
 			unsigned int get_max_entry_count(
 				const buffer_plain_size_configuration& buffers_config,
 				float ratio = 1.0F) const;
 
+			// Returns the same configuration with thread_count threads, used to run actions on a group of threads
+			const_ptr get_thread_group_configuration(int thread_count) const;
+
+			// Returns the same configuration with testers and updaters running the algorithm specified, auto_tuner_plain times candidates with it
+			// and forward and backward prop run each layer with the one made for the algorithm resolved when the layer is set up
+			const_ptr get_algorithm_configuration(const std::string& algorithm) const;
+
+			// Peak performance estimated from the number of physical cores used, their frequency and the instruction set,
+			// throws when the frequency is unknown
+			float get_flops() const;
+
+			// At least 1
+			unsigned int get_numa_node_count() const;
+
+			// Binds each of openmp_thread_count OpenMP threads of the calling thread to its own CPU when thread_affinity is on,
+			// threads are spread evenly over NUMA nodes, or over the CPUs of numa_node_id when it is non-negative.
+			// The calling thread is bound too, being the master of the team
+			void bind_openmp_threads(int numa_node_id = -1) const;
+
+			// Binds the calling thread to the CPUs of the node, OpenMP threads it starts afterwards inherit the binding
+			void bind_current_thread_to_numa_node(unsigned int numa_node_id) const;
+
+			// Buffers are worth first-touching when threads are bound and there are several nodes
+			bool is_first_touch_required() const;
+
 			float max_memory_usage_gigabytes;
 			int openmp_thread_count;
 
+			// Thread count of the whole configuration, differs from openmp_thread_count for thread group configurations only;
+			// algorithm decisions are keyed by it so that thread groups make the same choices buffers are sized for
+			int total_openmp_thread_count;
+
+			// Feature maps of activations are stored in blocks of this size, [entry][feature_map_block][spatial][feature_map_in_block],
+			// by the layers supporting such layout; 0 means plain [entry][feature_map][spatial] layout everywhere
+			unsigned int channel_block_size;
+
+			// Forward prop runs up to this number of independent branches of the schema concurrently, each on its own group of threads;
+			// more branches keep more layer outputs alive, 1 runs layers one by one which takes the least memory
+			unsigned int max_concurrent_branch_count;
+
+			// OpenMP threads the background reader of the chunk pipeline decodes entries with, they run alongside
+			// the compute threads and take cores from them; 0 passed to the constructor picks a quarter of openmp_thread_count
+			unsigned int reader_thread_count;
+
+			// Buffer arenas of forward and backward prop are advised to be backed by transparent huge pages
+			bool huge_pages;
+
+			// Kernels split the spatial domain of a feature map between threads when entries and feature maps are too few to keep them busy
+			bool low_latency;
+
+			// OpenMP threads are bound to CPUs when propagation starts
+			bool thread_affinity;
+
+			// Forward prop keeps a replica of the weights on each NUMA node, splits each chunk of entries between the nodes
+			// and runs each part on the threads of the node the part is assigned to
+			bool numa_weight_replicas;
+
+			// Layer buffers of forward and backward prop are placed at planned offsets of a single allocation,
+			// otherwise buffers which are never alive at the same time share the storage of the largest of them
+			bool buffer_offset_planning;
+
+			// Backward prop keeps forward outputs of the checkpoint layers only, the other outputs are recomputed from them
+			// segment by segment right before the backward actions needing them; checkpoints are the last layers of
+			// checkpoint_segment_count segments of roughly the same number of layers, -1 stands for square root of the layer count
+			// segments, 0 keeps all the outputs
+			int checkpoint_segment_count;
+
+			// Checkpoint layers specified by name, they override checkpoint_segment_count when not empty
+			std::set<std::string> checkpoint_layer_names;
+
+			// CPUs of each NUMA node, empty when the topology is unknown
+			std::vector<std::vector<unsigned int> > numa_node_cpu_lists;
+
+			// Specified by the user or detected, 0 when unknown
+			float cpu_frequency_ghz;
+
+			// Instruction set the kernels compiled in several variants are dispatched to
+			cpu_dispatch_plain::isa cpu_isa;
+
+			// Algorithms are chosen by auto_tuner_plain when it is not null and tuning is on
+			tuning_state::ptr tuning;
+
+			// Algorithm testers and updaters run, set for algorithm configurations only; empty means the heuristic choice is made
+			std::string algorithm;
+
+			// Runs parallel loops of parallel_plain when the backend is built with NNFORGE_PLAIN_WORK_STEALING,
+			// null otherwise and for a single thread; thread group configurations share the scheduler of the whole configuration
+			work_stealing_scheduler::ptr scheduler;
+
+		private:
+			// Thread group configuration
+			plain_running_configuration(
+				const plain_running_configuration& parent,
+				int thread_count);
+
+			// Algorithm configuration
+			plain_running_configuration(
+				const plain_running_configuration& parent,
+				const std::string& algorithm);
+
+			// Returns 0 when the frequency cannot be detected
+			static float detect_cpu_frequency_ghz();
+
 		private:
 			plain_running_configuration();
 			plain_running_configuration(const plain_running_configuration&);
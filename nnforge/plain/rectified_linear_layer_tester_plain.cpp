@@ -16,12 +16,32 @@
 
 #include "rectified_linear_layer_tester_plain.h"
 
+#include "parallel_plain.h"
+#include "simd_kernels_plain.h"
+#include "spatial_split_plain.h"
 #include "../rectified_linear_layer.h"
 
+#include <algorithm>
+
 namespace nnforge
 {
 	namespace plain
 	{
+		namespace
+		{
+			struct rectified_linear_forward_chunk
+			{
+				cpu_dispatch_plain::isa isa;
+				const float * in_it;
+				float * out_it;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					simd_kernels_plain::rectified_linear(isa, in_it + start, out_it + start, current_elem_count);
+				}
+			};
+		}
+
 		rectified_linear_layer_tester_plain::rectified_linear_layer_tester_plain()
 		{
 		}
@@ -52,9 +72,12 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
-				*(out_it + i) = std::max<float>(*(in_it + i), 0.0F);
+			const int chunk_elem_count = spatial_split_plain::get_chunk_elem_count(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count);
+			rectified_linear_forward_chunk body;
+			body.isa = plain_config->cpu_isa;
+			body.in_it = in_it;
+			body.out_it = out_it;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, chunk_elem_count, body);
 		}
 
 		int rectified_linear_layer_tester_plain::get_input_index_layer_can_write(
@@ -65,5 +88,14 @@ namespace nnforge
 		{
 			return 0;
 		}
+
+		bool rectified_linear_layer_tester_plain::is_channel_blocked_layout_supported(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return true;
+		}
 	}
 }
@@ -16,12 +16,45 @@
 
 #include "rectified_linear_layer_updater_plain.h"
 
+#include "parallel_plain.h"
+#include "simd_kernels_plain.h"
 #include "../rectified_linear_layer.h"
 
+#include <algorithm>
+
 namespace nnforge
 {
 	namespace plain
 	{
+		namespace
+		{
+			struct rectified_linear_forward_chunk
+			{
+				cpu_dispatch_plain::isa isa;
+				const float * in_it;
+				float * out_it;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					simd_kernels_plain::rectified_linear(isa, in_it + start, out_it + start, current_elem_count);
+				}
+			};
+
+			struct rectified_linear_backward_chunk
+			{
+				cpu_dispatch_plain::isa isa;
+				const float * out_it;
+				const float * out_err_it;
+				float * in_err_it;
+				bool add_update_to_destination;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					simd_kernels_plain::rectified_linear_backward(isa, out_it + start, out_err_it + start, in_err_it + start, current_elem_count, add_update_to_destination);
+				}
+			};
+		}
+
 		rectified_linear_layer_updater_plain::rectified_linear_layer_updater_plain()
 		{
 		}
@@ -54,9 +87,11 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
-				*(out_it + i) = std::max<float>(*(in_it + i), 0.0F);
+			rectified_linear_forward_chunk body;
+			body.isa = plain_config->cpu_isa;
+			body.in_it = in_it;
+			body.out_it = out_it;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count, body);
 		}
 
 		void rectified_linear_layer_updater_plain::run_backward_data_propagation(
@@ -83,26 +118,13 @@ namespace nnforge
 			float * const in_err_it = *input_errors_buffer;
 			const float * const out_err_it = *output_errors_buffer;
 
-			if (add_update_to_destination)
-			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
-				{
-					float out_val = *(out_it + i);
-					float out_err = *(out_err_it+ i);
-					*(in_err_it + i) += (out_val == 0.0F) ? 0.0F : out_err;
-				}
-			}
-			else
-			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
-				{
-					float out_val = *(out_it + i);
-					float out_err = *(out_err_it+ i);
-					*(in_err_it + i) = (out_val == 0.0F) ? 0.0F : out_err;
-				}
-			}
+			rectified_linear_backward_chunk body;
+			body.isa = plain_config->cpu_isa;
+			body.out_it = out_it;
+			body.out_err_it = out_err_it;
+			body.in_err_it = in_err_it;
+			body.add_update_to_destination = add_update_to_destination;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count, body);
 		}
 
 		int rectified_linear_layer_updater_plain::get_input_index_layer_can_write(
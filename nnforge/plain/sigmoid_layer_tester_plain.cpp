@@ -16,13 +16,33 @@
 
 #include "sigmoid_layer_tester_plain.h"
 
+#include "parallel_plain.h"
+#include "simd_kernels_plain.h"
+#include "spatial_split_plain.h"
 #include "../sigmoid_layer.h"
 #include "../nn_types.h"
 
+#include <algorithm>
+
 namespace nnforge
 {
 	namespace plain
 	{
+		namespace
+		{
+			struct sigmoid_forward_chunk
+			{
+				cpu_dispatch_plain::isa isa;
+				const float * in_it;
+				float * out_it;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					simd_kernels_plain::sigmoid(isa, in_it + start, out_it + start, current_elem_count);
+				}
+			};
+		}
+
 		sigmoid_layer_tester_plain::sigmoid_layer_tester_plain()
 		{
 		}
@@ -53,13 +73,12 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
-			{
-				float inp = *(in_it + i);
-				float res = 1.0F / (expf(-inp) + 1.0F);
-				*(out_it + i) = res;
-			}
+			const int chunk_elem_count = spatial_split_plain::get_chunk_elem_count(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count);
+			sigmoid_forward_chunk body;
+			body.isa = plain_config->cpu_isa;
+			body.in_it = in_it;
+			body.out_it = out_it;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, chunk_elem_count, body);
 		}
 
 		int sigmoid_layer_tester_plain::get_input_index_layer_can_write(
@@ -70,5 +89,14 @@ namespace nnforge
 		{
 			return 0;
 		}
+
+		bool sigmoid_layer_tester_plain::is_channel_blocked_layout_supported(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return true;
+		}
 	}
 }
@@ -16,14 +16,47 @@
 
 #include "sigmoid_layer_updater_plain.h"
 
+#include "parallel_plain.h"
+#include "simd_kernels_plain.h"
 #include "../sigmoid_layer.h"
 #include "../neural_network_exception.h"
 #include "../nn_types.h"
 
+#include <algorithm>
+
 namespace nnforge
 {
 	namespace plain
 	{
+		namespace
+		{
+			struct sigmoid_forward_chunk
+			{
+				cpu_dispatch_plain::isa isa;
+				const float * in_it;
+				float * out_it;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					simd_kernels_plain::sigmoid(isa, in_it + start, out_it + start, current_elem_count);
+				}
+			};
+
+			struct sigmoid_backward_chunk
+			{
+				cpu_dispatch_plain::isa isa;
+				const float * out_it;
+				const float * out_err_it;
+				float * in_err_it;
+				bool add_update_to_destination;
+
+				void operator()(int start, int current_elem_count) const
+				{
+					simd_kernels_plain::sigmoid_backward(isa, out_it + start, out_err_it + start, in_err_it + start, current_elem_count, add_update_to_destination);
+				}
+			};
+		}
+
 		sigmoid_layer_updater_plain::sigmoid_layer_updater_plain()
 		{
 		}
@@ -56,13 +89,11 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
-			{
-				float inp = *(in_it + i);
-				float res = 1.0F / (expf(-inp) + 1.0F);
-				*(out_it + i) = res;
-			}
+			sigmoid_forward_chunk body;
+			body.isa = plain_config->cpu_isa;
+			body.in_it = in_it;
+			body.out_it = out_it;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count, body);
 		}
 
 		void sigmoid_layer_updater_plain::run_backward_data_propagation(
@@ -89,26 +120,13 @@ namespace nnforge
 			const float * const out_it = *output_neurons_buffer;
 			const float * const out_err_it = *output_errors_buffer;
 
-			if (add_update_to_destination)
-			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
-				{
-					float out_neuron = *(out_it + i);
-					float der1st = out_neuron * (1.0F - out_neuron);
-					*(in_err_it + i) += *(out_err_it + i) * der1st;
-				}
-			}
-			else
-			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
-				{
-					float out_neuron = *(out_it + i);
-					float der1st = out_neuron * (1.0F - out_neuron);
-					*(in_err_it + i) = *(out_err_it + i) * der1st;
-				}
-			}
+			sigmoid_backward_chunk body;
+			body.isa = plain_config->cpu_isa;
+			body.out_it = out_it;
+			body.out_err_it = out_err_it;
+			body.in_err_it = in_err_it;
+			body.add_update_to_destination = add_update_to_destination;
+			parallel_plain::for_each_chunk(*plain_config, elem_count, simd_kernels_plain::chunk_elem_count, body);
 		}
 
 		int sigmoid_layer_updater_plain::get_input_index_layer_can_write(
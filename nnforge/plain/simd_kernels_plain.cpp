@@ -0,0 +1,613 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "simd_kernels_plain.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			// Kernel bodies are inlined into the variants below and get compiled for the instruction set of each variant
+
+			NNFORGE_PLAIN_FORCEINLINE void rectified_linear_body(
+				const float * input,
+				float * output,
+				size_t elem_count)
+			{
+				for(size_t i = 0; i < elem_count; ++i)
+					output[i] = std::max<float>(input[i], 0.0F);
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE void rectified_linear_backward_body(
+				const float * output_neurons,
+				const float * output_errors,
+				float * input_errors,
+				size_t elem_count,
+				bool add_update_to_destination)
+			{
+				if (add_update_to_destination)
+				{
+					for(size_t i = 0; i < elem_count; ++i)
+						input_errors[i] += (output_neurons[i] == 0.0F) ? 0.0F : output_errors[i];
+				}
+				else
+				{
+					for(size_t i = 0; i < elem_count; ++i)
+						input_errors[i] = (output_neurons[i] == 0.0F) ? 0.0F : output_errors[i];
+				}
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE void sigmoid_body(
+				const float * input,
+				float * output,
+				size_t elem_count)
+			{
+				for(size_t i = 0; i < elem_count; ++i)
+					output[i] = 1.0F / (expf(-input[i]) + 1.0F);
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE void sigmoid_backward_body(
+				const float * output_neurons,
+				const float * output_errors,
+				float * input_errors,
+				size_t elem_count,
+				bool add_update_to_destination)
+			{
+				if (add_update_to_destination)
+				{
+					for(size_t i = 0; i < elem_count; ++i)
+						input_errors[i] += output_errors[i] * (output_neurons[i] * (1.0F - output_neurons[i]));
+				}
+				else
+				{
+					for(size_t i = 0; i < elem_count; ++i)
+						input_errors[i] = output_errors[i] * (output_neurons[i] * (1.0F - output_neurons[i]));
+				}
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE void hyperbolic_tangent_body(
+				const float * input,
+				float * output,
+				size_t elem_count,
+				float steepness2,
+				float scale)
+			{
+				for(size_t i = 0; i < elem_count; ++i)
+				{
+					float inp2 = expf(input[i] * steepness2);
+					output[i] = (inp2 - 1.0F) / (inp2 + 1.0F) * scale;
+				}
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE void hyperbolic_tangent_backward_body(
+				const float * output_neurons,
+				const float * output_errors,
+				float * input_errors,
+				size_t elem_count,
+				float scale_reverse,
+				float steepness3,
+				bool add_update_to_destination)
+			{
+				if (add_update_to_destination)
+				{
+					for(size_t i = 0; i < elem_count; ++i)
+					{
+						float normalized_value = output_neurons[i] * scale_reverse;
+						input_errors[i] += output_errors[i] * (steepness3 * (1.0F - (normalized_value * normalized_value)));
+					}
+				}
+				else
+				{
+					for(size_t i = 0; i < elem_count; ++i)
+					{
+						float normalized_value = output_neurons[i] * scale_reverse;
+						input_errors[i] = output_errors[i] * (steepness3 * (1.0F - (normalized_value * normalized_value)));
+					}
+				}
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE void max_accumulate_body(
+				float * accumulator,
+				const float * input,
+				size_t elem_count,
+				bool is_min)
+			{
+				if (is_min)
+				{
+					for(size_t i = 0; i < elem_count; ++i)
+						accumulator[i] = std::min<float>(accumulator[i], input[i]);
+				}
+				else
+				{
+					for(size_t i = 0; i < elem_count; ++i)
+						accumulator[i] = std::max<float>(accumulator[i], input[i]);
+				}
+			}
+
+			// Branchless compare and select over the window lets the compiler vectorize across the outputs
+			template<unsigned int window_size, bool is_min>
+			NNFORGE_PLAIN_FORCEINLINE void max_subsampling_stride2_row_window_body(
+				const float * input,
+				size_t input_row_elem_count,
+				float * output,
+				unsigned char * max_indexes,
+				size_t output_elem_count)
+			{
+				for(size_t i = 0; i < output_elem_count; ++i)
+				{
+					const float * in_window = input + i * 2;
+					float best_val = in_window[0];
+					unsigned char max_index = 0;
+					for(unsigned int y = 0; y < window_size; ++y)
+					{
+						for(unsigned int x = 0; x < window_size; ++x)
+						{
+							float new_val = in_window[y * input_row_elem_count + x];
+							bool better = is_min ? (new_val < best_val) : (new_val > best_val);
+							best_val = better ? new_val : best_val;
+							max_index = better ? static_cast<unsigned char>(y * window_size + x) : max_index;
+						}
+					}
+					output[i] = best_val;
+					max_indexes[i] = max_index;
+				}
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE void max_subsampling_stride2_row_body(
+				const float * input,
+				size_t input_row_elem_count,
+				float * output,
+				unsigned char * max_indexes,
+				size_t output_elem_count,
+				unsigned int window_size,
+				bool is_min)
+			{
+				if (window_size == 2)
+				{
+					if (is_min)
+						max_subsampling_stride2_row_window_body<2, true>(input, input_row_elem_count, output, max_indexes, output_elem_count);
+					else
+						max_subsampling_stride2_row_window_body<2, false>(input, input_row_elem_count, output, max_indexes, output_elem_count);
+				}
+				else
+				{
+					if (is_min)
+						max_subsampling_stride2_row_window_body<3, true>(input, input_row_elem_count, output, max_indexes, output_elem_count);
+					else
+						max_subsampling_stride2_row_window_body<3, false>(input, input_row_elem_count, output, max_indexes, output_elem_count);
+				}
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE void max_subsampling_stride2_backward_row_body(
+				const float * output_errors,
+				const unsigned char * max_indexes,
+				float * input_errors,
+				size_t input_row_elem_count,
+				size_t output_elem_count,
+				unsigned int window_size,
+				bool add_update_to_destination)
+			{
+				if (window_size == 2)
+				{
+					// Windows don't overlap, each input elem gets either the error or zero
+					if (add_update_to_destination)
+					{
+						for(size_t i = 0; i < output_elem_count; ++i)
+						{
+							float * in_window = input_errors + i * 2;
+							const float err = output_errors[i];
+							const unsigned char max_index = max_indexes[i];
+							in_window[0] += (max_index == 0) ? err : 0.0F;
+							in_window[1] += (max_index == 1) ? err : 0.0F;
+							in_window[input_row_elem_count] += (max_index == 2) ? err : 0.0F;
+							in_window[input_row_elem_count + 1] += (max_index == 3) ? err : 0.0F;
+						}
+					}
+					else
+					{
+						for(size_t i = 0; i < output_elem_count; ++i)
+						{
+							float * in_window = input_errors + i * 2;
+							const float err = output_errors[i];
+							const unsigned char max_index = max_indexes[i];
+							in_window[0] = (max_index == 0) ? err : 0.0F;
+							in_window[1] = (max_index == 1) ? err : 0.0F;
+							in_window[input_row_elem_count] = (max_index == 2) ? err : 0.0F;
+							in_window[input_row_elem_count + 1] = (max_index == 3) ? err : 0.0F;
+						}
+					}
+				}
+				else
+				{
+					// Neighbour windows share a column, so the errors are added one by one
+					for(size_t i = 0; i < output_elem_count; ++i)
+					{
+						const unsigned int max_index = max_indexes[i];
+						input_errors[i * 2 + (max_index / 3) * input_row_elem_count + (max_index % 3)] += output_errors[i];
+					}
+				}
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE double update_weights_sgd_body(
+				float * weights,
+				float * gradient,
+				size_t elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay)
+			{
+				double accum = 0.0;
+				for(size_t i = 0; i < elem_count; ++i)
+				{
+					float current_weight = weights[i];
+					float upd = learning_rate * (gradient[i] * normalizer - current_weight * weight_decay);
+					accum += static_cast<double>(fabsf(upd));
+					weights[i] = current_weight + upd;
+					gradient[i] = 0.0F;
+				}
+				return accum;
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE double update_weights_momentum_body(
+				float * weights,
+				float * gradient,
+				float * previous_update,
+				size_t elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float momentum)
+			{
+				double accum = 0.0;
+				for(size_t i = 0; i < elem_count; ++i)
+				{
+					float current_weight = weights[i];
+					float upd = previous_update[i] * momentum + learning_rate * (gradient[i] * normalizer - current_weight * weight_decay);
+					accum += static_cast<double>(fabsf(upd));
+					weights[i] = current_weight + upd;
+					gradient[i] = 0.0F;
+					previous_update[i] = upd;
+				}
+				return accum;
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE double update_weights_nesterov_body(
+				float * weights,
+				float * gradient,
+				float * previous_update,
+				size_t elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float momentum)
+			{
+				const float mp1 = momentum + 1.0F;
+				double accum = 0.0;
+				for(size_t i = 0; i < elem_count; ++i)
+				{
+					float current_weight = weights[i];
+					float prev_upd = previous_update[i];
+					float new_upd = prev_upd * momentum + learning_rate * (gradient[i] * normalizer - current_weight * weight_decay);
+					float upd = mp1 * new_upd - momentum * prev_upd;
+					accum += static_cast<double>(fabsf(upd));
+					weights[i] = current_weight + upd;
+					gradient[i] = 0.0F;
+					previous_update[i] = new_upd;
+				}
+				return accum;
+			}
+
+			NNFORGE_PLAIN_FORCEINLINE double update_weights_adam_body(
+				float * weights,
+				float * gradient,
+				float * biased_first_momentum,
+				float * biased_second_momentum,
+				size_t elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float beta1,
+				float beta2,
+				float one_minus_beta1t_inverted,
+				float one_minus_beta2t_inverted,
+				float epsilon)
+			{
+				double accum = 0.0;
+				for(size_t i = 0; i < elem_count; ++i)
+				{
+					float current_weight = weights[i];
+					float total_gradient = gradient[i] * normalizer - current_weight * weight_decay;
+					float new_biased_first_momentum = beta1 * biased_first_momentum[i] + (1.0F - beta1) * total_gradient;
+					float new_biased_second_momentum = beta2 * biased_second_momentum[i] + (1.0F - beta2) * total_gradient * total_gradient;
+					float unbiased_first_momentum = new_biased_first_momentum * one_minus_beta1t_inverted;
+					float unbiased_second_momentum = new_biased_second_momentum * one_minus_beta2t_inverted;
+					float upd = (learning_rate * unbiased_first_momentum) / (sqrtf(unbiased_second_momentum) + epsilon);
+					accum += static_cast<double>(fabsf(upd));
+					weights[i] = current_weight + upd;
+					gradient[i] = 0.0F;
+					biased_first_momentum[i] = new_biased_first_momentum;
+					biased_second_momentum[i] = new_biased_second_momentum;
+				}
+				return accum;
+			}
+
+			class kernel_table
+			{
+			public:
+				void (*rectified_linear)(const float *, float *, size_t);
+				void (*rectified_linear_backward)(const float *, const float *, float *, size_t, bool);
+				void (*sigmoid)(const float *, float *, size_t);
+				void (*sigmoid_backward)(const float *, const float *, float *, size_t, bool);
+				void (*hyperbolic_tangent)(const float *, float *, size_t, float, float);
+				void (*hyperbolic_tangent_backward)(const float *, const float *, float *, size_t, float, float, bool);
+				void (*max_accumulate)(float *, const float *, size_t, bool);
+				void (*max_subsampling_stride2_row)(const float *, size_t, float *, unsigned char *, size_t, unsigned int, bool);
+				void (*max_subsampling_stride2_backward_row)(const float *, const unsigned char *, float *, size_t, size_t, unsigned int, bool);
+				double (*update_weights_sgd)(float *, float *, size_t, float, float, float);
+				double (*update_weights_momentum)(float *, float *, float *, size_t, float, float, float, float);
+				double (*update_weights_nesterov)(float *, float *, float *, size_t, float, float, float, float);
+				double (*update_weights_adam)(float *, float *, float *, float *, size_t, float, float, float, float, float, float, float, float);
+			};
+
+			// Defines kernels compiled with target_attribute and their table in namespace isa_namespace
+#define NNFORGE_SIMD_KERNELS_PLAIN_VARIANT(isa_namespace, target_attribute) \
+			namespace isa_namespace \
+			{ \
+				target_attribute void rectified_linear(const float * input, float * output, size_t elem_count) \
+				{ \
+					rectified_linear_body(input, output, elem_count); \
+				} \
+				target_attribute void rectified_linear_backward(const float * output_neurons, const float * output_errors, float * input_errors, size_t elem_count, bool add_update_to_destination) \
+				{ \
+					rectified_linear_backward_body(output_neurons, output_errors, input_errors, elem_count, add_update_to_destination); \
+				} \
+				target_attribute void sigmoid(const float * input, float * output, size_t elem_count) \
+				{ \
+					sigmoid_body(input, output, elem_count); \
+				} \
+				target_attribute void sigmoid_backward(const float * output_neurons, const float * output_errors, float * input_errors, size_t elem_count, bool add_update_to_destination) \
+				{ \
+					sigmoid_backward_body(output_neurons, output_errors, input_errors, elem_count, add_update_to_destination); \
+				} \
+				target_attribute void hyperbolic_tangent(const float * input, float * output, size_t elem_count, float steepness2, float scale) \
+				{ \
+					hyperbolic_tangent_body(input, output, elem_count, steepness2, scale); \
+				} \
+				target_attribute void hyperbolic_tangent_backward(const float * output_neurons, const float * output_errors, float * input_errors, size_t elem_count, float scale_reverse, float steepness3, bool add_update_to_destination) \
+				{ \
+					hyperbolic_tangent_backward_body(output_neurons, output_errors, input_errors, elem_count, scale_reverse, steepness3, add_update_to_destination); \
+				} \
+				target_attribute void max_accumulate(float * accumulator, const float * input, size_t elem_count, bool is_min) \
+				{ \
+					max_accumulate_body(accumulator, input, elem_count, is_min); \
+				} \
+				target_attribute void max_subsampling_stride2_row(const float * input, size_t input_row_elem_count, float * output, unsigned char * max_indexes, size_t output_elem_count, unsigned int window_size, bool is_min) \
+				{ \
+					max_subsampling_stride2_row_body(input, input_row_elem_count, output, max_indexes, output_elem_count, window_size, is_min); \
+				} \
+				target_attribute void max_subsampling_stride2_backward_row(const float * output_errors, const unsigned char * max_indexes, float * input_errors, size_t input_row_elem_count, size_t output_elem_count, unsigned int window_size, bool add_update_to_destination) \
+				{ \
+					max_subsampling_stride2_backward_row_body(output_errors, max_indexes, input_errors, input_row_elem_count, output_elem_count, window_size, add_update_to_destination); \
+				} \
+				target_attribute double update_weights_sgd(float * weights, float * gradient, size_t elem_count, float learning_rate, float normalizer, float weight_decay) \
+				{ \
+					return update_weights_sgd_body(weights, gradient, elem_count, learning_rate, normalizer, weight_decay); \
+				} \
+				target_attribute double update_weights_momentum(float * weights, float * gradient, float * previous_update, size_t elem_count, float learning_rate, float normalizer, float weight_decay, float momentum) \
+				{ \
+					return update_weights_momentum_body(weights, gradient, previous_update, elem_count, learning_rate, normalizer, weight_decay, momentum); \
+				} \
+				target_attribute double update_weights_nesterov(float * weights, float * gradient, float * previous_update, size_t elem_count, float learning_rate, float normalizer, float weight_decay, float momentum) \
+				{ \
+					return update_weights_nesterov_body(weights, gradient, previous_update, elem_count, learning_rate, normalizer, weight_decay, momentum); \
+				} \
+				target_attribute double update_weights_adam(float * weights, float * gradient, float * biased_first_momentum, float * biased_second_momentum, size_t elem_count, float learning_rate, float normalizer, float weight_decay, float beta1, float beta2, float one_minus_beta1t_inverted, float one_minus_beta2t_inverted, float epsilon) \
+				{ \
+					return update_weights_adam_body(weights, gradient, biased_first_momentum, biased_second_momentum, elem_count, learning_rate, normalizer, weight_decay, beta1, beta2, one_minus_beta1t_inverted, one_minus_beta2t_inverted, epsilon); \
+				} \
+				const kernel_table table = { \
+					rectified_linear, \
+					rectified_linear_backward, \
+					sigmoid, \
+					sigmoid_backward, \
+					hyperbolic_tangent, \
+					hyperbolic_tangent_backward, \
+					max_accumulate, \
+					max_subsampling_stride2_row, \
+					max_subsampling_stride2_backward_row, \
+					update_weights_sgd, \
+					update_weights_momentum, \
+					update_weights_nesterov, \
+					update_weights_adam}; \
+			}
+
+			NNFORGE_PLAIN_FOR_EACH_ISA(NNFORGE_SIMD_KERNELS_PLAIN_VARIANT)
+
+#undef NNFORGE_SIMD_KERNELS_PLAIN_VARIANT
+
+			const kernel_table& get_kernel_table(cpu_dispatch_plain::isa isa)
+			{
+				return NNFORGE_PLAIN_SELECT_ISA(isa, table);
+			}
+		}
+
+		const int simd_kernels_plain::chunk_elem_count = 4096;
+
+		void simd_kernels_plain::rectified_linear(
+			cpu_dispatch_plain::isa isa,
+			const float * input,
+			float * output,
+			size_t elem_count)
+		{
+			get_kernel_table(isa).rectified_linear(input, output, elem_count);
+		}
+
+		void simd_kernels_plain::rectified_linear_backward(
+			cpu_dispatch_plain::isa isa,
+			const float * output_neurons,
+			const float * output_errors,
+			float * input_errors,
+			size_t elem_count,
+			bool add_update_to_destination)
+		{
+			get_kernel_table(isa).rectified_linear_backward(output_neurons, output_errors, input_errors, elem_count, add_update_to_destination);
+		}
+
+		void simd_kernels_plain::sigmoid(
+			cpu_dispatch_plain::isa isa,
+			const float * input,
+			float * output,
+			size_t elem_count)
+		{
+			get_kernel_table(isa).sigmoid(input, output, elem_count);
+		}
+
+		void simd_kernels_plain::sigmoid_backward(
+			cpu_dispatch_plain::isa isa,
+			const float * output_neurons,
+			const float * output_errors,
+			float * input_errors,
+			size_t elem_count,
+			bool add_update_to_destination)
+		{
+			get_kernel_table(isa).sigmoid_backward(output_neurons, output_errors, input_errors, elem_count, add_update_to_destination);
+		}
+
+		void simd_kernels_plain::hyperbolic_tangent(
+			cpu_dispatch_plain::isa isa,
+			const float * input,
+			float * output,
+			size_t elem_count,
+			float steepness2,
+			float scale)
+		{
+			get_kernel_table(isa).hyperbolic_tangent(input, output, elem_count, steepness2, scale);
+		}
+
+		void simd_kernels_plain::hyperbolic_tangent_backward(
+			cpu_dispatch_plain::isa isa,
+			const float * output_neurons,
+			const float * output_errors,
+			float * input_errors,
+			size_t elem_count,
+			float scale_reverse,
+			float steepness3,
+			bool add_update_to_destination)
+		{
+			get_kernel_table(isa).hyperbolic_tangent_backward(output_neurons, output_errors, input_errors, elem_count, scale_reverse, steepness3, add_update_to_destination);
+		}
+
+		void simd_kernels_plain::max_accumulate(
+			cpu_dispatch_plain::isa isa,
+			float * accumulator,
+			const float * input,
+			size_t elem_count,
+			bool is_min)
+		{
+			get_kernel_table(isa).max_accumulate(accumulator, input, elem_count, is_min);
+		}
+
+		void simd_kernels_plain::max_subsampling_stride2_row(
+			cpu_dispatch_plain::isa isa,
+			const float * input,
+			size_t input_row_elem_count,
+			float * output,
+			unsigned char * max_indexes,
+			size_t output_elem_count,
+			unsigned int window_size,
+			bool is_min)
+		{
+			get_kernel_table(isa).max_subsampling_stride2_row(input, input_row_elem_count, output, max_indexes, output_elem_count, window_size, is_min);
+		}
+
+		void simd_kernels_plain::max_subsampling_stride2_backward_row(
+			cpu_dispatch_plain::isa isa,
+			const float * output_errors,
+			const unsigned char * max_indexes,
+			float * input_errors,
+			size_t input_row_elem_count,
+			size_t output_elem_count,
+			unsigned int window_size,
+			bool add_update_to_destination)
+		{
+			get_kernel_table(isa).max_subsampling_stride2_backward_row(output_errors, max_indexes, input_errors, input_row_elem_count, output_elem_count, window_size, add_update_to_destination);
+		}
+
+		double simd_kernels_plain::update_weights_sgd(
+			cpu_dispatch_plain::isa isa,
+			float * weights,
+			float * gradient,
+			size_t elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay)
+		{
+			return get_kernel_table(isa).update_weights_sgd(weights, gradient, elem_count, learning_rate, normalizer, weight_decay);
+		}
+
+		double simd_kernels_plain::update_weights_momentum(
+			cpu_dispatch_plain::isa isa,
+			float * weights,
+			float * gradient,
+			float * previous_update,
+			size_t elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float momentum)
+		{
+			return get_kernel_table(isa).update_weights_momentum(weights, gradient, previous_update, elem_count, learning_rate, normalizer, weight_decay, momentum);
+		}
+
+		double simd_kernels_plain::update_weights_nesterov(
+			cpu_dispatch_plain::isa isa,
+			float * weights,
+			float * gradient,
+			float * previous_update,
+			size_t elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float momentum)
+		{
+			return get_kernel_table(isa).update_weights_nesterov(weights, gradient, previous_update, elem_count, learning_rate, normalizer, weight_decay, momentum);
+		}
+
+		double simd_kernels_plain::update_weights_adam(
+			cpu_dispatch_plain::isa isa,
+			float * weights,
+			float * gradient,
+			float * biased_first_momentum,
+			float * biased_second_momentum,
+			size_t elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float beta1,
+			float beta2,
+			float one_minus_beta1t_inverted,
+			float one_minus_beta2t_inverted,
+			float epsilon)
+		{
+			return get_kernel_table(isa).update_weights_adam(weights, gradient, biased_first_momentum, biased_second_momentum, elem_count, learning_rate, normalizer, weight_decay, beta1, beta2, one_minus_beta1t_inverted, one_minus_beta2t_inverted, epsilon);
+		}
+	}
+}
@@ -0,0 +1,170 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "cpu_dispatch_plain.h"
+
+#include <cstddef>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Hot elementwise kernels compiled for each instruction set of cpu_dispatch_plain,
+		// the variant for the instruction set passed is called. Kernels are single threaded
+		class simd_kernels_plain
+		{
+		public:
+			// Elementwise work is split into chunks of this size between threads
+			static const int chunk_elem_count;
+
+			static void rectified_linear(
+				cpu_dispatch_plain::isa isa,
+				const float * input,
+				float * output,
+				size_t elem_count);
+
+			static void rectified_linear_backward(
+				cpu_dispatch_plain::isa isa,
+				const float * output_neurons,
+				const float * output_errors,
+				float * input_errors,
+				size_t elem_count,
+				bool add_update_to_destination);
+
+			static void sigmoid(
+				cpu_dispatch_plain::isa isa,
+				const float * input,
+				float * output,
+				size_t elem_count);
+
+			static void sigmoid_backward(
+				cpu_dispatch_plain::isa isa,
+				const float * output_neurons,
+				const float * output_errors,
+				float * input_errors,
+				size_t elem_count,
+				bool add_update_to_destination);
+
+			static void hyperbolic_tangent(
+				cpu_dispatch_plain::isa isa,
+				const float * input,
+				float * output,
+				size_t elem_count,
+				float steepness2,
+				float scale);
+
+			static void hyperbolic_tangent_backward(
+				cpu_dispatch_plain::isa isa,
+				const float * output_neurons,
+				const float * output_errors,
+				float * input_errors,
+				size_t elem_count,
+				float scale_reverse,
+				float steepness3,
+				bool add_update_to_destination);
+
+			// accumulator = max(accumulator, input) elementwise, min is taken when is_min is true
+			static void max_accumulate(
+				cpu_dispatch_plain::isa isa,
+				float * accumulator,
+				const float * input,
+				size_t elem_count,
+				bool is_min);
+
+			// Max (min when is_min) of window_size x window_size windows with stride 2 along a row of output_elem_count outputs,
+			// input points to the top left elem of the first window. max_indexes receive the position inside the window, x first.
+			// window_size is either 2 or 3
+			static void max_subsampling_stride2_row(
+				cpu_dispatch_plain::isa isa,
+				const float * input,
+				size_t input_row_elem_count,
+				float * output,
+				unsigned char * max_indexes,
+				size_t output_elem_count,
+				unsigned int window_size,
+				bool is_min);
+
+			// Propagates output errors to input errors at the positions max_subsampling_stride2_row reported.
+			// When add_update_to_destination is false window_size should be 2, the windows are assigned entirely
+			static void max_subsampling_stride2_backward_row(
+				cpu_dispatch_plain::isa isa,
+				const float * output_errors,
+				const unsigned char * max_indexes,
+				float * input_errors,
+				size_t input_row_elem_count,
+				size_t output_elem_count,
+				unsigned int window_size,
+				bool add_update_to_destination);
+
+			// Weight update functions apply the update to weights, zero gradient and return the sum of absolute updates
+			static double update_weights_sgd(
+				cpu_dispatch_plain::isa isa,
+				float * weights,
+				float * gradient,
+				size_t elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay);
+
+			// previous_update holds the update of the previous iteration
+			static double update_weights_momentum(
+				cpu_dispatch_plain::isa isa,
+				float * weights,
+				float * gradient,
+				float * previous_update,
+				size_t elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float momentum);
+
+			// previous_update holds the update of the previous iteration before Nesterov correction
+			static double update_weights_nesterov(
+				cpu_dispatch_plain::isa isa,
+				float * weights,
+				float * gradient,
+				float * previous_update,
+				size_t elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float momentum);
+
+			// biased_first_momentum and biased_second_momentum are updated in place
+			static double update_weights_adam(
+				cpu_dispatch_plain::isa isa,
+				float * weights,
+				float * gradient,
+				float * biased_first_momentum,
+				float * biased_second_momentum,
+				size_t elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float beta1,
+				float beta2,
+				float one_minus_beta1t_inverted,
+				float one_minus_beta2t_inverted,
+				float epsilon);
+
+		private:
+			simd_kernels_plain();
+			~simd_kernels_plain();
+		};
+	}
+}
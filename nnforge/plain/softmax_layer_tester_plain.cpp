@@ -20,8 +20,11 @@
 #include <omp.h>
 #endif
 
+#include "spatial_split_plain.h"
 #include "../softmax_layer.h"
 
+#include <vector>
+
 namespace nnforge
 {
 	namespace plain
@@ -61,6 +64,20 @@ namespace nnforge
 
 			const int total_workload = entry_count * neuron_count_per_feature_map;
 			const int openmp_thread_count = plain_config->openmp_thread_count;
+
+			const unsigned int split_count = spatial_split_plain::get_split_count(*plain_config, total_workload, feature_map_count, 16);
+			if (split_count > 1)
+			{
+				run_forward_propagation_split(
+					output_buffer_it,
+					input_buffer_it,
+					openmp_thread_count,
+					neuron_count_per_feature_map,
+					feature_map_count,
+					entry_count,
+					split_count);
+				return;
+			}
 			
 			#pragma omp parallel default(none) num_threads(openmp_thread_count)
 			{
@@ -98,6 +115,90 @@ namespace nnforge
 			} // #pragma parallel
 		}
 
+		void softmax_layer_tester_plain::run_forward_propagation_split(
+			float * output,
+			const float * input,
+			int openmp_thread_count,
+			unsigned int neuron_count_per_feature_map,
+			unsigned int feature_map_count,
+			unsigned int entry_count,
+			unsigned int split_count) const
+		{
+			// Reduction over feature maps is split into parts: partial maximums, then exponents and partial sums, then scaling
+			const unsigned int neuron_count = neuron_count_per_feature_map * feature_map_count;
+			const int total_workload = static_cast<int>(entry_count * neuron_count_per_feature_map * split_count);
+			std::vector<float> partial_max(total_workload);
+			std::vector<float> partial_sum(total_workload);
+
+			#pragma omp parallel default(shared) num_threads(openmp_thread_count)
+			{
+				#pragma omp for schedule(static)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					int entry_neuron_id = workload_id / split_count;
+					int split_id = workload_id - entry_neuron_id * split_count;
+					int entry_id = entry_neuron_id / neuron_count_per_feature_map;
+					int neuron_id = entry_neuron_id - (entry_id * neuron_count_per_feature_map);
+					unsigned int feature_map_start;
+					unsigned int feature_map_end;
+					spatial_split_plain::get_range(feature_map_count, split_count, split_id, feature_map_start, feature_map_end);
+					const float * in_it = input + (entry_id * neuron_count) + neuron_id;
+
+					float max_val = -1.0e+37F;
+					for(unsigned int feature_map_id = feature_map_start; feature_map_id < feature_map_end; ++feature_map_id)
+						max_val = std::max(max_val, *(in_it + (feature_map_id * neuron_count_per_feature_map)));
+					partial_max[workload_id] = max_val;
+				}
+
+				#pragma omp for schedule(static)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					int entry_neuron_id = workload_id / split_count;
+					int split_id = workload_id - entry_neuron_id * split_count;
+					int entry_id = entry_neuron_id / neuron_count_per_feature_map;
+					int neuron_id = entry_neuron_id - (entry_id * neuron_count_per_feature_map);
+					unsigned int feature_map_start;
+					unsigned int feature_map_end;
+					spatial_split_plain::get_range(feature_map_count, split_count, split_id, feature_map_start, feature_map_end);
+					const float * in_it = input + (entry_id * neuron_count) + neuron_id;
+					float * out_it = output + (entry_id * neuron_count) + neuron_id;
+
+					float max_val = -1.0e+37F;
+					for(unsigned int i = 0; i < split_count; ++i)
+						max_val = std::max(max_val, partial_max[entry_neuron_id * split_count + i]);
+
+					float sum = 0.0F;
+					for(unsigned int feature_map_id = feature_map_start; feature_map_id < feature_map_end; ++feature_map_id)
+					{
+						float val = expf((*(in_it + (feature_map_id * neuron_count_per_feature_map))) - max_val);
+						sum += val;
+						*(out_it + (feature_map_id * neuron_count_per_feature_map)) = val;
+					}
+					partial_sum[workload_id] = sum;
+				}
+
+				#pragma omp for schedule(static)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					int entry_neuron_id = workload_id / split_count;
+					int split_id = workload_id - entry_neuron_id * split_count;
+					int entry_id = entry_neuron_id / neuron_count_per_feature_map;
+					int neuron_id = entry_neuron_id - (entry_id * neuron_count_per_feature_map);
+					unsigned int feature_map_start;
+					unsigned int feature_map_end;
+					spatial_split_plain::get_range(feature_map_count, split_count, split_id, feature_map_start, feature_map_end);
+					float * out_it = output + (entry_id * neuron_count) + neuron_id;
+
+					float sum = 0.0F;
+					for(unsigned int i = 0; i < split_count; ++i)
+						sum += partial_sum[entry_neuron_id * split_count + i];
+					float mult = 1.0F / sum;
+					for(unsigned int feature_map_id = feature_map_start; feature_map_id < feature_map_end; ++feature_map_id)
+						*(out_it + (feature_map_id * neuron_count_per_feature_map)) *= mult;
+				}
+			} // #pragma parallel
+		}
+
 		int softmax_layer_tester_plain::get_input_index_layer_can_write(
 			plain_running_configuration::const_ptr plain_config,
 			layer::const_ptr layer_schema,
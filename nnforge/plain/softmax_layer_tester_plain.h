@@ -49,6 +49,16 @@ namespace nnforge
 				layer::const_ptr layer_schema,
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
+
+		private:
+			void run_forward_propagation_split(
+				float * output,
+				const float * input,
+				int openmp_thread_count,
+				unsigned int neuron_count_per_feature_map,
+				unsigned int feature_map_count,
+				unsigned int entry_count,
+				unsigned int split_count) const;
 		};
 	}
 }
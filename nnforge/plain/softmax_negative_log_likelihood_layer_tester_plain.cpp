@@ -0,0 +1,129 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "softmax_negative_log_likelihood_layer_tester_plain.h"
+
+#include "../negative_log_likelihood_layer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		softmax_negative_log_likelihood_layer_tester_plain::softmax_negative_log_likelihood_layer_tester_plain()
+		{
+		}
+
+		softmax_negative_log_likelihood_layer_tester_plain::~softmax_negative_log_likelihood_layer_tester_plain()
+		{
+		}
+
+		void softmax_negative_log_likelihood_layer_tester_plain::run_forward_propagation(
+			plain_buffer::ptr output_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count) const
+		{
+			const float * const in_it_global_softmax_input = *input_buffers[0];
+			const float * const in_it_global_actual = *input_buffers[1];
+			float * const out_it_global = *output_buffer;
+			const float * scale_mask_it = 0;
+			if (input_buffers.size() > 2)
+				scale_mask_it = *input_buffers[2];
+			const float * const const_scale_mask_it = scale_mask_it;
+			const int input_neuron_count = static_cast<int>(input_configuration_specific_list[0].get_neuron_count());
+			const int neuron_count_per_feature_map = static_cast<int>(input_configuration_specific_list[0].get_neuron_count_per_feature_map());
+			const int input_feature_map_count = static_cast<int>(input_configuration_specific_list[0].feature_map_count);
+			nnforge_shared_ptr<const negative_log_likelihood_layer> layer_derived = nnforge_dynamic_pointer_cast<const negative_log_likelihood_layer>(layer_schema);
+			const float scale = layer_derived->scale;
+			const int total_entry_count = static_cast<int>(entry_count);
+
+			// Feature maps are iterated in the outer loop, so that each pass reads contiguous neurons of a feature map:
+			// the first pass gets the running maximum and the sum of exponents rescaled to it, -log(softmax(x)) = max + log(sum) - x
+			// for each target is accumulated by the second one
+			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			{
+				std::vector<float> max_vals(neuron_count_per_feature_map);
+				std::vector<float> sums(neuron_count_per_feature_map);
+				std::vector<float> errs(neuron_count_per_feature_map);
+
+				#pragma omp for schedule(guided)
+				for(int entry_id = 0; entry_id < total_entry_count; ++entry_id)
+				{
+					const float * in_it_base_softmax_input = in_it_global_softmax_input + entry_id * input_neuron_count;
+					const float * in_it_base_actual = in_it_global_actual + entry_id * input_neuron_count;
+					float * out_it_base = out_it_global + entry_id * neuron_count_per_feature_map;
+
+					std::copy(in_it_base_softmax_input, in_it_base_softmax_input + neuron_count_per_feature_map, max_vals.begin());
+					std::fill(sums.begin(), sums.end(), 1.0F);
+					for(int feature_map_id = 1; feature_map_id < input_feature_map_count; ++feature_map_id)
+					{
+						const float * in_it = in_it_base_softmax_input + feature_map_id * neuron_count_per_feature_map;
+						for(int neuron_id = 0; neuron_id < neuron_count_per_feature_map; ++neuron_id)
+						{
+							float val = in_it[neuron_id];
+							float max_val = max_vals[neuron_id];
+							if (val > max_val)
+							{
+								sums[neuron_id] = sums[neuron_id] * expf(max_val - val) + 1.0F;
+								max_vals[neuron_id] = val;
+							}
+							else
+							{
+								sums[neuron_id] += expf(val - max_val);
+							}
+						}
+					}
+
+					// max_vals become logsumexp
+					for(int neuron_id = 0; neuron_id < neuron_count_per_feature_map; ++neuron_id)
+						max_vals[neuron_id] += logf(sums[neuron_id]);
+
+					std::fill(errs.begin(), errs.end(), 0.0F);
+					for(int feature_map_id = 0; feature_map_id < input_feature_map_count; ++feature_map_id)
+					{
+						const float * in_it = in_it_base_softmax_input + feature_map_id * neuron_count_per_feature_map;
+						const float * actual_it = in_it_base_actual + feature_map_id * neuron_count_per_feature_map;
+						for(int neuron_id = 0; neuron_id < neuron_count_per_feature_map; ++neuron_id)
+						{
+							float actual_val = actual_it[neuron_id];
+							if (actual_val > 0.0F)
+								errs[neuron_id] += actual_val * (max_vals[neuron_id] - in_it[neuron_id]);
+						}
+					}
+
+					for(int neuron_id = 0; neuron_id < neuron_count_per_feature_map; ++neuron_id)
+					{
+						float total_scale = scale;
+						if (const_scale_mask_it)
+							total_scale *= *(const_scale_mask_it + entry_id * neuron_count_per_feature_map + neuron_id);
+						out_it_base[neuron_id] = errs[neuron_id] * total_scale;
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,126 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "softmax_negative_log_likelihood_layer_updater_plain.h"
+
+#include "../negative_log_likelihood_layer.h"
+#include "../neural_network_exception.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		softmax_negative_log_likelihood_layer_updater_plain::softmax_negative_log_likelihood_layer_updater_plain()
+		{
+		}
+
+		softmax_negative_log_likelihood_layer_updater_plain::~softmax_negative_log_likelihood_layer_updater_plain()
+		{
+		}
+
+		void softmax_negative_log_likelihood_layer_updater_plain::run_backward_data_propagation(
+			unsigned int input_index,
+			plain_buffer::ptr input_errors_buffer,
+			plain_buffer::const_ptr output_errors_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+			plain_buffer::const_ptr output_neurons_buffer,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_buffer::ptr temporary_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const bool add_update_to_destination,
+			const std::set<layer_action>& actions,
+			unsigned int entry_count) const
+		{
+			if (input_index == 1)
+				throw neural_network_exception("softmax_negative_log_likelihood_layer_updater_plain cannot do backward propagation for targets");
+			if (input_index == 2)
+				throw neural_network_exception("softmax_negative_log_likelihood_layer_updater_plain cannot do backward propagation for scale mask");
+
+			float * const in_err_it = *input_errors_buffer;
+			const float * const softmax_output_neurons_it = *input_neurons_buffers[0];
+			const float * const target_input_neurons_it = *input_neurons_buffers[1];
+			const float * scale_mask_it = 0;
+			if (input_neurons_buffers.size() > 2)
+				scale_mask_it = *input_neurons_buffers[2];
+			const float * const const_scale_mask_it = scale_mask_it;
+
+			nnforge_shared_ptr<const negative_log_likelihood_layer> layer_derived = nnforge_dynamic_pointer_cast<const negative_log_likelihood_layer>(layer_schema);
+			const float scale = layer_derived->scale;
+			const int neuron_count_per_feature_map = input_configuration_specific_list[0].get_neuron_count_per_feature_map();
+			const int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
+			const int input_neuron_count = input_feature_map_count * neuron_count_per_feature_map;
+			const int total_entry_count = static_cast<int>(entry_count);
+
+			// With predicted = softmax(x) and loss = -sum(actual * log(predicted)) over positive actual values
+			// the error for x is actual - predicted * sum(actual), no division by predicted and no softmax Jacobian.
+			// Feature maps are iterated in the outer loop, so that each pass reads contiguous neurons of a feature map
+			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			{
+				std::vector<float> actual_sums(neuron_count_per_feature_map);
+				std::vector<float> total_scales(neuron_count_per_feature_map);
+
+				#pragma omp for schedule(guided)
+				for(int entry_id = 0; entry_id < total_entry_count; ++entry_id)
+				{
+					const int input_base_offset = entry_id * input_neuron_count;
+
+					std::fill(actual_sums.begin(), actual_sums.end(), 0.0F);
+					for(int feature_map_id = 0; feature_map_id < input_feature_map_count; ++feature_map_id)
+					{
+						const float * actual_it = target_input_neurons_it + input_base_offset + feature_map_id * neuron_count_per_feature_map;
+						for(int neuron_id = 0; neuron_id < neuron_count_per_feature_map; ++neuron_id)
+							actual_sums[neuron_id] += std::max(actual_it[neuron_id], 0.0F);
+					}
+
+					for(int neuron_id = 0; neuron_id < neuron_count_per_feature_map; ++neuron_id)
+					{
+						float total_scale = scale;
+						if (const_scale_mask_it)
+							total_scale *= *(const_scale_mask_it + entry_id * neuron_count_per_feature_map + neuron_id);
+						total_scales[neuron_id] = total_scale;
+					}
+
+					for(int feature_map_id = 0; feature_map_id < input_feature_map_count; ++feature_map_id)
+					{
+						const int input_offset = input_base_offset + feature_map_id * neuron_count_per_feature_map;
+						const float * actual_it = target_input_neurons_it + input_offset;
+						const float * predicted_it = softmax_output_neurons_it + input_offset;
+						float * in_err_it_base = in_err_it + input_offset;
+						for(int neuron_id = 0; neuron_id < neuron_count_per_feature_map; ++neuron_id)
+						{
+							float actual_val = std::max(actual_it[neuron_id], 0.0F);
+							float gradient = (actual_val - predicted_it[neuron_id] * actual_sums[neuron_id]) * total_scales[neuron_id];
+
+							if (add_update_to_destination)
+								in_err_it_base[neuron_id] += gradient;
+							else
+								in_err_it_base[neuron_id] = gradient;
+						}
+					}
+				}
+			}
+		}
+	}
+}
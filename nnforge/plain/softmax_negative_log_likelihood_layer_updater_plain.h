@@ -0,0 +1,54 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "negative_log_likelihood_layer_updater_plain.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Used by backward_propagation_plain for the negative log likelihood layer fed by a softmax layer which has no other consumers.
+		// The softmax layer gets no backward data action then, this updater propagates errors to the input of the softmax directly
+		class softmax_negative_log_likelihood_layer_updater_plain : public negative_log_likelihood_layer_updater_plain
+		{
+		public:
+			softmax_negative_log_likelihood_layer_updater_plain();
+
+			virtual ~softmax_negative_log_likelihood_layer_updater_plain();
+
+			virtual void run_backward_data_propagation(
+				unsigned int input_index,
+				plain_buffer::ptr input_errors_buffer,
+				plain_buffer::const_ptr output_errors_buffer,
+				const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+				plain_buffer::const_ptr output_neurons_buffer,
+				plain_buffer::ptr temporary_working_fixed_buffer,
+				plain_buffer::ptr temporary_working_per_entry_buffer,
+				plain_buffer::ptr temporary_per_entry_buffer,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				layer_data::const_ptr data,
+				layer_data_custom::const_ptr data_custom,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				const bool add_update_to_destination,
+				const std::set<layer_action>& actions,
+				unsigned int entry_count) const;
+		};
+	}
+}
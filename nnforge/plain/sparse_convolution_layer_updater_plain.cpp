@@ -16,6 +16,7 @@
 
 #include "sparse_convolution_layer_updater_plain.h"
 
+#include "gradient_reduction_plain.h"
 #include "../sparse_convolution_layer.h"
 
 #include <array>
@@ -484,6 +485,12 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 			const std::vector<std::pair<int, int> >::const_iterator out_fm_in_fm_it = out_fm_in_fm_list.begin();
 
+			// With few connections entries are split into slices, each slice accumulating into its own slab
+			const size_t gradient_elem_count = (*gradient)[0].size();
+			const unsigned int slice_count = gradient_reduction_plain::get_slice_count(total_workload, gradient_elem_count, entry_count, plain_config->openmp_thread_count);
+			void * const slab_buffer = (slice_count > 1) ? static_cast<void *>(*temporary_working_fixed_buffer) : 0;
+			const int total_sliced_workload = total_workload * static_cast<int>(slice_count);
+
 			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
 			{
 				nnforge_array<unsigned int, max_dimension_count> current_output_position;
@@ -491,15 +498,20 @@ namespace nnforge
 				std::vector<float> weights_local(const_window_elem_count, 0.0F);
 
 				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = 0; workload_id < total_sliced_workload; ++workload_id)
 				{
-					int weight_block_id = workload_id;
+					int slice_id = workload_id / total_workload;
+					int weight_block_id = workload_id - (slice_id * total_workload);
 					int output_feature_map_id = out_fm_in_fm_it[weight_block_id].first;
 					int input_feature_map_id = out_fm_in_fm_it[weight_block_id].second;
 
 					std::fill_n(weights_local.begin(), const_window_elem_count, 0.0F);
 
-					for(int entry_id = 0; entry_id < const_entry_count; ++entry_id)
+					unsigned int entry_start = 0;
+					unsigned int entry_end = const_entry_count;
+					if (slice_count > 1)
+						gradient_reduction_plain::get_entry_range(const_entry_count, slice_count, slice_id, entry_start, entry_end);
+					for(int entry_id = static_cast<int>(entry_start); entry_id < static_cast<int>(entry_end); ++entry_id)
 					{
 						const float * in_it_base = in_it_global + (entry_id * input_neuron_count) + (input_feature_map_id * input_neuron_count_per_feature_map);
 						const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
@@ -552,13 +564,25 @@ namespace nnforge
 						}
 					}
 
-					std::vector<float>::iterator gradient_weights_it_base = gradient_weights + weight_block_id * const_window_elem_count;
-					std::vector<float>::iterator weights_local_it = weights_local.begin();
-					for(std::vector<float>::iterator it = gradient_weights_it_base; it != gradient_weights_it_base + const_window_elem_count; ++it, ++weights_local_it)
-						*it += *weights_local_it;
+					if (slice_count > 1)
+					{
+						// Each slab element is written by a single work item, so the slabs need no clearing
+						float * slab = gradient_reduction_plain::get_slab(slab_buffer, gradient_elem_count, slice_id);
+						std::copy(weights_local.begin(), weights_local.end(), slab + weight_block_id * const_window_elem_count);
+					}
+					else
+					{
+						std::vector<float>::iterator gradient_weights_it_base = gradient_weights + weight_block_id * const_window_elem_count;
+						std::vector<float>::iterator weights_local_it = weights_local.begin();
+						for(std::vector<float>::iterator it = gradient_weights_it_base; it != gradient_weights_it_base + const_window_elem_count; ++it, ++weights_local_it)
+							*it += *weights_local_it;
+					}
 				}
 			}
 
+			if (slice_count > 1)
+				gradient_reduction_plain::reduce(slab_buffer, gradient_elem_count, slice_count, &(*gradient)[0][0], plain_config->openmp_thread_count);
+
 			if (bias)
 			{
 				const std::vector<float>::iterator gradient_biases = (*gradient)[1].begin();
@@ -584,6 +608,30 @@ namespace nnforge
 			}
 		}
 
+		size_t sparse_convolution_layer_updater_plain::get_temporary_working_fixed_buffer_size(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			if (action.get_action_type() == layer_action::backward_weights)
+			{
+				nnforge_shared_ptr<const sparse_convolution_layer> layer_derived = nnforge_dynamic_pointer_cast<const sparse_convolution_layer>(layer_schema);
+				size_t window_elem_count = 1;
+				for(std::vector<unsigned int>::const_iterator it = layer_derived->window_sizes.begin(); it != layer_derived->window_sizes.end(); ++it)
+					window_elem_count *= *it;
+
+				return gradient_reduction_plain::get_slab_buffer_size(
+					layer_derived->feature_map_connection_count,
+					layer_derived->feature_map_connection_count * window_elem_count,
+					plain_config->openmp_thread_count);
+			}
+
+			return layer_updater_plain::get_temporary_working_fixed_buffer_size(action, actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific);
+		}
+
 		bool sparse_convolution_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
 			unsigned int action_input_index,
 			unsigned int data_input_index,
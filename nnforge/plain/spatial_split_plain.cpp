@@ -0,0 +1,76 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "spatial_split_plain.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const unsigned int spatial_split_plain::min_cost_per_split = 16384;
+		const unsigned int spatial_split_plain::split_count_per_thread = 2;
+		const int spatial_split_plain::min_chunk_elem_count = 256;
+
+		unsigned int spatial_split_plain::get_split_count(
+			const plain_running_configuration& config,
+			unsigned int outer_workload_count,
+			unsigned int inner_item_count,
+			unsigned int cost_per_inner_item)
+		{
+			const unsigned int thread_count = static_cast<unsigned int>(std::max(config.openmp_thread_count, 1));
+			if (!config.low_latency || (thread_count <= 1) || (outer_workload_count == 0) || (outer_workload_count >= thread_count) || (inner_item_count <= 1))
+				return 1;
+
+			const unsigned int split_count_for_threads = (thread_count * split_count_per_thread + outer_workload_count - 1) / outer_workload_count;
+			const unsigned long long split_count_by_cost = static_cast<unsigned long long>(inner_item_count) * cost_per_inner_item / min_cost_per_split;
+			const unsigned int res = static_cast<unsigned int>(std::min(static_cast<unsigned long long>(std::min(split_count_for_threads, inner_item_count)), split_count_by_cost));
+
+			return std::max(res, 1U);
+		}
+
+		int spatial_split_plain::get_chunk_elem_count(
+			const plain_running_configuration& config,
+			int elem_count,
+			int default_chunk_elem_count)
+		{
+			const int thread_count = config.openmp_thread_count;
+			if (!config.low_latency || (thread_count <= 1))
+				return default_chunk_elem_count;
+
+			const int chunk_count = (elem_count + default_chunk_elem_count - 1) / default_chunk_elem_count;
+			if (chunk_count >= thread_count)
+				return default_chunk_elem_count;
+
+			// Multiple of 16 keeps chunks aligned for the widest vectors
+			int res = (elem_count + thread_count - 1) / thread_count;
+			res = (res + 15) / 16 * 16;
+			return std::min(std::max(res, min_chunk_elem_count), default_chunk_elem_count);
+		}
+
+		void spatial_split_plain::get_range(
+			unsigned int item_count,
+			unsigned int split_count,
+			unsigned int split_id,
+			unsigned int& start,
+			unsigned int& end)
+		{
+			start = static_cast<unsigned int>(static_cast<unsigned long long>(item_count) * split_id / split_count);
+			end = static_cast<unsigned int>(static_cast<unsigned long long>(item_count) * (split_id + 1) / split_count);
+		}
+	}
+}
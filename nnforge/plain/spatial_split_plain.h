@@ -0,0 +1,66 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Low latency mode support: when entries and feature maps don't keep all the threads busy,
+		// the work of each of them is split into parts along the spatial or reduction domain
+		class spatial_split_plain
+		{
+		public:
+			// Returns the number of parts each of outer_workload_count work items is split into,
+			// inner_item_count is the number of items the work item can be split by, each costing about cost_per_inner_item operations;
+			// returns 1 when low latency mode is off or when there is enough outer work
+			static unsigned int get_split_count(
+				const plain_running_configuration& config,
+				unsigned int outer_workload_count,
+				unsigned int inner_item_count,
+				unsigned int cost_per_inner_item);
+
+			// Chunk size of elementwise kernels, reduced from default_chunk_elem_count in low latency mode when there are fewer chunks than threads
+			static int get_chunk_elem_count(
+				const plain_running_configuration& config,
+				int elem_count,
+				int default_chunk_elem_count);
+
+			static void get_range(
+				unsigned int item_count,
+				unsigned int split_count,
+				unsigned int split_id,
+				unsigned int& start,
+				unsigned int& end);
+
+		private:
+			// Parts cheaper than this don't pay for scheduling
+			static const unsigned int min_cost_per_split;
+
+			// More parts than threads balance the load of uneven parts
+			static const unsigned int split_count_per_thread;
+
+			static const int min_chunk_elem_count;
+
+		private:
+			spatial_split_plain();
+			~spatial_split_plain();
+		};
+	}
+}
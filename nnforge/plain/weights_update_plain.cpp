@@ -0,0 +1,166 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "weights_update_plain.h"
+
+#include "simd_kernels_plain.h"
+#include "parallel_plain.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		weights_update_plain::weights_update_plain(
+			layer_data::ptr data,
+			layer_data::ptr gradient,
+			layer_data::ptr previous_upd,
+			layer_data::ptr previous_upd2,
+			const std::vector<float>& learning_rates,
+			const std::set<unsigned int>& weight_decay_part_id_set,
+			float weight_decay,
+			training_momentum momentum)
+			: momentum(momentum)
+			, learning_rate_list(learning_rates)
+		{
+			const size_t chunk_elem_count = static_cast<size_t>(simd_kernels_plain::chunk_elem_count);
+			for(unsigned int part_id = 0; part_id < static_cast<unsigned int>(data->size()); ++part_id)
+			{
+				std::vector<float>& weights = data->at(part_id);
+				const size_t elem_count = weights.size();
+				weights_list.push_back(elem_count > 0 ? &weights[0] : 0);
+				gradient_list.push_back(elem_count > 0 ? &gradient->at(part_id)[0] : 0);
+				previous_upd_list.push_back((previous_upd && (elem_count > 0)) ? &previous_upd->at(part_id)[0] : 0);
+				previous_upd2_list.push_back((previous_upd2 && (elem_count > 0)) ? &previous_upd2->at(part_id)[0] : 0);
+				// Adam applies weight decay to all the parts
+				bool is_weight_decay = (momentum.type == training_momentum::adam_momentum) || (weight_decay_part_id_set.find(part_id) != weight_decay_part_id_set.end());
+				weight_decay_list.push_back(is_weight_decay ? weight_decay : 0.0F);
+
+				for(size_t start = 0; start < elem_count; start += chunk_elem_count)
+				{
+					chunk c;
+					c.part_id = part_id;
+					c.start = start;
+					c.elem_count = std::min(chunk_elem_count, elem_count - start);
+					chunks.push_back(c);
+				}
+			}
+			chunk_updates.resize(chunks.size());
+		}
+
+		void weights_update_plain::run(
+			const plain_running_configuration& config,
+			float normalizer,
+			unsigned int iteration_id,
+			std::vector<double>& updates_accumulated)
+		{
+			chunk_body body;
+			body.parent = this;
+			body.isa = config.cpu_isa;
+			body.normalizer = normalizer;
+			body.one_minus_beta1t_inverted = 0.0F;
+			body.one_minus_beta2t_inverted = 0.0F;
+			if (momentum.type == training_momentum::adam_momentum)
+			{
+				body.one_minus_beta1t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val, static_cast<float>(iteration_id)));
+				body.one_minus_beta2t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val2, static_cast<float>(iteration_id)));
+			}
+
+			// A single chunk is not worth waking threads up
+			const int chunk_count = static_cast<int>(chunks.size());
+			if (chunk_count == 1)
+				body(0, 1);
+			else
+				parallel_plain::parallel_for(config, chunk_count, body);
+
+			for(unsigned int chunk_id = 0; chunk_id < static_cast<unsigned int>(chunks.size()); ++chunk_id)
+				updates_accumulated[chunks[chunk_id].part_id] += chunk_updates[chunk_id];
+		}
+
+		void weights_update_plain::chunk_body::operator()(int chunk_start, int chunk_end) const
+		{
+			const float epsilon = 1.0e-8F;
+			for(int chunk_id = chunk_start; chunk_id < chunk_end; ++chunk_id)
+			{
+				const chunk& c = parent->chunks[chunk_id];
+				const unsigned int part_id = c.part_id;
+				float * weights = parent->weights_list[part_id] + c.start;
+				float * gradient = parent->gradient_list[part_id] + c.start;
+				const float learning_rate = parent->learning_rate_list[part_id];
+				const float weight_decay = parent->weight_decay_list[part_id];
+
+				double res;
+				switch (parent->momentum.type)
+				{
+				case training_momentum::vanilla_momentum:
+					res = simd_kernels_plain::update_weights_momentum(
+						isa,
+						weights,
+						gradient,
+						parent->previous_upd_list[part_id] + c.start,
+						c.elem_count,
+						learning_rate,
+						normalizer,
+						weight_decay,
+						parent->momentum.momentum_val);
+					break;
+				case training_momentum::nesterov_momentum:
+					res = simd_kernels_plain::update_weights_nesterov(
+						isa,
+						weights,
+						gradient,
+						parent->previous_upd_list[part_id] + c.start,
+						c.elem_count,
+						learning_rate,
+						normalizer,
+						weight_decay,
+						parent->momentum.momentum_val);
+					break;
+				case training_momentum::adam_momentum:
+					res = simd_kernels_plain::update_weights_adam(
+						isa,
+						weights,
+						gradient,
+						parent->previous_upd_list[part_id] + c.start,
+						parent->previous_upd2_list[part_id] + c.start,
+						c.elem_count,
+						learning_rate,
+						normalizer,
+						weight_decay,
+						parent->momentum.momentum_val,
+						parent->momentum.momentum_val2,
+						one_minus_beta1t_inverted,
+						one_minus_beta2t_inverted,
+						epsilon);
+					break;
+				default:
+					res = simd_kernels_plain::update_weights_sgd(
+						isa,
+						weights,
+						gradient,
+						c.elem_count,
+						learning_rate,
+						normalizer,
+						weight_decay);
+					break;
+				}
+				parent->chunk_updates[chunk_id] = res;
+			}
+		}
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+#include "../layer_data.h"
+#include "../training_momentum.h"
+#include "../nn_types.h"
+
+#include <vector>
+#include <set>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Updates weights of a single layer applying the update, updating momentum data, zeroing the gradient
+		// and accumulating absolute updates in a single pass over the data.
+		// Parts are resolved and split into chunks once per run, chunks of all the parts are processed in parallel
+		class weights_update_plain
+		{
+		public:
+			typedef nnforge_shared_ptr<weights_update_plain> ptr;
+
+			// previous_upd and previous_upd2 are empty when the momentum type doesn't need them
+			weights_update_plain(
+				layer_data::ptr data,
+				layer_data::ptr gradient,
+				layer_data::ptr previous_upd,
+				layer_data::ptr previous_upd2,
+				const std::vector<float>& learning_rates,
+				const std::set<unsigned int>& weight_decay_part_id_set,
+				float weight_decay,
+				training_momentum momentum);
+
+			// Sums of absolute updates are added to updates_accumulated, one per part
+			void run(
+				const plain_running_configuration& config,
+				float normalizer,
+				unsigned int iteration_id,
+				std::vector<double>& updates_accumulated);
+
+		private:
+			class chunk
+			{
+			public:
+				unsigned int part_id;
+				size_t start;
+				size_t elem_count;
+			};
+
+			class chunk_body
+			{
+			public:
+				void operator()(int chunk_start, int chunk_end) const;
+
+				weights_update_plain * parent;
+				cpu_dispatch_plain::isa isa;
+				float normalizer;
+				float one_minus_beta1t_inverted;
+				float one_minus_beta2t_inverted;
+			};
+
+		private:
+			training_momentum momentum;
+
+			std::vector<float *> weights_list;
+			std::vector<float *> gradient_list;
+			std::vector<float *> previous_upd_list;
+			std::vector<float *> previous_upd2_list;
+			std::vector<float> learning_rate_list;
+			// Zero for the parts not subject to weight decay
+			std::vector<float> weight_decay_list;
+
+			std::vector<chunk> chunks;
+			// Sum of absolute updates for each chunk, summed up per part in chunk order so that the result doesn't depend on threads
+			std::vector<double> chunk_updates;
+
+		private:
+			weights_update_plain(const weights_update_plain&);
+			weights_update_plain& operator =(const weights_update_plain&);
+		};
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "worker_pool_plain.h"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		worker_pool_plain::worker_pool_plain(
+			unsigned int worker_count,
+			bool calling_thread_is_worker)
+			: worker_count(std::max(worker_count, 1U))
+			, first_thread_worker_id(calling_thread_is_worker ? 1 : 0)
+			, posted_task(0)
+			, task_generation(0)
+			, busy_worker_count(0)
+			, stopping(false)
+		{
+			for(unsigned int worker_id = first_thread_worker_id; worker_id < this->worker_count; ++worker_id)
+				threads.create_thread(boost::bind(&worker_pool_plain::run_worker, this, worker_id));
+		}
+
+		worker_pool_plain::~worker_pool_plain()
+		{
+			{
+				boost::lock_guard<boost::mutex> lock(state_mutex);
+				stopping = true;
+			}
+			task_posted.notify_all();
+			threads.join_all();
+		}
+
+		unsigned int worker_pool_plain::get_worker_count() const
+		{
+			return worker_count;
+		}
+
+		void worker_pool_plain::run(task& current_task)
+		{
+			if (worker_count > first_thread_worker_id)
+			{
+				{
+					boost::lock_guard<boost::mutex> lock(state_mutex);
+					posted_task = &current_task;
+					busy_worker_count = worker_count - first_thread_worker_id;
+					++task_generation;
+				}
+				task_posted.notify_all();
+			}
+
+			if (first_thread_worker_id > 0)
+			{
+				try
+				{
+					current_task.run(0);
+				}
+				catch (...)
+				{
+					// The other workers still use the task
+					wait_for_workers();
+					throw;
+				}
+			}
+
+			wait_for_workers();
+		}
+
+		void worker_pool_plain::wait_for_workers()
+		{
+			boost::unique_lock<boost::mutex> lock(state_mutex);
+			while (busy_worker_count > 0)
+				task_done.wait(lock);
+			posted_task = 0;
+		}
+
+		void worker_pool_plain::run_worker(unsigned int worker_id)
+		{
+			unsigned int done_task_generation = 0;
+			while (true)
+			{
+				task * current_task;
+				{
+					boost::unique_lock<boost::mutex> lock(state_mutex);
+					while (!stopping && (task_generation == done_task_generation))
+						task_posted.wait(lock);
+					if (stopping)
+						return;
+					done_task_generation = task_generation;
+					current_task = posted_task;
+				}
+
+				current_task->run(worker_id);
+
+				{
+					boost::lock_guard<boost::mutex> lock(state_mutex);
+					if (--busy_worker_count == 0)
+						task_done.notify_all();
+				}
+			}
+		}
+	}
+}
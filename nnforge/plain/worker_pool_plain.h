@@ -0,0 +1,84 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../nn_types.h"
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Threads kept between runs, they wait for the next task instead of being created and joined for each one
+		class worker_pool_plain
+		{
+		public:
+			typedef nnforge_shared_ptr<worker_pool_plain> ptr;
+
+			class task
+			{
+			public:
+				virtual ~task()
+				{
+				}
+
+				// worker_id is in [0, worker_count) range, the method should not throw
+				virtual void run(unsigned int worker_id) = 0;
+			};
+
+			// Starts worker_count - 1 threads, the thread calling run is used as worker 0;
+			// all the workers are threads of the pool when calling_thread_is_worker is false, so that they may be bound to CPUs
+			worker_pool_plain(
+				unsigned int worker_count,
+				bool calling_thread_is_worker = true);
+
+			~worker_pool_plain();
+
+			unsigned int get_worker_count() const;
+
+			// Runs the task on all the workers and returns when all of them are done, runs may not overlap
+			void run(task& current_task);
+
+		private:
+			void run_worker(unsigned int worker_id);
+
+			void wait_for_workers();
+
+		private:
+			unsigned int worker_count;
+			// 1 when the calling thread is worker 0, 0 otherwise
+			unsigned int first_thread_worker_id;
+			boost::thread_group threads;
+
+			boost::mutex state_mutex;
+			boost::condition_variable task_posted;
+			boost::condition_variable task_done;
+			task * posted_task;
+			// Incremented each time a task is posted, so that each worker runs each task once
+			unsigned int task_generation;
+			unsigned int busy_worker_count;
+			bool stopping;
+
+		private:
+			worker_pool_plain(const worker_pool_plain&);
+			worker_pool_plain& operator =(const worker_pool_plain&);
+		};
+	}
+}
@@ -27,6 +27,17 @@ namespace nnforge
 		return i.seconds > j.seconds;
 	}
 
+	std::string profile_util::get_layer_type(
+		const std::map<std::string, std::string>& layer_name_to_layer_type_map,
+		const std::string& layer_name)
+	{
+		std::map<std::string, std::string>::const_iterator it = layer_name_to_layer_type_map.find(layer_name);
+		if (it != layer_name_to_layer_type_map.end())
+			return it->second;
+		else
+			return layer_name;
+	}
+
 	void profile_util::dump_layer_action_performance(
 		profile_state::ptr profile,
 		float max_flops,
@@ -49,19 +60,21 @@ namespace nnforge
 			float max_gflops = max_flops * 1.0e-9F;
 			for(std::vector<entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
 			{
-				float gflops = action_flops_per_entry.find(it->action)->second * static_cast<float>(entry_count) / it->seconds * 1.0e-9F;
+				std::map<layer_name_with_action, float>::const_iterator flops_it = action_flops_per_entry.find(it->action);
+				bool perf_available = (flops_it != action_flops_per_entry.end()) && (it->action.get_action().get_action_type() != layer_action::update_weights);
+				float gflops = perf_available ? flops_it->second * static_cast<float>(entry_count) / it->seconds * 1.0e-9F : 0.0F;
 				float relative_gflops = gflops / max_gflops;
 
 				out << it->action.get_name();
-				out << "\t" << layer_name_to_layer_type_map.find(it->action.get_name())->second;
+				out << "\t" << get_layer_type(layer_name_to_layer_type_map, it->action.get_name());
 				out << "\t" << it->action.get_action().str();
 				out << "\t" << (boost::format("%|1$.2f|%%") % (it->seconds / static_cast<float>(total_second) * 100.0F)).str();
-				if (it->action.get_action().get_action_type() != layer_action::update_weights)
+				if (perf_available)
 					out << "\t" << (boost::format("%|1$.2f|%%") % (relative_gflops * 100.0F)).str();
 				else
 					out << "\tNA";
 				out << "\t" << it->seconds;
-				if (it->action.get_action().get_action_type() != layer_action::update_weights)
+				if (perf_available)
 					out << "\t" << gflops;
 				else
 					out << "\tNA";
@@ -76,7 +89,7 @@ namespace nnforge
 
 			std::map<layer_name_with_action, double> action_seconds2;
 			for(std::map<layer_name_with_action, float>::const_iterator it = action_seconds.begin(); it != action_seconds.end(); ++it)
-				action_seconds2.insert(std::make_pair(layer_name_with_action(layer_name_to_layer_type_map.find(it->first.get_name())->second, it->first.get_action()), 0.0)).first->second += static_cast<double>(it->second);
+				action_seconds2.insert(std::make_pair(layer_name_with_action(get_layer_type(layer_name_to_layer_type_map, it->first.get_name()), it->first.get_action()), 0.0)).first->second += static_cast<double>(it->second);
 
 			std::vector<entry> entries;
 			for(std::map<layer_name_with_action, double>::const_iterator it = action_seconds2.begin(); it != action_seconds2.end(); ++it)
@@ -89,18 +102,20 @@ namespace nnforge
 			float max_gflops = max_flops * 1.0e-9F;
 			for(std::vector<entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
 			{
-				float gflops = static_cast<float>(action_flops_per_entry2.find(it->action)->second) * static_cast<float>(entry_count) / it->seconds * 1.0e-9F;
+				std::map<layer_name_with_action, double>::const_iterator flops_it = action_flops_per_entry2.find(it->action);
+				bool perf_available = (flops_it != action_flops_per_entry2.end()) && (it->action.get_action().get_action_type() != layer_action::update_weights);
+				float gflops = perf_available ? static_cast<float>(flops_it->second) * static_cast<float>(entry_count) / it->seconds * 1.0e-9F : 0.0F;
 				float relative_gflops = gflops / max_gflops;
 
 				out << it->action.get_name();
 				out << "\t" << it->action.get_action().str();
 				out << "\t" << (boost::format("%|1$.2f|%%") % (it->seconds / static_cast<float>(total_second) * 100.0F)).str();
-				if (it->action.get_action().get_action_type() != layer_action::update_weights)
+				if (perf_available)
 					out << "\t" << (boost::format("%|1$.2f|%%") % (relative_gflops * 100.0F)).str();
 				else
 					out << "\tNA";
 				out << "\t" << it->seconds;
-				if (it->action.get_action().get_action_type() != layer_action::update_weights)
+				if (perf_available)
 					out << "\t" << gflops;
 				else
 					out << "\tNA";
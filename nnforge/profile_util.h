@@ -26,6 +26,8 @@ namespace nnforge
 	class profile_util
 	{
 	public:
+		// Actions of pseudo layers, those missing in layer_name_to_layer_type_map, are allowed in action_seconds,
+		// they are reported with the layer type equal to their name and without perf numbers
 		static void dump_layer_action_performance(
 			profile_state::ptr profile,
 			float max_flops,
@@ -51,6 +53,10 @@ namespace nnforge
 
 		static bool compare_entry(const entry& i, const entry& j);
 
+		static std::string get_layer_type(
+			const std::map<std::string, std::string>& layer_name_to_layer_type_map,
+			const std::string& layer_name);
+
 	private:
 		profile_util();
 		~profile_util();
@@ -23,6 +23,9 @@
 #include <iostream>
 #include <boost/algorithm/string.hpp>
 #include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <boost/chrono.hpp>
 
 #include "layer_factory.h"
 #include "neural_network_exception.h"
@@ -54,6 +57,7 @@ namespace nnforge
 	const char * toolset::ann_subfolder_name = "trained_data";
 	const char * toolset::debug_subfolder_name = "debug";
 	const char * toolset::profile_subfolder_name = "profile";
+	const char * toolset::tuning_cache_file_name = "tuning_cache.txt";
 	const char * toolset::dump_data_subfolder_name = "dump_data";
 	const char * toolset::trained_ann_index_extractor_pattern = "^ann_trained_(\\d+)$";
 	const char * toolset::snapshot_ann_index_extractor_pattern = "^ann_trained_(\\d+)_epoch_(\\d+)$";
@@ -80,6 +84,10 @@ namespace nnforge
 		{
 			run_inference();
 		}
+		else if (!action.compare("benchmark_latency"))
+		{
+			benchmark_latency();
+		}
 		else if (!action.compare("dump_schema"))
 		{
 			dump_schema_gv();
@@ -296,6 +304,7 @@ namespace nnforge
 		debug = debug_state::ptr(new debug_state(debug_mode, get_working_data_folder() / debug_subfolder_name));
 		profile = profile_state::ptr(new profile_state(profile_mode, get_working_data_folder() / profile_subfolder_name));
 
+		master_factory->set_tuning_state(tuning_state::ptr(new tuning_state(tuning_state::parse_mode_name(auto_tuning), get_working_data_folder() / tuning_cache_file_name)));
 		master_factory->initialize();
 
 		forward_prop_factory = master_factory->create_forward_propagation_factory();
@@ -329,7 +338,7 @@ namespace nnforge
 	{
 		std::vector<string_option> res;
 
-		res.push_back(string_option("action", &action, get_default_action().c_str(), "run action (info, prepare_training_data, prepare_testing_data, shuffle_data, dump_data, dump_schema, create_normalizer, inference, train, save_random_weights, update_bn_weights)"));
+		res.push_back(string_option("action", &action, get_default_action().c_str(), "run action (info, prepare_training_data, prepare_testing_data, shuffle_data, dump_data, dump_schema, create_normalizer, inference, benchmark_latency, train, save_random_weights, update_bn_weights)"));
 		res.push_back(string_option("schema", &schema_filename, "schema.txt", "Name of the file with schema of the network, in protobuf format"));
 		res.push_back(string_option("inference_dataset_name", &inference_dataset_name, "validating", "Name of the dataset to be used for inference"));
 		res.push_back(string_option("training_dataset_name", &training_dataset_name, "training", "Name of the dataset to be used for training"));
@@ -346,6 +355,7 @@ namespace nnforge
 		res.push_back(string_option("normalizer_dataset_name", &normalizer_dataset_name, "training", "Name of the dataset to create normalizer from"));
 		res.push_back(string_option("normalizer_layer_name", &normalizer_layer_name, "", "Name of the layer to create normalizer for"));
 		res.push_back(string_option("log_mode", &log_mode, "duplicate", "Duplicate or redirect output to log file (duplicate, redirect)"));
+		res.push_back(string_option("auto_tuning", &auto_tuning, "off", "Choose layer algorithms by timing them, decisions are cached in the working data folder (off, on, refresh)"));
 		res.push_back(string_option("check_gradient_weights", &check_gradient_weights, "::", "The set of weights to check for gradient, in the form Layer:WeightSet:WeightID"));
 		res.push_back(string_option("learning_rate_policy", &learning_rate_policy, "exponential", "Learning rate decay policy (exponential, step)"));
 		res.push_back(string_option("step_learning_rate_epochs_and_rates", &step_learning_rate_epochs_and_rates, "", "List of start epoch and decay for step learining rate policy, for example 30:0.1:60:0.01"));
@@ -426,6 +436,9 @@ namespace nnforge
 		res.push_back(int_option("shuffle_block_size", &shuffle_block_size, 0, "The size of contiguous blocks when shuffling training data, 0 indicates no shuffling"));
 		res.push_back(int_option("check_gradient_max_weights_per_set", &check_gradient_max_weights_per_set, 20, "The maximum amount of weights to check in the set"));
 		res.push_back(int_option("keep_snapshots_frequency", &keep_snapshots_frequency, 10, "Keep every Nth snapshot"));
+		res.push_back(int_option("benchmark_latency_entry_count", &benchmark_latency_entry_count, 1, "Entries in a single forward propagation run when benchmarking latency"));
+		res.push_back(int_option("benchmark_latency_run_count", &benchmark_latency_run_count, 100, "Timed forward propagation runs when benchmarking latency"));
+		res.push_back(int_option("benchmark_latency_warmup_run_count", &benchmark_latency_warmup_run_count, 10, "Untimed forward propagation runs preceding the timed ones when benchmarking latency"));
 
 		return res;
 	}
@@ -549,6 +562,75 @@ namespace nnforge
 		return res;
 	}
 
+	void toolset::benchmark_latency()
+	{
+		if (benchmark_latency_entry_count <= 0)
+			throw neural_network_exception((boost::format("Invalid benchmark_latency_entry_count: %1%") % benchmark_latency_entry_count).str());
+		if (benchmark_latency_run_count <= 0)
+			throw neural_network_exception((boost::format("Invalid benchmark_latency_run_count: %1%") % benchmark_latency_run_count).str());
+
+		network_schema::ptr schema = get_schema(schema_usage_inference);
+		forward_propagation::ptr forward_prop = forward_prop_factory->create(*schema, inference_output_layer_names, debug, profile);
+
+		network_data data;
+		if (forward_prop->is_schema_with_weights())
+		{
+			std::vector<std::pair<unsigned int, boost::filesystem::path> > ann_data_name_and_folderpath_list = get_ann_data_index_and_folderpath_list();
+			if (ann_data_name_and_folderpath_list.empty())
+				throw neural_network_exception("No trained networks found for benchmarking latency");
+			data.read(ann_data_name_and_folderpath_list.front().second);
+		}
+		forward_prop->set_data(data);
+
+		// Entries are read upfront so that timings don't include dataset reading and decoding
+		std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> > layer_name_to_config_and_value_set_map;
+		{
+			structured_data_bunch_reader::ptr reader = get_structured_data_bunch_reader(inference_dataset_name, dataset_usage_inference, 1, 0);
+			std::map<std::string, layer_configuration_specific> config_map = reader->get_config_map();
+			std::map<std::string, std::vector<float> > entry_data_map;
+			std::map<std::string, float *> data_map;
+			for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+			{
+				std::vector<float>& entry_data = entry_data_map[it->first];
+				entry_data.resize(it->second.get_neuron_count());
+				data_map.insert(std::make_pair(it->first, &entry_data[0]));
+				layer_name_to_config_and_value_set_map.insert(std::make_pair(it->first, std::make_pair(it->second, neuron_value_set::ptr(new neuron_value_set(it->second.get_neuron_count())))));
+			}
+			for(int entry_id = 0; entry_id < benchmark_latency_entry_count; ++entry_id)
+			{
+				if (!reader->read(entry_id, data_map))
+					throw neural_network_exception((boost::format("Dataset %1% contains less than %2% entries") % inference_dataset_name % benchmark_latency_entry_count).str());
+				for(std::map<std::string, float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+					layer_name_to_config_and_value_set_map[it->first].second->add_entry(it->second);
+			}
+		}
+		neuron_value_set_data_bunch_reader reader(layer_name_to_config_and_value_set_map);
+
+		std::cout << "Benchmarking latency of " << benchmark_latency_entry_count << " entries, " << benchmark_latency_warmup_run_count << " warmup runs and " << benchmark_latency_run_count << " timed runs..." << std::endl;
+
+		for(int run_id = 0; run_id < benchmark_latency_warmup_run_count; ++run_id)
+		{
+			neuron_value_set_data_bunch_writer writer;
+			forward_prop->run(reader, writer);
+		}
+
+		std::vector<double> latency_list;
+		for(int run_id = 0; run_id < benchmark_latency_run_count; ++run_id)
+		{
+			neuron_value_set_data_bunch_writer writer;
+			boost::chrono::steady_clock::time_point start = boost::chrono::high_resolution_clock::now();
+			forward_prop->run(reader, writer);
+			boost::chrono::duration<double> sec = boost::chrono::high_resolution_clock::now() - start;
+			latency_list.push_back(sec.count() * 1000.0);
+		}
+		std::sort(latency_list.begin(), latency_list.end());
+
+		// Nearest rank percentiles
+		unsigned int p50_index = static_cast<unsigned int>(std::max(static_cast<int>(ceil(0.50 * latency_list.size())) - 1, 0));
+		unsigned int p99_index = static_cast<unsigned int>(std::max(static_cast<int>(ceil(0.99 * latency_list.size())) - 1, 0));
+		std::cout << "Latency: min " << latency_list.front() << " ms, p50 " << latency_list[p50_index] << " ms, p99 " << latency_list[p99_index] << " ms, max " << latency_list.back() << " ms" << std::endl;
+	}
+
 	std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > toolset::run_inference()
 	{
 		std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > res;
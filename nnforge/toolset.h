@@ -93,6 +93,8 @@ namespace nnforge
 
 		virtual void dump_schema_gv();
 
+		virtual void benchmark_latency();
+
 		virtual void train();
 
 		virtual boost::filesystem::path get_ann_subfolder_name() const;
@@ -233,10 +235,14 @@ namespace nnforge
 		bool dump_data_rgb;
 		int dump_data_scale;
 		int dump_data_video_fps;
+		int benchmark_latency_entry_count;
+		int benchmark_latency_run_count;
+		int benchmark_latency_warmup_run_count;
 		int epoch_count_in_training_dataset;
 		int epoch_count_in_validating_dataset;
 		int dump_compact_samples;
 		std::string log_mode;
+		std::string auto_tuning;
 		float training_mix_validating_ratio;
 		std::string dump_format;
 		int shuffle_block_size;
@@ -255,6 +261,7 @@ namespace nnforge
 		static const char * ann_subfolder_name;
 		static const char * debug_subfolder_name;
 		static const char * profile_subfolder_name;
+		static const char * tuning_cache_file_name;
 		static const char * trained_ann_index_extractor_pattern;
 		static const char * snapshot_ann_index_extractor_pattern;
 		static const char * ann_snapshot_subfolder_name;
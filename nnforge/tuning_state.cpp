@@ -0,0 +1,140 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "tuning_state.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	tuning_state::tuning_state(
+		tuning_mode mode,
+		const boost::filesystem::path& cache_file_path)
+		: mode(mode)
+		, cache_file_path(cache_file_path)
+	{
+		if (mode != tuning_mode_off)
+			load();
+	}
+
+	tuning_state::~tuning_state()
+	{
+	}
+
+	bool tuning_state::is_tuning() const
+	{
+		return (mode != tuning_mode_off);
+	}
+
+	tuning_state::tuning_mode tuning_state::get_mode() const
+	{
+		return mode;
+	}
+
+	bool tuning_state::get_decision(
+		const std::string& key,
+		std::string& value) const
+	{
+		boost::unique_lock<boost::mutex> lock(decisions_mutex);
+
+		std::map<std::string, std::string>::const_iterator it = decisions.find(key);
+		if (it == decisions.end())
+			return false;
+		if ((mode == tuning_mode_refresh) && (refreshed_keys.find(key) == refreshed_keys.end()))
+			return false;
+
+		value = it->second;
+		return true;
+	}
+
+	void tuning_state::set_decision(
+		const std::string& key,
+		const std::string& value)
+	{
+		boost::unique_lock<boost::mutex> lock(decisions_mutex);
+
+		decisions[key] = value;
+		refreshed_keys.insert(key);
+	}
+
+	// Each line holds the key and the value separated with tab
+	void tuning_state::load()
+	{
+		if (!boost::filesystem::exists(cache_file_path))
+			return;
+
+		boost::filesystem::ifstream in(cache_file_path, std::ios_base::in);
+		if (!in)
+			throw neural_network_exception((boost::format("Cannot open tuning cache file %1%") % cache_file_path.string()).str());
+
+		std::string line;
+		while (std::getline(in, line))
+		{
+			if (!line.empty() && (line[line.size() - 1] == '\r'))
+				line.resize(line.size() - 1);
+			std::string::size_type separator_pos = line.find('\t');
+			if (separator_pos == std::string::npos)
+				continue;
+			decisions[line.substr(0, separator_pos)] = line.substr(separator_pos + 1);
+		}
+	}
+
+	void tuning_state::save() const
+	{
+		if (mode == tuning_mode_off)
+			return;
+
+		boost::unique_lock<boost::mutex> lock(decisions_mutex);
+
+		if (!cache_file_path.parent_path().empty())
+			boost::filesystem::create_directories(cache_file_path.parent_path());
+
+		boost::filesystem::ofstream out(cache_file_path, std::ios_base::out | std::ios_base::trunc);
+		if (!out)
+			throw neural_network_exception((boost::format("Cannot write tuning cache file %1%") % cache_file_path.string()).str());
+
+		for(std::map<std::string, std::string>::const_iterator it = decisions.begin(); it != decisions.end(); ++it)
+			out << it->first << '\t' << it->second << std::endl;
+	}
+
+	tuning_state::tuning_mode tuning_state::parse_mode_name(const std::string& name)
+	{
+		if (name == "off")
+			return tuning_mode_off;
+		else if (name == "on")
+			return tuning_mode_on;
+		else if (name == "refresh")
+			return tuning_mode_refresh;
+
+		throw neural_network_exception((boost::format("Invalid auto tuning mode: %1%") % name).str());
+	}
+
+	std::string tuning_state::get_mode_name(tuning_mode mode)
+	{
+		switch (mode)
+		{
+		case tuning_mode_on:
+			return "on";
+		case tuning_mode_refresh:
+			return "refresh";
+		default:
+			return "off";
+		}
+	}
+}
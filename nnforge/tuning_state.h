@@ -0,0 +1,90 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+#include <map>
+#include <set>
+#include <string>
+
+#include "nn_types.h"
+
+namespace nnforge
+{
+	// Decisions of the backend auto-tuners, persisted in the cache file so that later runs don't repeat the measurements
+	class tuning_state
+	{
+	public:
+		typedef nnforge_shared_ptr<tuning_state> ptr;
+
+		enum tuning_mode
+		{
+			// Heuristics are used, the cache file is neither read nor written
+			tuning_mode_off = 0,
+			// Decisions cached are reused, the rest are measured and added to the cache
+			tuning_mode_on = 1,
+			// Decisions cached are ignored and measured again, the new ones replace them in the cache
+			tuning_mode_refresh = 2
+		};
+
+		tuning_state(
+			tuning_mode mode,
+			const boost::filesystem::path& cache_file_path);
+
+		~tuning_state();
+
+		bool is_tuning() const;
+
+		tuning_mode get_mode() const;
+
+		// Returns false if there is no decision for the key,
+		// in refresh mode the same for the decisions loaded from the cache and not set again
+		bool get_decision(
+			const std::string& key,
+			std::string& value) const;
+
+		// The decision is kept in memory until save is called, the cache keeps decisions for other keys
+		void set_decision(
+			const std::string& key,
+			const std::string& value);
+
+		void save() const;
+
+		static tuning_mode parse_mode_name(const std::string& name);
+
+		static std::string get_mode_name(tuning_mode mode);
+
+	protected:
+		void load();
+
+	protected:
+		tuning_mode mode;
+		boost::filesystem::path cache_file_path;
+
+	private:
+		mutable boost::mutex decisions_mutex;
+		std::map<std::string, std::string> decisions;
+		// Keys set by this process, only they are reported by get_decision in refresh mode
+		std::set<std::string> refreshed_keys;
+
+	private:
+		tuning_state();
+		tuning_state(const tuning_state&);
+		tuning_state& operator =(const tuning_state&);
+	};
+}
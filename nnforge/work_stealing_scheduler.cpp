@@ -0,0 +1,300 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "work_stealing_scheduler.h"
+
+#include "neural_network_exception.h"
+
+#include <algorithm>
+#include <exception>
+#include <boost/bind.hpp>
+#include <boost/thread/tss.hpp>
+
+namespace nnforge
+{
+	namespace
+	{
+		struct worker_context
+		{
+			const work_stealing_scheduler * owner;
+			unsigned int worker_id;
+		};
+
+		boost::thread_specific_ptr<worker_context> current_worker;
+	}
+
+	const unsigned int work_stealing_scheduler::spin_count = 1024;
+
+	work_stealing_scheduler::task_group::task_group(work_stealing_scheduler& scheduler)
+		: scheduler(scheduler)
+		, pending_task_count(0)
+		, failed(false)
+	{
+	}
+
+	work_stealing_scheduler::task_group::~task_group()
+	{
+		try
+		{
+			wait();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void work_stealing_scheduler::task_group::run(const task& func)
+	{
+		queued_task t;
+		t.func = func;
+		t.group = this;
+		pending_task_count.fetch_add(1);
+		scheduler.push(t);
+	}
+
+	void work_stealing_scheduler::task_group::wait()
+	{
+		queued_task t;
+		unsigned int idle_count = 0;
+		while (pending_task_count.load() > 0)
+		{
+			if (scheduler.try_pop(t))
+			{
+				scheduler.execute(t);
+				idle_count = 0;
+			}
+			else if (++idle_count >= spin_count)
+				boost::this_thread::yield();
+		}
+
+		boost::mutex::scoped_lock lock(error_mutex);
+		if (failed)
+		{
+			failed = false;
+			throw neural_network_exception(error_message);
+		}
+	}
+
+	void work_stealing_scheduler::task_group::set_error(const std::string& message)
+	{
+		boost::mutex::scoped_lock lock(error_mutex);
+		if (!failed)
+		{
+			failed = true;
+			error_message = message;
+		}
+	}
+
+	work_stealing_scheduler::work_stealing_scheduler(unsigned int thread_count)
+		: thread_count(thread_count)
+		, queued_task_count(0)
+		, sleeping_worker_count(0)
+		, stopping(false)
+	{
+		for(unsigned int i = 0; i < thread_count; ++i)
+			worker_queues.push_back(nnforge_shared_ptr<task_queue>(new task_queue()));
+		for(unsigned int i = 0; i < thread_count; ++i)
+			threadpool.create_thread(boost::bind(&work_stealing_scheduler::worker_loop, this, i));
+	}
+
+	work_stealing_scheduler::~work_stealing_scheduler()
+	{
+		{
+			boost::mutex::scoped_lock lock(sleep_mutex);
+			stopping = true;
+		}
+		wakeup.notify_all();
+		threadpool.join_all();
+	}
+
+	unsigned int work_stealing_scheduler::get_thread_count() const
+	{
+		return thread_count + 1;
+	}
+
+	int work_stealing_scheduler::get_current_worker_id() const
+	{
+		worker_context * context = current_worker.get();
+		if ((context == 0) || (context->owner != this))
+			return -1;
+		return static_cast<int>(context->worker_id);
+	}
+
+	void work_stealing_scheduler::push(const queued_task& t)
+	{
+		int worker_id = get_current_worker_id();
+		task_queue& q = (worker_id >= 0) ? *worker_queues[worker_id] : inject_queue;
+		{
+			boost::mutex::scoped_lock lock(q.mutex);
+			q.tasks.push_back(t);
+		}
+
+		// Sequentially consistent counters make either this thread see the sleeping worker
+		// or the worker see the task before it goes to sleep
+		queued_task_count.fetch_add(1);
+		if (sleeping_worker_count.load() > 0)
+		{
+			{
+				boost::mutex::scoped_lock lock(sleep_mutex);
+			}
+			wakeup.notify_one();
+		}
+	}
+
+	bool work_stealing_scheduler::try_pop(queued_task& t)
+	{
+		if (queued_task_count.load() <= 0)
+			return false;
+
+		int worker_id = get_current_worker_id();
+
+		// The most recent task of the own deque is the one with the data still in cache
+		if (worker_id >= 0)
+		{
+			task_queue& q = *worker_queues[worker_id];
+			boost::mutex::scoped_lock lock(q.mutex);
+			if (!q.tasks.empty())
+			{
+				t = q.tasks.back();
+				q.tasks.pop_back();
+				queued_task_count.fetch_sub(1);
+				return true;
+			}
+		}
+
+		{
+			boost::mutex::scoped_lock lock(inject_queue.mutex);
+			if (!inject_queue.tasks.empty())
+			{
+				t = inject_queue.tasks.front();
+				inject_queue.tasks.pop_front();
+				queued_task_count.fetch_sub(1);
+				return true;
+			}
+		}
+
+		// The oldest tasks of the others are the largest ones when ranges are split in halves
+		unsigned int start_victim_id = (worker_id >= 0) ? static_cast<unsigned int>(worker_id) + 1 : 0;
+		for(unsigned int i = 0; i < thread_count; ++i)
+		{
+			unsigned int victim_id = (start_victim_id + i) % thread_count;
+			if (static_cast<int>(victim_id) == worker_id)
+				continue;
+			task_queue& q = *worker_queues[victim_id];
+			boost::mutex::scoped_lock lock(q.mutex);
+			if (!q.tasks.empty())
+			{
+				t = q.tasks.front();
+				q.tasks.pop_front();
+				queued_task_count.fetch_sub(1);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void work_stealing_scheduler::execute(queued_task& t)
+	{
+		task_group * group = t.group;
+		try
+		{
+			t.func();
+		}
+		catch (const std::exception& e)
+		{
+			group->set_error(e.what());
+		}
+		catch (...)
+		{
+			group->set_error("Unknown error in work stealing scheduler task");
+		}
+		t.func.clear();
+
+		// The group might be destroyed as soon as the counter drops to zero
+		group->pending_task_count.fetch_sub(1);
+	}
+
+	void work_stealing_scheduler::worker_loop(unsigned int worker_id)
+	{
+		worker_context * context = new worker_context();
+		context->owner = this;
+		context->worker_id = worker_id;
+		current_worker.reset(context);
+
+		queued_task t;
+		unsigned int idle_count = 0;
+		while (true)
+		{
+			if (try_pop(t))
+			{
+				execute(t);
+				idle_count = 0;
+				continue;
+			}
+
+			if (++idle_count < spin_count)
+				continue;
+
+			boost::mutex::scoped_lock lock(sleep_mutex);
+			if (stopping)
+				break;
+			sleeping_worker_count.fetch_add(1);
+			if (queued_task_count.load() <= 0)
+				wakeup.wait(lock);
+			sleeping_worker_count.fetch_sub(1);
+			idle_count = 0;
+		}
+	}
+
+	void work_stealing_scheduler::parallel_for(
+		int begin,
+		int end,
+		int grain_size,
+		const range_task& body)
+	{
+		if (end <= begin)
+			return;
+
+		if ((thread_count == 0) || (end - begin <= grain_size))
+		{
+			body(begin, end);
+			return;
+		}
+
+		task_group group(*this);
+		run_range(group, begin, end, grain_size, body);
+		group.wait();
+	}
+
+	void work_stealing_scheduler::run_range(
+		task_group& group,
+		int begin,
+		int end,
+		int grain_size,
+		const range_task& body)
+	{
+		// The upper half is left for thieves, the lower one is processed by the current thread
+		while (end - begin > std::max(grain_size, 1))
+		{
+			int middle = begin + (end - begin) / 2;
+			group.run(boost::bind(&work_stealing_scheduler::run_range, this, boost::ref(group), middle, end, grain_size, boost::cref(body)));
+			end = middle;
+		}
+
+		body(begin, end);
+	}
+}
@@ -0,0 +1,145 @@
+/*
+ *  Copyright 2011-2015 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "nn_types.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace nnforge
+{
+	// Task pool with a deque per worker thread and an inject queue for tasks submitted by other threads:
+	// a worker pushes and pops its own tasks at the back of its deque and steals from the front of the others' deques when it runs out of them,
+	// threads waiting for a task group run pending tasks instead of blocking, so nested parallelism doesn't deadlock or oversubscribe
+	class work_stealing_scheduler
+	{
+	public:
+		typedef nnforge_shared_ptr<work_stealing_scheduler> ptr;
+		typedef boost::function<void ()> task;
+		typedef boost::function<void (int, int)> range_task;
+
+		// Tasks run within the group are waited for together, the group should outlive them
+		class task_group
+		{
+		public:
+			task_group(work_stealing_scheduler& scheduler);
+
+			// Waits for the tasks, errors are dropped
+			~task_group();
+
+			void run(const task& func);
+
+			// Runs pending tasks of the scheduler until all the tasks of the group are done,
+			// throws neural_network_exception with the message of the first task failed
+			void wait();
+
+		private:
+			void set_error(const std::string& message);
+
+		private:
+			work_stealing_scheduler& scheduler;
+			boost::atomic<int> pending_task_count;
+			boost::mutex error_mutex;
+			bool failed;
+			std::string error_message;
+
+			friend class work_stealing_scheduler;
+
+		private:
+			task_group();
+			task_group(const task_group&);
+			task_group& operator =(const task_group&);
+		};
+
+		// The thread calling parallel_for or waiting for a task group takes part in running the tasks,
+		// so thread_count workers plus the caller run them
+		work_stealing_scheduler(unsigned int thread_count);
+
+		~work_stealing_scheduler();
+
+		// Splits [begin, end) in halves recursively until the ranges are not larger than grain_size and runs body on each of them,
+		// returns when all of them are done
+		void parallel_for(
+			int begin,
+			int end,
+			int grain_size,
+			const range_task& body);
+
+		// Worker threads plus the calling one
+		unsigned int get_thread_count() const;
+
+	private:
+		struct queued_task
+		{
+			task func;
+			task_group * group;
+		};
+
+		struct task_queue
+		{
+			boost::mutex mutex;
+			std::deque<queued_task> tasks;
+		};
+
+		void push(const queued_task& t);
+
+		bool try_pop(queued_task& t);
+
+		void execute(queued_task& t);
+
+		void worker_loop(unsigned int worker_id);
+
+		void run_range(
+			task_group& group,
+			int begin,
+			int end,
+			int grain_size,
+			const range_task& body);
+
+		// Returns -1 when the calling thread is not a worker of this scheduler
+		int get_current_worker_id() const;
+
+	private:
+		unsigned int thread_count;
+		std::vector<nnforge_shared_ptr<task_queue> > worker_queues;
+		task_queue inject_queue;
+
+		// Tasks in all the queues, sleeping workers are woken when it becomes positive
+		boost::atomic<int> queued_task_count;
+		boost::atomic<int> sleeping_worker_count;
+		boost::mutex sleep_mutex;
+		boost::condition_variable wakeup;
+		bool stopping;
+
+		boost::thread_group threadpool;
+
+		// Failed attempts to get a task before the worker goes to sleep
+		static const unsigned int spin_count;
+
+	private:
+		work_stealing_scheduler();
+		work_stealing_scheduler(const work_stealing_scheduler&);
+		work_stealing_scheduler& operator =(const work_stealing_scheduler&);
+	};
+}